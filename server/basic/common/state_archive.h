@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace quanttrader {
+
+/**
+ * @brief Binary writer for checkpoints of the engine state
+ *
+ * Numbers are written with the byte order of the machine, a checkpoint is restored on the
+ * same kind of machine. Strings are prefixed by their size, so a component can write its
+ * state into a writer of its own and its parent stores the result as one string.
+ */
+class StateWriter {
+public:
+    template <typename T>
+    void write(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only numbers and enums are written as bytes");
+        data_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(std::string_view value) {
+        write<uint64_t>(value.size());
+        data_.append(value.data(), value.size());
+    }
+
+    void write(const std::string& value) { write(std::string_view(value)); }
+    void write(const char* value) { write(std::string_view(value)); }
+
+    const std::string& data() const { return data_; }
+    std::string take() { return std::move(data_); }
+
+private:
+    std::string data_;
+};
+
+/**
+ * @brief Reads what a StateWriter wrote, in the same order
+ *
+ * A read past the end or of a malformed size fails and every later read fails too, so a
+ * component can read all of its fields and check ok() once.
+ */
+class StateReader {
+public:
+    explicit StateReader(std::string_view data) : data_(data) {}
+
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only numbers and enums are read as bytes");
+        if (!ok_ || data_.size() - offset_ < sizeof(T)) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(&value, data_.data() + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& value) {
+        uint64_t size = 0;
+        if (!read(size) || data_.size() - offset_ < size) {
+            ok_ = false;
+            return false;
+        }
+        value.assign(data_.data() + offset_, size);
+        offset_ += size;
+        return true;
+    }
+
+    /**
+     * @brief Read a count of elements that are at least min_element_size bytes each
+     *
+     * @return false if the rest of the data cannot hold that many elements
+     */
+    bool read_count(uint64_t& count, size_t min_element_size = 1) {
+        if (!read(count) || count > (data_.size() - offset_) / std::max<size_t>(min_element_size, 1)) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return offset_ == data_.size(); }
+
+private:
+    std::string_view data_;
+    size_t offset_ = 0;
+    bool ok_ = true;
+};
+
+/**
+ * @brief Write a checkpoint to a file, through a temporary file so a crash keeps the old one
+ *
+ * @return true if the file was written
+ */
+inline bool write_state_file(const std::filesystem::path& path, const std::string& state) {
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(state.data(), static_cast<std::streamsize>(state.size()))) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    return !ec;
+}
+
+/**
+ * @brief Read a checkpoint file
+ *
+ * @return The state, std::nullopt if the file cannot be read
+ */
+inline std::optional<std::string> read_state_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::ostringstream state;
+    state << file.rdbuf();
+    return state.str();
+}
+
+}
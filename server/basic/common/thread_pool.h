@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace quanttrader {
+
+/**
+ * @brief Fixed number of worker threads running submitted tasks in order
+ *
+ * The destructor runs the tasks still queued, then joins the workers.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads) {
+        threads = std::max<size_t>(threads, 1);
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task
+     *
+     * @param task Callable without arguments
+     * @return Future of the task result, exceptions of the task are rethrown by get()
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        // std::function needs a copyable target, the packaged task is shared
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([packaged] { (*packaged)(); });
+        }
+        cv_.notify_one();
+        return future;
+    }
+
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief Threads to use for a number of independent tasks
+     *
+     * @param tasks Number of tasks
+     * @param limit Upper bound, 0 for the number of hardware threads
+     */
+    static size_t bounded_size(size_t tasks, size_t limit = 0) {
+        size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return std::max<size_t>(std::min(tasks, limit > 0 ? limit : hardware), 1);
+    }
+
+    /**
+     * @brief Run a task for every index on a pool of its own
+     *
+     * Each worker takes the next index until none is left, so tasks of very different
+     * lengths keep all workers busy until the last one is done.
+     *
+     * @param count Number of indexes
+     * @param threads Number of workers
+     * @param task Called with the index and the worker number, below threads; exceptions are rethrown
+     */
+    template <typename F>
+    static void for_each_index(size_t count, size_t threads, F&& task) {
+        std::atomic<size_t> next {0};
+        ThreadPool pool(threads);
+        std::vector<std::future<void>> workers;
+        workers.reserve(pool.size());
+        for (size_t worker = 0; worker < pool.size(); ++worker) {
+            workers.push_back(pool.submit([&task, &next, count, worker]() {
+                for (size_t index = next++; index < count; index = next++) {
+                    task(index, worker);
+                }
+            }));
+        }
+        for (auto& future : workers) {
+            future.get();
+        }
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+}
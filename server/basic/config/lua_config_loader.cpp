@@ -194,6 +194,48 @@ int LuaConfigLoader::get_int_value(const std::string &table_name, const std::str
     return value;
 }
 
+double LuaConfigLoader::get_double_value(const std::string &table_name, const std::string &key_path) {
+    if (table_name.empty() || key_path.empty()) {
+        logger_->error("Table name *{}* or key path *{}* is empty.", table_name, key_path);
+        return 0.0;
+    }
+
+    // Split the key_path to get the last key
+    size_t last_dot = key_path.find_last_of('.');
+    std::string parent_path = "";
+    std::string last_key = key_path;
+    
+    if (last_dot != std::string::npos) {
+        parent_path = key_path.substr(0, last_dot);
+        last_key = key_path.substr(last_dot + 1);
+    }
+    
+    // Traverse to the parent table
+    if (!traverse_nested_tables(table_name, parent_path)) {
+        return 0.0;
+    }
+    
+    // Now get the value from the final table
+    lua_pushstring(luastate_, last_key.c_str());
+    lua_gettable(luastate_, -2);
+    
+    if (lua_isnil(luastate_, -1)) {
+        lua_pop(luastate_, 2); // Remove nil value and table from stack
+        return 0.0;
+    }
+    
+    // lua_isnumber also accepts numeric strings, only take real numbers
+    if (lua_type(luastate_, -1) != LUA_TNUMBER) {
+        logger_->error("Value from {}.{} is not a number.", table_name, key_path);
+        lua_pop(luastate_, 2); // Remove value and table from stack
+        return 0.0;
+    }
+    
+    double value = static_cast<double>(lua_tonumber(luastate_, -1));
+    lua_pop(luastate_, 2); // Remove value and table from stack
+    return value;
+}
+
 std::string LuaConfigLoader::get_string_value(const std::string &table_name, const std::string &key_path) {
     if (table_name.empty() || key_path.empty()) {
         logger_->error("Table name *{}* or key path *{}* is empty.", table_name, key_path);
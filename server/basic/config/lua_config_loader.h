@@ -39,6 +39,10 @@ public:
     // Support nested table access with dot notation, e.g., "a.b.c.d"
     int get_int_value(const std::string &table_name, const std::string &key_path);
 
+    // Get a number value from a Lua table, integers are converted
+    // Support nested table access with dot notation, e.g., "a.b.c.d"
+    double get_double_value(const std::string &table_name, const std::string &key_path);
+
     // Get a string value from a Lua table
     // Support nested table access with dot notation, e.g., "a.b.c.d"
     std::string get_string_value(const std::string &table_name, const std::string &key_path);
@@ -17,6 +17,7 @@ LevelEnum QuantLogger::default_log_level_ = LevelEnum::info; // Default log leve
 std::once_flag QuantLogger::init_pool_flag_; // Ensures single thread pool initialization
 bool QuantLogger::init_flag_ = false; // Flag to check if logger is initialized
 std::mutex QuantLogger::logger_mutex_; // Mutex for thread-safe access
+std::recursive_mutex QuantLogger::create_mutex_;
 std::unordered_set<std::string> QuantLogger::logger_names_; // Set of logger names to avoid duplicates
 LoggerPtr QuantLogger::g_logger_; // Global logger instance
 std::unordered_map<std::string, LevelEnum> QuantLogger::log_level_map_ = {
@@ -121,6 +122,13 @@ LoggerPtr QuantLogger::get_logger(const std::string &name, const std::string &lo
         return logger;
     }
 
+    // Another thread may be creating the same logger, registering it twice throws
+    std::lock_guard<std::recursive_mutex> create_lock(create_mutex_);
+    logger = spdlog::get(name);
+    if (logger) {
+        return logger;
+    }
+
     bool use_sync_config = false;
     LevelEnum level_config = default_log_level_;
     std::string sinks_config = quanttrader::logger::LOGGER_SINK_DAILY_FILE_TYPE;
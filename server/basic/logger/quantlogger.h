@@ -64,6 +64,7 @@ private:
     static LevelEnum default_log_level_; // Current log level
     static std::once_flag init_pool_flag_; // Ensures thread pool is initialized only once
     static std::mutex logger_mutex_; // Mutex for thread-safe logger operations
+    static std::recursive_mutex create_mutex_; // Serializes logger creation, recursive as loading the logger config creates a logger
     static std::unordered_set<std::string> logger_names_; // Set of logger names to avoid duplicates
     static LoggerPtr g_logger_; // Global logger instance
     static bool init_flag_; // Flag to check if logger is initialized
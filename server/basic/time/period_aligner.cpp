@@ -0,0 +1,166 @@
+#include "period_aligner.h"
+#include "time_util.h"
+#include "logger/quantlogger.h"
+#include <algorithm>
+
+namespace quanttrader {
+namespace time {
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1000000000LL;
+constexpr int64_t kNanosPerDay = 86400LL * kNanosPerSecond;
+// Days added past the requested ones when the table grows
+constexpr int64_t kTableMarginDays = 7;
+constexpr int64_t kTableGrowthDays = 366;
+
+int64_t floor_div(int64_t value, int64_t unit) {
+    int64_t quotient = value / unit;
+    return value % unit < 0 ? quotient - 1 : quotient;
+}
+
+}  // namespace
+
+PeriodAligner::PeriodAligner(std::string_view zone_name, std::string_view session_start, std::string_view session_end)
+    : zone_(zone_name) {
+    if (session_start.empty() && session_end.empty()) {
+        return;
+    }
+    auto start = parse_time_of_day(session_start);
+    auto end = parse_time_of_day(session_end);
+    if (!start.has_value() || !end.has_value() || start.value() == end.value()) {
+        log::Error("Invalid session '{}' to '{}', aligning to local days of {}", session_start, session_end, zone_.get_zone_name());
+        return;
+    }
+    has_session_ = true;
+    session_start_ = start.value();
+    session_end_ = end.value();
+    overnight_ = session_start_ > session_end_;
+}
+
+PeriodAligner::Range PeriodAligner::align(uint64_t time_ns, Period period, unsigned int count) {
+    int64_t day = trading_day(time_ns);
+    int64_t first = day;
+    int64_t next = day + 1;
+    switch (period) {
+        case Period::Day:
+            count = std::max(count, 1u);
+            first = floor_div(day, count) * count;
+            next = first + count;
+            break;
+        case Period::Week:
+            first = day - TimeUtil::weekday_from_days(day);
+            next = first + 7;
+            break;
+        case Period::Month: {
+            int64_t year = 0;
+            unsigned int month = 0;
+            unsigned int day_of_month = 0;
+            TimeUtil::civil_from_days(day, year, month, day_of_month);
+            first = TimeUtil::days_from_civil(year, month, 1);
+            next = month == 12 ? TimeUtil::days_from_civil(year + 1, 1, 1) : TimeUtil::days_from_civil(year, month + 1, 1);
+            break;
+        }
+    }
+    ensure_days(first, next);
+    return {day_stamp(first), day_begin(next)};
+}
+
+bool PeriodAligner::in_session(uint64_t time_ns) {
+    if (!has_session_) {
+        return true;
+    }
+    int64_t local = zone_.to_local(time_ns);
+    int64_t time_of_day = local - floor_div(local, kNanosPerDay) * kNanosPerDay;
+    if (overnight_) {
+        return time_of_day >= session_start_ || time_of_day < session_end_;
+    }
+    return time_of_day >= session_start_ && time_of_day < session_end_;
+}
+
+std::optional<int64_t> PeriodAligner::parse_time_of_day(std::string_view text) {
+    int64_t fields[3] = {0, 0, 0};
+    size_t field = 0;
+    size_t digits = 0;
+    for (char c : text) {
+        if (c == ':') {
+            if (digits == 0 || ++field > 2) {
+                return std::nullopt;
+            }
+            digits = 0;
+        } else if (c >= '0' && c <= '9' && digits < 2) {
+            fields[field] = fields[field] * 10 + (c - '0');
+            ++digits;
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (field == 0 || digits == 0 || fields[0] > 24 || fields[1] > 59 || fields[2] > 59) {
+        return std::nullopt;
+    }
+    int64_t seconds = fields[0] * 3600 + fields[1] * 60 + fields[2];
+    if (seconds > 86400) {
+        return std::nullopt;
+    }
+    return seconds * kNanosPerSecond;
+}
+
+int64_t PeriodAligner::trading_day(uint64_t time_ns) {
+    // The trading day starts at most a day before the local one
+    int64_t local_day = floor_div(zone_.to_local(time_ns), kNanosPerDay);
+    ensure_days(local_day - 1, local_day + 2);
+
+    int64_t day = local_day + 1;
+    while (time_ns < day_begin(day)) {
+        --day;
+    }
+    return day;
+}
+
+void PeriodAligner::ensure_days(int64_t first, int64_t last) {
+    int64_t table_last = first_day_ + static_cast<int64_t>(day_begin_.size()) - 1;
+    if (!day_begin_.empty() && first >= first_day_ && last <= table_last) {
+        return;
+    }
+
+    int64_t new_first = first - kTableMarginDays;
+    int64_t new_last = last + kTableGrowthDays;
+    if (!day_begin_.empty()) {
+        new_first = std::min(new_first, first_day_);
+        new_last = std::max(new_last, table_last);
+    }
+
+    std::vector<uint64_t> begins;
+    std::vector<uint64_t> stamps;
+    begins.reserve(static_cast<size_t>(new_last - new_first + 1));
+    stamps.reserve(begins.capacity());
+    for (int64_t day = new_first; day <= new_last; ++day) {
+        int64_t midnight = day * kNanosPerDay;
+        if (!has_session_) {
+            uint64_t begin = local_to_utc(midnight);
+            begins.push_back(begin);
+            stamps.push_back(begin);
+        } else if (overnight_) {
+            uint64_t begin = local_to_utc(midnight - kNanosPerDay + session_start_);
+            begins.push_back(begin);
+            stamps.push_back(begin);
+        } else {
+            begins.push_back(local_to_utc(midnight));
+            stamps.push_back(local_to_utc(midnight + session_start_));
+        }
+    }
+    first_day_ = new_first;
+    day_begin_ = std::move(begins);
+    day_stamp_ = std::move(stamps);
+}
+
+uint64_t PeriodAligner::local_to_utc(int64_t local_ns) {
+    // The offset at the local time read as UTC is off by at most one transition, correct it once.
+    // A local time skipped by DST lands next to the gap.
+    int64_t guess = local_ns - zone_.get_offset(static_cast<uint64_t>(std::max<int64_t>(local_ns, 0)));
+    int64_t utc = local_ns - zone_.get_offset(static_cast<uint64_t>(std::max<int64_t>(guess, 0)));
+    return static_cast<uint64_t>(std::max<int64_t>(utc, 0));
+}
+
+} // namespace time
+} // namespace quanttrader
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "time_boundary_tracker.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace quanttrader {
+namespace time {
+
+/**
+ * @brief Aligns timestamps to the trading days, weeks and months of an exchange
+ *
+ * A trading day is a local calendar day of the exchange timezone. A session that wraps
+ * midnight, e.g. "18:00:00" to "17:00:00", starts its trading day the evening before. Periods
+ * are stamped at the session start of their first day, like the daily bars of the broker, or
+ * at local midnight without a session.
+ *
+ * The UTC instants where the trading days begin and their session starts are kept in a table
+ * per day, grown a year at a time as the data reaches further, so aligning is a table lookup
+ * with civil date arithmetic and no time zone or libc call.
+ *
+ * Not thread safe, keep one aligner per thread.
+ */
+class PeriodAligner {
+public:
+    enum class Period {
+        Day,
+        Week,  // starts on Monday
+        Month
+    };
+
+    struct Range {
+        uint64_t start = 0;  // stamp of the period
+        uint64_t end = 0;    // where the next period begins
+    };
+
+    /**
+     * @brief Build an aligner for an exchange
+     *
+     * @param zone_name Timezone of the exchange, empty for the current zone
+     * @param session_start Local session start like "09:30:00", empty for none
+     * @param session_end Local session end like "16:00:00", empty for none
+     */
+    PeriodAligner(std::string_view zone_name, std::string_view session_start = "", std::string_view session_end = "");
+
+    /**
+     * @brief Find the period holding a timestamp
+     *
+     * @param time_ns UTC timestamp in nanoseconds
+     * @param period The calendar unit
+     * @param count Number of days per period, ignored for weeks and months
+     * @return The stamp of the period and the beginning of the next one
+     */
+    Range align(uint64_t time_ns, Period period, unsigned int count = 1);
+
+    /**
+     * @brief Whether a timestamp falls into the session, always true without a session
+     */
+    bool in_session(uint64_t time_ns);
+
+    bool has_session() const { return has_session_; }
+
+    /**
+     * @brief Parse a local time of day
+     *
+     * @param text "HH:MM:SS" or "HH:MM"
+     * @return Nanoseconds after midnight, std::nullopt if the text is not a time of day
+     */
+    static std::optional<int64_t> parse_time_of_day(std::string_view text);
+
+private:
+    // Trading day of a timestamp, in days since 1970-01-01
+    int64_t trading_day(uint64_t time_ns);
+    // Grow the table to hold the days from first to last
+    void ensure_days(int64_t first, int64_t last);
+    uint64_t local_to_utc(int64_t local_ns);
+    uint64_t day_begin(int64_t day) { return day_begin_[static_cast<size_t>(day - first_day_)]; }
+    uint64_t day_stamp(int64_t day) { return day_stamp_[static_cast<size_t>(day - first_day_)]; }
+
+    TimeBoundaryTracker zone_;
+    bool has_session_ = false;
+    bool overnight_ = false;      // the session wraps midnight
+    int64_t session_start_ = 0;   // nanoseconds after local midnight
+    int64_t session_end_ = 0;
+
+    int64_t first_day_ = 0;
+    std::vector<uint64_t> day_begin_;  // UTC instant each trading day begins
+    std::vector<uint64_t> day_stamp_;  // UTC instant of its session start
+};
+
+} // namespace time
+} // namespace quanttrader
@@ -0,0 +1,128 @@
+#include "time_boundary_tracker.h"
+#include "time_util.h"
+#include "logger/quantlogger.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+namespace quanttrader {
+namespace time {
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1000000000LL;
+constexpr int64_t kNanosPerMinute = 60LL * kNanosPerSecond;
+constexpr int64_t kNanosPerHour = 3600LL * kNanosPerSecond;
+constexpr int64_t kNanosPerDay = 86400LL * kNanosPerSecond;
+
+int64_t floor_to(int64_t value, int64_t unit) {
+    int64_t quotient = value / unit;
+    if (value % unit < 0) {
+        --quotient;
+    }
+    return quotient * unit;
+}
+
+// The zone info spans can reach far past what fits in nanoseconds
+uint64_t seconds_to_nanos(int64_t seconds) {
+    if (seconds <= 0) {
+        return 0;
+    }
+    if (seconds >= static_cast<int64_t>(std::numeric_limits<uint64_t>::max() / kNanosPerSecond)) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return static_cast<uint64_t>(seconds) * kNanosPerSecond;
+}
+
+uint64_t to_utc(int64_t local_ns, int64_t offset) {
+    int64_t utc = local_ns - offset;
+    return utc < 0 ? 0 : static_cast<uint64_t>(utc);
+}
+
+}  // namespace
+
+TimeBoundaryTracker::TimeBoundaryTracker(std::string_view zone_name) {
+#if USE_DATE_LIBRARY
+    using date::current_zone;
+    using date::locate_zone;
+#else
+    using std::chrono::current_zone;
+    using std::chrono::locate_zone;
+#endif
+    try {
+        if (zone_name.empty()) {
+            zone_ = current_zone();
+        } else {
+            auto canonical = TimeWithZone::get_canonical_zone_name(zone_name);
+            zone_ = locate_zone(std::string(canonical.empty() ? zone_name : canonical));
+        }
+    } catch (const std::runtime_error& e) {
+        log::Error("Unknown time zone '{}', tracking time changes in UTC: {}", zone_name, e.what());
+        zone_ = locate_zone("UTC");
+    }
+    zone_name_ = std::string(zone_->name());
+}
+
+TimeBoundaryTracker::Changes TimeBoundaryTracker::cross_minute(uint64_t time_ns) {
+    load_zone_info(time_ns);
+    int64_t local = static_cast<int64_t>(time_ns) + offset_;
+    int64_t minute = floor_to(local, kNanosPerMinute);
+    int64_t hour = floor_to(local, kNanosPerHour);
+    int64_t day = floor_to(local, kNanosPerDay);
+
+    Changes changes;
+    if (initialized_) {
+        changes.day = day != local_day_;
+        changes.hour = hour != local_hour_ || changes.day;
+        changes.minute = minute != local_minute_ || changes.hour;
+    }
+
+    initialized_ = true;
+    local_minute_ = minute;
+    local_hour_ = hour;
+    local_day_ = day;
+    // The minute ends early when the offset changes within it
+    minute_start_ = std::max(to_utc(minute, offset_), info_begin_);
+    minute_end_ = std::min(to_utc(minute + kNanosPerMinute, offset_), info_end_);
+    return changes;
+}
+
+void TimeBoundaryTracker::load_zone_info(uint64_t time_ns) {
+    if (time_ns >= info_begin_ && time_ns < info_end_) {
+        return;
+    }
+    using SysTime = TimeWithZone::SysTime;
+    auto info = zone_->get_info(SysTime(std::chrono::nanoseconds(time_ns)));
+    info_begin_ = seconds_to_nanos(info.begin.time_since_epoch().count());
+    info_end_ = seconds_to_nanos(info.end.time_since_epoch().count());
+    offset_ = static_cast<int64_t>(info.offset.count()) * kNanosPerSecond;
+    abbrev_ = info.abbrev;
+}
+
+int64_t TimeBoundaryTracker::get_offset(uint64_t time_ns) {
+    load_zone_info(time_ns);
+    return offset_;
+}
+
+std::string TimeBoundaryTracker::format(uint64_t time_ns) {
+    int64_t local = to_local(time_ns);
+    int64_t day = floor_to(local, kNanosPerDay);
+    int64_t of_day = local - day;
+
+    int64_t year = 0;
+    unsigned int month = 0;
+    unsigned int day_of_month = 0;
+    TimeUtil::civil_from_days(day / kNanosPerDay, year, month, day_of_month);
+
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u %02lld:%02lld:%02lld.%09lld ", static_cast<long long>(year),
+                  month, day_of_month, static_cast<long long>(of_day / kNanosPerHour),
+                  static_cast<long long>(of_day % kNanosPerHour / kNanosPerMinute),
+                  static_cast<long long>(of_day % kNanosPerMinute / kNanosPerSecond),
+                  static_cast<long long>(of_day % kNanosPerSecond));
+    return buffer + abbrev_;
+}
+
+} // namespace time
+} // namespace quanttrader
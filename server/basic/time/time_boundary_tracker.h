@@ -0,0 +1,117 @@
+#pragma once
+
+#include "time_with_zone.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace quanttrader {
+namespace time {
+
+/**
+ * @brief Detects local minute, hour and day changes of a stream of UTC timestamps
+ *
+ * The zone is resolved once. The tracker keeps the UTC span of the local minute in progress,
+ * clipped to the span where the zone's offset is constant, so a timestamp inside it costs two
+ * compares. Crossing it floors the local time again with the cached offset, looking the zone
+ * up only when a DST transition is passed. Changes follow the local wall clock: the repeated
+ * hour when DST ends is not a new hour.
+ *
+ * Not thread safe, keep one tracker per thread.
+ */
+class TimeBoundaryTracker {
+public:
+    struct Changes {
+        bool day = false;
+        bool hour = false;    // also set when the day changed
+        bool minute = false;  // also set when the hour changed
+    };
+
+    /**
+     * @brief Resolve the zone
+     *
+     * @param zone_name IANA or legacy zone name like "US/Eastern", empty for the current zone.
+     *                  An unknown zone falls back to UTC with an error logged.
+     */
+    explicit TimeBoundaryTracker(std::string_view zone_name = "");
+
+    /**
+     * @brief Move to the next timestamp
+     *
+     * @param time_ns UTC timestamp in nanoseconds
+     * @return What changed since the previous timestamp, nothing for the first one
+     */
+    Changes advance(uint64_t time_ns) {
+        if (initialized_ && time_ns >= minute_start_ && time_ns < minute_end_) {
+            return {};
+        }
+        return cross_minute(time_ns);
+    }
+
+    /**
+     * @brief Forget the previous timestamp, e.g. when a replay is rewound
+     */
+    void reset() { initialized_ = false; }
+
+    bool is_initialized() const { return initialized_; }
+
+    /**
+     * @brief End of the UTC span sharing the current local minute, the next time advance does work
+     */
+    uint64_t get_next_boundary() const { return initialized_ ? minute_end_ : 0; }
+
+    /**
+     * @brief Offset of the local time from UTC in nanoseconds
+     *
+     * @param time_ns UTC timestamp in nanoseconds
+     * @return The offset, negative west of Greenwich
+     */
+    int64_t get_offset(uint64_t time_ns);
+
+    /**
+     * @brief Local wall clock time in nanoseconds since the local epoch
+     */
+    int64_t to_local(uint64_t time_ns) { return static_cast<int64_t>(time_ns) + get_offset(time_ns); }
+
+    /**
+     * @brief Format like TimeWithZone::to_string_with_name, "2024-03-10 03:00:00.000000000 EDT"
+     *
+     * @param time_ns UTC timestamp in nanoseconds
+     * @return The local time with the zone abbreviation
+     */
+    std::string format(uint64_t time_ns);
+
+    const std::string& get_zone_name() const { return zone_name_; }
+
+private:
+#if USE_DATE_LIBRARY
+    using TimeZone = date::time_zone;
+#else
+    using TimeZone = std::chrono::time_zone;
+#endif
+
+    Changes cross_minute(uint64_t time_ns);
+    // Load the offset span holding the timestamp unless it is the cached one
+    void load_zone_info(uint64_t time_ns);
+
+    std::string zone_name_;
+    const TimeZone* zone_ = nullptr;
+
+    // Span of the cached zone info, where the offset and abbreviation hold
+    uint64_t info_begin_ = 0;
+    uint64_t info_end_ = 0;
+    int64_t offset_ = 0;
+    std::string abbrev_;
+
+    // Local minute in progress, as a UTC span and as local floors
+    bool initialized_ = false;
+    uint64_t minute_start_ = 0;
+    uint64_t minute_end_ = 0;
+    int64_t local_minute_ = 0;
+    int64_t local_hour_ = 0;
+    int64_t local_day_ = 0;
+};
+
+} // namespace time
+} // namespace quanttrader
@@ -54,115 +54,96 @@ public:
         return hours_epoch * ns_per_hour;
     }
     
+    /**
+     * @brief Days since 1970-01-01 of a civil date, see https://howardhinnant.github.io/date_algorithms.html
+     * 
+     * @param year The year
+     * @param month The month, 1 to 12
+     * @param day The day of the month, 1 to 31
+     * @return Days since the epoch, negative before it
+     */
+    static constexpr int64_t days_from_civil(int64_t year, unsigned int month, unsigned int day) {
+        year -= month <= 2 ? 1 : 0;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned int year_of_era = static_cast<unsigned int>(year - era * 400);
+        const unsigned int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+    }
+
+    /**
+     * @brief Civil date of a day since 1970-01-01, the inverse of days_from_civil
+     * 
+     * @param days Days since the epoch
+     * @param year The year
+     * @param month The month, 1 to 12
+     * @param day The day of the month, 1 to 31
+     */
+    static constexpr void civil_from_days(int64_t days, int64_t& year, unsigned int& month, unsigned int& day) {
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned int day_of_era = static_cast<unsigned int>(days - era * 146097);
+        const unsigned int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        const unsigned int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        const unsigned int month_index = (5 * day_of_year + 2) / 153;
+        day = day_of_year - (153 * month_index + 2) / 5 + 1;
+        month = month_index < 10 ? month_index + 3 : month_index - 9;
+        year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2 ? 1 : 0);
+    }
+
+    /**
+     * @brief Day of the week of a day since 1970-01-01
+     * 
+     * @param days Days since the epoch
+     * @return 0 for Monday to 6 for Sunday
+     */
+    static constexpr unsigned int weekday_from_days(int64_t days) {
+        // 1970-01-01 is a Thursday
+        return static_cast<unsigned int>(days >= -3 ? (days + 3) % 7 : (days + 4) % 7 + 6);
+    }
+
     /**
      * @brief Align a timestamp to the start of a day period
      * 
+     * Days are UTC calendar days, use PeriodAligner for the days of an exchange.
+     * 
      * @param time_ns Timestamp in nanoseconds
      * @param days The number of days in the period
      * @return Aligned timestamp in nanoseconds
      */
     static uint64_t align_to_day(uint64_t time_ns, unsigned int days = 1) {
-        // Convert to time_t (seconds)
-        time_t time_secs = static_cast<time_t>(time_ns / 1000000000ULL);
-        
-        // Convert to calendar time (thread-safe version)
-        std::tm cal_time = {};
-#ifdef _WIN32
-        gmtime_s(&cal_time, &time_secs);
-#else
-        gmtime_r(&time_secs, &cal_time);
-#endif
-        
-        // Reset to start of day
-        cal_time.tm_hour = 0;
-        cal_time.tm_min = 0;
-        cal_time.tm_sec = 0;
-        
-        // Convert back to time_t
-        time_t day_start = std::mktime(&cal_time);
-        
-        // Align to multi-day period if necessary
-        if (days > 1) {
-            // Get the day of the epoch (days since Jan 1, 1970)
-            const time_t seconds_per_day = 86400;
-            time_t days_since_epoch = day_start / seconds_per_day;
-            
-            // Align to the period
-            days_since_epoch = (days_since_epoch / days) * days;
-            
-            // Convert back to seconds
-            day_start = days_since_epoch * seconds_per_day;
-        }
-        
-        // Convert to nanoseconds
-        return static_cast<uint64_t>(day_start) * 1000000000ULL;
+        constexpr uint64_t ns_per_day = 86400ULL * 1000000000ULL;
+        uint64_t days_epoch = time_ns / ns_per_day;
+        days_epoch = (days_epoch / days) * days;
+        return days_epoch * ns_per_day;
     }
     
     /**
-     * @brief Align a timestamp to the start of a week
+     * @brief Align a timestamp to the start of a week, weeks start on Monday in UTC
      * 
      * @param time_ns Timestamp in nanoseconds
      * @return Aligned timestamp in nanoseconds
      */
     static uint64_t align_to_week(uint64_t time_ns) {
-        // Convert to time_t (seconds)
-        time_t time_secs = static_cast<time_t>(time_ns / 1000000000ULL);
-        
-        // Convert to calendar time (thread-safe version)
-        std::tm cal_time = {};
-#ifdef _WIN32
-        gmtime_s(&cal_time, &time_secs);
-#else
-        gmtime_r(&time_secs, &cal_time);
-#endif
-        
-        // Reset to start of day
-        cal_time.tm_hour = 0;
-        cal_time.tm_min = 0;
-        cal_time.tm_sec = 0;
-        
-        // Calculate days since start of week (assuming Monday is start of week)
-        int day_of_week = cal_time.tm_wday;
-        if (day_of_week == 0) day_of_week = 7;  // Convert Sunday (0) to 7
-        day_of_week -= 1;  // Adjust to make Monday = 0
-        
-        // Go back to the start of the week
-        time_t day_start = std::mktime(&cal_time);
-        time_t week_start = day_start - (day_of_week * 86400);
-        
-        // Convert to nanoseconds
-        return static_cast<uint64_t>(week_start) * 1000000000ULL;
+        constexpr uint64_t ns_per_day = 86400ULL * 1000000000ULL;
+        int64_t days_epoch = static_cast<int64_t>(time_ns / ns_per_day);
+        int64_t monday = days_epoch - weekday_from_days(days_epoch);
+        return monday < 0 ? 0 : static_cast<uint64_t>(monday) * ns_per_day;
     }
     
     /**
-     * @brief Align a timestamp to the start of a month
+     * @brief Align a timestamp to the start of a month in UTC
      * 
      * @param time_ns Timestamp in nanoseconds
      * @return Aligned timestamp in nanoseconds
      */
     static uint64_t align_to_month(uint64_t time_ns) {
-        // Convert to time_t (seconds)
-        time_t time_secs = static_cast<time_t>(time_ns / 1000000000ULL);
-        
-        // Convert to calendar time (thread-safe version)
-        std::tm cal_time = {};
-#ifdef _WIN32
-        gmtime_s(&cal_time, &time_secs);
-#else
-        gmtime_r(&time_secs, &cal_time);
-#endif
-        
-        // Reset to start of month
-        cal_time.tm_mday = 1;
-        cal_time.tm_hour = 0;
-        cal_time.tm_min = 0;
-        cal_time.tm_sec = 0;
-        
-        // Convert back to time_t
-        time_t month_start = std::mktime(&cal_time);
-        
-        // Convert to nanoseconds
-        return static_cast<uint64_t>(month_start) * 1000000000ULL;
+        constexpr uint64_t ns_per_day = 86400ULL * 1000000000ULL;
+        int64_t year = 0;
+        unsigned int month = 0;
+        unsigned int day = 0;
+        civil_from_days(static_cast<int64_t>(time_ns / ns_per_day), year, month, day);
+        return static_cast<uint64_t>(days_from_civil(year, month, 1)) * ns_per_day;
     }
 };
 
@@ -7,6 +7,43 @@
 namespace quanttrader {
 namespace broker {
 
+namespace {
+
+void write_order(StateWriter& writer, const Order& order) {
+    writer.write(static_cast<int64_t>(order.order_id));
+    writer.write(order.symbol);
+    writer.write(order.side);
+    writer.write(order.type);
+    writer.write(order.quantity);
+    writer.write(order.price);
+    writer.write(order.stop_price);
+    writer.write(order.status);
+    writer.write(order.filled_quantity);
+    writer.write(order.remaining_quantity);
+    writer.write(order.timestamp);
+    writer.write(order.error_message);
+}
+
+bool read_order(StateReader& reader, Order& order) {
+    int64_t order_id = 0;
+    reader.read(order_id);
+    order.order_id = static_cast<long>(order_id);
+    reader.read(order.symbol);
+    reader.read(order.side);
+    reader.read(order.type);
+    reader.read(order.quantity);
+    reader.read(order.price);
+    reader.read(order.stop_price);
+    reader.read(order.status);
+    reader.read(order.filled_quantity);
+    reader.read(order.remaining_quantity);
+    reader.read(order.timestamp);
+    reader.read(order.error_message);
+    return reader.ok();
+}
+
+} // namespace
+
 AbstractBroker::AbstractBroker(double starting_cash) : account_info_(starting_cash) {
     logger_ = quanttrader::log::get_common_rotation_logger("AbstractBroker", "broker");
     logger_->info("Initialized AbstractBroker with starting cash: {}", starting_cash);
@@ -434,5 +471,145 @@ std::string AbstractBroker::order_status_to_string(OrderStatus status) const {
     }
 }
 
+void AbstractBroker::checkpoint(StateWriter& writer) const {
+    writer.write(account_info_.cash);
+    writer.write(account_info_.equity);
+    writer.write(account_info_.buying_power);
+    writer.write(account_info_.maintenance_margin);
+    writer.write(account_info_.initial_margin);
+    writer.write(account_info_.unrealized_pnl);
+    writer.write(account_info_.realized_pnl);
+    writer.write(static_cast<int64_t>(next_order_id_));
+
+    // By id, so equal states give equal checkpoints
+    std::vector<long> order_ids;
+    order_ids.reserve(orders_.size());
+    for (const auto& [order_id, order] : orders_) {
+        order_ids.push_back(order_id);
+    }
+    std::sort(order_ids.begin(), order_ids.end());
+    writer.write<uint64_t>(order_ids.size());
+    for (long order_id : order_ids) {
+        write_order(writer, orders_.at(order_id));
+    }
+
+    writer.write<uint64_t>(positions_.size());
+    for (const auto& [symbol, position] : positions_) {
+        writer.write(symbol);
+        writer.write(position.quantity);
+        writer.write(position.avg_price);
+        writer.write(position.unrealized_pnl);
+        writer.write(position.realized_pnl);
+    }
+
+    writer.write<uint64_t>(trades_.size());
+    for (const auto& trade : trades_) {
+        writer.write(static_cast<int64_t>(trade.order_id));
+        writer.write(trade.symbol);
+        writer.write(trade.side);
+        writer.write(trade.quantity);
+        writer.write(trade.price);
+        writer.write(trade.timestamp);
+        writer.write(trade.commission);
+    }
+
+    writer.write<uint64_t>(last_prices_.size());
+    for (const auto& [symbol, price] : last_prices_) {
+        writer.write(symbol);
+        writer.write(price);
+    }
+}
+
+std::function<void()> AbstractBroker::stage_restore(StateReader& reader) {
+    AccountInfo account_info;
+    reader.read(account_info.cash);
+    reader.read(account_info.equity);
+    reader.read(account_info.buying_power);
+    reader.read(account_info.maintenance_margin);
+    reader.read(account_info.initial_margin);
+    reader.read(account_info.unrealized_pnl);
+    reader.read(account_info.realized_pnl);
+    int64_t next_order_id = 0;
+    reader.read(next_order_id);
+
+    uint64_t count = 0;
+    std::unordered_map<long, Order> orders;
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        Order order;
+        if (read_order(reader, order)) {
+            orders[order.order_id] = std::move(order);
+        }
+    }
+
+    std::map<std::string, Position> positions;
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        Position position;
+        reader.read(position.symbol);
+        reader.read(position.quantity);
+        reader.read(position.avg_price);
+        reader.read(position.unrealized_pnl);
+        reader.read(position.realized_pnl);
+        positions[position.symbol] = position;
+    }
+
+    std::vector<Trade> trades;
+    reader.read_count(count);
+    trades.reserve(reader.ok() ? count : 0);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        int64_t order_id = 0;
+        std::string symbol;
+        OrderSide side = OrderSide::BUY;
+        double quantity = 0.0;
+        double price = 0.0;
+        uint64_t timestamp = 0;
+        double commission = 0.0;
+        reader.read(order_id);
+        reader.read(symbol);
+        reader.read(side);
+        reader.read(quantity);
+        reader.read(price);
+        reader.read(timestamp);
+        reader.read(commission);
+        trades.emplace_back(static_cast<long>(order_id), symbol, side, quantity, price, timestamp, commission);
+    }
+
+    std::map<std::string, double> last_prices;
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        std::string symbol;
+        double price = 0.0;
+        reader.read(symbol);
+        reader.read(price);
+        last_prices[symbol] = price;
+    }
+
+    if (!reader.ok()) {
+        logger_->error("Malformed broker state in the checkpoint");
+        return {};
+    }
+    return [this, account_info, next_order_id, orders = std::move(orders), positions = std::move(positions),
+            trades = std::move(trades), last_prices = std::move(last_prices)]() mutable {
+        account_info_ = account_info;
+        next_order_id_ = static_cast<long>(next_order_id);
+        orders_ = std::move(orders);
+        positions_ = std::move(positions);
+        trades_ = std::move(trades);
+        last_prices_ = std::move(last_prices);
+        logger_->info("Restored {} orders, {} positions and {} trades, equity {}", orders_.size(), positions_.size(),
+                      trades_.size(), account_info_.equity);
+    };
+}
+
+bool AbstractBroker::restore(StateReader& reader) {
+    auto apply = stage_restore(reader);
+    if (!apply) {
+        return false;
+    }
+    apply();
+    return true;
+}
+
 } // namespace broker
 } // namespace quanttrader
@@ -8,6 +8,7 @@
 #include <optional>
 #include <functional>
 #include "logger/quantlogger.h"
+#include "common/state_archive.h"
 
 namespace quanttrader {
 namespace broker {
@@ -167,6 +168,26 @@ public:
     // Utility methods
     virtual long get_next_order_id() { return next_order_id_++; }
     virtual void reset_account(double starting_cash);
+
+    /**
+     * @brief Write the account, orders, positions, trades and last prices to a checkpoint
+     */
+    virtual void checkpoint(StateWriter& writer) const;
+
+    /**
+     * @brief Read a state written by checkpoint without changing the broker
+     *
+     * @return A function replacing the state with the one read, the callbacks and provider are kept.
+     *         Empty if the state is malformed.
+     */
+    virtual std::function<void()> stage_restore(StateReader& reader);
+
+    /**
+     * @brief Replace the state with one written by checkpoint, see stage_restore
+     *
+     * @return false if the state is malformed, the broker is unchanged then
+     */
+    bool restore(StateReader& reader);
     
 protected:
     // Internal order processing
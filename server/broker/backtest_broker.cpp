@@ -174,5 +174,25 @@ void BacktestBroker::check_margin_requirements() {
     }
 }
 
+void BacktestBroker::checkpoint(StateWriter& writer) const {
+    writer.write(current_timestamp_);
+    AbstractBroker::checkpoint(writer);
+}
+
+std::function<void()> BacktestBroker::stage_restore(StateReader& reader) {
+    uint64_t current_timestamp = 0;
+    if (!reader.read(current_timestamp)) {
+        return {};
+    }
+    auto apply = AbstractBroker::stage_restore(reader);
+    if (!apply) {
+        return {};
+    }
+    return [this, current_timestamp, apply = std::move(apply)]() {
+        apply();
+        current_timestamp_ = current_timestamp;
+    };
+}
+
 } // namespace broker
 } // namespace quanttrader
@@ -35,6 +35,10 @@ public:
     long place_order(const std::string& symbol, OrderSide side, OrderType type, 
                     double quantity, double price, double stop_price, uint64_t timestamp) override;
 
+    // Adds the replay time to the state of AbstractBroker
+    void checkpoint(StateWriter& writer) const override;
+    std::function<void()> stage_restore(StateReader& reader) override;
+
 private:
     // Backtesting parameters
     double commission_per_trade_ = 0.0;
@@ -86,6 +86,8 @@ public:
     virtual void registerTradeCallback(TradeCallback callback) = 0;
     virtual void registerOrderStatusCallback(OrderStatusCallback callback) = 0;
     virtual void registerErrorCallback(ErrorCallback callback) = 0;
+    // Errors of one request, e.g. a historical data pacing violation; an empty callback removes it
+    virtual void registerRequestErrorCallback(long requestId, ErrorCallback callback) = 0;
     
     // Contract details methods
     virtual long requestContractDetails(
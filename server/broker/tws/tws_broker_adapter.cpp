@@ -251,6 +251,15 @@ void TwsBrokerAdapter::registerOrderStatusCallback(OrderStatusCallback callback)
     orderStatusCallback_ = callback;
 }
 
+void TwsBrokerAdapter::registerRequestErrorCallback(long requestId, ErrorCallback callback) {
+    std::lock_guard<std::mutex> lock(requestErrorMutex_);
+    if (callback) {
+        requestErrorCallbacks_[requestId] = std::move(callback);
+    } else {
+        requestErrorCallbacks_.erase(requestId);
+    }
+}
+
 void TwsBrokerAdapter::registerErrorCallback(ErrorCallback callback) {
     errorCallback_ = callback;
 }
@@ -661,6 +670,17 @@ void TwsBrokerAdapter::distributeResponse(std::atomic<int> &twsVersion) {
         logger_->debug("Received response: {}", static_cast<int>(responsePtr->response_type));
         if (responsePtr->response_type == MessageType::ERROR_MSG) {
             auto errorResponse = std::dynamic_pointer_cast<ResErrorMsg>(responsePtr);
+            ErrorCallback requestCallback = nullptr;
+            if (errorResponse) {
+                std::lock_guard<std::mutex> lock(requestErrorMutex_);
+                auto iter = requestErrorCallbacks_.find(errorResponse->request_id);
+                if (iter != requestErrorCallbacks_.end()) {
+                    requestCallback = iter->second;
+                }
+            }
+            if (requestCallback) {
+                requestCallback(errorResponse->error_code, errorResponse->error_string);
+            }
             if (errorResponse && errorCallback_) {
                 errorCallback_(errorResponse->error_code, errorResponse->error_string);
             }
@@ -12,6 +12,7 @@
 #include <string>
 #include <memory>
 #include <thread>
+#include <mutex>
 #include <atomic>
 #include <unordered_map>
 #include <optional>
@@ -75,6 +76,7 @@ public:
     void registerTradeCallback(TradeCallback callback) override;
     void registerOrderStatusCallback(OrderStatusCallback callback) override;
     void registerErrorCallback(ErrorCallback callback) override;
+    void registerRequestErrorCallback(long requestId, ErrorCallback callback) override;
     void registerContractDetailsCallback(long requestId, std::function<void(const ContractDetails&)> callback);
 
     long requestContractDetails(
@@ -166,6 +168,8 @@ private:
     TradeCallback tradeCallback_ = nullptr;
     OrderStatusCallback orderStatusCallback_ = nullptr;
     ErrorCallback errorCallback_ = nullptr;
+    std::unordered_map<TickerId, ErrorCallback> requestErrorCallbacks_;
+    std::mutex requestErrorMutex_;  // registered by data feeds while the response thread reads
 
     // Storage for contract details
     std::unordered_map<std::string, ContractDetails> contractDetails_;
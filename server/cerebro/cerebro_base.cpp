@@ -1,5 +1,6 @@
 #include "cerebro_base.h"
 #include "broker/backtest_broker.h"
+#include <limits>
 #include <thread>
 
 namespace quanttrader {
@@ -10,6 +11,7 @@ CerebroBase::CerebroBase(const std::string_view name)
     logger_ = quanttrader::log::get_common_rotation_logger(name_, "cerebro");
     logger_->info("Created cerebro: {}", name_);
     replay_controller_ = std::make_shared<data::replay::DataReplayController>();
+    pacing_policy_ = std::make_shared<UnthrottledPacing>();
     observers_.push_back(std::make_shared<observer::PerformanceObserver>());
 }
 
@@ -24,7 +26,8 @@ bool CerebroBase::add_data(const std::string& name, std::shared_ptr<data::provid
         return false;
     }
     
-    if (is_running_) {
+    // The feed slots of a paused run keep the views of the feeds that ticked
+    if (is_running_ || is_paused_) {
         logger_->error("{} Cannot add data provider while cerebro is running", name_);
         return false;
     }
@@ -59,6 +62,13 @@ bool CerebroBase::add_strategy(std::shared_ptr<strategy::StrategyBase> strategy)
     for (auto& obs : observers_) {
         strategy->add_observer(obs);
     }
+
+    // Strategies of a paused run are started already, a new one joins them
+    if (is_paused_ && !strategy->on_start()) {
+        logger_->error("{} Failed to start strategy: {}", name_, strategy->get_name());
+        strategies_.pop_back();
+        return false;
+    }
     logger_->info("{} Added strategy: {}", name_, strategy->get_name());
     return true;
 }
@@ -110,6 +120,40 @@ void CerebroBase::set_replay_mode(data::provider::DataProvider::ReplayMode mode)
     logger_->info("{} Set replay mode to: {}", name_, static_cast<int>(mode));
 }
 
+void CerebroBase::set_pacing_policy(std::shared_ptr<PacingPolicy> policy) {
+    if (!policy) {
+        logger_->error("{} Cannot set null pacing policy", name_);
+        return;
+    }
+    if (is_running_) {
+        logger_->error("{} Cannot change pacing policy while running", name_);
+        return;
+    }
+    pacing_policy_ = policy;
+    if (is_prepared_) {
+        bind_data_listeners();
+    }
+    if (is_paused_) {
+        pacing_policy_->on_start();
+    }
+    logger_->info("{} Set pacing policy to: {}", name_, pacing_policy_->name());
+}
+
+void CerebroBase::pin_view(FeedSlot& slot, size_t count) {
+    // Read the generation first, a change racing the pin only pins the view once more next step
+    slot.generation = slot.provider->get_bar_generation();
+    auto pinned = slot.provider->pin_bar_view(count);
+    *slot.view = pinned.view;
+    slot.pin = std::move(pinned.owner);
+}
+
+void CerebroBase::bind_data_listeners() {
+    // Let providers wake the event loop when new bars arrive
+    for (const auto& [name, provider] : replay_controller_->get_providers()) {
+        provider->set_data_listener([policy = pacing_policy_]() { policy->notify_data(); });
+    }
+}
+
 void CerebroBase::next_step() {
     replay_controller_->next_step();
 }
@@ -161,6 +205,42 @@ bool CerebroBase::resample_data(const std::string& name, data::BarType target_ty
     return true;
 }
 
+bool CerebroBase::resample_data(const std::string& name, const std::vector<std::pair<data::BarType, unsigned int>>& targets) {
+    auto provider = replay_controller_->get_data_provider(name);
+    if (!provider) {
+        logger_->error("{} Data provider not found for resampling: {}", name_, name);
+        return false;
+    }
+
+    auto resampled_providers = provider->resample(targets);
+    if (resampled_providers.empty()) {
+        logger_->error("{} Failed to resample data provider: {} to {} timeframes", name_, name, targets.size());
+        return false;
+    }
+
+    // The original provider is read through the resampled ones
+    if (!replay_controller_->remove_data_provider(name)) {
+        logger_->error("{} Failed to remove original data provider during resampling: {}", name_, name);
+        return false;
+    }
+
+    for (size_t i = 0; i < resampled_providers.size(); ++i) {
+        const auto& resampled = resampled_providers[i];
+        if (!replay_controller_->add_data_provider(resampled->get_data_name(), resampled)) {
+            logger_->error("{} Failed to add resampled data provider: {}", name_, resampled->get_data_name());
+            // Try to restore the original provider
+            for (size_t j = 0; j < i; ++j) {
+                replay_controller_->remove_data_provider(resampled_providers[j]->get_data_name());
+            }
+            replay_controller_->add_data_provider(name, provider);
+            return false;
+        }
+        logger_->info("{} Resampled data provider: {} for symbol: {} to {}", name_, name, provider->get_symbol(),
+                      resampled->get_data_name());
+    }
+    return true;
+}
+
 bool CerebroBase::prepare() {
     if (is_prepared_) {
         return true;
@@ -193,6 +273,7 @@ bool CerebroBase::prepare() {
         for (auto& observer : observers_) {
             auto performance_observer = std::dynamic_pointer_cast<observer::PerformanceObserver>(observer);
             if (performance_observer) {
+                performance_observer->set_starting_cash(backtest_config_.starting_cash);
                 performance_observer->set_broker(broker_);
             }
         }
@@ -231,29 +312,21 @@ bool CerebroBase::prepare() {
         }
     }
 
-    // Wait for all data to be ready
-    int wait_time = 0;
-    const int max_wait_time = static_cast<int>(wait_data_timeout_ / 1000);  // seconds
-    bool all_ready = false;
-
-    while (wait_time < max_wait_time) {
-        if (replay_controller_->all_data_ready()) {
-            all_ready = true;
-            break;
-        }
-
-        logger_->info("{} Waiting for data providers to be ready, elapsed: {}s", name_, wait_time);
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        wait_time++;
-    }
-
-    if (!all_ready) {
-        logger_->error("{} Timed out({} seconds) waiting for data providers to be ready", name_, max_wait_time);
+    // Wait for all data to be ready, the wait ends when the last provider is
+    logger_->info("{} Waiting for data providers to be ready", name_);
+    auto wait_started = std::chrono::steady_clock::now();
+    if (!replay_controller_->wait_all_data_ready(std::chrono::milliseconds(wait_data_timeout_))) {
+        logger_->error("{} Data providers failed or timed out({} seconds) getting ready", name_, wait_data_timeout_ / 1000);
         return false;
     }
+    logger_->info("{} Data providers ready after waiting {} ms", name_,
+                  std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - wait_started).count());
+
+    // Views are created when a feed first ticks
+    bar_views_.clear();
+    bind_feed_slots();
 
-    // Initialize cached BarSeries for all data providers
-    cached_bar_series_.clear();
+    bind_data_listeners();
 
     is_prepared_ = true;
     logger_->info("CerebroBase {} preparation completed successfully", name_);
@@ -261,52 +334,57 @@ bool CerebroBase::prepare() {
 }
 
 bool CerebroBase::stop() {
-    if (!is_running_) {
+    // Wake the event loop first, it may wait for data or not have started running yet
+    stop_flag_.store(true);
+    pacing_policy_->interrupt();
+
+    if (!is_running_ && !is_paused_) {
         logger_->warn("{} CerebroBase is not running", name_);
         return true;
     }
     
-    stop_flag_.store(true);
-    
     // Stop all data providers
     replay_controller_->stop();
     
-    // Clear cached data for clean restart
-    cached_bar_series_.clear();
-    
-    // Close all strategies
-    for (auto& strategy : strategies_) {
-        strategy->on_stop();
+    // Clear cached views for clean restart
+    bar_views_.clear();
+    for (auto& slot : feed_slots_) {
+        slot.view = nullptr;
+        slot.pin.reset();
     }
     
+    // Close the strategies unless the run finished and closed them
+    stop_strategies();
+    
     // Observer reports
     for (const auto& observer : observers_) {
         observer->report();
     }
     
     is_running_ = false;
+    is_paused_ = false;
     logger_->info("{} CerebroBase stopped successfully", name_);
     return true;
 }
 
-void CerebroBase::update_cached_bar_series(const std::string& data_provider_name, const std::optional<data::BarStruct>& new_bar) {
-    if (!new_bar.has_value()) {
-        return;
+void CerebroBase::bind_feed_slots() {
+    size_t count = replay_controller_->get_feed_count();
+    price_map_.clear();
+    feed_slots_.clear();
+    feed_slots_.resize(count);
+    last_ticked_.clear();
+    last_ticked_.reserve(count);
+
+    for (data::replay::FeedId id = 0; id < count; ++id) {
+        auto& slot = feed_slots_[id];
+        slot.name = replay_controller_->get_feed_name(id);
+        slot.provider = replay_controller_->get_feed_provider(id).get();
+        slot.symbol = slot.provider->get_symbol();
+
+        // Allocate the price map node once, process_next only moves it in and out of the map
+        auto it = price_map_.try_emplace(slot.symbol, 0.0).first;
+        slot.price_node = price_map_.extract(it);
     }
-    
-    const auto& bar = new_bar.value();
-    
-    // Get or create the cached series for this data provider
-    auto& series = cached_bar_series_[data_provider_name];
-    
-    // Add the new bar data to the series
-    series.start_time.push_back(bar.time);
-    series.open.push_back(bar.open);
-    series.high.push_back(bar.high);
-    series.low.push_back(bar.low);
-    series.close.push_back(bar.close);
-    series.volume.push_back(bar.volume);
-    series.count.push_back(bar.count);
 }
 
 bool CerebroBase::process_next() {
@@ -317,69 +395,96 @@ bool CerebroBase::process_next() {
     
     // Check if we have more data
     if (!replay_controller_->has_more_data()) {
-        logger_->info("{} No more data to process", name_);
+        logger_->debug("{} No more data to process", name_);
         return false;
     }
     
+    // Drop the pins of the feeds ticked last step, the merge pulls their next bars and should not copy pinned columns
+    for (auto id : last_ticked_) {
+        feed_slots_[id].pin.reset();
+    }
+    last_ticked_.clear();
+
     // Get next synchronized data points
-    auto sync_result = replay_controller_->next_synchronized();
-    if (sync_result.data.empty()) {
-        logger_->info("{} Empty data returned from replay controller", name_);
+    const auto& sync_result = replay_controller_->next_synchronized();
+    if (!sync_result.has_result) {
+        logger_->debug("{} Empty data returned from replay controller", name_);
         return false;
     }
+
+    if (feed_slots_.size() != replay_controller_->get_feed_count()) {
+        bind_feed_slots();
+    }
     
-    // Update our historical data storage with the new data points
-    for (const auto& [name, bar] : sync_result.data) {
-        if (historical_data_.find(name) == historical_data_.end()) {
-            historical_data_[name] = std::vector<std::optional<data::BarStruct>>();
+    // Pin the views of the ticked feeds over their provider's bars, nothing is copied
+    for (auto id : sync_result.ticked) {
+        auto& slot = feed_slots_[id];
+        if (!slot.view) {
+            slot.view = &bar_views_[slot.name];
+        }
+        pin_view(slot, replay_controller_->get_emitted_count(id));
+        last_ticked_.push_back(id);
+    }
+
+    // The other views keep their pins, so their bars stay alive whatever the feeds store. Only the
+    // feeds whose stored bars were moved or overwritten since, e.g. by late bars or a live feed
+    // thread, are pinned again to show the current bars.
+    for (data::replay::FeedId id = 0; id < feed_slots_.size(); ++id) {
+        auto& slot = feed_slots_[id];
+        if (slot.view && slot.pin && slot.generation != slot.provider->get_bar_generation()) {
+            pin_view(slot, replay_controller_->get_emitted_count(id));
         }
-        historical_data_[name].push_back(bar);
-        
-        // Update cached BarSeries for efficient strategy access
-        update_cached_bar_series(name, bar);
     }
     
-    // Feed the cached BarSeries directly to all strategies (readonly access)
+    pacing_policy_->pace(sync_result.current_time, sync_result.ticked.size());
+    
+    // Feed the views directly to all strategies (readonly access)
     for (auto& strategy : strategies_) {
-        strategy->on_data_series(cached_bar_series_, sync_result.day_changed, 
+        strategy->on_data_series(bar_views_, sync_result.day_changed, 
                                  sync_result.hour_changed, sync_result.minute_changed);
     }
 
-    std::map<std::string, double> price_map;
-    for (const auto& [name, bar] : sync_result.data) {
-        if (bar.has_value()) {
-            auto provider = replay_controller_->get_data_provider(name);
-            if (provider) {
-                price_map[provider->get_symbol()] = bar->close;
-            }
+    // Lend each ticked feed's node to the price map, ticked feeds come in name order so the last one wins on a shared symbol
+    for (auto id : sync_result.ticked) {
+        auto& slot = feed_slots_[id];
+        double close = sync_result.bars[id]->close;
+        slot.price_node.mapped() = close;
+        auto inserted = price_map_.insert(std::move(slot.price_node));
+        if (!inserted.inserted) {
+            inserted.position->second = close;
+            slot.price_node = std::move(inserted.node);
         }
     }
     
     // Update broker with market prices
     if (broker_) {
-        broker_->update_market_prices(price_map);
+        broker_->update_market_prices(price_map_);
         
         // If using backtest broker, process market data
         auto backtest_broker = std::dynamic_pointer_cast<broker::BacktestBroker>(broker_);
         if (backtest_broker) {
-            backtest_broker->process_market_data(sync_result.current_time, price_map);
+            backtest_broker->process_market_data(sync_result.current_time, price_map_);
         }
     }
     
     for (auto& obs : observers_) {
-        obs->update_market_value(sync_result.current_time, price_map);
+        obs->update_market_value(sync_result.current_time, price_map_);
+    }
+
+    // Take the nodes back so the map is empty for the next step
+    for (auto id : sync_result.ticked) {
+        auto& slot = feed_slots_[id];
+        if (slot.price_node.empty()) {
+            slot.price_node = price_map_.extract(slot.symbol);
+        }
     }
 
     return true;
 }
 
-bool CerebroBase::run() {
-    if (!prepare()) {
-        logger_->error("{} Failed to prepare for execution", name_);
-        return false;
-    }
-    
+bool CerebroBase::start_run() {
     is_running_ = true;
+    strategies_started_ = true;
     logger_->info("{} Starting execution...", name_);
     
     // Initialize all strategies
@@ -389,22 +494,67 @@ bool CerebroBase::run() {
             return false;
         }
     }
+    pacing_policy_->on_start();
+    return true;
+}
+
+void CerebroBase::stop_strategies() {
+    if (!strategies_started_) {
+        return;
+    }
+    strategies_started_ = false;
+    for (auto& strategy : strategies_) {
+        strategy->on_stop();
+    }
+}
+
+bool CerebroBase::run() {
+    return run_until(std::numeric_limits<uint64_t>::max());
+}
+
+bool CerebroBase::run_until(uint64_t time) {
+    if (!prepare()) {
+        logger_->error("{} Failed to prepare for execution", name_);
+        return false;
+    }
+    
+    // A paused run continues with its strategies as they are
+    if (is_paused_) {
+        is_paused_ = false;
+        is_running_ = true;
+        logger_->info("{} Resuming execution at {}", name_, replay_controller_->get_current_time());
+    } else if (!start_run()) {
+        return false;
+    }
     
     // Main execution loop
     while (is_running_ && !stop_flag_.load()) {
-        if (!process_next()) {
+        if (process_next()) {
+            if (replay_controller_->get_current_time() >= time) {
+                // Not running while paused, so the setters accept changes before the run goes on
+                is_running_ = false;
+                is_paused_ = true;
+                logger_->info("{} Paused execution at {}", name_, replay_controller_->get_current_time());
+                return true;
+            }
+            continue;
+        }
+        
+        // Live feeds may get more bars, the policy decides whether to wait for them
+        if (stop_flag_.load() || !pacing_policy_->wait_for_data()) {
             logger_->info("{} No more data to process, execution complete", name_);
             break;
         }
-        
-        // Small delay to prevent tight loop in real-time scenarios
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        replay_controller_->resume_exhausted_providers();
     }
     
+    auto stats = pacing_policy_->get_stats();
+    logger_->info("{} Pacing {}: {} steps, {} bars in {:.3f}s ({:.0f} bars/s), idle {:.3f}s ({:.1f}%)",
+                  name_, pacing_policy_->name(), stats.steps, stats.bars, stats.elapsed_seconds,
+                  stats.bars_per_second(), stats.idle_seconds, stats.idle_ratio() * 100.0);
+    
     // Stop all strategies
-    for (auto& strategy : strategies_) {
-        strategy->on_stop();
-    }
+    stop_strategies();
     
     // moved to stop function
     // Observer reports
@@ -417,5 +567,191 @@ bool CerebroBase::run() {
     return true;
 }
 
+namespace {
+
+constexpr uint64_t kCheckpointMagic = 0x5154434b50543031ULL;  // "QTCKPT01"
+constexpr uint32_t kCheckpointVersion = 1;
+
+// Write a component into a writer of its own, so its reader cannot run into the next one
+template <typename Component>
+void write_section(StateWriter& writer, const Component& component) {
+    StateWriter section;
+    component.checkpoint(section);
+    writer.write(section.data());
+}
+
+// Read a component's section without changing the component, empty if the section is malformed
+template <typename Component>
+auto stage_section(StateReader& reader, Component& component) -> decltype(component.stage_restore(reader)) {
+    std::string section;
+    if (!reader.read(section)) {
+        return {};
+    }
+    StateReader section_reader(section);
+    auto apply = component.stage_restore(section_reader);
+    if (!section_reader.ok()) {
+        return {};
+    }
+    return apply;
+}
+
+}
+
+std::optional<std::string> CerebroBase::checkpoint() const {
+    if (!is_prepared_) {
+        logger_->error("{} Cannot checkpoint a cerebro that is not prepared", name_);
+        return std::nullopt;
+    }
+
+    StateWriter writer;
+    writer.write(kCheckpointMagic);
+    writer.write(kCheckpointVersion);
+    write_section(writer, *replay_controller_);
+    writer.write<uint8_t>(broker_ ? 1 : 0);
+    if (broker_) {
+        write_section(writer, *broker_);
+    }
+    writer.write<uint64_t>(observers_.size());
+    for (const auto& observer : observers_) {
+        write_section(writer, *observer);
+    }
+    writer.write<uint64_t>(strategies_.size());
+    for (const auto& strategy : strategies_) {
+        writer.write(strategy->get_name());
+        write_section(writer, *strategy);
+    }
+    logger_->info("{} Checkpoint of {} bytes at {}", name_, writer.data().size(), replay_controller_->get_current_time());
+    return writer.take();
+}
+
+bool CerebroBase::restore(const std::string& state) {
+    if (!prepare()) {
+        logger_->error("{} Failed to prepare for restore", name_);
+        return false;
+    }
+
+    StateReader reader(state);
+    uint64_t magic = 0;
+    uint32_t version = 0;
+    reader.read(magic);
+    reader.read(version);
+    if (!reader.ok() || magic != kCheckpointMagic || version != kCheckpointVersion) {
+        logger_->error("{} Not a checkpoint of version {}", name_, kCheckpointVersion);
+        return false;
+    }
+
+    // Read and check every section first, a malformed state leaves cerebro as it was
+    auto apply_replay = stage_section(reader, *replay_controller_);
+    if (!apply_replay) {
+        logger_->error("{} Cannot restore the replay", name_);
+        return false;
+    }
+
+    uint8_t has_broker = 0;
+    reader.read(has_broker);
+    std::function<void()> apply_broker;
+    if (has_broker != (broker_ ? 1 : 0) || (broker_ && !(apply_broker = stage_section(reader, *broker_)))) {
+        logger_->error("{} Cannot restore the broker", name_);
+        return false;
+    }
+
+    uint64_t count = 0;
+    if (!reader.read_count(count) || count != observers_.size()) {
+        logger_->error("{} The checkpoint has {} observers, cerebro has {}", name_, count, observers_.size());
+        return false;
+    }
+    std::vector<std::function<void()>> apply_observers;
+    for (auto& observer : observers_) {
+        apply_observers.push_back(stage_section(reader, *observer));
+        if (!apply_observers.back()) {
+            logger_->error("{} Cannot restore an observer", name_);
+            return false;
+        }
+    }
+
+    if (!reader.read_count(count) || count != strategies_.size()) {
+        logger_->error("{} The checkpoint has {} strategies, cerebro has {}", name_, count, strategies_.size());
+        return false;
+    }
+    std::vector<std::function<bool()>> apply_strategies;
+    for (auto& strategy : strategies_) {
+        std::string strategy_name;
+        if (!reader.read(strategy_name) || strategy_name != strategy->get_name()) {
+            logger_->error("{} Strategy {} of the checkpoint does not match {}", name_, strategy_name, strategy->get_name());
+            return false;
+        }
+        apply_strategies.push_back(stage_section(reader, *strategy));
+        if (!apply_strategies.back()) {
+            logger_->error("{} Cannot restore strategy {}", name_, strategy_name);
+            return false;
+        }
+    }
+    if (!reader.at_end()) {
+        logger_->error("{} The checkpoint has bytes after its last section", name_);
+        return false;
+    }
+
+    // Strategies load their state after on_start, as they would have been in the checkpointed run.
+    // Their blobs are only checked by load_state, so they are loaded before the rest is applied.
+    bool started = !is_paused_ && !is_running_;
+    if (started && !start_run()) {
+        stop_strategies();
+        is_running_ = false;
+        return false;
+    }
+    std::vector<std::string> previous_states;  // of a paused run, taken back if a strategy refuses its blob
+    for (size_t i = 0; i < strategies_.size(); ++i) {
+        if (!started) {
+            StateWriter writer;
+            strategies_[i]->checkpoint(writer);
+            previous_states.push_back(writer.take());
+        }
+        if (apply_strategies[i]()) {
+            continue;
+        }
+
+        logger_->error("{} Cannot restore strategy {}", name_, strategies_[i]->get_name());
+        if (started) {
+            stop_strategies();
+            is_running_ = false;
+        } else {
+            for (size_t j = 0; j < i; ++j) {
+                StateReader previous(previous_states[j]);
+                strategies_[j]->restore(previous);
+            }
+        }
+        return false;
+    }
+
+    apply_replay();
+    if (apply_broker) {
+        apply_broker();
+    }
+    for (auto& apply : apply_observers) {
+        apply();
+    }
+
+    // The views of the feeds that ticked before the checkpoint
+    bar_views_.clear();
+    last_ticked_.clear();
+    if (feed_slots_.size() != replay_controller_->get_feed_count()) {
+        bind_feed_slots();
+    }
+    for (data::replay::FeedId id = 0; id < feed_slots_.size(); ++id) {
+        auto& slot = feed_slots_[id];
+        size_t emitted = replay_controller_->get_emitted_count(id);
+        slot.view = emitted > 0 ? &bar_views_[slot.name] : nullptr;
+        slot.pin.reset();
+        if (slot.view) {
+            pin_view(slot, emitted);
+        }
+    }
+
+    is_running_ = false;
+    is_paused_ = true;
+    logger_->info("{} Restored checkpoint at {}", name_, replay_controller_->get_current_time());
+    return true;
+}
+
 } // namespace cerebro
 } // namespace quanttrader
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cerebro_consts.h"
+#include "cerebro/pacing_policy.h"
 #include "data/common/data_provider.h"
 #include "data/replay/data_replay_controller.h"
 #include "strategy/strategy_base.h"
@@ -9,6 +10,7 @@
 #include "broker/abstract_broker.h"
 #include "logger/quantlogger.h"
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -91,6 +93,18 @@ public:
      */
     void set_replay_mode(data::provider::DataProvider::ReplayMode mode);
 
+    /**
+     * @brief Set the pacing policy of the event loop
+     * 
+     * @param policy The policy, unthrottled by default
+     */
+    void set_pacing_policy(std::shared_ptr<PacingPolicy> policy);
+
+    /**
+     * @brief Get the pacing policy of the event loop
+     */
+    std::shared_ptr<PacingPolicy> get_pacing_policy() const { return pacing_policy_; }
+
     /**
      * @brief For STEPPED replay mode, advance to the next data point
      */
@@ -106,6 +120,17 @@ public:
      */
     bool resample_data(const std::string& name, data::BarType target_type, unsigned int target_size);
 
+    /**
+     * @brief Replace a data feed with several timeframes built in one pass over it
+     * 
+     * Each timeframe is added as "<name>_<bar type>", e.g. "min_data_5_mins".
+     * 
+     * @param name The name of the data feed to resample
+     * @param targets The target bar types and sizes
+     * @return true if successful, false otherwise
+     */
+    bool resample_data(const std::string& name, const std::vector<std::pair<data::BarType, unsigned int>>& targets);
+
     /**
      * @brief Prepare cerebro for execution
      * 
@@ -124,6 +149,40 @@ public:
      */
     virtual bool run();
 
+    /**
+     * @brief Run the cerebro engine until the replay reaches a time
+     * 
+     * The run pauses after the first step at or past time, the strategies are not stopped.
+     * A later run or run_until continues from there.
+     * 
+     * @param time Time to pause at, in the time unit of the bars
+     * @return true if the run is successful, false otherwise
+     */
+    bool run_until(uint64_t time);
+
+    /**
+     * @brief Save the state of a prepared cerebro between steps
+     * 
+     * Holds the replay position of every feed, the broker, the observers and the strategies.
+     * The bars are not part of it, a restore needs the same feeds.
+     * 
+     * @return The state, std::nullopt if cerebro is not prepared
+     */
+    std::optional<std::string> checkpoint() const;
+
+    /**
+     * @brief Continue from a state saved by checkpoint
+     * 
+     * Cerebro is prepared and its strategies started if needed, then the following run continues
+     * at the step after the checkpoint. Several cerebros can restore one state to branch a run.
+     * Every section is read and checked before any is applied, so a state that is refused leaves
+     * cerebro as it was, with strategies it had to start for the restore stopped again.
+     * 
+     * @param state The state from checkpoint
+     * @return true if successful, false if the state is malformed or does not match the feeds and strategies
+     */
+    bool restore(const std::string& state);
+
     /**
      * @brief Stop cerebro execution
      * 
@@ -140,19 +199,26 @@ public:
         wait_data_timeout_ = timeout;
     }
 
+    /**
+     * @brief Set the number of threads that start the data providers, 0 for the hardware threads
+     */
+    inline void set_start_threads(size_t threads) {
+        replay_controller_->set_start_threads(threads);
+    }
+
     std::vector<std::shared_ptr<observer::ObserverBase>> get_observers() const { return observers_; }
     void add_observer(std::shared_ptr<observer::ObserverBase> obs) { if (obs) observers_.push_back(obs); }
 
 protected:
     /**
-     * @brief Update cached BarSeries with new bar data
-     * 
-     * This method efficiently updates the cached BarSeries when new bars are available.
-     * 
-     * @param data_provider_name The name of the data provider
-     * @param new_bar The new bar to add to the series
+     * @brief Cache per-feed lookups by feed id for the replay loop
+     */
+    void bind_feed_slots();
+
+    /**
+     * @brief Route the data listeners of all providers to the pacing policy
      */
-    void update_cached_bar_series(const std::string& data_provider_name, const std::optional<data::BarStruct>& new_bar);
+    void bind_data_listeners();
 
     /**
      * @brief Process the next set of data
@@ -163,21 +229,52 @@ protected:
      */
     virtual bool process_next();
 
+    /**
+     * @brief Start the strategies and the pacing policy at the beginning of a run
+     */
+    bool start_run();
+
+    /**
+     * @brief Call on_stop of the started strategies, once per start_run
+     */
+    void stop_strategies();
+
     // Data management
     std::shared_ptr<data::replay::DataReplayController> replay_controller_;
     
-    // Historical data storage - maps data provider name to accumulated bar history
-    std::map<std::string, std::vector<std::optional<data::BarStruct>>> historical_data_;
-    
-    // Cached BarSeries for efficient strategy access - maps data provider name to TA-Lib compatible series
-    std::map<std::string, data::BarSeries> cached_bar_series_;
+    // Read-only views over each provider's bars, maps data provider name to the bars replayed so far
+    std::map<std::string, data::BarSeriesView> bar_views_;
+
+    using PriceMap = std::map<std::string, double>;
+
+    // Everything process_next needs about a feed, indexed by replay feed id
+    struct FeedSlot {
+        std::string name;
+        std::string symbol;
+        data::provider::DataProvider* provider = nullptr;
+        data::BarSeriesView* view = nullptr;
+        std::shared_ptr<const void> pin;  // keeps the view's bars alive while the strategies read them
+        uint64_t generation = 0;  // bar generation of the provider when the view was pinned
+        PriceMap::node_type price_node;  // node for this symbol, lent to price_map_ while the feed ticks
+    };
+
+    /**
+     * @brief Point a feed's view at its first bars and hold them until the view is pinned again
+     */
+    void pin_view(FeedSlot& slot, size_t count);
+
+    std::vector<FeedSlot> feed_slots_;
+    std::vector<data::replay::FeedId> last_ticked_;  // feeds whose pins are dropped before the next step
+    PriceMap price_map_;
     
     // Strategy management
     std::vector<std::shared_ptr<strategy::StrategyBase>> strategies_;
     
     // Execution state
-    bool is_running_ = false;
+    std::atomic<bool> is_running_ {false};  // read by setters called from other threads than the run loop
     bool is_prepared_ = false;
+    bool is_paused_ = false;  // run_until returned with the strategies started
+    bool strategies_started_ = false;  // on_start ran and on_stop did not yet
     
     // Logging
     quanttrader::log::LoggerPtr logger_;
@@ -185,6 +282,7 @@ protected:
     std::shared_ptr<broker::AbstractBroker> broker_;
     std::atomic<bool> stop_flag_;
     long long wait_data_timeout_ = 60000; // 60 seconds
+    std::shared_ptr<PacingPolicy> pacing_policy_;
 
     std::vector<std::shared_ptr<observer::ObserverBase>> observers_;
     
@@ -23,7 +23,8 @@ public:
      */
     LiveCerebro(const std::string_view name)
         : CerebroBase(name), trading_thread_(nullptr) {
-        
+        // Live feeds deliver bars over time, block until they arrive instead of finishing
+        pacing_policy_ = std::make_shared<EventDrivenPacing>();
         logger_->info("Created live trading cerebro: {}", name_);
     }
 
@@ -56,17 +57,22 @@ public:
      * @brief Stop the live trading session
      */
     bool stop() override {
-        CerebroBase::stop(); // Call base class stop first
-        
-        if (!trading_thread_) {
-            return false;
-        }
-        
-        if (trading_thread_->joinable()) {
+        // Wake the trading loop before joining it, it may wait for data or not be running yet
+        stop_flag_.store(true);
+        pacing_policy_->interrupt();
+
+        bool had_thread = trading_thread_ != nullptr;
+        if (had_thread && trading_thread_->joinable()) {
             trading_thread_->join();
         }
-        
         trading_thread_.reset();
+
+        // The trading loop is done, the base teardown no longer races it
+        CerebroBase::stop();
+        if (!had_thread) {
+            return false;
+        }
+
         logger_->info("Live trading stopped");
         return true;
     }
@@ -76,26 +82,10 @@ private:
      * @brief Main trading loop for live execution
      */
     void trading_loop() {
-        // Start real-time data feeds
-        // start_data_providers();
-        
-        // // Register callbacks for real-time data and trading events
-        // // TODO: Implement proper callback registration
-        
-        // // Main trading loop
-        // while (!stop_flag_.load()) {
-        //     // Process any new data or trading events
-        //     process_strategies_on_tick();
-        //     process_strategies_on_bar();
-            
-        //     // Process any trade signals
-        //     for (auto& strategy : strategies_) {
-        //         strategy->on_trade();
-        //     }
-            
-        //     // Sleep to prevent high CPU usage
-        //     std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        // }
+        // The base event loop blocks on the pacing policy until feeds deliver new bars or stop() is called
+        if (!CerebroBase::run()) {
+            logger_->error("Live trading loop of {} failed", name_);
+        }
     }
 
     std::shared_ptr<std::thread> trading_thread_;
@@ -0,0 +1,184 @@
+#include "parameter_grid.h"
+#include "logger/quantlogger.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <optional>
+#include <sstream>
+
+namespace quanttrader {
+namespace cerebro {
+namespace optimize {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    auto begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    auto end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> split(const std::string& text, char delimiter) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(text);
+    std::string token;
+    while (std::getline(ss, token, delimiter)) {
+        tokens.push_back(trim(token));
+    }
+    return tokens;
+}
+
+std::optional<int> parse_int(const std::string& text) {
+    int value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<double> parse_double(const std::string& text) {
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || !std::isfinite(value)) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::string format_double(double value) {
+    std::ostringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+}  // namespace
+
+bool ParameterGrid::add_axis(const std::string& name, const std::string& spec) {
+    if (name.empty() || std::find(names_.begin(), names_.end(), name) != names_.end()) {
+        log::Error("Parameter '{}' is empty or already in the grid", name);
+        return false;
+    }
+
+    Axis axis;
+    if (!parse_spec(trim(spec), axis)) {
+        log::Error("Invalid values '{}' for parameter {}, expected 'start:stop:step' or a list like '20,50,100'", spec, name);
+        return false;
+    }
+    if (size() > 0 && size() > kMaxPoints / axis.values.size()) {
+        log::Error("Parameter {} with {} values makes the grid larger than {} points", name, axis.values.size(), kMaxPoints);
+        return false;
+    }
+
+    names_.push_back(name);
+    axes_.push_back(std::move(axis));
+    strides_.assign(axes_.size(), 1);
+    for (size_t i = axes_.size() - 1; i > 0; --i) {
+        strides_[i - 1] = strides_[i] * axes_[i].values.size();
+    }
+    return true;
+}
+
+size_t ParameterGrid::size() const {
+    if (axes_.empty()) {
+        return 0;
+    }
+    return strides_[0] * axes_[0].values.size();
+}
+
+void ParameterGrid::apply(size_t point, strategy::StrategyCreateFuncParemType& params) const {
+    for (size_t i = 0; i < axes_.size(); ++i) {
+        params[names_[i]] = axes_[i].values[value_index(point, i)];
+    }
+}
+
+std::vector<std::string> ParameterGrid::labels(size_t point) const {
+    std::vector<std::string> result;
+    result.reserve(axes_.size());
+    for (size_t i = 0; i < axes_.size(); ++i) {
+        result.push_back(axes_[i].labels[value_index(point, i)]);
+    }
+    return result;
+}
+
+bool ParameterGrid::parse_spec(const std::string& spec, Axis& axis) {
+    if (spec.empty()) {
+        return false;
+    }
+
+    // A range, start:stop or start:stop:step
+    if (spec.find(':') != std::string::npos) {
+        auto parts = split(spec, ':');
+        if (parts.size() < 2 || parts.size() > 3) {
+            return false;
+        }
+        if (parts.size() == 2) {
+            parts.push_back("1");
+        }
+
+        auto start = parse_int(parts[0]);
+        auto stop = parse_int(parts[1]);
+        auto step = parse_int(parts[2]);
+        if (start && stop && step) {
+            if (step.value() <= 0 || start.value() > stop.value() ||
+                (static_cast<long long>(stop.value()) - start.value()) / step.value() >= static_cast<long long>(kMaxAxisValues)) {
+                return false;
+            }
+            for (long long value = start.value(); value <= stop.value(); value += step.value()) {
+                axis.values.emplace_back(static_cast<int>(value));
+                axis.labels.push_back(std::to_string(value));
+            }
+            return true;
+        }
+
+        auto start_d = parse_double(parts[0]);
+        auto stop_d = parse_double(parts[1]);
+        auto step_d = parse_double(parts[2]);
+        if (!start_d || !stop_d || !step_d || step_d.value() <= 0 || start_d.value() > stop_d.value()) {
+            return false;
+        }
+        // Tolerate the rounding of the step so the stop value is included
+        double steps = std::floor((stop_d.value() - start_d.value()) / step_d.value() + 1e-9);
+        if (steps >= static_cast<double>(kMaxAxisValues)) {
+            return false;
+        }
+        for (size_t i = 0; i <= static_cast<size_t>(steps); ++i) {
+            double value = start_d.value() + static_cast<double>(i) * step_d.value();
+            axis.values.emplace_back(value);
+            axis.labels.push_back(format_double(value));
+        }
+        return true;
+    }
+
+    // A list, typed by its values
+    auto tokens = split(spec, ',');
+    if (tokens.empty() || tokens.size() > kMaxAxisValues ||
+        std::any_of(tokens.begin(), tokens.end(), [](const std::string& token) { return token.empty(); })) {
+        return false;
+    }
+    bool all_ints = std::all_of(tokens.begin(), tokens.end(), [](const std::string& token) { return parse_int(token).has_value(); });
+    bool all_numbers =
+        std::all_of(tokens.begin(), tokens.end(), [](const std::string& token) { return parse_double(token).has_value(); });
+    for (const auto& token : tokens) {
+        if (all_ints) {
+            axis.values.emplace_back(parse_int(token).value());
+        } else if (all_numbers) {
+            axis.values.emplace_back(parse_double(token).value());
+        } else {
+            axis.values.emplace_back(token);
+        }
+        axis.labels.push_back(token);
+    }
+    return true;
+}
+
+} // namespace optimize
+} // namespace cerebro
+} // namespace quanttrader
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "strategy/strategy_base.h"
+#include <any>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace quanttrader {
+namespace cerebro {
+namespace optimize {
+
+/**
+ * @brief Cartesian product of strategy parameter values
+ *
+ * Each axis is given by a spec: "5:50:5" for 5 to 50 in steps of 5, "5:50" for steps of 1,
+ * or a list such as "20,50,100" or "sma,ema". Values are ints when every value of the axis
+ * is an integer, doubles when they are numbers and strings otherwise, so strategies read
+ * them with the types they read from their config tables.
+ *
+ * Points are numbered from 0 with the last axis changing fastest and are decoded on
+ * demand, a grid of millions of points takes the memory of its axes.
+ */
+class ParameterGrid {
+public:
+    static constexpr size_t kMaxPoints = 100000000;
+    static constexpr size_t kMaxAxisValues = 1000000;
+
+    /**
+     * @brief Add a parameter to the grid
+     *
+     * @param name The strategy parameter
+     * @param spec The values, e.g. "5:50:5" or "20,50,100"
+     * @return false if the spec is invalid, the name is already used or the grid gets too large
+     */
+    bool add_axis(const std::string& name, const std::string& spec);
+
+    /**
+     * @brief Number of points, 0 without axes
+     */
+    size_t size() const;
+
+    const std::vector<std::string>& get_names() const { return names_; }
+
+    /**
+     * @brief Set the parameter values of a point
+     *
+     * @param point Index of the point, below size()
+     * @param params The strategy parameters to overwrite
+     */
+    void apply(size_t point, strategy::StrategyCreateFuncParemType& params) const;
+
+    /**
+     * @brief The values of a point as text, in the order of the names
+     */
+    std::vector<std::string> labels(size_t point) const;
+
+private:
+    struct Axis {
+        std::vector<std::any> values;
+        std::vector<std::string> labels;
+    };
+
+    // Index of the value on an axis at a point
+    size_t value_index(size_t point, size_t axis) const { return point / strides_[axis] % axes_[axis].values.size(); }
+
+    static bool parse_spec(const std::string& spec, Axis& axis);
+
+    std::vector<std::string> names_;
+    std::vector<Axis> axes_;
+    std::vector<size_t> strides_;  // points between two values of an axis
+};
+
+} // namespace optimize
+} // namespace cerebro
+} // namespace quanttrader
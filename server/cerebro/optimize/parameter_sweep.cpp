@@ -0,0 +1,515 @@
+#include "parameter_sweep.h"
+#include "cerebro/cerebro_factory.h"
+#include "cerebro/cerebro_consts.h"
+#include "broker/broker_provider_factory.h"
+#include "data/common/data_provider_factory.h"
+#include "data/common/bar_cache.h"
+#include "data/replay/data_replay_controller.h"
+#include "strategy/strategy_factory.h"
+#include "strategy/strategy_loader.h"
+#include "service/service_consts.h"
+#include "config/lua_config_loader.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace quanttrader {
+namespace cerebro {
+namespace optimize {
+
+namespace {
+
+constexpr char kGridPrefix[] = "grid.";
+constexpr long long kDefaultWaitDataTimeout = 60000;  // milliseconds
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Metrics where a lower value ranks first
+bool lower_is_better(const std::string& metric) {
+    return metric == "max_drawdown" || metric == "max_drawdown_percent";
+}
+
+} // namespace
+
+ParameterSweep::ParameterSweep(const SweepOptions& options) : options_(options) {
+    logger_ = quanttrader::log::get_common_rotation_logger("ParameterSweep", "cerebro");
+}
+
+ParameterSweep::~ParameterSweep() {
+    // The strategies of the runs are gone, the plugins that created them can go too
+    if (plugins_loaded_) {
+        strategy::StrategyLoader::unload_plugins();
+    }
+}
+
+bool ParameterSweep::add_data(std::shared_ptr<data::provider::DataProvider> provider) {
+    if (!provider) {
+        logger_->error("Cannot add a null data provider to the sweep");
+        return false;
+    }
+    for (const auto& source : sources_) {
+        if (source->get_data_name() == provider->get_data_name()) {
+            logger_->error("Data provider {} is already in the sweep", provider->get_data_name());
+            return false;
+        }
+    }
+    sources_.push_back(std::move(provider));
+    return true;
+}
+
+void ParameterSweep::set_strategy(const std::string& strategy_type, const strategy::StrategyCreateFuncParemType& params) {
+    strategy_type_ = strategy_type;
+    strategy_params_ = params;
+}
+
+bool ParameterSweep::add_parameter(const std::string& name, const std::string& spec) {
+    return grid_.add_axis(name, spec);
+}
+
+bool ParameterSweep::prepare() {
+    prepared_ = false;
+    if (!load_config()) {
+        return false;
+    }
+
+    // Grid parameters of the options, in name order so the points do not depend on the table order
+    std::vector<std::pair<std::string, std::string>> specs;
+    for (const auto& [key, value] : options_) {
+        if (key.rfind(kGridPrefix, 0) != 0) {
+            continue;
+        }
+        std::string spec;
+        if (auto text = std::any_cast<std::string>(&value)) {
+            spec = *text;
+        } else if (auto number = std::any_cast<int>(&value)) {
+            spec = std::to_string(*number);
+        } else if (auto real = std::any_cast<double>(&value)) {
+            std::ostringstream ss;
+            ss << *real;
+            spec = ss.str();
+        }
+        specs.emplace_back(key.substr(sizeof(kGridPrefix) - 1), spec);
+    }
+    std::sort(specs.begin(), specs.end());
+    for (const auto& [name, spec] : specs) {
+        if (!add_parameter(name, spec)) {
+            logger_->error("Invalid grid values '{}' for parameter {}", spec, name);
+            return false;
+        }
+    }
+
+    rank_by_ = get_option<std::string>("rank_by", rank_by_);
+    if (!get_metric(observer::PerformanceSummary{}, rank_by_).has_value()) {
+        logger_->error("Unknown rank_by metric: {}", rank_by_);
+        return false;
+    }
+    starting_cash_ = get_option<double>("starting_cash", starting_cash_);
+    commission_ = get_option<double>("commission", commission_);
+    slippage_ = get_option<double>("slippage", slippage_);
+
+    if (strategy_type_.empty()) {
+        logger_->error("No strategy to sweep");
+        return false;
+    }
+    if (grid_.size() == 0) {
+        logger_->error("No parameter grid for strategy {}, add grid.<parameter> options", strategy_type_);
+        return false;
+    }
+    if (sources_.empty()) {
+        logger_->error("No data to sweep strategy {} over", strategy_type_);
+        return false;
+    }
+    if (!load_data()) {
+        return false;
+    }
+
+    logger_->info("Sweeping {} over {} points of {} parameters with {} feeds loaded in {:.2f}s", strategy_type_, grid_.size(),
+                  grid_.get_names().size(), feeds_.size(), load_seconds_);
+    prepared_ = true;
+    return true;
+}
+
+bool ParameterSweep::load_config() {
+    std::string config_path = get_option<std::string>("config_path", "");
+    if (config_path.empty()) {
+        // Data and strategy come from add_data and set_strategy
+        return true;
+    }
+    if (!fs::is_regular_file(config_path)) {
+        logger_->error("Trade configuration file does not exist: {}", config_path);
+        return false;
+    }
+    config_path = fs::absolute(config_path).string();
+    auto config = luascript::LuaConfigLoader(config_path);
+    if (!config.load_config()) {
+        logger_->error("Failed to load trade configuration file: {}", config_path);
+        return false;
+    }
+    std::string service = get_option<std::string>("service", service::STOCK_TRADE_SERVICE_NAME);
+
+    // Every feed is loaded once, the bar cache only saves loading a series twice within the sweep
+    int bar_cache_mb = config.get_int_value(service, "bar_cache_mb");
+    if (bar_cache_mb > 0) {
+        data::util::BarCache::instance()->set_memory_budget(static_cast<size_t>(bar_cache_mb) * 1024 * 1024);
+    }
+
+    // Some data providers download through the broker provider
+    auto broker_provider_name = config.get_string_value(service, "broker_provider");
+    if (!broker_provider_name.empty()) {
+        auto broker_provider_config = config.get_string_value(service, "broker_config");
+        if (broker_provider_config == "this") {
+            broker_provider_config = config_path;
+        }
+        broker_provider_ = broker::BrokerProviderFactory::instance()->createProvider(broker_provider_name, broker_provider_config);
+        if (!broker_provider_) {
+            logger_->error("Failed to create the broker provider: {}", broker_provider_name);
+            return false;
+        }
+    }
+
+    // Data providers, one per ticker like the trade service
+    std::stringstream data_series(config.get_string_value(service, "data_series"));
+    std::string prefix;
+    while (std::getline(data_series, prefix, ',')) {
+        if (prefix.empty()) {
+            continue;
+        }
+        std::string provider_type = config.get_string_value(service, prefix + ".provider_type");
+        auto provider_config = config.get_string_value(service, prefix + ".provider_config");
+        if (provider_type.empty()) {
+            logger_->warn("Data provider type is empty for prefix: {}", prefix);
+            continue;
+        }
+        if (provider_config == "this") {
+            provider_config = config_path;
+        }
+        auto provider_loader = luascript::LuaConfigLoader(provider_config);
+        provider_loader.load_config();
+
+        std::stringstream tickers(config.get_string_value(service, prefix + ".tickers"));
+        std::string ticker;
+        while (std::getline(tickers, ticker, ',')) {
+            if (ticker.empty()) {
+                continue;
+            }
+            auto params = std::make_shared<std::unordered_map<std::string, std::any>>();
+            auto data_name = prefix + "_" + ticker;
+            provider_loader.get_all_values(prefix, *params);
+            (*params)["data_name"] = data_name;
+            (*params)["broker_provider"] = broker_provider_;
+            (*params)["provider_type"] = provider_type;
+            (*params)["provider_config"] = provider_config;
+            (*params)["ticker"] = ticker;
+
+            auto provider = data::provider::DataProviderFactory::instance()->create_provider(provider_type, data_name, params);
+            if (!provider) {
+                logger_->error("Failed to create data provider with name: {} and type: {}", data_name, provider_type);
+                return false;
+            }
+            provider->set_broker(broker_provider_);
+            if (!provider->prepare_data() || !add_data(provider)) {
+                logger_->error("Failed to prepare data provider: {}", data_name);
+                return false;
+            }
+        }
+    }
+
+    // The strategy table to sweep, the first strategy of the service by default
+    std::string strategy_name = get_option<std::string>("strategy", "");
+    if (strategy_name.empty()) {
+        std::stringstream names(config.get_string_value(service, "strategy_names"));
+        std::getline(names, strategy_name, ',');
+    }
+    auto strategy_type = config.get_string_value(strategy_name, "strategy_type");
+    if (strategy_name.empty() || strategy_type.empty()) {
+        logger_->error("No strategy type for strategy '{}' in {}", strategy_name, config_path);
+        return false;
+    }
+
+    std::string plugin_dir = config.get_string_value(service, service::STRATEGY_LIB_PATH);
+    if (plugin_dir.empty()) {
+        plugin_dir = "strategies";
+    }
+    strategy::StrategyLoader::load_plugins((fs::current_path() / plugin_dir).string());
+    plugins_loaded_ = true;
+
+    strategy::StrategyCreateFuncParemType params;
+    config.get_all_values(strategy_name, params);
+    params[service::STRATEGY_NAME_VARIABLE] = strategy_name;
+    set_strategy(strategy_type, params);
+    return true;
+}
+
+bool ParameterSweep::load_data() {
+    auto start = std::chrono::steady_clock::now();
+    feeds_.clear();
+
+    // Start all providers at once, the same way a cerebro does
+    data::replay::DataReplayController loader;
+    for (const auto& source : sources_) {
+        if (!loader.add_data_provider(source->get_data_name(), source)) {
+            logger_->error("Failed to add data provider {} to the loader", source->get_data_name());
+            return false;
+        }
+    }
+    loader.set_start_threads(static_cast<size_t>(std::max(get_option<int>("threads", 0), 0)));
+    bool loaded = loader.start();
+    auto timeout = std::chrono::milliseconds(static_cast<long long>(get_option<double>("wait_data_timeout", kDefaultWaitDataTimeout)));
+    loaded = loaded && loader.wait_all_data_ready(timeout);
+    loader.stop();
+    if (!loaded) {
+        logger_->error("Failed to load the data of the sweep within {} ms", timeout.count());
+        return false;
+    }
+
+    for (const auto& source : sources_) {
+        const auto name = source->get_data_name();
+        if (source->is_live()) {
+            logger_->error("Cannot sweep over the live data provider {}", name);
+            return false;
+        }
+        if (!source->need_resample()) {
+            if (!share_feed(name, source)) {
+                return false;
+            }
+            continue;
+        }
+
+        // Resampled once here, so the runs only replay the periods
+        std::vector<std::pair<data::BarType, unsigned int>> targets;
+        std::stringstream sizes(source->get_resample_size());
+        std::string size;
+        while (std::getline(sizes, size, ',')) {
+            size.erase(0, size.find_first_not_of(" \t"));
+            size.erase(size.find_last_not_of(" \t") + 1);
+            auto target = data::provider::DataProvider::get_bar_type_from_string(size);
+            if (target.first == data::BarType::NONE) {
+                logger_->error("Cannot parse the resample size {} of data provider: {}", size, name);
+                return false;
+            }
+            targets.push_back(target);
+        }
+        if (targets.size() == 1) {
+            // Named like CerebroBase::resample_data names it
+            auto resampled = source->resample(targets[0].first, targets[0].second);
+            if (!resampled || !share_feed(name + "_resampled", resampled)) {
+                logger_->error("Failed to resample data {} to {}", name, source->get_resample_size());
+                return false;
+            }
+        } else if (!targets.empty()) {
+            auto resampled = source->resample(targets);
+            if (resampled.empty()) {
+                logger_->error("Failed to resample data {} to {}", name, source->get_resample_size());
+                return false;
+            }
+            for (const auto& feed : resampled) {
+                if (!share_feed(feed->get_data_name(), feed)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    load_seconds_ = seconds_since(start);
+    return true;
+}
+
+bool ParameterSweep::share_feed(const std::string& name, std::shared_ptr<data::provider::DataProvider> provider) {
+    // Resamplers store their periods as they are read, read them all once
+    if (std::find(sources_.begin(), sources_.end(), provider) == sources_.end()) {
+        if (!provider->start_request_data() || !provider->is_data_ready()) {
+            logger_->error("Failed to start data provider {}", name);
+            return false;
+        }
+        while (provider->next().has_value()) {
+        }
+    }
+
+    auto bars = data::feed::SharedSeriesFeed::share_bars(provider);
+    if (!bars.has_value()) {
+        logger_->error("Cannot share the bars of data provider {}", name);
+        return false;
+    }
+    auto feed = std::make_shared<data::feed::SharedSeriesFeed>(name, *provider, std::move(bars.value()));
+    logger_->info("Loaded {} bars of {} for the sweep", feed->size(), name);
+    feeds_.push_back(std::move(feed));
+    return true;
+}
+
+void ParameterSweep::quiet_loggers() const {
+    // Thousands of backtests would flood the logs, only the sweep itself keeps logging
+    std::string log_level = get_option<std::string>("log_level", "warn");
+    if (!log_level.empty() && quanttrader::log::QuantLogger::set_default_log_level(log_level)) {
+        quanttrader::log::QuantLogger::set_all_logger_level(log_level);
+        logger_->set_level(spdlog::level::info);
+    }
+}
+
+std::optional<SweepStats> ParameterSweep::run() {
+    if (!prepared_) {
+        logger_->error("ParameterSweep::run called before a successful prepare");
+        return std::nullopt;
+    }
+
+    quiet_loggers();
+    SweepStats stats;
+    stats.points = grid_.size();
+    stats.threads = ThreadPool::bounded_size(stats.points, static_cast<size_t>(std::max(get_option<int>("threads", 0), 0)));
+    stats.load_seconds = load_seconds_;
+    for (const auto& feed : feeds_) {
+        stats.bars += feed->size();
+    }
+    results_.assign(stats.points, SweepResult{});
+
+    // Each worker takes the next point until none is left
+    std::atomic<size_t> finished {0};
+    const size_t progress_step = std::max<size_t>(stats.points / 10, 1);
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool::for_each_index(stats.points, stats.threads, [this, &stats, &finished, progress_step](size_t point, size_t worker) {
+        auto& result = results_[point];
+        result.point = point;
+        result.values = grid_.labels(point);
+        auto begin = std::chrono::steady_clock::now();
+        try {
+            auto performance = backtest(point, "optimize_" + std::to_string(worker));
+            if (performance) {
+                result.completed = true;
+                result.summary = performance->get_summary();
+            }
+        } catch (const std::exception& e) {
+            logger_->error("Point {} of the sweep failed with an exception: {}", point, e.what());
+        }
+        result.seconds = seconds_since(begin);
+
+        size_t done = ++finished;
+        if (done % progress_step == 0 || done == stats.points) {
+            logger_->info("Finished {} of {} points", done, stats.points);
+        }
+    });
+    stats.seconds = seconds_since(start);
+    stats.failed = static_cast<size_t>(std::count_if(results_.begin(), results_.end(), [](const auto& result) { return !result.completed; }));
+    rank(results_, rank_by_);
+
+    logger_->info("Swept {} points ({} failed) on {} threads in {:.2f}s, {:.1f} backtests/s over {} bars each", stats.points,
+                  stats.failed, stats.threads, stats.seconds, stats.points / std::max(stats.seconds, 1e-9), stats.bars);
+    return stats;
+}
+
+std::shared_ptr<observer::PerformanceObserver> ParameterSweep::backtest(size_t point, const std::string& cerebro_name,
+                                                                         uint64_t begin_time, uint64_t end_time) const {
+    auto cerebro = CerebroFactory::instance()->create_cerebro(BACKTEST_CEREBRO_TYPE, cerebro_name);
+    if (!cerebro) {
+        logger_->error("Failed to create the backtest cerebro for point {}", point);
+        return nullptr;
+    }
+
+    // A cursor of its own over the shared bars, already at the window start
+    for (const auto& feed : feeds_) {
+        auto replay = feed->clone(begin_time, end_time);
+        if (!replay->prepare_data() || !cerebro->add_data(replay->get_data_name(), replay)) {
+            logger_->error("Failed to add data {} for point {}", feed->get_data_name(), point);
+            return nullptr;
+        }
+    }
+
+    auto params = strategy_params_;
+    grid_.apply(point, params);
+    auto strategy = strategy::StrategyFactory::create_strategy(strategy_type_, params);
+    if (!strategy || !cerebro->add_strategy(strategy)) {
+        logger_->error("Failed to create strategy {} for point {}", strategy_type_, point);
+        return nullptr;
+    }
+
+    cerebro->configure_backtest_broker(starting_cash_, commission_, slippage_);
+    cerebro->set_start_threads(1);
+    if (!cerebro->run()) {
+        logger_->error("Backtest of point {} failed", point);
+        return nullptr;
+    }
+
+    // The cerebro stops its providers and strategies when it goes out of scope
+    for (const auto& obs : cerebro->get_observers()) {
+        if (auto performance = std::dynamic_pointer_cast<observer::PerformanceObserver>(obs)) {
+            return performance;
+        }
+    }
+    logger_->error("No performance observer in the cerebro of point {}", point);
+    return nullptr;
+}
+
+void ParameterSweep::rank(std::vector<SweepResult>& results, const std::string& rank_by) {
+    const bool ascending = lower_is_better(rank_by);
+    auto score = [&rank_by, ascending](const SweepResult& result) {
+        double value = get_metric(result.summary, rank_by).value_or(0.0);
+        if (!result.completed || std::isnan(value)) {
+            return -std::numeric_limits<double>::infinity();
+        }
+        return ascending ? -value : value;
+    };
+    std::stable_sort(results.begin(), results.end(),
+                     [&score](const SweepResult& a, const SweepResult& b) { return score(a) > score(b); });
+}
+
+bool ParameterSweep::write_csv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        logger_->error("Cannot write the sweep results to {}", path);
+        return false;
+    }
+
+    out << "rank,point";
+    for (const auto& name : grid_.get_names()) {
+        out << ',' << name;
+    }
+    out << ",completed,total_profit,return_percent,max_drawdown,max_drawdown_percent,total_trades,winning_trades,win_rate,"
+           "profit_factor,return_dd_ratio,ending_equity,seconds\n";
+    for (size_t rank = 0; rank < results_.size(); ++rank) {
+        const auto& result = results_[rank];
+        const auto& summary = result.summary;
+        out << rank + 1 << ',' << result.point;
+        for (const auto& value : result.values) {
+            out << ',' << value;
+        }
+        out << ',' << (result.completed ? 1 : 0) << ',' << summary.total_profit << ',' << summary.return_percent << ','
+            << summary.max_drawdown << ',' << summary.max_drawdown_percent << ',' << summary.total_trades << ','
+            << summary.winning_trades << ',' << summary.win_rate << ',' << summary.profit_factor << ','
+            << summary.return_dd_ratio << ',' << summary.ending_equity << ',' << result.seconds << '\n';
+    }
+    logger_->info("Wrote {} sweep results to {}", results_.size(), path);
+    return static_cast<bool>(out);
+}
+
+std::optional<double> ParameterSweep::get_metric(const observer::PerformanceSummary& summary, const std::string& name) {
+    if (name == "total_profit") {
+        return summary.total_profit;
+    } else if (name == "return_percent") {
+        return summary.return_percent;
+    } else if (name == "return_dd_ratio") {
+        return summary.return_dd_ratio;
+    } else if (name == "profit_factor") {
+        return summary.profit_factor;
+    } else if (name == "win_rate") {
+        return summary.win_rate;
+    } else if (name == "total_trades") {
+        return static_cast<double>(summary.total_trades);
+    } else if (name == "max_drawdown") {
+        return summary.max_drawdown;
+    } else if (name == "max_drawdown_percent") {
+        return summary.max_drawdown_percent;
+    }
+    return std::nullopt;
+}
+
+} // namespace optimize
+} // namespace cerebro
+} // namespace quanttrader
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "parameter_grid.h"
+#include "data/common/data_provider.h"
+#include "data/feed/shared_series_feed.h"
+#include "observer/performance_observer.h"
+#include "strategy/strategy_base.h"
+#include "logger/quantlogger.h"
+#include <any>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace quanttrader {
+namespace broker {
+class BrokerProvider;
+}
+namespace cerebro {
+namespace optimize {
+
+using SweepOptions = std::unordered_map<std::string, std::any>;
+
+struct SweepResult {
+    size_t point = 0;                 // index of the point in the grid
+    std::vector<std::string> values;  // parameter values, in the order of the grid names
+    bool completed = false;           // false if the backtest could not run
+    observer::PerformanceSummary summary;
+    double seconds = 0.0;
+};
+
+struct SweepStats {
+    size_t points = 0;
+    size_t failed = 0;
+    size_t threads = 0;
+    size_t bars = 0;  // bars of the shared feeds, replayed by every run
+    double load_seconds = 0.0;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Backtests one strategy over a grid of parameter values
+ *
+ * The feeds are loaded and resampled once, then every run replays them through its own
+ * SharedSeriesFeed over the same read-only columns. Each point of the grid gets its own
+ * BacktestCerebro, BacktestBroker and PerformanceObserver, so runs share nothing mutable.
+ * The workers claim the next point from a shared counter, a fast worker keeps taking
+ * points while a slow backtest runs and no thread idles before the grid is done.
+ *
+ * Options, usually the optimize_config table of the main config:
+ * config_path (a trade config like the one of the strategy command), service (its service
+ * table, StockTradeService by default), strategy (the strategy table to sweep),
+ * grid.<parameter> (the values, e.g. "5:50:5" or "20,50,100"), threads, rank_by
+ * (total_profit, return_percent, return_dd_ratio, profit_factor, win_rate, total_trades,
+ * max_drawdown or max_drawdown_percent), top, output (a CSV file for all results),
+ * starting_cash, commission, slippage, wait_data_timeout and log_level (the level of the
+ * other loggers during the sweep, "warn" by default, empty to keep them).
+ */
+class ParameterSweep {
+public:
+    explicit ParameterSweep(const SweepOptions& options);
+    ~ParameterSweep();
+
+    /**
+     * @brief Add a prepared data provider, loaded by prepare()
+     *
+     * @param provider A finite provider, its data name is the feed name of the strategies
+     * @return false if the provider is null or its name is taken
+     */
+    bool add_data(std::shared_ptr<data::provider::DataProvider> provider);
+
+    /**
+     * @brief Set the strategy to sweep and the parameters the grid does not change
+     *
+     * @param strategy_type The type registered with the StrategyFactory
+     * @param params The base parameters
+     */
+    void set_strategy(const std::string& strategy_type, const strategy::StrategyCreateFuncParemType& params);
+
+    /**
+     * @brief Add a parameter to the grid
+     *
+     * @param name The strategy parameter
+     * @param spec The values, e.g. "5:50:5" or "20,50,100"
+     * @return false if the spec is invalid
+     */
+    bool add_parameter(const std::string& name, const std::string& spec);
+
+    /**
+     * @brief Read the trade config and the grid of the options, then load all feeds once
+     *
+     * @return true if there is a strategy, a grid and data to sweep
+     */
+    bool prepare();
+
+    /**
+     * @brief Backtest every point of the grid
+     *
+     * @return The totals, nullopt if prepare was not successful
+     */
+    std::optional<SweepStats> run();
+
+    /**
+     * @brief The results of the last run, best first by the rank_by metric, failed runs last
+     */
+    const std::vector<SweepResult>& get_results() const { return results_; }
+
+    const ParameterGrid& get_grid() const { return grid_; }
+
+    const std::string& get_rank_by() const { return rank_by_; }
+
+    /**
+     * @brief Write the ranked results with one column per parameter and metric
+     *
+     * @param path The CSV file
+     * @return true if the file was written
+     */
+    bool write_csv(const std::string& path) const;
+
+    /**
+     * @brief Value of a metric by name
+     *
+     * @return The value, std::nullopt for an unknown name
+     */
+    static std::optional<double> get_metric(const observer::PerformanceSummary& summary, const std::string& name);
+
+    /**
+     * @brief Sort results best first by a metric, failed runs last
+     *
+     * @param results The results to sort
+     * @param rank_by A metric known to get_metric, lower is better for the drawdowns
+     */
+    static void rank(std::vector<SweepResult>& results, const std::string& rank_by);
+
+    /**
+     * @brief Backtest one point of the grid over a time window of the loaded feeds
+     *
+     * Safe to call from several threads once prepare succeeded. The feeds seek to the window
+     * start, the bars before it are history for the strategy and are not replayed.
+     *
+     * @param point Index of the point
+     * @param cerebro_name Name of the cerebro, one per worker so the loggers are reused
+     * @param begin_time First time of the window in nanoseconds, 0 for the first bar
+     * @param end_time End of the window in nanoseconds, exclusive
+     * @return The observer of the run with its metrics and equity history, nullptr if the backtest failed
+     */
+    std::shared_ptr<observer::PerformanceObserver> backtest(size_t point, const std::string& cerebro_name, uint64_t begin_time = 0,
+                                                            uint64_t end_time = std::numeric_limits<uint64_t>::max()) const;
+
+    /**
+     * @brief Lower the other loggers to the log_level option, many backtests would flood the logs
+     */
+    void quiet_loggers() const;
+
+    /**
+     * @brief The loaded feeds, empty before prepare
+     */
+    const std::vector<std::shared_ptr<data::feed::SharedSeriesFeed>>& get_feeds() const { return feeds_; }
+
+    double get_starting_cash() const { return starting_cash_; }
+
+    double get_load_seconds() const { return load_seconds_; }
+
+    /**
+     * @brief Value of an option, the default if it is missing or of another type
+     */
+    template <typename T>
+    T get_option(const std::string& key, const T& default_value) const {
+        auto iter = options_.find(key);
+        if (iter == options_.end()) {
+            return default_value;
+        }
+        if (auto value = std::any_cast<T>(&iter->second)) {
+            return *value;
+        }
+        // Lua numbers without a fraction arrive as ints
+        if constexpr (std::is_same_v<T, double>) {
+            if (auto value = std::any_cast<int>(&iter->second)) {
+                return *value;
+            }
+        }
+        return default_value;
+    }
+
+private:
+    bool load_config();
+    bool load_data();
+    bool share_feed(const std::string& name, std::shared_ptr<data::provider::DataProvider> provider);
+
+    SweepOptions options_;
+    ParameterGrid grid_;
+    std::string strategy_type_;
+    strategy::StrategyCreateFuncParemType strategy_params_;
+    std::shared_ptr<broker::BrokerProvider> broker_provider_;
+    std::vector<std::shared_ptr<data::provider::DataProvider>> sources_;  // providers to load
+    std::vector<std::shared_ptr<data::feed::SharedSeriesFeed>> feeds_;    // loaded bars, cloned for every run
+    std::vector<SweepResult> results_;
+    double load_seconds_ = 0.0;
+    bool prepared_ = false;
+    bool plugins_loaded_ = false;
+
+    std::string rank_by_ = "total_profit";
+    double starting_cash_ = 100000.0;
+    double commission_ = 0.0;
+    double slippage_ = 0.0;
+    quanttrader::log::LoggerPtr logger_;
+};
+
+} // namespace optimize
+} // namespace cerebro
+} // namespace quanttrader
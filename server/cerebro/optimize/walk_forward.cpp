@@ -0,0 +1,210 @@
+#include "walk_forward.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+namespace quanttrader {
+namespace cerebro {
+namespace optimize {
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+WalkForward::WalkForward(const SweepOptions& options) : sweep_(options) {
+    logger_ = quanttrader::log::get_common_rotation_logger("WalkForward", "cerebro");
+}
+
+bool WalkForward::prepare() {
+    prepared_ = false;
+    if (!sweep_.prepare() || !build_windows()) {
+        return false;
+    }
+    logger_->info("Walking forward over {} windows of {} grid points", windows_.size(), sweep_.get_grid().size());
+    prepared_ = true;
+    return true;
+}
+
+bool WalkForward::build_windows() {
+    windows_.clear();
+    int in_sample = sweep_.get_option<int>("in_sample_bars", 0);
+    int out_of_sample = sweep_.get_option<int>("out_of_sample_bars", 0);
+    int step = sweep_.get_option<int>("step_bars", out_of_sample);
+    bool anchored = sweep_.get_option<bool>("anchored", false);
+    if (in_sample <= 0 || out_of_sample <= 0 || step <= 0) {
+        logger_->error("Walk-forward needs positive in_sample_bars, out_of_sample_bars and step_bars, got {}, {} and {}",
+                       in_sample, out_of_sample, step);
+        return false;
+    }
+
+    // The windows follow the bars of the first feed, the other feeds are cut at the same times
+    const auto& feeds = sweep_.get_feeds();
+    if (feeds.empty()) {
+        logger_->error("No data to walk forward over");
+        return false;
+    }
+    auto times = feeds.front()->get_bars().start_time;
+    size_t bars = times.size();
+    auto time_at = [&times, bars](size_t index) {
+        return index < bars ? times[index] : std::numeric_limits<uint64_t>::max();
+    };
+
+    for (size_t start = 0;; start += static_cast<size_t>(step)) {
+        size_t in_sample_begin = anchored ? 0 : start;
+        size_t out_of_sample_begin = start + static_cast<size_t>(in_sample);
+        if (out_of_sample_begin >= bars) {
+            break;
+        }
+        size_t out_of_sample_end = std::min(out_of_sample_begin + static_cast<size_t>(out_of_sample), bars);
+
+        WalkForwardWindow window;
+        window.index = windows_.size();
+        window.in_sample_begin = time_at(in_sample_begin);
+        window.out_of_sample_begin = time_at(out_of_sample_begin);
+        window.out_of_sample_end = time_at(out_of_sample_end);
+        window.in_sample_bars = out_of_sample_begin - in_sample_begin;
+        window.out_of_sample_bars = out_of_sample_end - out_of_sample_begin;
+        windows_.push_back(std::move(window));
+    }
+
+    if (windows_.empty()) {
+        logger_->error("{} bars of {} are not enough for {} in-sample bars and an out-of-sample window", bars,
+                       feeds.front()->get_data_name(), in_sample);
+        return false;
+    }
+    return true;
+}
+
+std::optional<WalkForwardStats> WalkForward::run() {
+    if (!prepared_) {
+        logger_->error("WalkForward::run called before a successful prepare");
+        return std::nullopt;
+    }
+    sweep_.quiet_loggers();
+    logger_->set_level(spdlog::level::info);
+
+    const size_t points = sweep_.get_grid().size();
+    const size_t limit = static_cast<size_t>(std::max(sweep_.get_option<int>("threads", 0), 0));
+    WalkForwardStats stats;
+    stats.windows = windows_.size();
+    stats.points = points;
+    stats.threads = ThreadPool::bounded_size(windows_.size() * points, limit);
+    stats.load_seconds = sweep_.get_load_seconds();
+    auto start = std::chrono::steady_clock::now();
+
+    // Every point of every window in sample, the windows do not wait for each other
+    std::vector<SweepResult> in_sample(windows_.size() * points);
+    std::atomic<size_t> finished {0};
+    const size_t progress_step = std::max<size_t>(in_sample.size() / 10, 1);
+    ThreadPool::for_each_index(in_sample.size(), stats.threads, [&](size_t index, size_t worker) {
+        const auto& window = windows_[index / points];
+        auto& result = in_sample[index];
+        result.point = index % points;
+        auto begin = std::chrono::steady_clock::now();
+        try {
+            auto performance = sweep_.backtest(result.point, "walkforward_" + std::to_string(worker), window.in_sample_begin,
+                                               window.out_of_sample_begin);
+            if (performance) {
+                result.completed = true;
+                result.summary = performance->get_summary();
+            }
+        } catch (const std::exception& e) {
+            logger_->error("Point {} of window {} failed with an exception: {}", result.point, window.index, e.what());
+        }
+        result.seconds = seconds_since(begin);
+
+        size_t done = ++finished;
+        if (done % progress_step == 0 || done == in_sample.size()) {
+            logger_->info("Finished {} of {} in-sample backtests", done, in_sample.size());
+        }
+    });
+
+    // The best point of each window, then all windows out of sample at once
+    for (auto& window : windows_) {
+        std::vector<SweepResult> results(in_sample.begin() + window.index * points, in_sample.begin() + (window.index + 1) * points);
+        ParameterSweep::rank(results, sweep_.get_rank_by());
+        window.completed = results.front().completed;
+        window.best_point = results.front().point;
+        window.best_values = sweep_.get_grid().labels(window.best_point);
+        window.in_sample = results.front().summary;
+    }
+    std::vector<std::shared_ptr<observer::PerformanceObserver>> runs(windows_.size());
+    ThreadPool::for_each_index(windows_.size(), ThreadPool::bounded_size(windows_.size(), limit), [&](size_t index, size_t worker) {
+        auto& window = windows_[index];
+        if (!window.completed) {
+            return;
+        }
+        try {
+            runs[index] = sweep_.backtest(window.best_point, "walkforward_" + std::to_string(worker), window.out_of_sample_begin,
+                                          window.out_of_sample_end);
+        } catch (const std::exception& e) {
+            logger_->error("Window {} failed out of sample with an exception: {}", window.index, e.what());
+        }
+        window.completed = runs[index] != nullptr;
+        if (window.completed) {
+            window.out_of_sample = runs[index]->get_summary();
+        }
+    });
+
+    stats.backtests = in_sample.size() + windows_.size();
+    stats.seconds = seconds_since(start);
+    stitch(runs, stats);
+    logger_->info("Walked forward over {} windows ({} failed) with {} backtests on {} threads in {:.2f}s, out-of-sample profit {:.2f}",
+                  stats.windows, stats.failed, stats.backtests, stats.threads, stats.seconds, stats.total_profit);
+    return stats;
+}
+
+void WalkForward::stitch(const std::vector<std::shared_ptr<observer::PerformanceObserver>>& runs, WalkForwardStats& stats) {
+    equity_.clear();
+    equity_windows_.clear();
+    const double starting_cash = sweep_.get_starting_cash();
+    double offset = starting_cash;  // equity at the end of the previous window
+    double peak = starting_cash;
+    for (const auto& window : windows_) {
+        const auto& run = runs[window.index];
+        if (!run) {
+            ++stats.failed;
+            continue;
+        }
+        // Every window starts with the starting cash, its profit continues the curve
+        for (const auto& point : run->get_equity_history()) {
+            double equity = offset + point.equity - starting_cash;
+            peak = std::max(peak, equity);
+            equity_.push_back({point.time, equity, peak, peak - equity});
+            equity_windows_.push_back(window.index);
+            stats.max_drawdown = std::max(stats.max_drawdown, peak - equity);
+        }
+        offset += window.out_of_sample.total_profit;
+        stats.total_trades += window.out_of_sample.total_trades;
+    }
+    stats.total_profit = offset - starting_cash;
+    stats.return_percent = starting_cash > 0 ? stats.total_profit / starting_cash * 100.0 : 0.0;
+}
+
+bool WalkForward::write_csv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        logger_->error("Cannot write the walk-forward equity to {}", path);
+        return false;
+    }
+
+    out << "time,window,equity,peak_equity,drawdown\n";
+    for (size_t i = 0; i < equity_.size(); ++i) {
+        const auto& point = equity_[i];
+        out << point.time << ',' << equity_windows_[i] << ',' << point.equity << ',' << point.peak_equity << ','
+            << point.drawdown << '\n';
+    }
+    logger_->info("Wrote {} stitched equity points to {}", equity_.size(), path);
+    return static_cast<bool>(out);
+}
+
+} // namespace optimize
+} // namespace cerebro
+} // namespace quanttrader
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "parameter_sweep.h"
+#include "observer/performance_observer.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace quanttrader {
+namespace cerebro {
+namespace optimize {
+
+struct WalkForwardWindow {
+    size_t index = 0;
+    uint64_t in_sample_begin = 0;      // times in nanoseconds
+    uint64_t out_of_sample_begin = 0;  // also the end of the in-sample part
+    uint64_t out_of_sample_end = 0;    // exclusive, the maximum for a window that ends with the data
+    size_t in_sample_bars = 0;         // bars of the first feed
+    size_t out_of_sample_bars = 0;
+    bool completed = false;            // false if no in-sample point or the out-of-sample run failed
+    size_t best_point = 0;             // the grid point chosen in sample
+    std::vector<std::string> best_values;
+    observer::PerformanceSummary in_sample;      // of the best point
+    observer::PerformanceSummary out_of_sample;  // of the best point on the following bars
+};
+
+struct WalkForwardStats {
+    size_t windows = 0;
+    size_t failed = 0;     // windows without an out-of-sample result
+    size_t points = 0;     // grid points optimized in every window
+    size_t backtests = 0;
+    size_t threads = 0;
+    double load_seconds = 0.0;
+    double seconds = 0.0;
+    // Of the stitched out-of-sample equity
+    double total_profit = 0.0;
+    double return_percent = 0.0;
+    double max_drawdown = 0.0;
+    size_t total_trades = 0;
+};
+
+/**
+ * @brief Walk-forward analysis, the parameters are optimized on a window and traded on the next bars
+ *
+ * Windows are counted in bars of the first feed: in_sample_bars to optimize on, followed by
+ * out_of_sample_bars to trade the best point on. Rolling windows move by step_bars (the
+ * out-of-sample length by default), anchored windows keep starting at the first bar.
+ *
+ * The feeds are loaded once by the ParameterSweep. Every backtest seeks its feeds to the
+ * window start in their sorted start times instead of replaying from the first bar, the bars
+ * before the window only serve as history of the strategy's views. The in-sample points of
+ * all windows run in parallel, then the out-of-sample runs of all windows. The out-of-sample
+ * equity curves are stitched, each window adding its profit to where the previous one ended.
+ *
+ * Options are those of the ParameterSweep plus in_sample_bars, out_of_sample_bars,
+ * step_bars and anchored, usually the walkforward_config table of the main config.
+ */
+class WalkForward {
+public:
+    explicit WalkForward(const SweepOptions& options);
+
+    /**
+     * @brief The sweep that optimizes every window, to add data, strategy and grid before prepare
+     */
+    ParameterSweep& get_sweep() { return sweep_; }
+
+    /**
+     * @brief Load the data once and split it into windows
+     *
+     * @return true if the sweep is prepared and there is at least one window
+     */
+    bool prepare();
+
+    /**
+     * @brief Optimize every window and trade its best point out of sample
+     *
+     * @return The totals, nullopt if prepare was not successful
+     */
+    std::optional<WalkForwardStats> run();
+
+    const std::vector<WalkForwardWindow>& get_windows() const { return windows_; }
+
+    /**
+     * @brief The stitched out-of-sample equity, one point per replayed timestamp
+     */
+    const std::vector<observer::EquityPoint>& get_equity() const { return equity_; }
+
+    /**
+     * @brief Write the stitched out-of-sample equity with the window of every point
+     *
+     * @param path The CSV file
+     * @return true if the file was written
+     */
+    bool write_csv(const std::string& path) const;
+
+private:
+    bool build_windows();
+    void stitch(const std::vector<std::shared_ptr<observer::PerformanceObserver>>& runs, WalkForwardStats& stats);
+
+    ParameterSweep sweep_;
+    std::vector<WalkForwardWindow> windows_;
+    std::vector<observer::EquityPoint> equity_;
+    std::vector<size_t> equity_windows_;  // window of every equity point
+    bool prepared_ = false;
+    quanttrader::log::LoggerPtr logger_;
+};
+
+} // namespace optimize
+} // namespace cerebro
+} // namespace quanttrader
@@ -0,0 +1,108 @@
+#include "pacing_policy.h"
+#include <thread>
+
+namespace quanttrader {
+namespace cerebro {
+
+void PacingPolicy::on_start() {
+    start_ = Clock::now();
+    idle_ = Clock::duration::zero();
+    steps_ = 0;
+    bars_ = 0;
+}
+
+void PacingPolicy::pace(uint64_t, size_t bar_count) {
+    ++steps_;
+    bars_ += bar_count;
+}
+
+PacingStats PacingPolicy::get_stats() const {
+    PacingStats stats;
+    stats.steps = steps_;
+    stats.bars = bars_;
+    stats.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+    stats.idle_seconds = std::chrono::duration<double>(idle_).count();
+    return stats;
+}
+
+WallClockScaledPacing::WallClockScaledPacing(double speed, std::chrono::milliseconds max_gap)
+    : speed_(speed > 0.0 ? speed : 1.0), max_gap_(max_gap) {
+}
+
+void WallClockScaledPacing::on_start() {
+    PacingPolicy::on_start();
+    anchored_ = false;
+    last_bar_time_ = 0;
+}
+
+void WallClockScaledPacing::pace(uint64_t bar_time, size_t bar_count) {
+    PacingPolicy::pace(bar_time, bar_count);
+
+    auto now = Clock::now();
+    if (!anchored_) {
+        anchored_ = true;
+        last_bar_time_ = bar_time;
+        target_ = now;
+        return;
+    }
+
+    if (bar_time > last_bar_time_) {
+        auto gap = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::nano>(static_cast<double>(bar_time - last_bar_time_) / speed_));
+        target_ += gap < max_gap_ ? gap : max_gap_;
+        last_bar_time_ = bar_time;
+    }
+
+    if (target_ > now) {
+        std::this_thread::sleep_until(target_);
+        add_idle(Clock::now() - now);
+    } else if (now - target_ > max_gap_) {
+        // Far behind (slow strategy or a debugger pause), do not burst to catch up
+        target_ = now;
+    }
+}
+
+void EventDrivenPacing::on_start() {
+    PacingPolicy::on_start();
+    std::lock_guard lock(mutex_);
+    interrupted_ = false;
+}
+
+bool EventDrivenPacing::wait_for_data() {
+    auto start = Clock::now();
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] { return data_pending_ || interrupted_; });
+    data_pending_ = false;
+    add_idle(Clock::now() - start);
+    return !interrupted_;
+}
+
+void EventDrivenPacing::notify_data() {
+    {
+        std::lock_guard lock(mutex_);
+        data_pending_ = true;
+    }
+    cv_.notify_one();
+}
+
+void EventDrivenPacing::interrupt() {
+    {
+        std::lock_guard lock(mutex_);
+        interrupted_ = true;
+    }
+    cv_.notify_all();
+}
+
+std::shared_ptr<PacingPolicy> create_pacing_policy(std::string_view replay_mode, double speed) {
+    if (replay_mode == "normal" || replay_mode == "stepped") {
+        return std::make_shared<UnthrottledPacing>();
+    } else if (replay_mode == "realtime") {
+        return std::make_shared<WallClockScaledPacing>(speed);
+    } else if (replay_mode == "event") {
+        return std::make_shared<EventDrivenPacing>();
+    }
+    return nullptr;
+}
+
+} // namespace cerebro
+} // namespace quanttrader
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace quanttrader {
+namespace cerebro {
+
+/**
+ * @brief Throughput and idle time of a cerebro event loop
+ */
+struct PacingStats {
+    uint64_t steps = 0;           // replay steps handed to strategies
+    uint64_t bars = 0;            // bars delivered across all feeds
+    double elapsed_seconds = 0.0; // wall time since the loop started
+    double idle_seconds = 0.0;    // wall time spent sleeping or blocked waiting for data
+
+    double bars_per_second() const { return elapsed_seconds > 0.0 ? static_cast<double>(bars) / elapsed_seconds : 0.0; }
+    double idle_ratio() const { return elapsed_seconds > 0.0 ? idle_seconds / elapsed_seconds : 0.0; }
+};
+
+/**
+ * @brief Decides how fast the cerebro event loop advances
+ *
+ * The loop calls pace() for every replay step before the step reaches the
+ * strategies, and wait_for_data() when the replay controller has nothing left.
+ */
+class PacingPolicy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~PacingPolicy() = default;
+
+    virtual std::string_view name() const = 0;
+
+    /**
+     * @brief Reset the statistics, called when the loop starts
+     */
+    virtual void on_start();
+
+    /**
+     * @brief Hold the step back if needed
+     *
+     * @param bar_time Timestamp of the step in nanoseconds
+     * @param bar_count Number of bars delivered in the step
+     */
+    virtual void pace(uint64_t bar_time, size_t bar_count);
+
+    /**
+     * @brief Block until new data may be available
+     *
+     * @return true if the loop should poll the feeds again, false if it should finish
+     */
+    virtual bool wait_for_data() { return false; }
+
+    /**
+     * @brief Signal that a feed received new data; may be called from any thread
+     */
+    virtual void notify_data() {}
+
+    /**
+     * @brief Wake up any blocking wait so the loop can stop
+     */
+    virtual void interrupt() {}
+
+    PacingStats get_stats() const;
+
+protected:
+    void add_idle(Clock::duration idle) { idle_ += idle; }
+
+private:
+    Clock::time_point start_ {};
+    Clock::duration idle_ {};
+    uint64_t steps_ = 0;
+    uint64_t bars_ = 0;
+};
+
+/**
+ * @brief Run as fast as the strategies allow, for backtests
+ */
+class UnthrottledPacing : public PacingPolicy {
+public:
+    std::string_view name() const override { return "unthrottled"; }
+};
+
+/**
+ * @brief Replay bars at a multiple of their recorded pace
+ *
+ * A speed of 60 plays one hour of market data in one minute. Gaps longer than
+ * max_gap of wall time (nights, weekends) are shortened to max_gap.
+ */
+class WallClockScaledPacing : public PacingPolicy {
+public:
+    explicit WallClockScaledPacing(double speed, std::chrono::milliseconds max_gap = std::chrono::seconds(10));
+
+    std::string_view name() const override { return "wall_clock"; }
+    void on_start() override;
+    void pace(uint64_t bar_time, size_t bar_count) override;
+
+private:
+    double speed_ = 1.0;
+    Clock::duration max_gap_;
+    bool anchored_ = false;
+    uint64_t last_bar_time_ = 0;
+    Clock::time_point target_ {};
+};
+
+/**
+ * @brief Block until a feed delivers new data, for live trading
+ */
+class EventDrivenPacing : public PacingPolicy {
+public:
+    std::string_view name() const override { return "event"; }
+    void on_start() override;
+    bool wait_for_data() override;
+    void notify_data() override;
+    void interrupt() override;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool data_pending_ = false;
+    bool interrupted_ = false;
+};
+
+/**
+ * @brief Create a pacing policy from a cerebro replay_mode setting
+ *
+ * @param replay_mode "normal", "stepped", "realtime" or "event"
+ * @param speed Replay speed for "realtime", 1 means the recorded pace
+ * @return The policy, or nullptr for an unknown mode
+ */
+std::shared_ptr<PacingPolicy> create_pacing_policy(std::string_view replay_mode, double speed = 1.0);
+
+} // namespace cerebro
+} // namespace quanttrader
@@ -0,0 +1,122 @@
+#include "bar_cache.h"
+#include <sstream>
+
+namespace quanttrader {
+namespace data {
+namespace util {
+
+std::string BarCacheKey::series() const {
+    // The separator does not appear in paths or symbols
+    return source + '\x1f' + symbol + '\x1f' + std::to_string(static_cast<int>(bar_type)) + '\x1f' + std::to_string(bar_size);
+}
+
+std::string BarCacheKey::to_string() const {
+    std::stringstream ss;
+    ss << series() << '\x1f' << (start_time.has_value() ? std::to_string(start_time.value()) : "-")
+       << '\x1f' << (end_time.has_value() ? std::to_string(end_time.value()) : "-");
+    return ss.str();
+}
+
+BarCache::BarCache() {
+    logger_ = quanttrader::log::get_common_rotation_logger("BarCache", "data");
+}
+
+size_t BarCache::byte_size(const BarSeriesView& bars) {
+    return bars.start_time.size_bytes() + bars.open.size_bytes() + bars.high.size_bytes() + bars.low.size_bytes() +
+           bars.close.size_bytes() + bars.wap.size_bytes() + bars.volume.size_bytes() + bars.count.size_bytes();
+}
+
+std::optional<SharedBarSeries> BarCache::get_or_load(const BarCacheKey& key, const Loader& loader) {
+    std::string series = key.series();
+    std::string full_key = key.to_string();
+    {
+        std::unique_lock lock(mutex_);
+        loaded_cv_.wait(lock, [this, &full_key] { return !loading_.contains(full_key); });
+        auto iter = index_.find(full_key);
+        if (iter != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            ++hits_;
+            return iter->second->bars;
+        }
+        ++misses_;
+        loading_.insert(full_key);
+    }
+
+    std::optional<SharedBarSeries> bars;
+    try {
+        bars = loader();
+    } catch (...) {
+        {
+            std::lock_guard lock(mutex_);
+            loading_.erase(full_key);
+        }
+        loaded_cv_.notify_all();
+        throw;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        loading_.erase(full_key);
+        if (bars.has_value()) {
+            size_t bytes = byte_size(bars->view);
+            if (bytes <= budget_) {
+                entries_.push_front(Entry{full_key, series, bars.value(), bytes});
+                index_[full_key] = entries_.begin();
+                bytes_ += bytes;
+                evict_over_budget();
+            } else {
+                logger_->debug("Not caching {} bars of {}, {} bytes exceed the budget of {}", bars->view.size(), key.symbol, bytes,
+                              budget_);
+            }
+        }
+    }
+    loaded_cv_.notify_all();
+    return bars;
+}
+
+void BarCache::invalidate(const std::string& source, const std::string& symbol, BarType bar_type, unsigned int bar_size) {
+    std::string series = BarCacheKey{source, symbol, bar_type, bar_size}.series();
+    std::lock_guard lock(mutex_);
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+        if (iter->series == series) {
+            bytes_ -= iter->bytes;
+            index_.erase(iter->key);
+            iter = entries_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void BarCache::set_memory_budget(size_t bytes) {
+    std::lock_guard lock(mutex_);
+    budget_ = bytes;
+    evict_over_budget();
+}
+
+BarCacheStats BarCache::get_stats() const {
+    std::lock_guard lock(mutex_);
+    return BarCacheStats{hits_, misses_, evictions_, entries_.size(), bytes_, budget_};
+}
+
+void BarCache::clear() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+void BarCache::evict_over_budget() {
+    while (bytes_ > budget_ && !entries_.empty()) {
+        Entry& entry = entries_.back();
+        logger_->debug("Evicting {} bytes of {}", entry.bytes, entry.key);
+        bytes_ -= entry.bytes;
+        index_.erase(entry.key);
+        entries_.pop_back();
+        ++evictions_;
+    }
+}
+
+}  // namespace util
+}  // namespace data
+}  // namespace quanttrader
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include "common/singleton.h"
+#include "logger/quantlogger.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace quanttrader {
+namespace data {
+namespace util {
+
+/**
+ * @brief Identifies one series of bars in the BarCache
+ *
+ * The source tells where the bars come from, e.g. a storage directory or a CSV file with
+ * its parsing options, so the same symbol read from two places is not mixed up.
+ */
+struct BarCacheKey {
+    std::string source;
+    std::string symbol;
+    BarType bar_type {BarType::NONE};
+    unsigned int bar_size {0};
+    std::optional<uint64_t> start_time {};
+    std::optional<uint64_t> end_time {};
+
+    std::string series() const;     // the key without the range
+    std::string to_string() const;
+};
+
+struct BarCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budget = 0;
+};
+
+/**
+ * @brief Process-wide cache of immutable bar series shared by all data providers
+ *
+ * Providers that load the same series get the same SharedBarSeries and attach it to their
+ * bar lines, every provider keeps its own cursor. The least recently used series are
+ * dropped once the cached bytes exceed the budget; providers holding an evicted series
+ * keep it alive until they release it. A series loaded by one thread is waited for by the
+ * others instead of being loaded twice.
+ */
+class BarCache : public Singleton<BarCache> {
+public:
+    using Loader = std::function<std::optional<SharedBarSeries>()>;
+
+    static constexpr size_t kDefaultBudget = 1024ULL * 1024 * 1024;
+
+    /**
+     * @brief Get a cached series or load and cache it
+     *
+     * @param key The series to get
+     * @param loader Loads the series on a miss, the bars must be sorted by time
+     * @return The shared bars, nullopt if the loader failed
+     */
+    std::optional<SharedBarSeries> get_or_load(const BarCacheKey& key, const Loader& loader);
+
+    /**
+     * @brief Drop all cached ranges of a series, e.g. after new bars were stored
+     *
+     * @param source The source of the series
+     * @param symbol The symbol of the series
+     * @param bar_type The bar type of the series
+     * @param bar_size The bar size of the series
+     */
+    void invalidate(const std::string& source, const std::string& symbol, BarType bar_type, unsigned int bar_size);
+
+    /**
+     * @brief Set the memory budget, evicting series above it
+     *
+     * @param bytes Budget in bytes, 0 disables caching
+     */
+    void set_memory_budget(size_t bytes);
+
+    BarCacheStats get_stats() const;
+
+    void clear();
+
+    /**
+     * @brief Memory taken by the columns of a series
+     */
+    static size_t byte_size(const BarSeriesView& bars);
+
+private:
+    friend class Singleton<BarCache>;
+    BarCache();
+
+    struct Entry {
+        std::string key;
+        std::string series;  // key without the range, for invalidate
+        SharedBarSeries bars;
+        size_t bytes = 0;
+    };
+
+    void evict_over_budget();  // should lock the mutex outside
+
+    mutable std::mutex mutex_;
+    std::condition_variable loaded_cv_;
+    std::list<Entry> entries_;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::unordered_set<std::string> loading_;  // keys being loaded by another thread
+    size_t budget_ = kDefaultBudget;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+    quanttrader::log::LoggerPtr logger_ {nullptr};
+};
+
+}  // namespace util
+}  // namespace data
+}  // namespace quanttrader
@@ -1,48 +1,237 @@
 #include "bar_line.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
 
 namespace quanttrader {
 namespace data {
 namespace util {
 
+namespace {
+
+template <typename T>
+void permute_column(std::vector<T> &column, const std::vector<size_t> &order) {
+    std::vector<T> result;
+    result.reserve(order.size());
+    for (size_t index : order) {
+        result.push_back(column[index]);
+    }
+    column.swap(result);
+}
+
+template <typename T>
+void append_column(std::vector<T> &to, const std::vector<T> &from) {
+    to.insert(to.end(), from.begin(), from.end());
+}
+
+void resize_columns(BarSeries &bars, size_t size) {
+    bars.start_time.resize(size);
+    bars.open.resize(size);
+    bars.high.resize(size);
+    bars.low.resize(size);
+    bars.close.resize(size);
+    bars.wap.resize(size);
+    bars.volume.resize(size);
+    bars.count.resize(size);
+}
+
+void set_bar(BarSeries &to, size_t index, const BarSeries &from, size_t from_index) {
+    to.start_time[index] = from.start_time[from_index];
+    to.open[index] = from.open[from_index];
+    to.high[index] = from.high[from_index];
+    to.low[index] = from.low[from_index];
+    to.close[index] = from.close[from_index];
+    to.wap[index] = from.wap[from_index];
+    to.volume[index] = from.volume[from_index];
+    to.count[index] = from.count[from_index];
+}
+
+void move_bar(BarSeries &bars, size_t to, size_t from) {
+    set_bar(bars, to, bars, from);
+}
+
+}  // namespace
+
+// One permutation applied to all columns
+void sort_and_dedupe(BarSeries &bars) {
+    std::vector<size_t> order(bars.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&bars](size_t a, size_t b) { return bars.start_time[a] < bars.start_time[b]; });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i + 1 < order.size() && bars.start_time[order[i]] == bars.start_time[order[i + 1]]) {
+            continue;  // a later bar with the same time follows
+        }
+        order[kept++] = order[i];
+    }
+    order.resize(kept);
+
+    permute_column(bars.start_time, order);
+    permute_column(bars.open, order);
+    permute_column(bars.high, order);
+    permute_column(bars.low, order);
+    permute_column(bars.close, order);
+    permute_column(bars.wap, order);
+    permute_column(bars.volume, order);
+    permute_column(bars.count, order);
+}
+
 std::optional<BarStruct> BarLine::next() {
-    std::shared_lock lock(bar_mutex_);
-    if (cur_ >= bars_.start_time.size()) {
+    // The cursor is written under the unique lock, readers of get_position() hold the shared one
+    std::unique_lock lock(bar_mutex_);
+    if (late_bar_at_cursor()) {
+        merge_late_bars();
+    }
+    auto bar = read_bar(cur_);
+    if (bar.has_value()) {
+        cur_++;
+    }
+    return bar;
+}
+
+std::optional<BarStruct> BarLine::read_bar(unsigned int index) const {
+    BarSeriesView bars = columns();
+    if (index >= bars.size()) {
         return std::nullopt;
     }
 
     BarStruct bar;
-    bar.time = bars_.start_time[cur_];
-    bar.open = bars_.open[cur_];
-    bar.high = bars_.high[cur_];
-    bar.low = bars_.low[cur_];
-    bar.close = bars_.close[cur_];
-    bar.volume = bars_.volume[cur_];
-    bar.swap = bars_.wap[cur_];
-    bar.count = bars_.count[cur_];
-    cur_++;
+    bar.time = bars.start_time[index];
+    bar.open = bars.open[index];
+    bar.high = bars.high[index];
+    bar.low = bars.low[index];
+    bar.close = bars.close[index];
+    bar.volume = bars.volume[index];
+    bar.swap = bars.wap[index];
+    bar.count = bars.count[index];
     return bar;
 }
 
-std::optional<int> BarLine::find_bar_position(uint64_t time) {
-    if (bars_.start_time.size() == 0) {
-        return kLastBarIndex;
+size_t BarLine::lower_bound_time(uint64_t time) const {
+    auto times = columns().start_time;
+    return static_cast<size_t>(std::distance(times.begin(), std::lower_bound(times.begin(), times.end(), time)));
+}
+
+BarSeriesView BarLine::columns() const {
+    return backing_ ? backing_->view : BarSeriesView(bars_);
+}
+
+SharedBarSeries BarLine::pin(size_t count) const {
+    std::shared_lock lock(bar_mutex_);
+    return SharedBarSeries{columns().subview(0, count), pinned_};
+}
+
+void BarLine::release_pinned(size_t appended, bool overwrites) {
+    if (overwrites) {
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    if (pinned_.use_count() == 1) {
+        // the readers dropped their pins, their reads happen before the change
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return;
     }
 
-    int last_index = static_cast<int>(bars_.start_time.size() - 1);
-    if (time == bars_.start_time[last_index]) {
-        // replace the last bar
-        return last_index;
-    } else if (time < bars_.start_time[last_index]) {
-        // find the proper position to inset the bar, if the time is dunplicated, return nullopt
-        auto iter = std::lower_bound(bars_.start_time.begin(), bars_.start_time.end(), time);
-        if (iter != bars_.start_time.end() && *iter == time) {
-            return std::nullopt;
-        } else {
-            return static_cast<int>(std::distance(bars_.start_time.begin(), iter)) + 1;
-        }
+    if (backing_) {
+        // materialize copies the attached bars anyway, the pins only keep their owner
+        pinned_->backing_owner = backing_->owner;
     } else {
-        return kLastBarIndex;
+        size_t size = bars_.size();
+        if (!overwrites && bars_.start_time.capacity() >= size + appended && bars_.open.capacity() >= size + appended &&
+            bars_.high.capacity() >= size + appended && bars_.low.capacity() >= size + appended &&
+            bars_.close.capacity() >= size + appended && bars_.wap.capacity() >= size + appended &&
+            bars_.volume.capacity() >= size + appended && bars_.count.capacity() >= size + appended) {
+            return;  // appending in place leaves the pinned bars untouched
+        }
+
+        logger_->debug("Copying {} pinned bars before a change", size);
+        pinned_->bars = std::move(bars_);
+        const BarSeries &pinned = pinned_->bars;
+        bars_ = BarSeries();
+        bars_.reserve(std::max(size + appended, size * 2));
+        append_column(bars_.start_time, pinned.start_time);
+        append_column(bars_.open, pinned.open);
+        append_column(bars_.high, pinned.high);
+        append_column(bars_.low, pinned.low);
+        append_column(bars_.close, pinned.close);
+        append_column(bars_.wap, pinned.wap);
+        append_column(bars_.volume, pinned.volume);
+        append_column(bars_.count, pinned.count);
     }
+    pinned_ = std::make_shared<PinnedColumns>();
+}
+
+void BarLine::materialize() {
+    if (!backing_) {
+        return;
+    }
+    release_pinned(0, true);
+    logger_->debug("Copying {} attached bars before a change", backing_->view.size());
+    bars_ = backing_->view.to_bar_series();
+    backing_.reset();
+}
+
+size_t BarLine::attach(SharedBarSeries bars) {
+    size_t count = bars.view.size();
+    std::unique_lock lock(bar_mutex_);
+    if (stored_size() == 0 && late_bars_.start_time.empty()) {
+        backing_ = std::move(bars);
+        return count;
+    }
+
+    // Already holding bars, fall back to a merge
+    merge_late_bars();
+    merge_batch(bars.view.to_bar_series());
+    return count;
+}
+
+void BarLine::store_bar(const BarStruct &bar) {
+    materialize();
+    if (bars_.start_time.empty() || bar.time > bars_.start_time.back()) {
+        release_pinned(1, false);
+        emplace_back(bar);
+        return;
+    }
+
+    auto iter = std::lower_bound(bars_.start_time.begin(), bars_.start_time.end(), bar.time);
+    if (*iter == bar.time) {
+        // maybe it is updated on real-time
+        int index = static_cast<int>(std::distance(bars_.start_time.begin(), iter));
+        release_pinned(0, true);
+        replace_data(index, bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.swap, bar.count);
+        return;
+    }
+
+    late_bars_.push_back(bar);
+    // next() merges before it reaches a staged bar, bars behind the cursor can wait
+    if (static_cast<size_t>(std::distance(bars_.start_time.begin(), iter)) >= cur_ &&
+        (!late_ahead_time_ || bar.time < *late_ahead_time_)) {
+        late_ahead_time_ = bar.time;
+    }
+    // Bound the staged bars when nobody reads, merging costs one pass over the columns
+    if (late_bars_.size() >= std::max(kMinLateBarsToMerge, bars_.size() / kLateBarsMergeRatio)) {
+        merge_late_bars();
+    }
+}
+
+void BarLine::merge_late_bars() {
+    if (late_bars_.start_time.empty()) {
+        return;
+    }
+    sort_and_dedupe(late_bars_);
+    merge_batch(std::move(late_bars_));
+    late_bars_ = BarSeries();
+    late_ahead_time_.reset();
+}
+
+bool BarLine::late_bar_at_cursor() const {
+    if (!late_ahead_time_) {
+        return false;
+    }
+    BarSeriesView bars = columns();
+    return cur_ >= bars.size() || *late_ahead_time_ < bars.start_time[cur_];
 }
 
 bool BarLine::emplace_back(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) {
@@ -69,31 +258,107 @@ bool BarLine::emplace_back(const BarStruct &bar) {
     return true;
 }
 
-bool BarLine::push_data(const BarStruct &bar) {
-    return push_data(bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.swap, bar.count);
-}
+size_t BarLine::append_batch(BarSeries &&bars) {
+    if (!bars.is_aligned()) {
+        logger_->error("Cannot append a batch with columns of different lengths");
+        return 0;
+    }
+    if (bars.start_time.empty()) {
+        return 0;
+    }
 
-bool BarLine::push_data(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) {
-    // lock the mutex first
+    // Feeds and storage deliver sorted bars, check that before paying for a sort
+    if (std::adjacent_find(bars.start_time.begin(), bars.start_time.end(), std::greater_equal<>{}) != bars.start_time.end()) {
+        sort_and_dedupe(bars);
+    }
+
+    size_t count = bars.size();
     std::unique_lock lock(bar_mutex_);
+    // Staged late bars are older updates, the batch has to win over them
+    merge_late_bars();
+    merge_batch(std::move(bars));
+    return count;
+}
 
-    auto position_opt = find_bar_position(time);
-    if (!position_opt.has_value()) {
-        return false;
+void BarLine::merge_batch(BarSeries &&bars) {
+    materialize();
+    if (bars_.start_time.empty()) {
+        bars_ = std::move(bars);
+        return;
     }
-    int position = position_opt.value();
 
-    if (position == kLastBarIndex) {
-        return emplace_back(time, open, high, low, close, vol, swap, count);
-    } else if (position == bars_.start_time.size() - 1) {
-        // replace the last data, maybe it is updated on real-time
-        replace_data(position, time, open, high, low, close, vol, swap, count);
-        return true;
-    } else {
-        // insert the data
-        insert_data(position, time, open, high, low, close, vol, swap, count);
-        return true;
+    if (bars.start_time.front() > bars_.start_time.back()) {
+        release_pinned(bars.size(), false);
+        bars_.reserve(bars_.size() + bars.size());
+        append_column(bars_.start_time, bars.start_time);
+        append_column(bars_.open, bars.open);
+        append_column(bars_.high, bars.high);
+        append_column(bars_.low, bars.low);
+        append_column(bars_.close, bars.close);
+        append_column(bars_.wap, bars.wap);
+        append_column(bars_.volume, bars.volume);
+        append_column(bars_.count, bars.count);
+        return;
+    }
+
+    // Overlapping ranges, the batch replaces stored bars with the same time. Only the stored bars
+    // after the first new one move, so the columns grow by the new bars and are merged from the back.
+    size_t size = bars_.size();
+    size_t first = static_cast<size_t>(std::distance(
+        bars_.start_time.begin(), std::lower_bound(bars_.start_time.begin(), bars_.start_time.end(), bars.start_time.front())));
+    size_t added = 0;
+    size_t added_before_cursor = 0;
+    for (size_t i = first, j = 0; j < bars.size();) {
+        if (i < size && bars_.start_time[i] < bars.start_time[j]) {
+            ++i;
+            continue;
+        }
+        if (i < size && bars_.start_time[i] == bars.start_time[j]) {
+            ++i;
+        } else {
+            // New bars that land before the cursor move it, so next() keeps returning the same bar
+            ++added;
+            added_before_cursor += i < cur_ ? 1 : 0;
+        }
+        ++j;
+    }
+
+    release_pinned(added, true);
+    resize_columns(bars_, size + added);
+    size_t to = size + added;
+    size_t i = size;
+    size_t j = bars.size();
+    while (j > 0) {
+        --to;
+        if (i > first && bars_.start_time[i - 1] > bars.start_time[j - 1]) {
+            move_bar(bars_, to, --i);
+            continue;
+        }
+        if (i > first && bars_.start_time[i - 1] == bars.start_time[j - 1]) {
+            --i;
+        }
+        set_bar(bars_, to, bars, --j);
     }
+    cur_ += static_cast<unsigned int>(added_before_cursor);
+}
+
+bool BarLine::push_data(const BarStruct &bar) {
+    std::unique_lock lock(bar_mutex_);
+    store_bar(bar);
+    return true;
+}
+
+bool BarLine::push_data(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) {
+    BarStruct bar;
+    bar.time = time;
+    bar.open = open;
+    bar.high = high;
+    bar.low = low;
+    bar.close = close;
+    bar.volume = vol;
+    bar.swap = swap;
+    bar.count = count;
+    return push_data(bar);
 }
 
 }  // namespace util
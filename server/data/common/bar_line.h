@@ -3,6 +3,7 @@
 #include "data/common/data_struct.h"
 #include "data/common/data_consts.h"
 #include "logger/quantlogger.h"
+#include <atomic>
 #include <shared_mutex>
 #include <optional>
 #include <array>
@@ -11,6 +12,13 @@ namespace quanttrader {
 namespace data {
 namespace util {
 
+/**
+ * @brief Sort bars by time and keep the last bar of every timestamp
+ *
+ * @param bars The bars to sort in place
+ */
+void sort_and_dedupe(BarSeries &bars);
+
 class BarLine {
 public:
     BarLine(unsigned int capacity, BarType bar_type, unsigned int bar_size) : bars_() {
@@ -24,8 +32,33 @@ public:
         // }
     }
 
-    bool push_data(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count);
-    bool push_data(const BarStruct &bar);
+    virtual ~BarLine() = default;
+
+    virtual bool push_data(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count);
+    virtual bool push_data(const BarStruct &bar);
+
+    /**
+     * @brief Add a batch of bars under a single lock
+     *
+     * Sorted input that starts after the last stored bar is appended column by column.
+     * Anything else is sorted, deduplicated (the later bar wins, as with push_data) and
+     * merged with the stored bars in one linear pass.
+     *
+     * @param bars Bars to add, the columns are consumed
+     * @return Number of distinct bars taken from the batch, 0 if the columns differ in length
+     */
+    virtual size_t append_batch(BarSeries &&bars);
+
+    /**
+     * @brief Serve read-only bars, e.g. a memory mapped storage file, without copying them
+     *
+     * The bars are copied into the line's own columns only when it is modified later.
+     * Call it before replay starts. If the line already holds bars the shared bars are merged in.
+     *
+     * @param bars Sorted bars and the owner that keeps them alive
+     * @return Number of bars attached
+     */
+    size_t attach(SharedBarSeries bars);
 
     bool set_capacity(unsigned int capacity) {
         if (capacity <= 0) {
@@ -56,32 +89,94 @@ public:
     }
     
     // Add methods to access and modify the cursor position
-    void reset() {
+    virtual void reset() {
         std::unique_lock lock(bar_mutex_);
+        merge_late_bars();  // staged bars behind the cursor are ahead of it again
         cur_ = 0;
     }
     
-    unsigned int get_position() const {
+    virtual unsigned int get_position() const {
         std::shared_lock lock(bar_mutex_);
         return cur_;
     }
     
-    void set_position(unsigned int position) {
+    virtual void set_position(unsigned int position) {
         std::unique_lock lock(bar_mutex_);
-        if (position <= size_) {
+        merge_late_bars();
+        if (position <= stored_size()) {
             cur_ = position;
         }
     }
 
-    std::optional<BarStruct> next();
+    /**
+     * @brief Move the cursor to the first bar at or after a time
+     *
+     * The start times are sorted, so the bar is found by binary search instead of
+     * replaying the bars before it. The bars before the cursor stay in the views.
+     *
+     * @param time Time in nanoseconds
+     * @return The new position, the number of bars before the time
+     */
+    virtual size_t seek(uint64_t time) {
+        std::unique_lock lock(bar_mutex_);
+        merge_late_bars();
+        cur_ = static_cast<unsigned int>(lower_bound_time(time));
+        return cur_;
+    }
+
+    virtual std::optional<BarStruct> next();
+
+    /**
+     * @brief Number of bars, including late bars that are not merged yet
+     */
+    virtual size_t size() const {
+        std::shared_lock lock(bar_mutex_);
+        return stored_size() + late_bars_.start_time.size();
+    }
+
+    /**
+     * @brief Get a read-only view over the first bars without copying them
+     * 
+     * Late bars show up in the view once they are merged: when next() reaches their position,
+     * on set_position() or seek(), or once enough of them are staged.
+     * 
+     * @param count Number of bars from the beginning, clamped to the bars stored
+     * @return The view, valid until the bar line stores new bars, use pin() to keep it longer
+     */
+    virtual BarSeriesView view(size_t count) const {
+        std::shared_lock lock(bar_mutex_);
+        return columns().subview(0, count);
+    }
+
+    /**
+     * @brief Get a read-only view over the first bars that stays valid while the owner is held
+     *
+     * A change that would move or overwrite pinned bars, e.g. growing a full column, a merge
+     * or an in place update from a live feed thread, first hands the columns to the owner and
+     * continues on a copy. Release the owner before storing bars on the same thread, so
+     * replay never pays for that copy.
+     *
+     * @param count Number of bars from the beginning, clamped to the bars stored
+     * @return The view and the owner keeping its bars alive
+     */
+    SharedBarSeries pin(size_t count) const;
+
+    /**
+     * @brief Counter of the changes that move or overwrite stored bars, read without the lock
+     *
+     * Appends after the last bar leave it unchanged, so a pinned view whose generation still
+     * matches holds the current bars.
+     */
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
     
     /**
      * @brief Rollback the cursor position by one, making the last retrieved bar available again
      * 
      * @return true if rollback was successful, false if already at the beginning
      */
-    bool rollback() {
+    virtual bool rollback() {
         std::unique_lock lock(bar_mutex_);
+        merge_late_bars();  // a staged bar may land right behind the cursor
         if (cur_ > 0) {
             cur_--;
             return true;
@@ -114,21 +209,19 @@ public:
     }
 
 protected:
-    std::optional<int> find_bar_position(uint64_t time);  // should lock the mutex outside
+    BarSeriesView columns() const;  // the attached bars until the first change, then bars_, should lock the mutex outside
+    size_t stored_size() const { return backing_ ? backing_->view.size() : bars_.start_time.size(); }
+    size_t lower_bound_time(uint64_t time) const;  // index of the first stored bar at or after time, should lock the mutex outside
+    void materialize();  // copy attached bars into bars_ before a change, should lock the mutex outside
+    void release_pinned(size_t appended, bool overwrites);  // hand pinned columns over before a change, should lock the mutex outside
+    std::optional<BarStruct> read_bar(unsigned int index) const;  // should lock the mutex outside
+    void store_bar(const BarStruct &bar);  // append, replace in place or stage a late bar, should lock the mutex outside
+    void merge_late_bars();  // move the staged late bars into the columns, should lock the mutex outside
+    bool late_bar_at_cursor() const;  // whether next() has to merge before reading, should lock the mutex outside
+    void merge_batch(BarSeries &&bars);  // bars must be sorted and unique, should lock the mutex outside
     bool emplace_back(const BarStruct &bar);
     bool emplace_back(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count);
 
-    inline void insert_data(int index, uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) {
-        bars_.start_time.insert(bars_.start_time.begin() + index, time);
-        bars_.open.insert(bars_.open.begin() + index, open);
-        bars_.high.insert(bars_.high.begin() + index, high);
-        bars_.low.insert(bars_.low.begin() + index, low);
-        bars_.close.insert(bars_.close.begin() + index, close);
-        bars_.wap.insert(bars_.wap.begin() + index, swap);
-        bars_.volume.insert(bars_.volume.begin() + index, vol);
-        bars_.count.insert(bars_.count.begin() + index, count);
-    }
-
     inline void replace_data(int index, uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) {
         bars_.start_time[index] = time;
         bars_.open[index] = open;
@@ -140,15 +233,31 @@ protected:
         bars_.count[index] = count;
     }
 
-private:
+protected:
+    static constexpr size_t kMinLateBarsToMerge = 4096;  // staged late bars merged without a reader asking
+    static constexpr size_t kLateBarsMergeRatio = 16;    // or once they reach 1/16 of the stored bars
+
     unsigned int cur_ = 0;
-    unsigned int size_ = 0;
     unsigned int capacity_ = 0;
     BarType bar_type_;
     unsigned int bar_size_ = 0;
     BarSeries bars_;
+    // Bars older than the last one and not in bars_ yet. Inserting them one by one would move
+    // every column behind them, so they are collected here and merged in one pass.
+    BarSeries late_bars_;
+    std::optional<uint64_t> late_ahead_time_;  // earliest staged bar at or after the cursor when it was staged
+    std::optional<SharedBarSeries> backing_;  // read-only bars served until the first change
+
+    // Owner handed out by pin(), it takes the columns pinned views point into before they change
+    struct PinnedColumns {
+        BarSeries bars;
+        std::shared_ptr<const void> backing_owner;
+    };
+    mutable std::shared_ptr<PinnedColumns> pinned_ = std::make_shared<PinnedColumns>();
+    std::atomic<uint64_t> generation_ {0};  // bumped by release_pinned before stored bars are overwritten
     quanttrader::log::LoggerPtr logger_ {nullptr};
 
+private:
     mutable std::shared_mutex bar_mutex_;
 };
 
@@ -17,6 +17,8 @@ constexpr const char *BAR_TYPE_NAME = "bar_type";
 constexpr const char *KEEP_UP_TO_DATE_NAME = "up_to_date";
 constexpr const char *NEED_RESAMPLE = "resample";
 constexpr const char *RESAMPLE_BAR_SIZE = "resample_bar_size";
+constexpr const char *DATA_BAR_LINE_NAME = "bar_line";
+constexpr const char *DATA_BAR_LINE_CAPACITY_NAME = "bar_line_capacity";
 
 constexpr const char *kDefaultSecurityType = "STK";
 constexpr const char *kDefaultExchange = "SMART";
@@ -27,6 +29,8 @@ constexpr const char *kDefaultDataType = "historical";
 constexpr const bool kDefaultUseRth = false;
 constexpr const char *kDefaultSessionStart = "09:30:00";
 constexpr const char *kDefaultSessionEnd = "16:00:00";
+constexpr const char *kDefaultBarLine = "locked";  // "locked" or "ring", see util::create_bar_line
+constexpr const int kDefaultBarLineCapacity = 4096;
 
 constexpr const char *DATA_SESSION_START_NAME = "session_start";
 constexpr const char *DATA_SESSION_END_NAME = "session_end";
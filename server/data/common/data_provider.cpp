@@ -1,5 +1,6 @@
 #include "data_provider.h"
 #include "data/resampler/data_resampler.h"
+#include "data/resampler/multi_resampler.h"
 #include <sstream>
 #include <regex>
 #include <algorithm>
@@ -35,6 +36,14 @@ std::shared_ptr<DataProvider> DataProvider::resample(BarType target_type, unsign
     return resampled_provider;
 }
 
+std::vector<std::shared_ptr<DataProvider>> DataProvider::resample(const std::vector<std::pair<BarType, unsigned int>>& targets) {
+    auto feeds = resampler::MultiResampler::create(this->shared_from_this(), targets);
+    if (feeds.empty()) {
+        logger_->error("Failed to resample data provider {} to {} timeframes", data_name_, targets.size());
+    }
+    return {feeds.begin(), feeds.end()};
+}
+
 bool DataProvider::rewind() {
     // Only allow rewind if we have a bar line
     if (!bar_line_) {
@@ -47,6 +56,44 @@ bool DataProvider::rewind() {
     return true;
 }
 
+bool DataProvider::set_position(size_t position) {
+    if (!bar_line_) {
+        logger_->error("Cannot set the position of data provider: bar line is not initialized");
+        return false;
+    }
+
+    bar_line_->set_position(static_cast<unsigned int>(std::min(position, bar_line_->size())));
+    while (get_position() < position) {
+        if (!next().has_value()) {
+            logger_->error("{} has {} of the {} bars to move to", data_name_, get_position(), position);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DataProvider::seek(uint64_t time) {
+    if (!bar_line_) {
+        logger_->error("Cannot seek data provider: bar line is not initialized");
+        return false;
+    }
+    bar_line_->seek(time);
+    return true;
+}
+
+size_t DataProvider::attach_cached_bars(const util::BarCacheKey& key, const util::BarCache::Loader& loader) {
+    if (!bar_line_) {
+        logger_->error("Cannot attach bars to {}: bar line is not initialized", data_name_);
+        return 0;
+    }
+
+    auto bars = get_config_value<bool>("use_bar_cache", true) ? util::BarCache::instance()->get_or_load(key, loader) : loader();
+    if (!bars.has_value()) {
+        return 0;
+    }
+    return bar_line_->attach(std::move(bars.value()));
+}
+
 std::pair<BarType, unsigned int> DataProvider::get_bar_type_from_string(const std::string &bar_type_str) {
     static const std::regex bar_regex(R"((\d+)\s+(\w+))");
     std::smatch match;
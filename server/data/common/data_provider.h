@@ -2,16 +2,19 @@
 
 #include "data/common/data_struct.h"
 #include "data/common/bar_line.h"
+#include "data/common/bar_cache.h"
 #include "logger/quantlogger.h"
 #include <string>
 #include <memory>
 #include <unordered_map>
 #include <any>
+#include <atomic>
 #include <optional>
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 
 namespace quanttrader {
 namespace broker {
@@ -22,6 +25,15 @@ namespace provider {
 
 using DataParamsType = std::shared_ptr<std::unordered_map<std::string, std::any>>;
 
+/**
+ * @brief Trading session of a provider, local times of day in the session timezone
+ */
+struct SessionHours {
+    std::string start;  // e.g. "09:30:00", empty when not configured
+    std::string end;    // e.g. "16:00:00", empty when not configured
+    std::string timezone;
+};
+
 /**
  * @brief Abstract base class for all data providers
  * 
@@ -34,7 +46,7 @@ public:
     // Replay mode options
     enum class ReplayMode {
         NORMAL,     // Return data as fast as possible
-        REALTIME,   // Simulate real-time data delivery based on bar timestamps
+        REALTIME,   // Simulate real-time data delivery, paced by the cerebro event loop
         STEPPED     // Manual stepping through data
     };
 
@@ -110,6 +122,16 @@ public:
      */
     virtual bool is_data_ready() = 0;
 
+    /**
+     * @brief Get the reason the data will not get ready, e.g. a request that failed
+     * 
+     * @return The reason, std::nullopt while the data may still get ready
+     */
+    std::optional<std::string> get_data_error() const {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        return data_error_;
+    }
+
     /**
      * @brief Get the next data point
      * 
@@ -117,6 +139,57 @@ public:
      */
     virtual std::optional<BarStruct> next() = 0;
 
+    /**
+     * @brief Get a read-only view over the first bars of this provider
+     * 
+     * @param count Number of bars from the beginning, clamped to the bars available
+     * @return The view, valid until the provider stores new bars
+     */
+    virtual BarSeriesView get_bar_view(size_t count) const {
+        return bar_line_ ? bar_line_->view(count) : BarSeriesView{};
+    }
+
+    /**
+     * @brief Get a read-only view over the first bars that stays valid while its owner is held
+     * 
+     * Live feed threads and lazy resamplers may store bars at any time, see BarLine::pin.
+     * 
+     * @param count Number of bars from the beginning, clamped to the bars available
+     * @return The view and the owner keeping its bars alive
+     */
+    virtual SharedBarSeries pin_bar_view(size_t count) const {
+        return bar_line_ ? bar_line_->pin(count) : SharedBarSeries{};
+    }
+
+    /**
+     * @brief Get the generation of the stored bars, see BarLine::generation
+     * 
+     * @return A counter that changes when bars already stored are moved or overwritten
+     */
+    virtual uint64_t get_bar_generation() const {
+        return bar_line_ ? bar_line_->generation() : 0;
+    }
+
+    /**
+     * @brief Get the number of bars returned by next() since the last rewind
+     * 
+     * @return The cursor position
+     */
+    virtual size_t get_position() const {
+        return bar_line_ ? bar_line_->get_position() : 0;
+    }
+
+    /**
+     * @brief Move the cursor to a number of returned bars, e.g. to restore a checkpoint
+     * 
+     * Stored bars are reached directly, bars not stored yet are read with next(), so a
+     * resampler builds the periods it has not served yet. Call it in normal replay mode.
+     * 
+     * @param position The number of bars next() has returned
+     * @return true if the provider has that many bars
+     */
+    virtual bool set_position(size_t position);
+
     /**
      * @brief Get the data prefix
      * 
@@ -186,6 +259,14 @@ public:
      */
     virtual std::shared_ptr<DataProvider> resample(BarType target_type, unsigned int target_size);
 
+    /**
+     * @brief Resample data to several timeframes in one pass over this provider
+     * 
+     * @param targets The target bar types and sizes
+     * @return One provider per distinct target, empty if a target is invalid
+     */
+    std::vector<std::shared_ptr<DataProvider>> resample(const std::vector<std::pair<BarType, unsigned int>>& targets);
+
     /**
      * @brief Rewind the data provider to the beginning
      * 
@@ -193,6 +274,16 @@ public:
      */
     virtual bool rewind();
 
+    /**
+     * @brief Move to the first bar at or after a time without replaying the bars before it
+     * 
+     * The bars before the time stay in the views, as history for the strategies.
+     * 
+     * @param time Time in nanoseconds
+     * @return true if the provider moved, false if it cannot seek
+     */
+    virtual bool seek(uint64_t time);
+
     /**
      * @brief Rollback the last retrieved bar and make it available again
      * 
@@ -226,6 +317,63 @@ public:
         broker_provider_ = broker_provider;
     }
 
+    using DataListener = std::function<void()>;
+
+    /**
+     * @brief Register a callback that is invoked whenever new bars become available
+     * 
+     * The callback runs on the thread that delivers the data, e.g. the broker callback thread.
+     * 
+     * @param listener The callback, an empty function removes it
+     */
+    void set_data_listener(DataListener listener) {
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        data_listener_ = std::move(listener);
+    }
+
+    using ReadyListener = std::function<void()>;
+
+    /**
+     * @brief Register a callback that is invoked once the data becomes ready
+     * 
+     * The callback runs on the thread that marks the data ready.
+     * 
+     * @param listener The callback, an empty function removes it
+     */
+    void set_ready_listener(ReadyListener listener) {
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        ready_listener_ = std::move(listener);
+    }
+
+    /**
+     * @brief Whether start_request_data may run on a pool thread together with other providers
+     * 
+     * Providers that read other providers or share a connection start one after another.
+     */
+    virtual bool supports_parallel_start() const { return true; }
+
+    /**
+     * @brief Whether bars keep arriving after the data is ready, e.g. real time feeds
+     * 
+     * A provider that returns std::nullopt from next() while live has no bars yet rather than none left.
+     */
+    virtual bool is_live() const { return false; }
+
+    /**
+     * @brief Get the trading session from the session_start, session_end and session_timezone params
+     *
+     * @return The session, in the provider's timezone unless a session timezone is set
+     */
+    virtual SessionHours get_session_hours() const {
+        SessionHours session {get_config_value<std::string>(DATA_SESSION_START_NAME, ""),
+                              get_config_value<std::string>(DATA_SESSION_END_NAME, ""),
+                              get_config_value<std::string>(DATA_SESSION_TIMEZONE_NAME, "")};
+        if (session.timezone.empty()) {
+            session.timezone = get_timezone();
+        }
+        return session;
+    }
+
     inline bool need_resample() const { return get_config_value<bool>(NEED_RESAMPLE, false); }
     inline std::string get_resample_size() const { return get_config_value<std::string>(RESAMPLE_BAR_SIZE); }
 
@@ -272,23 +420,51 @@ protected:
     }
 
     /**
-     * @brief Wait for the appropriate time in REALTIME replay mode
+     * @brief Tell the data listener that new bars were added
+     */
+    void notify_data_listener() {
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        if (data_listener_) {
+            data_listener_();
+        }
+    }
+
+    /**
+     * @brief Attach bars shared through the process-wide BarCache to the bar line
+     * 
+     * Providers that load the same series share one copy of the columns. The "use_bar_cache"
+     * param set to false loads a private copy instead.
      * 
-     * @param current_bar The current bar
-     * @param last_bar The previous bar
+     * @param key The series to attach
+     * @param loader Loads the series when it is not cached, the bars must be sorted by time
+     * @return Number of bars attached, 0 if loading failed
      */
-    void wait_for_realtime(const BarStruct &current_bar, const BarStruct &last_bar) {
-        if (replay_mode_ == ReplayMode::REALTIME && last_bar.time > 0) {
-            auto time_diff_ns = current_bar.time - last_bar.time;
-            auto sleep_time = std::chrono::nanoseconds(time_diff_ns);
-            
-            // Cap the sleep time to a reasonable value (e.g., 10 seconds)
-            auto max_sleep = std::chrono::seconds(10);
-            if (sleep_time > max_sleep) {
-                sleep_time = max_sleep;
-            }
-            
-            std::this_thread::sleep_for(sleep_time);
+    size_t attach_cached_bars(const util::BarCacheKey& key, const util::BarCache::Loader& loader);
+
+    /**
+     * @brief Mark the data ready and tell the ready listener the first time
+     */
+    void mark_data_ready() {
+        if (data_ready_.exchange(true)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        if (ready_listener_) {
+            ready_listener_();
+        }
+    }
+
+    /**
+     * @brief Record why the data will not get ready and tell the ready listener, so waiters stop early
+     */
+    void mark_data_failed(const std::string& reason) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            data_error_ = reason;
+        }
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        if (ready_listener_) {
+            ready_listener_();
         }
     }
 
@@ -312,7 +488,9 @@ protected:
     BarType bar_type_ {BarType::NONE};
     unsigned int bar_size_ {0};
     std::shared_ptr<util::BarLine> bar_line_ {nullptr};
-    bool data_ready_ {false};
+    std::atomic<bool> data_ready_ {false};  // set by the thread that delivers the data
+    mutable std::mutex error_mutex_;  // not held while the ready listener runs, waiters read the error under their lock
+    std::optional<std::string> data_error_ {};
     
     // Replay control
     ReplayMode replay_mode_ {ReplayMode::NORMAL};
@@ -321,6 +499,9 @@ protected:
     std::mutex step_mutex_;
     std::condition_variable step_cv_;
     std::shared_ptr<broker::BrokerProvider> broker_provider_ {nullptr};
+    std::mutex listener_mutex_;
+    DataListener data_listener_;
+    ReadyListener ready_listener_;
 };
 
 } // namespace provider
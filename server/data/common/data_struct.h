@@ -9,6 +9,9 @@
 #include <ctime>
 #include <cstring>
 #include <sstream>
+#include <span>
+#include <string>
+#include <algorithm>
 
 namespace quanttrader {
 namespace data {
@@ -73,6 +76,54 @@ struct BarSeries {
     std::vector<Decimal> volume;  // volume
     std::vector<int> count;
 
+    size_t size() const { return start_time.size(); }
+
+    // true if every column holds the same number of bars
+    bool is_aligned() const {
+        size_t n = start_time.size();
+        return open.size() == n && high.size() == n && low.size() == n && close.size() == n &&
+               wap.size() == n && volume.size() == n && count.size() == n;
+    }
+
+    void reserve(size_t capacity) {
+        start_time.reserve(capacity);
+        open.reserve(capacity);
+        high.reserve(capacity);
+        low.reserve(capacity);
+        close.reserve(capacity);
+        wap.reserve(capacity);
+        volume.reserve(capacity);
+        count.reserve(capacity);
+    }
+
+    void push_back(uint64_t time, double open_price, double high_price, double low_price, double close_price, Decimal vol, Decimal swap, int bar_count) {
+        start_time.push_back(time);
+        open.push_back(open_price);
+        high.push_back(high_price);
+        low.push_back(low_price);
+        close.push_back(close_price);
+        wap.push_back(swap);
+        volume.push_back(vol);
+        count.push_back(bar_count);
+    }
+
+    void push_back(const BarStruct &bar) {
+        push_back(bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.swap, bar.count);
+    }
+
+    // Append the bars of another series starting at index first
+    void append(const BarSeries &other, size_t first = 0) {
+        first = std::min(first, other.size());
+        start_time.insert(start_time.end(), other.start_time.begin() + first, other.start_time.end());
+        open.insert(open.end(), other.open.begin() + first, other.open.end());
+        high.insert(high.end(), other.high.begin() + first, other.high.end());
+        low.insert(low.end(), other.low.begin() + first, other.low.end());
+        close.insert(close.end(), other.close.begin() + first, other.close.end());
+        wap.insert(wap.end(), other.wap.begin() + first, other.wap.end());
+        volume.insert(volume.end(), other.volume.begin() + first, other.volume.end());
+        count.insert(count.end(), other.count.begin() + first, other.count.end());
+    }
+
     std::string last_one_to_string() const {
         if (close.empty()) {
             return "BarSeries is empty";
@@ -89,5 +140,111 @@ struct BarSeries {
     }
 };
 
+/**
+ * @brief Read-only window over the first bars of a columnar bar store
+ *
+ * The spans point into the owner's columns, so nothing is copied and the column
+ * pointers can be passed to ta-lib as they are. A view stays valid until the
+ * owner appends or inserts bars.
+ */
+struct BarSeriesView {
+    std::span<const uint64_t> start_time;
+    std::span<const double> open;
+    std::span<const double> high;
+    std::span<const double> low;
+    std::span<const double> close;
+    std::span<const Decimal> wap;
+    std::span<const Decimal> volume;
+    std::span<const int> count;
+
+    BarSeriesView() = default;
+    BarSeriesView(const BarSeries &series) : BarSeriesView(series, series.start_time.size()) {}
+    BarSeriesView(const BarSeries &series, size_t bar_count)
+        : start_time(prefix(series.start_time, bar_count)),
+          open(prefix(series.open, bar_count)),
+          high(prefix(series.high, bar_count)),
+          low(prefix(series.low, bar_count)),
+          close(prefix(series.close, bar_count)),
+          wap(prefix(series.wap, bar_count)),
+          volume(prefix(series.volume, bar_count)),
+          count(prefix(series.count, bar_count)) {}
+
+    size_t size() const { return start_time.size(); }
+    bool empty() const { return start_time.empty(); }
+
+    /**
+     * @brief Narrow the view to a range of bars
+     *
+     * @param offset Index of the first bar, clamped to the view size
+     * @param bar_count Number of bars, clamped to the bars after offset
+     */
+    BarSeriesView subview(size_t offset, size_t bar_count) const {
+        offset = std::min(offset, size());
+        bar_count = std::min(bar_count, size() - offset);
+        BarSeriesView result;
+        result.start_time = start_time.subspan(offset, bar_count);
+        result.open = open.subspan(offset, bar_count);
+        result.high = high.subspan(offset, bar_count);
+        result.low = low.subspan(offset, bar_count);
+        result.close = close.subspan(offset, bar_count);
+        result.wap = wap.subspan(offset, bar_count);
+        result.volume = volume.subspan(offset, bar_count);
+        result.count = count.subspan(offset, bar_count);
+        return result;
+    }
+
+    BarSeries to_bar_series() const {
+        BarSeries series;
+        series.start_time.assign(start_time.begin(), start_time.end());
+        series.open.assign(open.begin(), open.end());
+        series.high.assign(high.begin(), high.end());
+        series.low.assign(low.begin(), low.end());
+        series.close.assign(close.begin(), close.end());
+        series.wap.assign(wap.begin(), wap.end());
+        series.volume.assign(volume.begin(), volume.end());
+        series.count.assign(count.begin(), count.end());
+        return series;
+    }
+
+    std::string last_one_to_string() const {
+        if (close.empty()) {
+            return "BarSeries is empty";
+        }
+        BarStruct last_bar;
+        last_bar.time = start_time.back();
+        last_bar.open = open.back();
+        last_bar.high = high.back();
+        last_bar.low = low.back();
+        last_bar.close = close.back();
+        last_bar.volume = volume.back();
+        last_bar.count = count.back();
+        return last_bar.to_string();
+    }
+
+private:
+    template <typename T>
+    static std::span<const T> prefix(const std::vector<T> &column, size_t bar_count) {
+        return std::span<const T>(column.data(), std::min(bar_count, column.size()));
+    }
+};
+
+/**
+ * @brief Immutable bars shared without copying, e.g. a memory mapped file
+ *
+ * The owner keeps the memory behind the view alive for as long as any copy exists.
+ */
+struct SharedBarSeries {
+    BarSeriesView view;
+    std::shared_ptr<const void> owner;
+
+    /**
+     * @brief Share bars owned by the heap, the columns are moved
+     */
+    static SharedBarSeries own(BarSeries &&bars) {
+        auto owner = std::make_shared<const BarSeries>(std::move(bars));
+        return SharedBarSeries{BarSeriesView(*owner), owner};
+    }
+};
+
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "ring_bar_line.h"
+#include <bit>
+#include <cstring>
+
+namespace quanttrader {
+namespace data {
+namespace util {
+
+RingBarLine::RingBarLine(unsigned int capacity, BarType bar_type, unsigned int bar_size)
+    : BarLine(capacity, bar_type, bar_size) {
+    size_t ring_size = std::bit_ceil(static_cast<size_t>(capacity < 2 ? 2 : capacity));
+    ring_.resize(ring_size);
+    mask_ = ring_size - 1;
+    capacity_ = static_cast<unsigned int>(ring_size);
+}
+
+bool RingBarLine::push_data(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) {
+    BarStruct bar;
+    bar.time = time;
+    bar.open = open;
+    bar.high = high;
+    bar.low = low;
+    bar.close = close;
+    bar.volume = vol;
+    bar.swap = swap;
+    bar.count = count;
+    return push_data(bar);
+}
+
+bool RingBarLine::push_data(const BarStruct &bar) {
+    if (!writer_has_bar_) {
+        writer_bar_ = bar;
+        writer_has_bar_ = true;
+        publish_live(bar);
+    } else if (bar.time == writer_bar_.time) {
+        // the current bar is updated in place
+        writer_bar_ = bar;
+        publish_live(bar);
+    } else if (bar.time > writer_bar_.time) {
+        // the current bar is finished, it must reach the reader before the new live bar
+        enqueue(writer_bar_);
+        writer_bar_ = bar;
+        publish_live(bar);
+    } else {
+        // a late bar, the reader inserts it at the right position
+        enqueue(bar);
+    }
+    return true;
+}
+
+size_t RingBarLine::append_batch(BarSeries &&bars) {
+    if (!bars.is_aligned()) {
+        logger_->error("Cannot append a batch with columns of different lengths");
+        return 0;
+    }
+
+    // The column store belongs to the reader, the writer can only hand bars over
+    size_t count = 0;
+    for (size_t i = 0; i < bars.size(); ++i) {
+        BarStruct bar;
+        bar.time = bars.start_time[i];
+        bar.open = bars.open[i];
+        bar.high = bars.high[i];
+        bar.low = bars.low[i];
+        bar.close = bars.close[i];
+        bar.volume = bars.volume[i];
+        bar.swap = bars.wap[i];
+        bar.count = bars.count[i];
+        count += push_data(bar) ? 1 : 0;
+    }
+    return count;
+}
+
+void RingBarLine::enqueue(const BarStruct &bar) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (!overflow_pending_.load(std::memory_order_relaxed)) {
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+        }
+        if (tail - cached_head_ <= mask_) {
+            ring_[tail & mask_] = bar;
+            tail_.store(tail + 1, std::memory_order_release);
+            return;
+        }
+    }
+
+    // The reader is behind, do not block the broker thread
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    overflow_.push_back(bar);
+    overflow_pending_.store(true, std::memory_order_release);
+    overflow_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RingBarLine::publish_live(const BarStruct &bar) {
+    uint64_t words[kBarWords];
+    std::memcpy(words, &bar, sizeof(BarStruct));
+
+    uint64_t seq = live_seq_.load(std::memory_order_relaxed);
+    live_seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kBarWords; ++i) {
+        live_words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    live_seq_.store(seq + 2, std::memory_order_release);
+}
+
+bool RingBarLine::read_live(BarStruct &bar) {
+    uint64_t words[kBarWords];
+    while (true) {
+        uint64_t seq = live_seq_.load(std::memory_order_acquire);
+        if (seq == reader_live_seq_) {
+            return false;
+        }
+        if (seq & 1) {
+            continue;  // the writer is in the middle of an update
+        }
+
+        for (size_t i = 0; i < kBarWords; ++i) {
+            words[i] = live_words_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (live_seq_.load(std::memory_order_relaxed) == seq) {
+            reader_live_seq_ = seq;
+            std::memcpy(&bar, words, sizeof(BarStruct));
+            return true;
+        }
+    }
+}
+
+void RingBarLine::drain() {
+    // Snapshot the live bar first: its release makes every bar finished before it visible in the ring
+    BarStruct live_bar;
+    bool has_live = read_live(live_bar);
+
+    // The writer may finish the live bar and go on after the snapshot, the ring then holds newer versions
+    uint64_t latest_time = 0;
+    bool has_latest = false;
+    auto take = [&](const BarStruct &bar) {
+        store_bar(bar);
+        if (!has_latest || bar.time > latest_time) {
+            latest_time = bar.time;
+            has_latest = true;
+        }
+    };
+
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    while (head != tail) {
+        take(ring_[head & mask_]);
+        ++head;
+    }
+    head_.store(head, std::memory_order_release);
+
+    if (overflow_pending_.load(std::memory_order_acquire)) {
+        std::vector<BarStruct> overflow;
+        {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            overflow.swap(overflow_);
+            overflow_pending_.store(false, std::memory_order_release);
+        }
+        for (const auto &bar : overflow) {
+            take(bar);
+        }
+    }
+
+    // A snapshot at or before a bar from the ring was finished after it was read, the ring has its last version
+    if (has_live && !(has_latest && live_bar.time <= latest_time)) {
+        store_bar(live_bar);
+    }
+}
+
+std::optional<BarStruct> RingBarLine::next() {
+    drain();
+    if (late_bar_at_cursor()) {
+        merge_late_bars();
+    }
+    auto bar = read_bar(cur_);
+    if (bar.has_value()) {
+        cur_++;
+    }
+    return bar;
+}
+
+void RingBarLine::reset() {
+    merge_late_bars();
+    cur_ = 0;
+}
+
+void RingBarLine::set_position(unsigned int position) {
+    drain();
+    merge_late_bars();
+    if (position <= stored_size()) {
+        cur_ = position;
+    }
+}
+
+size_t RingBarLine::seek(uint64_t time) {
+    drain();
+    merge_late_bars();
+    cur_ = static_cast<unsigned int>(lower_bound_time(time));
+    return cur_;
+}
+
+bool RingBarLine::rollback() {
+    merge_late_bars();
+    if (cur_ > 0) {
+        cur_--;
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<BarLine> create_bar_line(std::string_view kind, unsigned int capacity, BarType bar_type, unsigned int bar_size) {
+    if (kind.empty() || kind == "locked") {
+        return std::make_shared<BarLine>(capacity, bar_type, bar_size);
+    } else if (kind == "ring") {
+        return std::make_shared<RingBarLine>(capacity, bar_type, bar_size);
+    }
+    return nullptr;
+}
+
+}  // namespace util
+}  // namespace data
+}  // namespace quanttrader
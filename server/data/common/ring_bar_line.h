@@ -0,0 +1,101 @@
+#pragma once
+
+#include "data/common/bar_line.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace util {
+
+/**
+ * @brief BarLine for live feeds with one writer thread and one reader thread
+ *
+ * The writer (the broker callback thread) never touches the column store. Finished
+ * bars go through a bounded single-producer/single-consumer ring, the bar that is
+ * still being updated in place is published through a seqlock slot. The reader
+ * (the cerebro thread) drains both into its own column store inside next(), so
+ * views over the store stay contiguous and the read path takes no lock.
+ *
+ * Only the writer may call push_data, all other methods belong to the reader.
+ * If the ring is full the writer parks bars in a mutex protected overflow list
+ * instead of blocking, e.g. while a large history arrives before replay starts.
+ */
+class RingBarLine : public BarLine {
+public:
+    /**
+     * @param capacity Ring capacity in bars, rounded up to a power of two
+     */
+    RingBarLine(unsigned int capacity, BarType bar_type, unsigned int bar_size);
+    ~RingBarLine() override = default;
+
+    // Writer side
+    bool push_data(uint64_t time, double open, double high, double low, double close, Decimal vol, Decimal swap, int count) override;
+    bool push_data(const BarStruct &bar) override;
+    size_t append_batch(BarSeries &&bars) override;  // pushes the bars through the ring one by one
+
+    // Reader side
+    std::optional<BarStruct> next() override;
+    void reset() override;
+    unsigned int get_position() const override { return cur_; }
+    void set_position(unsigned int position) override;
+    size_t seek(uint64_t time) override;
+    bool rollback() override;
+    size_t size() const override { return stored_size() + late_bars_.size(); }
+    BarSeriesView view(size_t count) const override { return columns().subview(0, count); }
+
+    size_t ring_capacity() const { return ring_.size(); }
+    uint64_t overflow_count() const { return overflow_count_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+    static constexpr size_t kBarWords = sizeof(BarStruct) / sizeof(uint64_t);
+    static_assert(sizeof(BarStruct) % sizeof(uint64_t) == 0, "BarStruct must be made of whole words for the seqlock slot");
+
+    void enqueue(const BarStruct &bar);
+    void publish_live(const BarStruct &bar);
+    bool read_live(BarStruct &bar);
+    void drain();
+
+    // Ring storage, written by the writer before the tail is released
+    std::vector<BarStruct> ring_;
+    size_t mask_ = 0;
+
+    alignas(kCacheLine) std::atomic<size_t> head_ {0};  // next slot the reader consumes
+    alignas(kCacheLine) std::atomic<size_t> tail_ {0};  // next slot the writer fills
+    alignas(kCacheLine) size_t cached_head_ = 0;        // writer's last view of head_
+
+    // Writer private state: the bar that is still being updated in place
+    BarStruct writer_bar_ {};
+    bool writer_has_bar_ = false;
+
+    // Seqlock slot holding the latest version of writer_bar_, odd sequence while it is written
+    alignas(kCacheLine) std::atomic<uint64_t> live_seq_ {0};
+    std::atomic<uint64_t> live_words_[kBarWords] {};
+
+    // Slow path when the ring is full
+    alignas(kCacheLine) std::atomic<bool> overflow_pending_ {false};
+    std::atomic<uint64_t> overflow_count_ {0};
+    std::mutex overflow_mutex_;
+    std::vector<BarStruct> overflow_;
+
+    // Reader private state
+    alignas(kCacheLine) uint64_t reader_live_seq_ = 0;
+};
+
+/**
+ * @brief Create the BarLine implementation selected in a data config
+ *
+ * @param kind "locked" (default, shared_mutex protected) or "ring" (lock-free single writer, single reader)
+ * @param capacity Initial capacity, the ring capacity for "ring"
+ * @return The bar line, or nullptr for an unknown kind
+ */
+std::shared_ptr<BarLine> create_bar_line(std::string_view kind, unsigned int capacity, BarType bar_type, unsigned int bar_size);
+
+}  // namespace util
+}  // namespace data
+}  // namespace quanttrader
@@ -1,13 +1,11 @@
 #include "csv_data_feed.h"
+#include "csv_parser.h"
 #include "data/storage/storage_factory.h"
 #include "time/time_with_zone.h"
-#include <fstream>
 #include <sstream>
 #include <vector>
 #include <algorithm>
 #include <filesystem>
-#include <iomanip>
-#include <ctime>
 
 namespace fs = std::filesystem;
 namespace qtime = quanttrader::time;
@@ -58,6 +56,7 @@ bool CsvDataFeed::prepare_data() {
     volume_column_ = get_config_value<int>("volume_column", 5);
     has_header_ = get_config_value<bool>("has_header", true);
     date_format_ = get_config_value<std::string>("date_format", "%Y-%m-%d");
+    csv_threads_ = static_cast<size_t>(std::max(get_config_value<int>("csv_threads", 0), 0));
     
     // Configure storage options
     use_storage_ = get_config_value<bool>("use_storage", false);
@@ -73,7 +72,8 @@ bool CsvDataFeed::prepare_data() {
     // Initialize storage if needed using the factory
     if (use_storage_ || store_after_load_) {
         storage_ = storage::StorageFactory::create(storage_type);
-        if (!storage_->initialize(storage_path_)) {
+        storage_source_ = "storage:" + storage_type + ":" + fs::absolute(storage_path_).string();
+        if ((params_ && !storage_->configure(*params_)) || !storage_->initialize(storage_path_)) {
             logger_->error("Failed to initialize {} storage at path: {}", storage_type, storage_path_);
             return false;
         }
@@ -89,7 +89,7 @@ bool CsvDataFeed::start_request_data() {
             logger_->info("Loading {} data for {} from storage", 
                 get_bar_type_string(bar_type_, bar_size_), symbol_);
             if (load_from_storage()) {
-                data_ready_ = true;
+                mark_data_ready();
                 return true;
             } else {
                 logger_->warn("Failed to load data from storage, falling back to CSV");
@@ -99,7 +99,7 @@ bool CsvDataFeed::start_request_data() {
     
     // Load from CSV file
     if (load_from_csv()) {
-        data_ready_ = true;
+        mark_data_ready();
         
         // Store the data if requested
         if (store_after_load_ && storage_) {
@@ -131,9 +131,6 @@ std::optional<BarStruct> CsvDataFeed::next() {
         // Handle replay modes
         BarStruct current_bar = bar_opt.value();
         
-        // For realtime mode, wait appropriately
-        wait_for_realtime(current_bar, last_bar_);
-        
         // For stepped mode, wait for step signal
         wait_for_step();
         
@@ -145,84 +142,30 @@ std::optional<BarStruct> CsvDataFeed::next() {
 }
 
 bool CsvDataFeed::load_from_csv() {
-    std::ifstream file(csv_file_path_);
-    if (!file.is_open()) {
+    // An edited file has another size or modification time and is parsed again
+    std::error_code ec;
+    auto file_size = fs::file_size(csv_file_path_, ec);
+    auto write_time = ec ? fs::file_time_type{} : fs::last_write_time(csv_file_path_, ec);
+    if (ec) {
         logger_->error("Failed to open CSV file: {}", csv_file_path_);
         return false;
     }
-    
-    std::string line;
+    std::stringstream source;
+    source << "csv:" << fs::absolute(csv_file_path_).string() << '|' << file_size << '|' << write_time.time_since_epoch().count()
+           << '|' << delimiter_ << '|' << date_format_ << '|' << has_header_ << '|' << date_time_column_ << ',' << open_column_
+           << ',' << high_column_ << ',' << low_column_ << ',' << close_column_ << ',' << volume_column_;
+
     int line_count = 0;
-    int data_count = 0;
-    
-    // Skip header if needed
-    if (has_header_ && std::getline(file, line)) {
-        line_count++;
-    }
-    
-    // Process each line
-    while (std::getline(file, line)) {
-        line_count++;
-        
-        std::vector<std::string> tokens;
-        std::stringstream ss(line);
-        std::string token;
-        
-        // Split the line by delimiter
-        while (std::getline(ss, token, delimiter_)) {
-            tokens.push_back(token);
-        }
-        
-        // Check if we have enough columns
-        size_t max_col = date_time_column_;
-        max_col = (max_col < open_column_) ? open_column_ : max_col;
-        max_col = (max_col < high_column_) ? high_column_ : max_col;
-        max_col = (max_col < low_column_) ? low_column_ : max_col;
-        max_col = (max_col < close_column_) ? close_column_ : max_col;
-        max_col = (max_col < volume_column_) ? volume_column_ : max_col;
-        
-        if (tokens.size() <= max_col) {
-            logger_->warn("Line {} has insufficient columns (found {}, need {})", 
-                        line_count, tokens.size(), max_col + 1);
-            continue;
-        }
-        
-        // Parse the values
-        uint64_t time_ns;
-        if (!parse_date_time(tokens[date_time_column_], time_ns)) {
-            logger_->warn("Failed to parse date/time on line {}: {}", 
-                        line_count, tokens[date_time_column_]);
-            continue;
-        }
-        
-        try {
-            double open = std::stod(tokens[open_column_]);
-            double high = std::stod(tokens[high_column_]);
-            double low = std::stod(tokens[low_column_]);
-            double close = std::stod(tokens[close_column_]);
-            
-            // Volume might be empty or invalid in some datasets
-            Decimal volume(0);
-            if (volume_column_ < tokens.size() && !tokens[volume_column_].empty()) {
-                try {
-                    // Fix: Convert string to Decimal directly using string constructor
-                    volume = Decimal(tokens[volume_column_].c_str());
-                } catch (...) {
-                    // Use default volume of 0
-                }
-            }
-            
-            // Add the bar to our bar line
-            if (bar_line_->push_data(time_ns, open, high, low, close, volume, Decimal(0), 0)) {
-                data_count++;
-            }
-        }
-        catch (const std::exception& e) {
-            logger_->warn("Error parsing values on line {}: {}", line_count, e.what());
-            continue;
+    util::BarCacheKey key{source.str(), symbol_, bar_type_, bar_size_};
+    int data_count = static_cast<int>(attach_cached_bars(key, [this, &line_count]() -> std::optional<SharedBarSeries> {
+        BarSeries bars;
+        if (!parse_csv(bars, line_count)) {
+            return std::nullopt;
         }
-    }
-    
+        util::sort_and_dedupe(bars);
+        return SharedBarSeries::own(std::move(bars));
+    }));
+
     logger_->info("Loaded {} data points from CSV file {} (processed {} lines)", 
                 data_count, csv_file_path_, line_count);
     
@@ -234,33 +177,35 @@ bool CsvDataFeed::load_from_csv() {
     return data_count > 0;
 }
 
-bool CsvDataFeed::load_from_storage() {
-    if (!storage_) {
+bool CsvDataFeed::parse_csv(BarSeries& bars, int& line_count) {
+    CsvFormat format;
+    format.delimiter = delimiter_;
+    format.has_header = has_header_;
+    format.date_time_column = date_time_column_;
+    format.open_column = open_column_;
+    format.high_column = high_column_;
+    format.low_column = low_column_;
+    format.close_column = close_column_;
+    format.volume_column = volume_column_;
+    format.date_format = date_format_;
+
+    auto result = CsvParser(format, logger_).parse_file(csv_file_path_, csv_threads_);
+    if (!result) {
         return false;
     }
-    
-    auto bars_opt = storage_->load_bars(symbol_, bar_type_, bar_size_);
-    if (!bars_opt.has_value()) {
+    line_count = static_cast<int>(result->lines);
+    bars = std::move(result->bars);
+    return true;
+}
+
+bool CsvDataFeed::load_from_storage() {
+    if (!storage_) {
         return false;
     }
     
-    BarSeries& bars = bars_opt.value();
-    
-    // Add all bars to our bar line
-    int count = 0;
-    for (size_t i = 0; i < bars.start_time.size(); ++i) {
-        if (bar_line_->push_data(
-            bars.start_time[i], 
-            bars.open[i], 
-            bars.high[i], 
-            bars.low[i], 
-            bars.close[i], 
-            bars.volume[i], 
-            bars.wap[i], 
-            bars.count[i])) {
-            count++;
-        }
-    }
+    // Column files are mapped and served by the bar line without copying
+    util::BarCacheKey key{storage_source_, symbol_, bar_type_, bar_size_};
+    int count = static_cast<int>(attach_cached_bars(key, [this]() { return storage_->map_bars(symbol_, bar_type_, bar_size_); }));
     
     logger_->info("Loaded {} data points from storage for {}", count, symbol_);
     
@@ -277,36 +222,18 @@ bool CsvDataFeed::save_to_storage() {
         return false;
     }
     
-    // Save current position
-    unsigned int current_pos = bar_line_->get_position(); // Using get_position() method
-    
-    // Rewind to beginning
-    bar_line_->reset(); // Using reset() method
-    
-    // Extract all data from bar line
-    BarSeries bars;
-    std::optional<BarStruct> bar;
-    while ((bar = bar_line_->next()).has_value()) {
-        bars.start_time.push_back(bar->time);
-        bars.open.push_back(bar->open);
-        bars.high.push_back(bar->high);
-        bars.low.push_back(bar->low);
-        bars.close.push_back(bar->close);
-        bars.volume.push_back(bar->volume);
-        bars.wap.push_back(bar->swap);
-        bars.count.push_back(bar->count);
-    }
-    
-    // Restore position
-    bar_line_->set_position(current_pos); // Using set_position() method
+    // Copy all bars without moving the replay cursor
+    BarSeries bars = bar_line_->view(bar_line_->size()).to_bar_series();
     
     if (bars.start_time.empty()) {
         logger_->warn("No data to save to storage for {}", symbol_);
         return false;
     }
     
-    bool result = storage_->store_bars(symbol_, bar_type_, bar_size_, bars);
+    // Only the bars after the stored ones are written
+    bool result = storage_->append_bars(symbol_, bar_type_, bar_size_, bars);
     if (result) {
+        util::BarCache::instance()->invalidate(storage_source_, symbol_, bar_type_, bar_size_);
         logger_->info("Successfully saved {} data points to storage for {}", 
                     bars.start_time.size(), symbol_);
     } else {
@@ -316,26 +243,6 @@ bool CsvDataFeed::save_to_storage() {
     return result;
 }
 
-bool CsvDataFeed::parse_date_time(const std::string& date_time_str, uint64_t& time_ns) {
-    std::tm tm = {};
-    std::istringstream ss(date_time_str);
-    
-    ss >> std::get_time(&tm, date_format_.c_str());
-    if (ss.fail()) {
-        return false;
-    }
-    
-    // Convert to time_t (seconds since epoch)
-    std::time_t time_sec = std::mktime(&tm);
-    if (time_sec == -1) {
-        return false;
-    }
-    
-    // Convert to nanoseconds
-    time_ns = static_cast<uint64_t>(time_sec) * 1000000000ULL;
-    return true;
-}
-
 } // namespace feed
 } // namespace data
 } // namespace quanttrader
\ No newline at end of file
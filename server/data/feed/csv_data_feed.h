@@ -30,13 +30,14 @@ public:
 
 private:
     bool load_from_csv();
+    bool parse_csv(BarSeries& bars, int& line_count);
     bool load_from_storage();
     bool save_to_storage();
-    bool parse_date_time(const std::string& date_time_str, uint64_t& time_ns);
 
     std::string csv_file_path_;
     std::string date_format_;
     std::string storage_path_;
+    std::string storage_source_;  // BarCache source of the storage
     bool use_storage_ = false;
     bool store_after_load_ = false;
     
@@ -51,6 +52,7 @@ private:
     int close_column_ = 4;
     int volume_column_ = 5;
     bool has_header_ = true;
+    size_t csv_threads_ = 0;  // 0 for the number of hardware threads
 };
 
 } // namespace feed
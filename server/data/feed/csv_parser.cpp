@@ -0,0 +1,516 @@
+#include "csv_parser.h"
+#include "data/storage/mapped_file.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define QT_CSV_SSE2 1
+#endif
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+namespace {
+
+constexpr size_t kMaxReportedLines = 20;  // per chunk and per file
+constexpr size_t kRowSampleBytes = 64 * 1024;
+
+enum class TimeField : uint8_t { Literal, Space, Year, Month, Day, Hour, Minute, Second };
+
+struct TimeToken {
+    TimeField field;
+    char literal;
+};
+
+using TimeFormat = std::vector<TimeToken>;
+
+// nullopt if the format has a specifier other than %Y %m %d %H %M %S %F %T %%
+std::optional<TimeFormat> compile_time_format(const std::string& format) {
+    TimeFormat tokens;
+    auto add = [&tokens](TimeField field, char literal = 0) { tokens.push_back({field, literal}); };
+    for (size_t i = 0; i < format.size(); ++i) {
+        char c = format[i];
+        if (c == ' ' || c == '\t') {
+            add(TimeField::Space);
+            continue;
+        }
+        if (c != '%') {
+            add(TimeField::Literal, c);
+            continue;
+        }
+        if (++i == format.size()) {
+            return std::nullopt;
+        }
+        switch (format[i]) {
+        case 'Y': add(TimeField::Year); break;
+        case 'm': add(TimeField::Month); break;
+        case 'd': add(TimeField::Day); break;
+        case 'H': add(TimeField::Hour); break;
+        case 'M': add(TimeField::Minute); break;
+        case 'S': add(TimeField::Second); break;
+        case 'F':
+            add(TimeField::Year); add(TimeField::Literal, '-'); add(TimeField::Month); add(TimeField::Literal, '-');
+            add(TimeField::Day);
+            break;
+        case 'T':
+            add(TimeField::Hour); add(TimeField::Literal, ':'); add(TimeField::Minute); add(TimeField::Literal, ':');
+            add(TimeField::Second);
+            break;
+        case '%': add(TimeField::Literal, '%'); break;
+        default: return std::nullopt;
+        }
+    }
+    return tokens;
+}
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Local midnight of the last day seen, rows are mostly sorted so nearly every row hits
+struct DayCache {
+    int64_t key = -1;
+    int64_t epoch = 0;
+};
+
+// Same result as std::get_time followed by std::mktime on a zeroed std::tm, which reads
+// the time as local standard time, so a day is always 86400 seconds long
+bool parse_time(std::string_view text, const TimeFormat& format, DayCache& cache, uint64_t& time_ns) {
+    // year, month, day, hour, minute, second as a zeroed std::tm has them
+    int values[6] = {1900, 1, 0, 0, 0, 0};
+    static constexpr int kMaxDigits[6] = {4, 2, 2, 2, 2, 2};
+    static constexpr int kMin[6] = {0, 1, 1, 0, 0, 0};
+    static constexpr int kMax[6] = {9999, 12, 31, 23, 59, 60};
+    uint64_t fraction_ns = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    for (const auto& token : format) {
+        if (token.field == TimeField::Space) {
+            while (p < end && (*p == ' ' || *p == '\t')) {
+                ++p;
+            }
+            continue;
+        }
+        if (token.field == TimeField::Literal) {
+            if (p == end || *p != token.literal) {
+                return false;
+            }
+            ++p;
+            continue;
+        }
+        int index = static_cast<int>(token.field) - static_cast<int>(TimeField::Year);
+        int value = 0;
+        int digits = 0;
+        while (digits < kMaxDigits[index] && p < end && is_digit(*p)) {
+            value = value * 10 + (*p++ - '0');
+            ++digits;
+        }
+        if (digits == 0 || value < kMin[index] || value > kMax[index]) {
+            return false;
+        }
+        values[index] = value;
+        // Tick data has fractions of a second, e.g. 09:30:00.250
+        if (token.field == TimeField::Second && p + 1 < end && *p == '.' && is_digit(p[1])) {
+            ++p;
+            uint64_t scale = 100000000;
+            for (; p < end && is_digit(*p); ++p, scale /= 10) {
+                fraction_ns += (*p - '0') * scale;
+            }
+        }
+    }
+
+    int64_t key = (static_cast<int64_t>(values[0]) * 16 + values[1]) * 32 + values[2];
+    if (key != cache.key) {
+        std::tm tm = {};
+        tm.tm_year = values[0] - 1900;
+        tm.tm_mon = values[1] - 1;
+        tm.tm_mday = values[2];
+        std::time_t midnight = std::mktime(&tm);
+        if (midnight == -1) {
+            return false;
+        }
+        cache.key = key;
+        cache.epoch = midnight;
+    }
+    int64_t seconds = cache.epoch + values[3] * 3600 + values[4] * 60 + values[5];
+    time_ns = static_cast<uint64_t>(seconds) * 1000000000ULL + fraction_ns;
+    return true;
+}
+
+inline std::string_view trim_left(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size() && (text[i] == ' ' || text[i] == '\t')) {
+        ++i;
+    }
+    return text.substr(i);
+}
+
+// Accepts what std::stod accepts for prices: leading spaces, a sign and trailing garbage
+bool parse_double(std::string_view text, double& value) {
+    text = trim_left(text);
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc();
+}
+
+struct ReportedLine {
+    size_t line;  // 1 based within the chunk
+    std::string message;
+};
+
+struct ChunkResult {
+    BarSeries bars;
+    size_t lines = 0;
+    size_t skipped = 0;
+    std::vector<ReportedLine> reported;
+};
+
+// Bars of a chunk from the average line length of its first bytes
+size_t estimate_rows(const char* begin, const char* end) {
+    size_t sample = std::min<size_t>(end - begin, kRowSampleBytes);
+    size_t lines = 0;
+    for (const char* p = begin; (p = static_cast<const char*>(std::memchr(p, '\n', begin + sample - p))) != nullptr; ++p) {
+        ++lines;
+    }
+    if (lines == 0) {
+        return 1;
+    }
+    return (end - begin) / (sample / lines) + 16;
+}
+
+class ChunkParser {
+public:
+    ChunkParser(const CsvFormat& format, const std::optional<TimeFormat>& time_format, ChunkResult& result)
+        : format_(format), time_format_(time_format), result_(result) {
+        columns_ = 1 + std::max({format.date_time_column, format.open_column, format.high_column, format.low_column,
+                                 format.close_column, format.volume_column});
+        fields_.resize(columns_);
+    }
+
+    void parse(const char* begin, const char* end) {
+        result_.bars.reserve(estimate_rows(begin, end));
+        field_start_ = begin;
+        const char* p = begin;
+#ifdef QT_CSV_SSE2
+        // Newlines and delimiters of 16 bytes at once, one bit per byte found
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i delimiter = _mm_set1_epi8(format_.delimiter);
+        for (; p + 16 <= end; p += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned int mask = static_cast<unsigned int>(
+                _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, newline), _mm_cmpeq_epi8(block, delimiter))));
+            while (mask != 0) {
+#if defined(_MSC_VER) && !defined(__clang__)
+                unsigned long bit;
+                _BitScanForward(&bit, mask);
+#else
+                int bit = __builtin_ctz(mask);
+#endif
+                separator(p + bit);
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; p < end; ++p) {
+            if (*p == '\n' || *p == format_.delimiter) {
+                separator(p);
+            }
+        }
+        if (field_start_ < end || field_count_ > 0) {
+            end_line(end);
+        }
+    }
+
+private:
+    void separator(const char* p) {
+        if (*p == '\n') {
+            end_line(p);
+        } else {
+            end_field(p);
+        }
+        field_start_ = p + 1;
+    }
+
+    void end_field(const char* stop) {
+        if (field_count_ < columns_) {
+            fields_[field_count_] = std::string_view(field_start_, stop - field_start_);
+        }
+        ++field_count_;
+    }
+
+    void end_line(const char* stop) {
+        if (stop > field_start_ && stop[-1] == '\r') {
+            --stop;
+        }
+        end_field(stop);
+        parse_line();
+        field_count_ = 0;
+    }
+
+    void parse_line() {
+        ++result_.lines;
+        if (field_count_ == 1 && fields_[0].empty()) {
+            return;  // blank line
+        }
+        if (field_count_ < columns_) {
+            skip("has insufficient columns (found " + std::to_string(field_count_) + ", need " + std::to_string(columns_) + ")");
+            return;
+        }
+
+        std::string_view time_text = fields_[format_.date_time_column];
+        uint64_t time_ns = 0;
+        bool time_ok = time_format_ ? parse_time(time_text, *time_format_, day_cache_, time_ns)
+                                    : CsvParser::parse_date_time(std::string(time_text), format_.date_format, time_ns);
+        if (!time_ok) {
+            skip("failed to parse date/time: " + std::string(time_text));
+            return;
+        }
+
+        double open = 0.0, high = 0.0, low = 0.0, close = 0.0;
+        if (!parse_double(fields_[format_.open_column], open) || !parse_double(fields_[format_.high_column], high) ||
+            !parse_double(fields_[format_.low_column], low) || !parse_double(fields_[format_.close_column], close)) {
+            skip("invalid price");
+            return;
+        }
+
+        // Volume might be empty or invalid in some datasets
+        Decimal volume = 0;
+        std::string_view volume_text = fields_[format_.volume_column];
+        if (!volume_text.empty() && !CsvParser::to_decimal(volume_text, volume)) {
+            volume = 0;
+        }
+        result_.bars.push_back(time_ns, open, high, low, close, volume, Decimal(0), 0);
+    }
+
+    void skip(std::string message) {
+        ++result_.skipped;
+        if (result_.reported.size() < kMaxReportedLines) {
+            result_.reported.push_back({result_.lines, std::move(message)});
+        }
+    }
+
+    const CsvFormat& format_;
+    const std::optional<TimeFormat>& time_format_;
+    ChunkResult& result_;
+    DayCache day_cache_;
+    size_t columns_ = 0;
+    std::vector<std::string_view> fields_;
+    size_t field_count_ = 0;
+    const char* field_start_ = nullptr;
+};
+
+template <typename T>
+void append_column(std::vector<T>& to, std::vector<T>& from) {
+    to.insert(to.end(), from.begin(), from.end());
+    std::vector<T>().swap(from);
+}
+
+} // namespace
+
+CsvParser::CsvParser(const CsvFormat& format, quanttrader::log::LoggerPtr logger, size_t min_chunk_bytes)
+    : format_(format), logger_(logger), min_chunk_bytes_(std::max<size_t>(min_chunk_bytes, 1)) {}
+
+std::optional<CsvParseResult> CsvParser::parse_file(const std::string& path, size_t threads) const {
+    std::error_code ec;
+    auto file_size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        logger_->error("Failed to open CSV file: {}", path);
+        return std::nullopt;
+    }
+    if (file_size == 0) {
+        return CsvParseResult{};  // empty files cannot be mapped
+    }
+    auto file = storage::MappedFile::open(path);
+    if (!file) {
+        logger_->error("Failed to map CSV file: {}", path);
+        return std::nullopt;
+    }
+    return parse(file->data(), file->size(), threads);
+}
+
+CsvParseResult CsvParser::parse(const char* data, size_t size, size_t threads) const {
+    CsvParseResult result;
+    for (int column : {format_.date_time_column, format_.open_column, format_.high_column, format_.low_column, format_.close_column,
+                       format_.volume_column}) {
+        if (column < 0) {
+            logger_->error("Invalid CSV column index {}", column);
+            return result;
+        }
+    }
+
+    const char* begin = data;
+    const char* end = data + size;
+    if (size >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        begin += 3;  // UTF-8 byte order mark
+    }
+    if (format_.has_header && begin < end) {
+        auto header_end = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        begin = header_end ? header_end + 1 : end;
+        result.lines = 1;
+    }
+
+    // Chunks end after a newline, several per thread so a slow chunk does not hold the others
+    size_t body = end - begin;
+    size_t thread_count = ThreadPool::bounded_size(std::max<size_t>(body / min_chunk_bytes_, 1), threads);
+    size_t chunk_count = std::max<size_t>(std::min(body / min_chunk_bytes_, thread_count * 4), 1);
+    std::vector<const char*> bounds {begin};
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const char* target = std::max(begin + body * i / chunk_count, bounds.back());
+        auto newline = static_cast<const char*>(std::memchr(target, '\n', end - target));
+        if (newline == nullptr) {
+            break;
+        }
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(end);
+
+    auto time_format = compile_time_format(format_.date_format);
+    if (!time_format) {
+        logger_->debug("Date format {} is parsed with std::get_time", format_.date_format);
+    }
+    std::vector<ChunkResult> chunks(bounds.size() - 1);
+    auto parse_chunk = [&](size_t index) {
+        ChunkParser(format_, time_format, chunks[index]).parse(bounds[index], bounds[index + 1]);
+    };
+    if (thread_count == 1 || chunks.size() == 1) {
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            parse_chunk(i);
+        }
+    } else {
+        ThreadPool pool(thread_count);
+        std::vector<std::future<void>> futures;
+        futures.reserve(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            futures.push_back(pool.submit([&parse_chunk, i]() { parse_chunk(i); }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+    // Columns are joined in file order, line numbers become file line numbers
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk.bars.start_time.size();
+    }
+    size_t logged = 0;
+    if (chunks.size() == 1) {
+        result.bars = std::move(chunks.front().bars);
+    } else {
+        result.bars.reserve(total);
+    }
+    for (auto& chunk : chunks) {
+        if (chunks.size() > 1) {
+            append_column(result.bars.start_time, chunk.bars.start_time);
+            append_column(result.bars.open, chunk.bars.open);
+            append_column(result.bars.high, chunk.bars.high);
+            append_column(result.bars.low, chunk.bars.low);
+            append_column(result.bars.close, chunk.bars.close);
+            append_column(result.bars.volume, chunk.bars.volume);
+            append_column(result.bars.wap, chunk.bars.wap);
+            append_column(result.bars.count, chunk.bars.count);
+        }
+        for (const auto& line : chunk.reported) {
+            if (logged < kMaxReportedLines) {
+                logger_->warn("Line {} {}", result.lines + line.line, line.message);
+                ++logged;
+            }
+        }
+        result.lines += chunk.lines;
+        result.skipped += chunk.skipped;
+    }
+    if (result.skipped > logged) {
+        logger_->warn("{} lines could not be parsed", result.skipped);
+    }
+    return result;
+}
+
+bool CsvParser::to_decimal(std::string_view text, Decimal& value) {
+    std::string_view number = trim_left(text);
+    size_t i = 0;
+    bool negative = false;
+    if (i < number.size() && (number[i] == '+' || number[i] == '-')) {
+        negative = number[i++] == '-';
+    }
+    // BID64 with the coefficient in the low 53 bits and the exponent biased by 398 above it
+    constexpr uint64_t kMaxCoefficient = (1ULL << 53) - 1;
+    uint64_t coefficient = 0;
+    int exponent = 0;
+    bool point = false;
+    bool digits = false;
+    bool simple = true;
+    for (; i < number.size(); ++i) {
+        char c = number[i];
+        if (is_digit(c)) {
+            digits = true;
+            if (coefficient > (kMaxCoefficient - 9) / 10) {
+                simple = false;
+                break;
+            }
+            coefficient = coefficient * 10 + (c - '0');
+            exponent -= point ? 1 : 0;
+        } else if (c == '.' && !point) {
+            point = true;
+        } else {
+            break;
+        }
+    }
+    for (; simple && i < number.size(); ++i) {
+        if (number[i] != ' ' && number[i] != '\t' && number[i] != '\r') {
+            simple = false;  // e.g. an exponent
+        }
+    }
+    if (simple) {
+        if (!digits || exponent < -398) {
+            return false;
+        }
+        value = (negative ? 1ULL << 63 : 0) | (static_cast<uint64_t>(398 + exponent) << 53) | coefficient;
+        return true;
+    }
+    // Long or scientific numbers go through the decimal library, NaN means not a number
+    constexpr uint64_t kNaN = 0x7C00000000000000ULL;
+    Decimal parsed = DecimalFunctions::stringToDecimal(std::string(number));
+    if ((parsed & kNaN) == kNaN) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool CsvParser::parse_date_time(const std::string& text, const std::string& date_format, uint64_t& time_ns) {
+    std::tm tm = {};
+    std::istringstream ss(text);
+
+    ss >> std::get_time(&tm, date_format.c_str());
+    if (ss.fail()) {
+        return false;
+    }
+
+    // Convert to time_t (seconds since epoch)
+    std::time_t time_sec = std::mktime(&tm);
+    if (time_sec == -1) {
+        return false;
+    }
+
+    // Convert to nanoseconds
+    time_ns = static_cast<uint64_t>(time_sec) * 1000000000ULL;
+    return true;
+}
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
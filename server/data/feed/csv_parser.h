@@ -0,0 +1,102 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include "logger/quantlogger.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+/**
+ * @brief Layout of a bar CSV file, the columns are 0 based
+ */
+struct CsvFormat {
+    char delimiter = ',';
+    bool has_header = true;
+    int date_time_column = 0;
+    int open_column = 1;
+    int high_column = 2;
+    int low_column = 3;
+    int close_column = 4;
+    int volume_column = 5;
+    std::string date_format = "%Y-%m-%d";  // std::get_time syntax, read as local time
+};
+
+struct CsvParseResult {
+    BarSeries bars;     // in file order
+    size_t lines = 0;   // lines read, the header included
+    size_t skipped = 0; // lines that could not be parsed
+};
+
+/**
+ * @brief Multi-threaded parser of bar CSV files
+ *
+ * The file is memory mapped and split at line boundaries into chunks that are parsed in
+ * parallel, each straight into its own columns. Delimiters and newlines are found 16
+ * bytes at a time, numbers are parsed with std::from_chars. Date formats made of %Y %m %d
+ * %H %M %S %F %T and literals are parsed by hand, the epoch of a day is computed once per
+ * day and thread, seconds may carry a fraction of up to 9 digits. Other formats fall back
+ * to std::get_time.
+ */
+class CsvParser {
+public:
+    static constexpr size_t kMinChunkBytes = 1 << 20;  // smaller files are not split
+
+    /**
+     * @param format Layout of the files
+     * @param logger Logger of the lines that cannot be parsed
+     * @param min_chunk_bytes Smallest chunk a file is split into
+     */
+    CsvParser(const CsvFormat& format, quanttrader::log::LoggerPtr logger, size_t min_chunk_bytes = kMinChunkBytes);
+
+    /**
+     * @brief Parse a whole file
+     *
+     * @param path Path of the CSV file
+     * @param threads Number of threads, 0 for the number of hardware threads
+     * @return The bars, nullopt if the file cannot be opened
+     */
+    std::optional<CsvParseResult> parse_file(const std::string& path, size_t threads = 0) const;
+
+    /**
+     * @brief Parse CSV text
+     *
+     * @param data The text, it does not have to end with a newline
+     * @param size Size of the text in bytes
+     * @param threads Number of threads, 0 for the number of hardware threads
+     * @return The bars
+     */
+    CsvParseResult parse(const char* data, size_t size, size_t threads = 0) const;
+
+    /**
+     * @brief Convert a decimal number such as "1200" or "0.25" to a BID64 decimal
+     *
+     * @param text The number, leading spaces and a sign are allowed
+     * @param value Receives the decimal
+     * @return false if the text is not a number
+     */
+    static bool to_decimal(std::string_view text, Decimal& value);
+
+    /**
+     * @brief Parse a date time with std::get_time and std::mktime, as local time
+     *
+     * @param text The date time
+     * @param date_format std::get_time format
+     * @param time_ns Receives the nanoseconds since the epoch
+     * @return false if the text does not match the format
+     */
+    static bool parse_date_time(const std::string& text, const std::string& date_format, uint64_t& time_ns);
+
+private:
+    CsvFormat format_;
+    quanttrader::log::LoggerPtr logger_;
+    size_t min_chunk_bytes_ = kMinChunkBytes;
+};
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
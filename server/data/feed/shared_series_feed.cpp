@@ -0,0 +1,87 @@
+#include "shared_series_feed.h"
+#include <algorithm>
+#include <limits>
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+SharedSeriesFeed::SharedSeriesFeed(const std::string_view& data_name, const provider::DataProvider& source, SharedBarSeries bars)
+    : provider::DataProvider(data_name, std::make_shared<std::unordered_map<std::string, std::any>>()),
+      bars_(std::move(bars)), session_(source.get_session_hours()) {
+    symbol_ = source.get_symbol();
+    bar_type_ = source.get_bar_type();
+    bar_size_ = source.get_bar_size();
+    timezone_ = source.get_timezone();
+}
+
+std::optional<SharedBarSeries> SharedSeriesFeed::share_bars(std::shared_ptr<provider::DataProvider> source) {
+    if (!source || source->is_live() || !source->is_data_ready()) {
+        return std::nullopt;
+    }
+    // The view stays valid as long as the provider stores no more bars, the owner keeps the provider
+    auto view = source->get_bar_view(std::numeric_limits<size_t>::max());
+    return SharedBarSeries{view, std::move(source)};
+}
+
+std::shared_ptr<SharedSeriesFeed> SharedSeriesFeed::clone() const {
+    auto feed = std::make_shared<SharedSeriesFeed>(data_name_, *this, bars_);
+    feed->begin_time_ = begin_time_;
+    return feed;
+}
+
+std::shared_ptr<SharedSeriesFeed> SharedSeriesFeed::clone(uint64_t begin_time, uint64_t end_time) const {
+    const auto& times = bars_.view.start_time;
+    size_t end = static_cast<size_t>(std::distance(times.begin(), std::lower_bound(times.begin(), times.end(), end_time)));
+    auto feed = std::make_shared<SharedSeriesFeed>(data_name_, *this, SharedBarSeries{bars_.view.subview(0, end), bars_.owner});
+    feed->begin_time_ = begin_time;
+    return feed;
+}
+
+bool SharedSeriesFeed::prepare_data() {
+    bar_line_ = std::make_shared<util::BarLine>(0, bar_type_, bar_size_);
+    if (bars_.view.size() > 0 && bar_line_->attach(bars_) == 0) {
+        logger_->error("Failed to attach {} shared bars to {}", bars_.view.size(), data_name_);
+        return false;
+    }
+    if (begin_time_ > 0) {
+        bar_line_->seek(begin_time_);
+    }
+    return true;
+}
+
+bool SharedSeriesFeed::start_request_data() {
+    if (!bar_line_) {
+        logger_->error("Cannot start {}: bar line is not initialized", data_name_);
+        return false;
+    }
+    mark_data_ready();
+    return true;
+}
+
+std::optional<BarStruct> SharedSeriesFeed::next() {
+    if (!data_ready_ || !bar_line_) {
+        return std::nullopt;
+    }
+
+    auto bar_opt = bar_line_->next();
+    if (bar_opt.has_value()) {
+        // For stepped mode, wait for step signal
+        wait_for_step();
+        last_bar_ = bar_opt.value();
+    }
+    return bar_opt;
+}
+
+bool SharedSeriesFeed::rewind() {
+    if (!bar_line_) {
+        logger_->error("Cannot rewind {}: bar line is not initialized", data_name_);
+        return false;
+    }
+    bar_line_->seek(begin_time_);
+    return true;
+}
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
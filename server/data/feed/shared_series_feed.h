@@ -0,0 +1,82 @@
+#pragma once
+
+#include "data/common/data_provider.h"
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+/**
+ * @brief Replays bars loaded once and shared read-only by many cerebros
+ *
+ * The feed attaches the shared columns to its own bar line, so every feed keeps its own
+ * cursor and nothing is copied. Runs of a parameter sweep each get a feed over the same
+ * bars, loaded and resampled before the sweep starts.
+ */
+class SharedSeriesFeed : public provider::DataProvider {
+public:
+    /**
+     * @brief Construct a feed over shared bars
+     *
+     * @param data_name The name of the feed
+     * @param source The provider the bars come from, for the symbol, bar type, timezone and session
+     * @param bars The shared bars
+     */
+    SharedSeriesFeed(const std::string_view& data_name, const provider::DataProvider& source, SharedBarSeries bars);
+    ~SharedSeriesFeed() = default;
+
+    /**
+     * @brief Share all bars of a finite provider, the provider is kept alive by the shared bars
+     *
+     * @param source A provider whose data is ready and that stores no more bars
+     * @return The bars, std::nullopt for a live provider or one whose data is not ready
+     */
+    static std::optional<SharedBarSeries> share_bars(std::shared_ptr<provider::DataProvider> source);
+
+    /**
+     * @brief Another feed over the same bars with its own cursor
+     */
+    std::shared_ptr<SharedSeriesFeed> clone() const;
+
+    /**
+     * @brief Another feed that replays a time window of the same bars
+     *
+     * The feed sees the bars before end_time and starts at the first bar at or after
+     * begin_time, so the bars before the window are the history of the strategies' views
+     * and are not replayed. A rewind goes back to the window start.
+     *
+     * @param begin_time First time of the window in nanoseconds
+     * @param end_time End of the window in nanoseconds, exclusive
+     */
+    std::shared_ptr<SharedSeriesFeed> clone(uint64_t begin_time, uint64_t end_time) const;
+
+    size_t size() const { return bars_.view.size(); }
+
+    /**
+     * @brief All shared bars, whatever the window
+     */
+    const BarSeriesView& get_bars() const { return bars_.view; }
+
+    // Implementation of DataProvider interface
+    bool prepare_data() override;
+    bool start_request_data() override;
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<BarStruct> next() override;
+    bool rewind() override;
+    provider::SessionHours get_session_hours() const override { return session_; }
+    // Attaching the bars takes no time, no thread is needed
+    bool supports_parallel_start() const override { return false; }
+
+private:
+    SharedBarSeries bars_;
+    uint64_t begin_time_ = 0;  // start of the window, the bars before it are history
+    provider::SessionHours session_;
+};
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
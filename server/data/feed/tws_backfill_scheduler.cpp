@@ -0,0 +1,539 @@
+#include "tws_backfill_scheduler.h"
+#include "broker/broker_provider.h"
+#include "data/common/bar_line.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+namespace {
+
+constexpr uint64_t kDaySeconds = 86400;
+constexpr int kPacingViolationCode = 162;  // also used for "query returned no data"
+constexpr int kMaxBackoffShift = 6;        // pacing violations only count as failures past 64 times the retry delay
+
+// Longest duration TWS accepts for a bar size, from its table of valid duration and bar size settings
+struct ChunkLimit {
+    uint64_t seconds;
+    const char* duration;
+};
+
+ChunkLimit chunk_limit(uint64_t bar_seconds) {
+    if (bar_seconds <= 1) return {1800, "1800 S"};
+    if (bar_seconds <= 5) return {3600, "3600 S"};
+    if (bar_seconds <= 15) return {14400, "14400 S"};
+    if (bar_seconds <= 30) return {28800, "28800 S"};
+    if (bar_seconds <= 60) return {kDaySeconds, "1 D"};
+    if (bar_seconds <= 120) return {2 * kDaySeconds, "2 D"};
+    if (bar_seconds < 1800) return {7 * kDaySeconds, "1 W"};
+    if (bar_seconds < kDaySeconds) return {28 * kDaySeconds, "1 M"};  // a month covers at least 28 days
+    return {365 * kDaySeconds, "1 Y"};
+}
+
+uint64_t bar_seconds(BarType bar_type, unsigned int bar_size) {
+    switch (bar_type) {
+    case BarType::Second: return bar_size;
+    case BarType::Minute: return bar_size * 60ULL;
+    case BarType::Hour: return bar_size * 3600ULL;
+    case BarType::Day: return bar_size * kDaySeconds;
+    case BarType::Week: return bar_size * 7 * kDaySeconds;
+    case BarType::Month: return bar_size * 30 * kDaySeconds;
+    default: return 0;
+    }
+}
+
+bool contains_no_case(const std::string& text, std::string_view part) {
+    auto iter = std::search(text.begin(), text.end(), part.begin(), part.end(),
+                            [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    return iter != text.end();
+}
+
+} // namespace
+
+TwsBackfillScheduler::TwsBackfillScheduler() {
+    logger_ = quanttrader::log::get_common_rotation_logger("TwsBackfill", "data");
+    tokens_ = options_.pacing_burst;
+    last_refill_ = Clock::now();
+    worker_ = std::thread([this]() { run(); });
+}
+
+TwsBackfillScheduler::~TwsBackfillScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void TwsBackfillScheduler::set_options(const BackfillOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        options_.max_in_flight = std::max<size_t>(options_.max_in_flight, 1);
+        options_.max_attempts = std::max(options_.max_attempts, 1);
+        tokens_ = std::min(tokens_, options_.pacing_burst);
+    }
+    cv_.notify_all();
+}
+
+BackfillOptions TwsBackfillScheduler::get_options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+long TwsBackfillScheduler::submit(std::shared_ptr<broker::BrokerProvider> broker, const BackfillRequest& request,
+                                  CompleteCallback on_complete, FailedCallback on_failed) {
+    auto chunks = split_range(request.bar_type, request.bar_type_size, request.start_seconds, request.end_seconds);
+    if (!broker || chunks.empty()) {
+        logger_->error("Invalid backfill of {} {} from {} to {}", request.symbol, request.bar_size, request.start_seconds,
+                       request.end_seconds);
+        return -1;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->broker = std::move(broker);
+    job->request = request;
+    job->on_complete = std::move(on_complete);
+    job->on_failed = std::move(on_failed);
+    job->chunks.resize(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        job->chunks[i].chunk = std::move(chunks[i]);
+        job->pending.push_back(i);
+    }
+
+    long job_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_id = next_job_id_++;
+        job->id = job_id;
+        job->started = Clock::now();
+        if (jobs_.empty() && callbacks_.empty() && running_callbacks_ == 0) {
+            busy_since_ = job->started;
+        }
+        jobs_[job_id] = job;
+        ++stats_.jobs;
+        stats_.chunks += job->chunks.size();
+    }
+    cv_.notify_all();
+    logger_->info("Backfill {} of {} {} from {} to {} in {} requests of {}", job_id, request.symbol, request.bar_size,
+                  format_end_time(request.start_seconds), format_end_time(request.end_seconds), job->chunks.size(),
+                  job->chunks.front().chunk.duration);
+    return job_id;
+}
+
+void TwsBackfillScheduler::cancel(long job_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = jobs_.find(job_id);
+        if (iter == jobs_.end()) {
+            return;
+        }
+        auto job = iter->second;
+        for (auto& state : job->chunks) {
+            if (state.status == ChunkStatus::InFlight) {
+                --in_flight_;
+                if (state.request_id > 0) {
+                    releases_.push_back({job, state.request_id, true});
+                }
+            }
+        }
+        jobs_.erase(iter);
+        logger_->info("Backfill {} of {} cancelled", job_id, job->request.symbol);
+    }
+    cv_.notify_all();
+}
+
+bool TwsBackfillScheduler::wait_idle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_cv_.wait_for(lock, timeout, [this] { return jobs_.empty() && callbacks_.empty() && running_callbacks_ == 0; });
+}
+
+BackfillStats TwsBackfillScheduler::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::vector<BackfillChunk> TwsBackfillScheduler::split_range(BarType bar_type, unsigned int bar_size, uint64_t start_seconds,
+                                                             uint64_t end_seconds) {
+    std::vector<BackfillChunk> chunks;
+    uint64_t bar = bar_seconds(bar_type, bar_size);
+    if (bar == 0 || end_seconds <= start_seconds) {
+        return chunks;
+    }
+    ChunkLimit limit = chunk_limit(bar);
+    for (uint64_t end = end_seconds; end > start_seconds;) {
+        BackfillChunk chunk;
+        chunk.end_seconds = end;
+        chunk.seconds = std::min(limit.seconds, end - start_seconds);
+        if (chunk.seconds == limit.seconds) {
+            chunk.duration = limit.duration;
+        } else if (chunk.seconds < kDaySeconds) {
+            chunk.duration = std::to_string(chunk.seconds) + " S";
+        } else {
+            chunk.duration = std::to_string((chunk.seconds + kDaySeconds - 1) / kDaySeconds) + " D";
+        }
+        end -= chunk.seconds;
+        chunks.push_back(std::move(chunk));
+    }
+    return chunks;
+}
+
+std::string TwsBackfillScheduler::format_end_time(uint64_t seconds) {
+    using namespace std::chrono;
+    sys_seconds time {std::chrono::seconds(seconds)};
+    auto day = floor<days>(time);
+    year_month_day date {day};
+    hh_mm_ss<std::chrono::seconds> clock {time - day};
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04d%02u%02u-%02d:%02d:%02d", static_cast<int>(date.year()),
+                  static_cast<unsigned>(date.month()), static_cast<unsigned>(date.day()), static_cast<int>(clock.hours().count()),
+                  static_cast<int>(clock.minutes().count()), static_cast<int>(clock.seconds().count()));
+    return buffer;
+}
+
+void TwsBackfillScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        auto now = Clock::now();
+        refill_tokens(now);
+
+        // Requests without an answer in time are cancelled and sent again
+        for (auto& [job_id, job] : jobs_) {
+            for (size_t i = 0; i < job->chunks.size(); ++i) {
+                auto& state = job->chunks[i];
+                if (state.status == ChunkStatus::InFlight && state.deadline <= now) {
+                    if (state.request_id > 0) {
+                        releases_.push_back({job, state.request_id, true});
+                    }
+                    retry_or_fail(*job, i, options_.retry_delay, "request timed out");
+                    break;  // the job may be gone
+                }
+            }
+        }
+
+        std::vector<Dispatch> dispatches;
+        Dispatch dispatch;
+        while (next_dispatch(now, dispatch)) {
+            dispatches.push_back(dispatch);
+        }
+        if (!dispatches.empty() || !releases_.empty() || !callbacks_.empty()) {
+            auto releases = std::move(releases_);
+            auto callbacks = std::move(callbacks_);
+            releases_.clear();
+            callbacks_.clear();
+            running_callbacks_ += callbacks.size();
+            lock.unlock();
+            for (const auto& release : releases) {
+                release.job->broker->registerRequestErrorCallback(release.request_id, nullptr);
+                if (release.cancel) {
+                    release.job->broker->cancelHistoricalData(release.request_id);
+                }
+            }
+            for (const auto& next : dispatches) {
+                send(next);
+            }
+            for (auto& callback : callbacks) {
+                callback();
+            }
+            lock.lock();
+            running_callbacks_ -= callbacks.size();
+            if (jobs_.empty() && callbacks_.empty() && running_callbacks_ == 0) {
+                idle_cv_.notify_all();
+            }
+            continue;
+        }
+
+        // Sleep until a chunk can be sent or a deadline is due, or until notified
+        auto wake = now + std::chrono::seconds(1);
+        auto send_at = Clock::time_point::max();
+        for (const auto& [job_id, job] : jobs_) {
+            for (size_t index : job->pending) {
+                send_at = std::min(send_at, job->chunks[index].not_before);
+            }
+            for (const auto& state : job->chunks) {
+                if (state.status == ChunkStatus::InFlight) {
+                    wake = std::min(wake, state.deadline);
+                }
+            }
+        }
+        if (send_at != Clock::time_point::max() && in_flight_ < options_.max_in_flight) {
+            send_at = std::max(send_at, paused_until_);
+            if (tokens_ < 1.0 && options_.pacing_rate > 0.0) {
+                auto refill = std::chrono::duration<double>((1.0 - tokens_) / options_.pacing_rate);
+                send_at = std::max(send_at, now + std::chrono::duration_cast<Clock::duration>(refill));
+            }
+            wake = std::min(wake, send_at);
+        }
+        cv_.wait_until(lock, std::max(wake, now + std::chrono::milliseconds(1)));
+    }
+}
+
+void TwsBackfillScheduler::send(const Dispatch& dispatch) {
+    const auto& request = dispatch.job->request;
+    const auto& chunk = dispatch.job->chunks[dispatch.chunk].chunk;  // never changes after submit
+    long job_id = dispatch.job->id;
+    size_t index = dispatch.chunk;
+    int attempt = dispatch.attempt;
+    auto& broker = dispatch.job->broker;
+
+    long request_id = broker->requestHistoricalData(request.symbol, request.sec_type, request.exchange, request.currency,
+                                                    format_end_time(chunk.end_seconds), chunk.duration, request.bar_size,
+                                                    request.what_to_show, request.use_rth, false, request.session_start,
+                                                    request.session_end, request.session_timezone);
+    if (request_id > 0) {
+        broker->registerRequestErrorCallback(request_id, [this, job_id, index, attempt](int code, const std::string& message) {
+            on_chunk_error(job_id, index, attempt, code, message);
+        });
+        broker->registerBarDataCallback(request_id, [this, job_id, index, attempt](const broker::BarData& bar) {
+            if (bar.is_last) {
+                on_chunk_done(job_id, index, attempt);
+            } else {
+                on_bar(job_id, index, attempt, bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.wap, bar.count);
+            }
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ChunkState* state = find_in_flight(job_id, index, attempt);
+        if (state == nullptr) {
+            // Cancelled or timed out while it was sent
+            if (request_id > 0) {
+                releases_.push_back({dispatch.job, request_id, true});
+            }
+        } else if (request_id <= 0) {
+            retry_or_fail(*dispatch.job, index, options_.retry_delay, "the broker rejected the request");
+        } else if (state->request_id == -1) {
+            state->request_id = request_id;
+        }
+    }
+    cv_.notify_all();
+}
+
+void TwsBackfillScheduler::on_bar(long job_id, size_t chunk, int attempt, uint64_t time, double open, double high, double low,
+                                  double close, Decimal volume, Decimal wap, int count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ChunkState* state = find_in_flight(job_id, chunk, attempt);
+    if (state != nullptr) {
+        state->bars.push_back(time, open, high, low, close, volume, wap, count);
+    }
+}
+
+void TwsBackfillScheduler::on_chunk_done(long job_id, size_t chunk, int attempt) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ChunkState* state = find_in_flight(job_id, chunk, attempt);
+        if (state == nullptr) {
+            return;
+        }
+        auto job = jobs_[job_id];
+        state->status = ChunkStatus::Done;
+        --in_flight_;
+        consecutive_violations_ = 0;
+        if (state->request_id > 0) {
+            releases_.push_back({job, state->request_id, false});
+        }
+        if (++job->done == job->chunks.size()) {
+            finish_job(job_id, false, "");
+        }
+    }
+    cv_.notify_all();
+}
+
+void TwsBackfillScheduler::on_chunk_error(long job_id, size_t chunk, int attempt, int code, const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ChunkState* state = find_in_flight(job_id, chunk, attempt);
+        if (state == nullptr) {
+            return;
+        }
+        auto job = jobs_[job_id];
+        if (state->request_id > 0) {
+            releases_.push_back({job, state->request_id, false});
+        }
+        if (code == kPacingViolationCode && contains_no_case(message, "returned no data")) {
+            // A range without trading, e.g. a holiday
+            state->status = ChunkStatus::Done;
+            --in_flight_;
+            if (++job->done == job->chunks.size()) {
+                finish_job(job_id, false, "");
+            }
+        } else if (code == kPacingViolationCode && contains_no_case(message, "pacing violation")) {
+            // Every job backs off, the limit is per connection. Requests sent before the pause
+            // started fail as well and do not lengthen it
+            ++stats_.pacing_violations;
+            auto now = Clock::now();
+            if (now >= paused_until_) {
+                auto delay = options_.retry_delay * (1 << std::min(consecutive_violations_++, kMaxBackoffShift));
+                paused_until_ = now + delay;
+                tokens_ = 0.0;
+                logger_->warn("Pacing violation for {} chunk ending {}, pausing {}ms", job->request.symbol,
+                              format_end_time(state->chunk.end_seconds),
+                              std::chrono::duration_cast<std::chrono::milliseconds>(delay).count());
+            }
+            if (consecutive_violations_ > kMaxBackoffShift) {
+                retry_or_fail(*job, chunk, paused_until_ - now, message);
+            } else {
+                --in_flight_;
+                requeue(*job, chunk, paused_until_);
+            }
+        } else {
+            logger_->warn("Error {} for {} chunk ending {}: {}", code, job->request.symbol, format_end_time(state->chunk.end_seconds),
+                          message);
+            retry_or_fail(*job, chunk, options_.retry_delay, std::to_string(code) + " " + message);
+        }
+    }
+    cv_.notify_all();
+}
+
+TwsBackfillScheduler::ChunkState* TwsBackfillScheduler::find_in_flight(long job_id, size_t chunk, int attempt) {
+    auto iter = jobs_.find(job_id);
+    if (iter == jobs_.end() || chunk >= iter->second->chunks.size()) {
+        return nullptr;
+    }
+    auto& state = iter->second->chunks[chunk];
+    if (state.status != ChunkStatus::InFlight || state.attempts != attempt) {
+        return nullptr;
+    }
+    return &state;
+}
+
+void TwsBackfillScheduler::retry_or_fail(Job& job, size_t chunk, Clock::duration delay, const std::string& reason) {
+    auto& state = job.chunks[chunk];
+    if (state.status == ChunkStatus::InFlight) {
+        --in_flight_;
+    }
+    if (++state.failures >= options_.max_attempts) {
+        state.status = ChunkStatus::Pending;
+        finish_job(job.id, true, "chunk ending " + format_end_time(state.chunk.end_seconds) + " failed " +
+                                     std::to_string(state.failures) + " times, last error: " + reason);
+        return;
+    }
+    requeue(job, chunk, Clock::now() + delay);
+}
+
+void TwsBackfillScheduler::requeue(Job& job, size_t chunk, Clock::time_point not_before) {
+    auto& state = job.chunks[chunk];
+    state.status = ChunkStatus::Pending;
+    state.bars = BarSeries();
+    state.request_id = -1;
+    state.not_before = not_before;
+    job.pending.push_front(chunk);
+    ++stats_.retries;
+}
+
+void TwsBackfillScheduler::finish_job(long job_id, bool failed, const std::string& reason) {
+    auto iter = jobs_.find(job_id);
+    if (iter == jobs_.end()) {
+        return;
+    }
+    auto job = iter->second;
+    jobs_.erase(iter);
+    double seconds = std::chrono::duration<double>(Clock::now() - job->started).count();
+
+    if (failed) {
+        for (auto& state : job->chunks) {
+            if (state.status == ChunkStatus::InFlight) {
+                --in_flight_;
+                if (state.request_id > 0) {
+                    releases_.push_back({job, state.request_id, true});
+                }
+            }
+        }
+        ++stats_.failed_jobs;
+        logger_->error("Backfill {} of {} failed after {:.2f}s: {}", job->id, job->request.symbol, seconds, reason);
+        if (job->on_failed) {
+            callbacks_.push_back([job, reason]() { job->on_failed(reason); });
+        }
+    } else {
+        // Chunks were created from the end backwards
+        size_t total = 0;
+        for (const auto& state : job->chunks) {
+            total += state.bars.size();
+        }
+        BarSeries stitched;
+        stitched.reserve(total);
+        for (auto state = job->chunks.rbegin(); state != job->chunks.rend(); ++state) {
+            stitched.append(state->bars);
+            state->bars = BarSeries();
+        }
+        util::sort_and_dedupe(stitched);
+
+        // Chunks of whole days or months may reach before the start
+        uint64_t start_ns = job->request.start_seconds * kSecondsToNano;
+        uint64_t end_ns = job->request.end_seconds * kSecondsToNano;
+        auto first = std::lower_bound(stitched.start_time.begin(), stitched.start_time.end(), start_ns) - stitched.start_time.begin();
+        auto last = std::lower_bound(stitched.start_time.begin(), stitched.start_time.end(), end_ns) - stitched.start_time.begin();
+        BarSeries bars;
+        if (first == 0 && static_cast<size_t>(last) == stitched.size()) {
+            bars = std::move(stitched);
+        } else {
+            bars.reserve(last - first);
+            for (auto i = first; i < last; ++i) {
+                bars.push_back(stitched.start_time[i], stitched.open[i], stitched.high[i], stitched.low[i], stitched.close[i],
+                               stitched.volume[i], stitched.wap[i], stitched.count[i]);
+            }
+        }
+        stats_.bars += bars.size();
+        logger_->info("Backfill {} of {} done: {} bars from {} requests in {:.2f}s", job->id, job->request.symbol, bars.size(),
+                      job->chunks.size(), seconds);
+        if (job->on_complete) {
+            callbacks_.push_back([job, bars = std::move(bars)]() mutable { job->on_complete(std::move(bars)); });
+        }
+    }
+
+    if (jobs_.empty()) {
+        stats_.seconds = std::chrono::duration<double>(Clock::now() - busy_since_).count();
+        logger_->info("Backfill finished in {:.2f}s: {} jobs ({} failed), {} requests, {} retries, {} pacing violations, {} bars",
+                      stats_.seconds, stats_.jobs, stats_.failed_jobs, stats_.requests, stats_.retries, stats_.pacing_violations,
+                      stats_.bars);
+    }
+}
+
+void TwsBackfillScheduler::refill_tokens(Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min(options_.pacing_burst, tokens_ + elapsed * options_.pacing_rate);
+    last_refill_ = now;
+}
+
+bool TwsBackfillScheduler::next_dispatch(Clock::time_point now, Dispatch& dispatch) {
+    if (in_flight_ >= options_.max_in_flight || tokens_ < 1.0 || jobs_.empty() || now < paused_until_) {
+        return false;
+    }
+    // Round robin over the jobs so every ticker progresses
+    auto iter = jobs_.upper_bound(last_served_job_);
+    for (size_t n = 0; n < jobs_.size(); ++n, ++iter) {
+        if (iter == jobs_.end()) {
+            iter = jobs_.begin();
+        }
+        auto& job = iter->second;
+        for (auto pending = job->pending.begin(); pending != job->pending.end(); ++pending) {
+            auto& state = job->chunks[*pending];
+            if (state.not_before > now) {
+                continue;
+            }
+            dispatch.job = job;
+            dispatch.chunk = *pending;
+            dispatch.attempt = ++state.attempts;
+            job->pending.erase(pending);
+            state.status = ChunkStatus::InFlight;
+            state.deadline = now + options_.request_timeout;
+            ++in_flight_;
+            tokens_ -= 1.0;
+            ++stats_.requests;
+            last_served_job_ = job->id;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include "data/common/data_consts.h"
+#include "common/singleton.h"
+#include "logger/quantlogger.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quanttrader {
+
+namespace broker {
+class BrokerProvider;
+}
+
+namespace data {
+namespace feed {
+
+/**
+ * @brief Historical bars of one contract over a time range
+ */
+struct BackfillRequest {
+    std::string symbol;
+    std::string sec_type;
+    std::string exchange;
+    std::string currency;
+    std::string bar_size;  // TWS bar size, e.g. "1 min"
+    BarType bar_type {BarType::NONE};
+    unsigned int bar_type_size {0};
+    std::string what_to_show;
+    bool use_rth = false;
+    std::string session_start;
+    std::string session_end;
+    std::string session_timezone;
+    uint64_t start_seconds = 0;  // epoch seconds, bars in [start, end) are kept
+    uint64_t end_seconds = 0;
+};
+
+/**
+ * @brief One TWS request of a backfill, ending at end_seconds
+ */
+struct BackfillChunk {
+    uint64_t end_seconds = 0;
+    uint64_t seconds = 0;  // length covered
+    std::string duration;  // TWS duration, e.g. "1 D"
+};
+
+struct BackfillOptions {
+    size_t max_in_flight = 10;
+    // Token bucket: burst + rate * 600 stays within the TWS limit of 60 requests per 10 minutes,
+    // and the burst within 6 requests per 2 seconds
+    double pacing_burst = 6.0;
+    double pacing_rate = 0.09;  // requests per second
+    int max_attempts = 5;       // failures of a chunk before its job fails
+    std::chrono::milliseconds retry_delay {10000};  // doubled on every consecutive pacing violation
+    std::chrono::milliseconds request_timeout {120000};
+};
+
+struct BackfillStats {
+    size_t jobs = 0;
+    size_t failed_jobs = 0;
+    size_t chunks = 0;
+    size_t requests = 0;
+    size_t retries = 0;
+    size_t pacing_violations = 0;
+    size_t bars = 0;
+    double seconds = 0.0;  // wall time of the last busy period, from the first submit until idle
+};
+
+/**
+ * @brief Process-wide scheduler of historical data backfills
+ *
+ * A range is split into chunks no longer than TWS allows for the bar size, chunks of all
+ * jobs are sent round robin with at most max_in_flight requests outstanding, under a
+ * token bucket. Pacing violations and timeouts are retried with a growing delay. Once
+ * every chunk of a job arrived the bars are stitched in time order, deduplicated and
+ * handed to the job's callback on the scheduler thread.
+ */
+class TwsBackfillScheduler : public Singleton<TwsBackfillScheduler> {
+public:
+    using CompleteCallback = std::function<void(BarSeries&& bars)>;
+    using FailedCallback = std::function<void(const std::string& reason)>;
+
+    ~TwsBackfillScheduler();
+
+    void set_options(const BackfillOptions& options);
+    BackfillOptions get_options() const;
+
+    /**
+     * @brief Queue a backfill
+     *
+     * @param broker Broker the requests are sent to
+     * @param request The contract and range
+     * @param on_complete Receives the sorted bars of the range
+     * @param on_failed Called instead when a chunk failed max_attempts times
+     * @return Job id, -1 if the request is invalid
+     */
+    long submit(std::shared_ptr<broker::BrokerProvider> broker, const BackfillRequest& request, CompleteCallback on_complete,
+                FailedCallback on_failed);
+
+    /**
+     * @brief Drop a job and cancel its outstanding requests, no callback is called
+     */
+    void cancel(long job_id);
+
+    /**
+     * @brief Wait until no job is left
+     *
+     * @return false on timeout
+     */
+    bool wait_idle(std::chrono::milliseconds timeout);
+
+    BackfillStats get_stats() const;
+
+    /**
+     * @brief Chunks covering [start, end), the latest first
+     */
+    static std::vector<BackfillChunk> split_range(BarType bar_type, unsigned int bar_size, uint64_t start_seconds,
+                                                  uint64_t end_seconds);
+
+    /**
+     * @brief TWS end time in UTC, e.g. 20240102-15:30:00
+     */
+    static std::string format_end_time(uint64_t seconds);
+
+private:
+    friend class Singleton<TwsBackfillScheduler>;
+    TwsBackfillScheduler();
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class ChunkStatus { Pending, InFlight, Done };
+
+    struct ChunkState {
+        BackfillChunk chunk;
+        BarSeries bars;
+        ChunkStatus status = ChunkStatus::Pending;
+        int attempts = 0;  // requests sent, identifies the current one in callbacks
+        int failures = 0;
+        long request_id = -1;
+        Clock::time_point not_before {};
+        Clock::time_point deadline {};
+    };
+
+    struct Job {
+        long id = 0;
+        std::shared_ptr<broker::BrokerProvider> broker;
+        BackfillRequest request;
+        std::vector<ChunkState> chunks;
+        std::deque<size_t> pending;  // chunk indexes waiting to be sent
+        size_t done = 0;
+        CompleteCallback on_complete;
+        FailedCallback on_failed;
+        Clock::time_point started;
+    };
+
+    // A chunk to send, outside the lock
+    struct Dispatch {
+        std::shared_ptr<Job> job;
+        size_t chunk = 0;
+        int attempt = 0;
+    };
+
+    // A finished or abandoned request whose callbacks are dropped outside the lock
+    struct Release {
+        std::shared_ptr<Job> job;
+        long request_id = -1;
+        bool cancel = false;
+    };
+
+    void run();
+    void send(const Dispatch& dispatch);
+    void on_bar(long job_id, size_t chunk, int attempt, uint64_t time, double open, double high, double low, double close,
+                Decimal volume, Decimal wap, int count);
+    void on_chunk_done(long job_id, size_t chunk, int attempt);
+    void on_chunk_error(long job_id, size_t chunk, int attempt, int code, const std::string& message);
+    // Should lock the mutex outside
+    ChunkState* find_in_flight(long job_id, size_t chunk, int attempt);
+    void retry_or_fail(Job& job, size_t chunk, Clock::duration delay, const std::string& reason);
+    void requeue(Job& job, size_t chunk, Clock::time_point not_before);
+    void finish_job(long job_id, bool failed, const std::string& reason);
+    void refill_tokens(Clock::time_point now);
+    bool next_dispatch(Clock::time_point now, Dispatch& dispatch);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;
+    std::map<long, std::shared_ptr<Job>> jobs_;  // in submission order
+    long next_job_id_ = 1;
+    long last_served_job_ = 0;  // round robin position
+    size_t in_flight_ = 0;
+    double tokens_ = 0.0;
+    Clock::time_point last_refill_;
+    Clock::time_point busy_since_;
+    Clock::time_point paused_until_;  // nothing is sent before, after a pacing violation
+    int consecutive_violations_ = 0;
+    BackfillOptions options_;
+    BackfillStats stats_;
+    std::vector<Release> releases_;
+    std::vector<std::function<void()>> callbacks_;  // job callbacks to run outside the lock
+    size_t running_callbacks_ = 0;
+    bool stopping_ = false;
+    std::thread worker_;
+    quanttrader::log::LoggerPtr logger_ {nullptr};
+};
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
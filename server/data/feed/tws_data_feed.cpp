@@ -1,7 +1,9 @@
 #include "tws_data_feed.h"
+#include "tws_backfill_scheduler.h"
 #include "broker/tws/tws_broker_adapter.h"
 #include "broker/requests.h"
 #include "time/time_with_zone.h"
+#include "data/common/ring_bar_line.h"
 #include <chrono>
 #include <cmath>
 #include <array>
@@ -38,6 +40,11 @@ bool TwsDataFeed::prepare_data() {
     timezone_ = get_config_value<std::string>(DATA_TIMEZONE_NAME, kDefaultTimezone);
     what_type_ = get_config_value<std::string>(DATA_TRADE_WHAT_NAME, kDefaultWhatToShow);
     keep_up_to_date_ = get_config_value<bool>(KEEP_UP_TO_DATE_NAME, false);
+    backfill_in_flight_ = get_config_value<int>("backfill_in_flight", 0);
+    backfill_requests_per_10min_ = get_config_value<int>("backfill_requests_per_10min", 0);
+    // "ring" suits live feeds: the broker thread is the only writer and the cerebro thread the only reader
+    std::string bar_line_kind = get_config_value<std::string>(DATA_BAR_LINE_NAME, kDefaultBarLine);
+    int bar_line_capacity = get_config_value<int>(DATA_BAR_LINE_CAPACITY_NAME, kDefaultBarLineCapacity);
 
     std::string data_type = get_config_value<std::string>(DATA_TYPE_NAME);
     if (data_type == "historical") {
@@ -54,7 +61,11 @@ bool TwsDataFeed::prepare_data() {
         } else {
             bar_type_ = bar_type_size.first;
             bar_size_ = bar_type_size.second;
-            bar_line_ = std::make_shared<util::BarLine>(0, bar_type_, bar_size_);
+            bar_line_ = util::create_bar_line(bar_line_kind, static_cast<unsigned int>(bar_line_capacity), bar_type_, bar_size_);
+            if (!bar_line_) {
+                logger_->error("Unknown bar line type: {} in data provider config: {}", bar_line_kind, data_name_);
+                return false;
+            }
             if (bar_type_ == BarType::Day) {
                 session_start_ = get_config_value<std::string>(DATA_SESSION_START_NAME, kDefaultSessionStart);
                 session_end_ = get_config_value<std::string>(DATA_SESSION_END_NAME, kDefaultSessionEnd);
@@ -84,7 +95,11 @@ bool TwsDataFeed::prepare_data() {
         } else {
             bar_type_ = bar_type_size.first;
             bar_size_ = bar_type_size.second;
-            bar_line_ = std::make_shared<util::BarLine>(0, bar_type_, bar_size_);
+            bar_line_ = util::create_bar_line(bar_line_kind, static_cast<unsigned int>(bar_line_capacity), bar_type_, bar_size_);
+            if (!bar_line_) {
+                logger_->error("Unknown bar line type: {} in data provider config: {}", bar_line_kind, data_name_);
+                return false;
+            }
             if (bar_type_ == BarType::Day) {
                 session_start_ = get_config_value<std::string>(DATA_SESSION_START_NAME, kDefaultSessionStart);
                 session_end_ = get_config_value<std::string>(DATA_SESSION_END_NAME, kDefaultSessionEnd);
@@ -129,7 +144,10 @@ bool TwsDataFeed::terminate_request_data() {
             logger_->info("Cancel up-to-date historical data request {}", request_id_);
         } else {
             // Cancel the historical data
-            if (!is_historical_completed()) {
+            if (!is_historical_completed() && backfill_job_ > 0) {
+                TwsBackfillScheduler::instance()->cancel(backfill_job_);
+                logger_->info("Cancel historical backfill {}", backfill_job_);
+            } else if (!is_historical_completed()) {
                 broker_adapter_->cancelHistoricalData(request_id_);
                 logger_->info("Cancel historical data request {}", request_id_);
             }
@@ -152,7 +170,7 @@ bool TwsDataFeed::start_request_data() {
     }
 
     if (is_historical_) {
-        request_id_ = fetch_historical_data();
+        request_id_ = keep_up_to_date_ ? fetch_historical_data() : backfill_historical_data();
     }
 
     if (is_realtime_) {
@@ -181,7 +199,7 @@ long TwsDataFeed::subscribe_realtime_data() {
             
             // In a real implementation, we'd update the bar_line_ with this data
             // For now, just mark data as ready
-            data_ready_ = true;
+            mark_data_ready();
         });
     } else {
         logger_->error("Failed to request realtime data for: {}", symbol_);
@@ -238,6 +256,7 @@ long TwsDataFeed::fetch_historical_data() {
     if (!broker_adapter_) return -1;
     
     historical_fetch_completed_.store(false);
+    history_batch_ = BarSeries();
 
     auto duration = get_duration();
     if (!duration.has_value()) {
@@ -271,13 +290,22 @@ long TwsDataFeed::fetch_historical_data() {
         // Register a callback for historical data using the returned request ID
         broker_adapter_->registerBarDataCallback(requestId, [this, requestId](const broker::BarData& barData) {
             if (barData.is_last) {
+                // Hand the whole history to the bar line at once
+                historical_data_length_ += static_cast<int>(bar_line_->append_batch(std::move(history_batch_)));
+                history_batch_ = BarSeries();
                 historical_fetch_completed_.store(true);
-                data_ready_ = true;
-                logger_->info("Historical data {} response for: {} is completed, request id {}", data_name_, symbol_, requestId);
+                mark_data_ready();
+                logger_->info("Historical data {} response for: {} is completed with {} bars, request id {}", data_name_, symbol_, historical_data_length_, requestId);
+                notify_data_listener();
+                return;
+            }
+
+            if (!historical_fetch_completed_.load()) {
+                history_batch_.push_back(barData.time, barData.open, barData.high, barData.low, barData.close, barData.volume, barData.wap, barData.count);
                 return;
             }
 
-            // Push historical bar data into the bar line
+            // Updates after the history (keep_up_to_date) go straight into the bar line
             if (bar_line_->push_data(
                     barData.time,
                     barData.open,
@@ -288,6 +316,7 @@ long TwsDataFeed::fetch_historical_data() {
                     barData.wap,
                     barData.count)) {
                 historical_data_length_++;
+                notify_data_listener();
             }
         });
 
@@ -316,6 +345,66 @@ long TwsDataFeed::fetch_historical_data() {
     return requestId;
 }
 
+long TwsDataFeed::backfill_historical_data() {
+    if (!broker_adapter_) return -1;
+
+    historical_fetch_completed_.store(false);
+
+    auto start = qtime::TimeWithZone::from_datetime_string(start_date_, timezone_);
+    auto end = end_date_ == "now" ? qtime::TimeWithZone::from_now() : qtime::TimeWithZone::from_datetime_string(end_date_, timezone_);
+    if (!start.has_value() || !end.has_value()) {
+        logger_->error("Cannot parse the historical range {} to {} for: {}", start_date_, end_date_, symbol_);
+        return -1;
+    }
+
+    data::feed::BackfillRequest request;
+    request.symbol = symbol_;
+    request.sec_type = security_type_;
+    request.exchange = exchange_;
+    request.currency = currency_;
+    request.bar_size = bar_type_str_;
+    request.bar_type = bar_type_;
+    request.bar_type_size = bar_size_;
+    request.what_to_show = what_type_;
+    request.use_rth = use_rth_;
+    if (bar_type_ == BarType::Day) {
+        request.session_start = session_start_;
+        request.session_end = session_end_;
+        request.session_timezone = session_timezone_;
+    }
+    request.start_seconds = start.value().get_seconds_epoch();
+    request.end_seconds = end.value().get_seconds_epoch();
+
+    auto scheduler = TwsBackfillScheduler::instance();
+    if (backfill_in_flight_ > 0 || backfill_requests_per_10min_ > 0) {
+        auto options = scheduler->get_options();
+        if (backfill_in_flight_ > 0) {
+            options.max_in_flight = static_cast<size_t>(backfill_in_flight_);
+        }
+        if (backfill_requests_per_10min_ > 0) {
+            // A tenth at once, the rest spread over the 10 minutes
+            options.pacing_burst = std::max(backfill_requests_per_10min_ / 10.0, 1.0);
+            options.pacing_rate = (backfill_requests_per_10min_ - options.pacing_burst) / 600.0;
+        }
+        scheduler->set_options(options);
+    }
+
+    backfill_job_ = scheduler->submit(
+        broker_adapter_, request,
+        [this](BarSeries&& bars) {
+            historical_data_length_ += static_cast<int>(bar_line_->append_batch(std::move(bars)));
+            historical_fetch_completed_.store(true);
+            mark_data_ready();
+            logger_->info("Historical data {} backfill for: {} is completed with {} bars", data_name_, symbol_, historical_data_length_);
+            notify_data_listener();
+        },
+        [this](const std::string& reason) {
+            logger_->error("Historical data {} backfill for: {} failed: {}", data_name_, symbol_, reason);
+            mark_data_failed("backfill failed: " + reason);
+        });
+    return backfill_job_;
+}
+
 bool TwsDataFeed::is_data_ready() {
     if (is_historical_) {
         return is_historical_completed();
@@ -338,9 +427,6 @@ std::optional<BarStruct> TwsDataFeed::next() {
         // Handle replay modes
         BarStruct current_bar = bar_opt.value();
         
-        // For realtime mode, wait appropriately
-        wait_for_realtime(current_bar, last_bar_);
-        
         // For stepped mode, wait for step signal
         wait_for_step();
         
@@ -35,6 +35,9 @@ public:
     bool is_data_ready() override;
     std::optional<BarStruct> next() override;
     inline void set_broker(std::shared_ptr<broker::BrokerProvider> broker_adapter) override;
+    // Requests go out on the shared broker connection, the data arrives asynchronously anyway
+    bool supports_parallel_start() const override { return false; }
+    bool is_live() const override { return is_realtime_ || keep_up_to_date_; }
     
     /**
      * @brief Rollback the last retrieved bar and make it available again
@@ -53,6 +56,8 @@ protected:
     bool is_historical_completed() const { return historical_fetch_completed_.load(); }
     long subscribe_realtime_data();
     long fetch_historical_data();
+    // A fixed range goes through the shared backfill scheduler in chunks
+    long backfill_historical_data();
     std::optional<std::string> get_duration();
 
 private:
@@ -78,6 +83,10 @@ private:
     std::atomic<bool> historical_fetch_completed_ {false};
     long request_id_ = 0;
     int historical_data_length_ = 0;
+    BarSeries history_batch_;  // historical bars collected on the broker thread until the last one arrives
+    long backfill_job_ = -1;
+    int backfill_in_flight_ = 0;         // 0 keeps the scheduler setting
+    int backfill_requests_per_10min_ = 0;
 };
 
 } // namespace feed
@@ -0,0 +1,204 @@
+#include "yahoo_chart_parser.h"
+#include <cmath>
+#include <limits>
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+namespace {
+
+constexpr double kNull = std::numeric_limits<double>::quiet_NaN();
+constexpr std::string_view kQuoteColumns[] = {"open", "high", "low", "close", "volume"};
+
+// Integral volumes are encoded directly as BID64, others through the decimal library
+Decimal to_volume(double volume) {
+    if (volume >= 0 && volume < 9007199254740992.0 && volume == std::floor(volume)) {
+        return (398ULL << 53) | static_cast<uint64_t>(volume);
+    }
+    return DecimalFunctions::doubleToDecimal(volume);
+}
+
+} // namespace
+
+bool YahooChartHandler::Null() {
+    return number(kNull);
+}
+
+bool YahooChartHandler::Bool(bool) {
+    next_element();
+    return true;
+}
+
+bool YahooChartHandler::String(const char* str, rapidjson::SizeType length, bool) {
+    if (!stack_.empty() && !stack_.back().array && stack_.back().key == "description" && at_path({"chart", "error"})) {
+        error_.assign(str, length);
+    }
+    next_element();
+    return true;
+}
+
+bool YahooChartHandler::StartObject() {
+    begin_container(false);
+    return true;
+}
+
+bool YahooChartHandler::Key(const char* str, rapidjson::SizeType length, bool) {
+    stack_.back().key.assign(str, length);
+    return true;
+}
+
+bool YahooChartHandler::EndObject(rapidjson::SizeType) {
+    end_container();
+    return true;
+}
+
+bool YahooChartHandler::StartArray() {
+    begin_container(true);
+    // The columns of the first result: chart.result[0].timestamp and chart.result[0].indicators.quote[0].*
+    if (at_path({"chart", "result", "0", "timestamp"})) {
+        column_ = kTime;
+    } else if (stack_.size() == 8 && at_path({"chart", "result", "0", "indicators", "quote", "0", stack_.back().name})) {
+        for (int i = 0; i < kColumnCount - 1; ++i) {
+            if (stack_.back().name == kQuoteColumns[i]) {
+                column_ = kOpen + i;
+            }
+        }
+    }
+    if (column_ >= 0 && column_depth_ == 0) {
+        column_depth_ = stack_.size();
+    }
+    return true;
+}
+
+bool YahooChartHandler::EndArray(rapidjson::SizeType) {
+    if (stack_.size() == column_depth_) {
+        column_ = -1;
+        column_depth_ = 0;
+    }
+    end_container();
+    return true;
+}
+
+bool YahooChartHandler::number(double value) {
+    if (column_ >= 0 && stack_.size() == column_depth_) {
+        columns_[column_].push_back(value);
+    }
+    next_element();
+    return true;
+}
+
+void YahooChartHandler::begin_container(bool array) {
+    Frame frame;
+    frame.array = array;
+    if (!stack_.empty()) {
+        frame.name = stack_.back().array ? std::to_string(stack_.back().index) : stack_.back().key;
+    }
+    stack_.push_back(std::move(frame));
+}
+
+void YahooChartHandler::end_container() {
+    stack_.pop_back();
+    next_element();
+}
+
+void YahooChartHandler::next_element() {
+    if (!stack_.empty() && stack_.back().array) {
+        ++stack_.back().index;
+    }
+}
+
+bool YahooChartHandler::at_path(std::initializer_list<std::string_view> names) const {
+    // The root container has no name, the path starts at its children
+    if (stack_.size() < names.size() + 1) {
+        return false;
+    }
+    size_t depth = 1;
+    for (auto name : names) {
+        if (stack_[depth++].name != name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BarSeries YahooChartHandler::to_bar_series(size_t& skipped) const {
+    BarSeries bars;
+    skipped = 0;
+    size_t rows = columns_[kTime].size();
+    bars.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        double values[kColumnCount];
+        bool complete = true;
+        for (int c = 0; c < kColumnCount && complete; ++c) {
+            values[c] = i < columns_[c].size() ? columns_[c][i] : kNull;
+            complete = !std::isnan(values[c]);
+        }
+        if (!complete) {
+            ++skipped;
+            continue;
+        }
+        // Yahoo timestamps are in seconds
+        uint64_t time_ns = static_cast<uint64_t>(values[kTime]) * 1000000000ULL;
+        bars.push_back(time_ns, values[kOpen], values[kHigh], values[kLow], values[kClose], to_volume(values[kVolume]), Decimal(0),
+                       0);
+    }
+    return bars;
+}
+
+void YahooChartHandler::clear() {
+    stack_.clear();
+    column_ = -1;
+    column_depth_ = 0;
+    for (auto& column : columns_) {
+        column.clear();
+    }
+    error_.clear();
+}
+
+bool ChunkedInputStream::push(const char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return stopped_ || chunks_.size() < max_chunks_; });
+    if (stopped_) {
+        return false;
+    }
+    chunks_.emplace_back(data, size);
+    lock.unlock();
+    cv_.notify_all();
+    return true;
+}
+
+void ChunkedInputStream::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    cv_.notify_all();
+}
+
+void ChunkedInputStream::stop_reading() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        chunks_.clear();
+    }
+    cv_.notify_all();
+}
+
+bool ChunkedInputStream::next_chunk() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !chunks_.empty() || finished_ || stopped_; });
+    if (chunks_.empty()) {
+        return false;
+    }
+    current_ = std::move(chunks_.front());
+    chunks_.pop_front();
+    pos_ = 0;
+    lock.unlock();
+    cv_.notify_all();
+    return !current_.empty() || next_chunk();
+}
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
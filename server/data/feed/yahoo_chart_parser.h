@@ -0,0 +1,158 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include <rapidjson/reader.h>
+#include <rapidjson/error/en.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace feed {
+
+/**
+ * @brief rapidjson SAX handler keeping the bars of a Yahoo Finance chart response
+ *
+ * Only the timestamp and quote arrays of the first result are kept, as columns, while the
+ * rest of the document is skipped as it is read. Nulls are kept as NaN until the bars are
+ * built.
+ */
+class YahooChartHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, YahooChartHandler> {
+public:
+    bool Null();
+    bool Bool(bool value);
+    bool Int(int value) { return number(value); }
+    bool Uint(unsigned value) { return number(value); }
+    bool Int64(int64_t value) { return number(static_cast<double>(value)); }
+    bool Uint64(uint64_t value) { return number(static_cast<double>(value)); }
+    bool Double(double value) { return number(value); }
+    bool String(const char* str, rapidjson::SizeType length, bool copy);
+    bool StartObject();
+    bool Key(const char* str, rapidjson::SizeType length, bool copy);
+    bool EndObject(rapidjson::SizeType member_count);
+    bool StartArray();
+    bool EndArray(rapidjson::SizeType element_count);
+
+    /**
+     * @brief Build the bars from the columns read
+     *
+     * @param skipped Receives the number of rows with a null or missing value, they are left out
+     * @return The bars in response order
+     */
+    BarSeries to_bar_series(size_t& skipped) const;
+
+    size_t rows() const { return columns_[kTime].size(); }
+    const std::string& error() const { return error_; }  // chart.error.description of the response
+    void clear();
+
+private:
+    enum ColumnIndex { kTime, kOpen, kHigh, kLow, kClose, kVolume, kColumnCount };
+
+    struct Frame {
+        bool array = false;
+        size_t index = 0;  // next element of an array
+        std::string key;   // current key of an object
+        std::string name;  // key or index of this container in its parent
+    };
+
+    bool number(double value);
+    void begin_container(bool array);
+    void end_container();
+    void next_element();
+    bool at_path(std::initializer_list<std::string_view> names) const;
+
+    std::vector<Frame> stack_;
+    int column_ = -1;        // column read by the innermost array, -1 for none
+    size_t column_depth_ = 0;
+    std::vector<double> columns_[kColumnCount];
+    std::string error_;
+};
+
+/**
+ * @brief rapidjson input stream over chunks pushed by another thread, e.g. a download
+ *
+ * The reader blocks until the next chunk arrives. At most max_chunks are queued, the
+ * writer blocks beyond that, so memory stays bounded whatever the response size.
+ */
+class ChunkedInputStream {
+public:
+    typedef char Ch;
+
+    static constexpr size_t kDefaultMaxChunks = 64;
+
+    explicit ChunkedInputStream(size_t max_chunks = kDefaultMaxChunks) : max_chunks_(max_chunks) {}
+
+    /**
+     * @brief Queue a chunk, waits while the queue is full
+     *
+     * @return false once the reader stopped, the chunk is dropped
+     */
+    bool push(const char* data, size_t size);
+
+    void finish();        // writer side, no more chunks
+    void stop_reading();  // reader side, pushes are dropped from now on
+
+    Ch Peek() const {
+        if (pos_ < current_.size()) {
+            return current_[pos_];
+        }
+        return next_chunk() ? current_[pos_] : '\0';
+    }
+
+    Ch Take() {
+        Ch c = Peek();
+        if (c != '\0') {
+            ++pos_;
+            ++consumed_;
+        }
+        return c;
+    }
+
+    size_t Tell() const { return consumed_; }
+
+    // Output functions of the stream concept, not used by rapidjson::Reader
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    void Put(Ch) { RAPIDJSON_ASSERT(false); }
+    void Flush() { RAPIDJSON_ASSERT(false); }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+
+private:
+    bool next_chunk() const;  // waits for a chunk, false at the end
+
+    size_t max_chunks_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    mutable std::deque<std::string> chunks_;
+    mutable std::string current_;
+    mutable size_t pos_ = 0;
+    size_t consumed_ = 0;
+    bool finished_ = false;
+    bool stopped_ = false;
+};
+
+/**
+ * @brief Read a chart response from a rapidjson input stream
+ *
+ * @param stream The stream, e.g. a ChunkedInputStream or a rapidjson::FileReadStream
+ * @param handler Receives the columns
+ * @return Empty on success, the parse error otherwise
+ */
+template <typename Stream>
+std::string parse_chart(Stream& stream, YahooChartHandler& handler) {
+    rapidjson::Reader reader;
+    rapidjson::ParseResult result = reader.Parse(stream, handler);
+    if (result.IsError()) {
+        return std::string(rapidjson::GetParseError_En(result.Code())) + " at offset " + std::to_string(result.Offset());
+    }
+    return "";
+}
+
+} // namespace feed
+} // namespace data
+} // namespace quanttrader
@@ -6,10 +6,13 @@
 #include <algorithm>
 #include <regex>
 #include <ctime>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
-// Replace nlohmann/json with rapidjson
-#include <rapidjson/document.h>
-#include <rapidjson/error/en.h>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <rapidjson/filereadstream.h>
 
 namespace fs = std::filesystem;
 namespace qtime = quanttrader::time;
@@ -18,6 +21,19 @@ namespace quanttrader {
 namespace data {
 namespace feed {
 
+namespace {
+
+constexpr char kDefaultChartUrl[] = "https://query1.finance.yahoo.com/v8/finance/chart/";
+
+// Where the curl callback sends the body: the parser and the cache file
+struct DownloadContext {
+    ChunkedInputStream* stream = nullptr;
+    std::ofstream* cache = nullptr;
+    size_t bytes = 0;
+};
+
+} // namespace
+
 YahooDataFeed::YahooDataFeed(const std::string_view &data_name, provider::DataParamsType params)
     : provider::DataProvider(data_name, params) {
     // Initialize curl
@@ -91,6 +107,10 @@ bool YahooDataFeed::prepare_data() {
     
     // Get storage type from configuration or use default
     std::string storage_type = get_config_value<std::string>("storage_type", "file");
+
+    chart_url_ = get_config_value<std::string>("chart_url", kDefaultChartUrl);
+    response_cache_dir_ = get_config_value<std::string>("response_cache_dir", "");
+    response_cache_max_age_ = std::max(get_config_value<int>("response_cache_max_age", 0), 0);
     
     // Initialize the bar line
     bar_line_ = std::make_shared<util::BarLine>(0, bar_type_, bar_size_);
@@ -98,7 +118,8 @@ bool YahooDataFeed::prepare_data() {
     // Initialize storage if needed using the factory
     if (use_storage_ || store_after_download_) {
         storage_ = storage::StorageFactory::create(storage_type);
-        if (!storage_->initialize(storage_path_)) {
+        storage_source_ = "storage:" + storage_type + ":" + std::filesystem::absolute(storage_path_).string();
+        if ((params_ && !storage_->configure(*params_)) || !storage_->initialize(storage_path_)) {
             logger_->error("Failed to initialize {} storage at path: {}", storage_type, storage_path_);
             return false;
         }
@@ -114,7 +135,7 @@ bool YahooDataFeed::start_request_data() {
             logger_->info("Loading {} data for {} from storage", 
                 get_bar_type_string(bar_type_, bar_size_), symbol_);
             if (load_from_storage()) {
-                data_ready_ = true;
+                mark_data_ready();
                 return true;
             } else {
                 logger_->warn("Failed to load data from storage, falling back to Yahoo Finance API");
@@ -122,18 +143,20 @@ bool YahooDataFeed::start_request_data() {
         }
     }
     
-    // Download data from Yahoo Finance
-    if (download_data()) {
-        if (parse_yahoo_data(response_data_)) {
-            data_ready_ = true;
-            
-            // Store the data if requested
-            if (store_after_download_ && storage_) {
-                save_to_storage();
-            }
-            
-            return true;
+    // A cached response skips the network
+    YahooChartHandler chart;
+    if (!read_response_cache(chart) && !download_data(chart)) {
+        return false;
+    }
+    if (attach_chart(chart)) {
+        mark_data_ready();
+        
+        // Store the data if requested
+        if (store_after_download_ && storage_) {
+            save_to_storage();
         }
+        
+        return true;
     }
     
     return false;
@@ -157,113 +180,154 @@ std::optional<BarStruct> YahooDataFeed::next() {
 }
 
 size_t YahooDataFeed::curl_write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
-    // Append the data to our string
+    // Hand the chunk to the parser, returning 0 aborts the transfer once the parser gave up
     if (userdata) {
-        std::string *str = static_cast<std::string*>(userdata);
-        str->append(ptr, size * nmemb);
-        return size * nmemb;
+        auto *context = static_cast<DownloadContext*>(userdata);
+        size_t bytes = size * nmemb;
+        if (context->cache) {
+            context->cache->write(ptr, static_cast<std::streamsize>(bytes));
+        }
+        context->bytes += bytes;
+        return context->stream->push(ptr, bytes) ? bytes : 0;
     }
     return 0;
 }
 
-bool YahooDataFeed::download_data() {
+bool YahooDataFeed::download_data(YahooChartHandler& chart) {
     if (!curl_handle_) {
         logger_->error("CURL not initialized");
         return false;
     }
     
     // Prepare URL
-    std::string url = "https://query1.finance.yahoo.com/v8/finance/chart/";
+    bool local = chart_url_.rfind("file://", 0) == 0;
+    std::string url = chart_url_;
     url += symbol_;
-    url += "?interval=" + interval_;
-    url += "&period1=" + start_date_;
-    url += "&period2=" + end_date_;
+    if (local) {
+        url += ".json";
+    } else {
+        url += "?interval=" + interval_;
+        url += "&period1=" + start_date_;
+        url += "&period2=" + end_date_;
+    }
+
+    // The body goes to a temporary file that becomes the cached response once it parsed
+    std::string cache_path = response_cache_path();
+    std::string partial_path = cache_path.empty() ? "" : cache_path + ".part";
+    std::ofstream cache_file;
+    if (!partial_path.empty()) {
+        std::error_code ec;
+        fs::create_directories(response_cache_dir_, ec);
+        cache_file.open(partial_path, std::ios::binary | std::ios::trunc);
+        if (!cache_file.is_open()) {
+            logger_->warn("Cannot write the response cache {}", partial_path);
+        }
+    }
+    ChunkedInputStream stream;
+    DownloadContext context{&stream, cache_file.is_open() ? &cache_file : nullptr};
     
     // Set up curl request
     curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, curl_write_callback);
-    curl_easy_setopt(curl_handle_, CURLOPT_WRITEDATA, &response_data_);
+    curl_easy_setopt(curl_handle_, CURLOPT_WRITEDATA, &context);
     curl_easy_setopt(curl_handle_, CURLOPT_USERAGENT, "libcurl-agent/1.0");
     curl_easy_setopt(curl_handle_, CURLOPT_TIMEOUT, 30L);
     
-    // Clear the response buffer
-    response_data_.clear();
-    
-    // Perform the request
+    // The response is parsed while it downloads
+    std::string parse_error;
+    std::thread parser([&stream, &chart, &parse_error]() {
+        parse_error = parse_chart(stream, chart);
+        stream.stop_reading();
+    });
     CURLcode res = curl_easy_perform(curl_handle_);
-    if (res != CURLE_OK) {
-        logger_->error("CURL request failed: {}", curl_easy_strerror(res));
-        return false;
-    }
-    
-    // Check HTTP status code
+    stream.finish();
+    parser.join();
+
     long http_code = 0;
     curl_easy_getinfo(curl_handle_, CURLINFO_RESPONSE_CODE, &http_code);
-    if (http_code != 200) {
-        logger_->error("HTTP error: {}", http_code);
-        return false;
+    bool success = false;
+    if (res != CURLE_OK && parse_error.empty()) {
+        logger_->error("CURL request failed: {}", curl_easy_strerror(res));
+    } else if (!local && http_code != 200) {
+        logger_->error("HTTP error: {} {}", http_code, chart.error());
+    } else if (!parse_error.empty()) {
+        logger_->error("JSON parse error: {}", parse_error);
+    } else if (!chart.error().empty()) {
+        logger_->error("Yahoo Finance error for {}: {}", symbol_, chart.error());
+    } else {
+        success = true;
     }
-    
-    logger_->info("Successfully downloaded data for {} ({} bytes)", symbol_, response_data_.size());
-    return true;
+
+    if (cache_file.is_open()) {
+        cache_file.close();
+        std::error_code ec;
+        if (success && !cache_file.fail()) {
+            fs::rename(partial_path, cache_path, ec);
+        } else {
+            fs::remove(partial_path, ec);
+        }
+    }
+    if (success) {
+        logger_->info("Successfully downloaded data for {} ({} bytes, {} rows)", symbol_, context.bytes, chart.rows());
+    }
+    return success;
 }
 
-bool YahooDataFeed::parse_yahoo_data(const std::string& data) {
-    try {
-        // Parse JSON response
-        rapidjson::Document document;
-        document.Parse(data.c_str());
-        if (document.HasParseError()) {
-            logger_->error("JSON parse error: {}", rapidjson::GetParseError_En(document.GetParseError()));
+bool YahooDataFeed::read_response_cache(YahooChartHandler& chart) {
+    std::string path = response_cache_path();
+    std::error_code ec;
+    if (path.empty() || !fs::exists(path, ec)) {
+        return false;
+    }
+    if (response_cache_max_age_ > 0) {
+        auto age = fs::file_time_type::clock::now() - fs::last_write_time(path, ec);
+        if (ec || age > std::chrono::seconds(response_cache_max_age_)) {
+            logger_->info("Cached response {} is older than {}s, downloading again", path, response_cache_max_age_);
             return false;
         }
-        
-        // Navigate to the actual data
-        const rapidjson::Value& result = document["chart"]["result"][0];
-        const rapidjson::Value& timestamps = result["timestamp"];
-        const rapidjson::Value& quote = result["indicators"]["quote"][0];
-        
-        // Get data arrays
-        const rapidjson::Value& open = quote["open"];
-        const rapidjson::Value& high = quote["high"];
-        const rapidjson::Value& low = quote["low"];
-        const rapidjson::Value& close = quote["close"];
-        const rapidjson::Value& volume = quote["volume"];
-        
-        // Process each data point
-        int count = 0;
-        for (rapidjson::SizeType i = 0; i < timestamps.Size(); i++) {
-            // Skip if any value is null/missing
-            if (open[i].IsNull() || high[i].IsNull() || 
-                low[i].IsNull() || close[i].IsNull() || 
-                volume[i].IsNull()) {
-                continue;
-            }
-            
-            // Convert timestamp to nanoseconds (Yahoo uses seconds)
-            uint64_t time_ns = timestamps[i].GetUint64() * 1000000000ULL;
-            
-            // Add the bar to our bar line
-            if (bar_line_->push_data(
-                time_ns, 
-                open[i].GetDouble(), 
-                high[i].GetDouble(), 
-                low[i].GetDouble(), 
-                close[i].GetDouble(), 
-                Decimal(volume[i].GetDouble()), 
-                Decimal(0), 
-                0)) {
-                count++;
-            }
-        }
-        
-        logger_->info("Successfully parsed {} data points for {}", count, symbol_);
-        return count > 0;
     }
-    catch (const std::exception& e) {
-        logger_->error("Failed to parse Yahoo Finance data: {}", e.what());
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
         return false;
     }
+    char buffer[65536];
+    rapidjson::FileReadStream stream(file, buffer, sizeof(buffer));
+    std::string parse_error = parse_chart(stream, chart);
+    std::fclose(file);
+    if (!parse_error.empty() || !chart.error().empty()) {
+        logger_->warn("Ignoring cached response {}: {}", path, parse_error.empty() ? chart.error() : parse_error);
+        chart.clear();
+        return false;
+    }
+    logger_->info("Read {} rows for {} from cached response {}", chart.rows(), symbol_, path);
+    return true;
+}
+
+bool YahooDataFeed::attach_chart(const YahooChartHandler& chart) {
+    size_t skipped = 0;
+    BarSeries bars = chart.to_bar_series(skipped);
+    
+    // Add all bars to our bar line at once
+    int count = static_cast<int>(bar_line_->append_batch(std::move(bars)));
+    
+    logger_->info("Successfully parsed {} data points for {} ({} rows with missing values)", count, symbol_, skipped);
+    return count > 0;
+}
+
+std::string YahooDataFeed::response_cache_path() const {
+    if (response_cache_dir_.empty()) {
+        return "";
+    }
+    // FNV-1a of the request, the same request always maps to the same file
+    std::string key = symbol_ + '|' + interval_ + '|' + start_date_ + '|' + end_date_;
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".json";
+    return (fs::path(response_cache_dir_) / name.str()).string();
 }
 
 bool YahooDataFeed::load_from_storage() {
@@ -271,28 +335,9 @@ bool YahooDataFeed::load_from_storage() {
         return false;
     }
     
-    auto bars_opt = storage_->load_bars(symbol_, bar_type_, bar_size_);
-    if (!bars_opt.has_value()) {
-        return false;
-    }
-    
-    BarSeries& bars = bars_opt.value();
-    
-    // Add all bars to our bar line
-    int count = 0;
-    for (size_t i = 0; i < bars.start_time.size(); ++i) {
-        if (bar_line_->push_data(
-            bars.start_time[i], 
-            bars.open[i], 
-            bars.high[i], 
-            bars.low[i], 
-            bars.close[i], 
-            bars.volume[i], 
-            bars.wap[i], 
-            bars.count[i])) {
-            count++;
-        }
-    }
+    // Column files are mapped and served by the bar line without copying
+    util::BarCacheKey key{storage_source_, symbol_, bar_type_, bar_size_};
+    int count = static_cast<int>(attach_cached_bars(key, [this]() { return storage_->map_bars(symbol_, bar_type_, bar_size_); }));
     
     logger_->info("Loaded {} data points from storage for {}", count, symbol_);
     return count > 0;
@@ -303,27 +348,18 @@ bool YahooDataFeed::save_to_storage() {
         return false;
     }
     
-    // Extract all data from bar line
-    BarSeries bars;
-    std::optional<BarStruct> bar;
-    while ((bar = bar_line_->next()).has_value()) {
-        bars.start_time.push_back(bar->time);
-        bars.open.push_back(bar->open);
-        bars.high.push_back(bar->high);
-        bars.low.push_back(bar->low);
-        bars.close.push_back(bar->close);
-        bars.volume.push_back(bar->volume);
-        bars.wap.push_back(bar->swap);
-        bars.count.push_back(bar->count);
-    }
+    // Copy all bars without moving the replay cursor
+    BarSeries bars = bar_line_->view(bar_line_->size()).to_bar_series();
     
     if (bars.start_time.empty()) {
         logger_->warn("No data to save to storage for {}", symbol_);
         return false;
     }
     
-    bool result = storage_->store_bars(symbol_, bar_type_, bar_size_, bars);
+    // Only the bars after the stored ones are written
+    bool result = storage_->append_bars(symbol_, bar_type_, bar_size_, bars);
     if (result) {
+        util::BarCache::instance()->invalidate(storage_source_, symbol_, bar_type_, bar_size_);
         logger_->info("Successfully saved {} data points to storage for {}", 
                     bars.start_time.size(), symbol_);
     } else {
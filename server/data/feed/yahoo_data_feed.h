@@ -3,6 +3,7 @@
 #include "data/common/data_provider.h"
 #include "data/common/bar_line.h"
 #include "data/storage/data_storage.h"
+#include "yahoo_chart_parser.h"
 #include <curl/curl.h>
 #include <memory>
 #include <string>
@@ -17,6 +18,11 @@ namespace feed {
  * 
  * This class implements a data feed that fetches market data from Yahoo Finance
  * and optionally persists it to the storage layer.
+ *
+ * The response is parsed while it downloads, only its columns are kept in memory. With
+ * response_cache_dir set, responses are kept under a hash of symbol, interval and range
+ * and read from there on the next run. A chart_url starting with file:// reads saved
+ * responses named <symbol>.json from a directory instead of the network.
  */
 class YahooDataFeed : public provider::DataProvider {
 public:
@@ -31,27 +37,27 @@ public:
     std::optional<BarStruct> next() override;
 
 private:
-    bool download_data();
-    bool parse_yahoo_data(const std::string& data);
+    bool download_data(YahooChartHandler& chart);
+    bool read_response_cache(YahooChartHandler& chart);
+    bool attach_chart(const YahooChartHandler& chart);
+    std::string response_cache_path() const;
     bool load_from_storage();
     bool save_to_storage();
     static size_t curl_write_callback(char *ptr, size_t size, size_t nmemb, void *userdata);
 
-    std::string symbol_;
     std::string period_ = "1d";       // 1d, 1wk, 1mo
     std::string interval_ = "1d";     // 1m, 2m, 5m, 15m, 30m, 60m, 1h, 1d, 5d, 1wk, 1mo, 3mo
     std::string start_date_;
     std::string end_date_;
     std::string storage_path_;
-    std::string response_data_;
+    std::string storage_source_;  // BarCache source of the storage
+    std::string chart_url_;
+    std::string response_cache_dir_;  // empty when responses are not cached
+    int response_cache_max_age_ = 0;  // seconds, 0 keeps responses forever
     
     bool use_storage_ = false;
     bool store_after_download_ = false;
-    bool data_ready_ = false;
     
-    BarType bar_type_ = BarType::NONE;
-    unsigned int bar_size_ = 0;
-    std::shared_ptr<util::BarLine> bar_line_;
     std::shared_ptr<storage::DataStorage> storage_;
     
     CURL* curl_handle_ = nullptr;
@@ -0,0 +1,243 @@
+#include "csv_ingester.h"
+#include "data/common/bar_line.h"
+#include "data/common/data_provider.h"
+#include "data/storage/storage_factory.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cctype>
+#include <future>
+#include <limits>
+
+namespace fs = std::filesystem;
+
+namespace quanttrader {
+namespace data {
+namespace ingest {
+
+namespace {
+
+// Parsed bars take about twice the CSV size, the sort may copy them once more
+constexpr size_t kBarBytesPerCsvByte = 2;
+
+bool wildcard_match(const char* pattern, const char* text) {
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*text) {
+        if (*pattern == '?' || *pattern == *text) {
+            ++pattern;
+            ++text;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = text;
+        } else if (star) {
+            pattern = star + 1;
+            text = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return *pattern == '\0';
+}
+
+bool is_csv(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == ".csv";
+}
+
+} // namespace
+
+void CsvIngester::MemoryBudget::acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this, bytes] { return used_ == 0 || used_ + bytes <= budget_; });
+    used_ += bytes;
+}
+
+void CsvIngester::MemoryBudget::release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_ -= bytes;
+    }
+    cv_.notify_all();
+}
+
+CsvIngester::CsvIngester(const storage::StorageParams& params) : params_(params) {
+    logger_ = quanttrader::log::get_common_rotation_logger("CsvIngester", "data");
+}
+
+bool CsvIngester::prepare() {
+    std::string source = get_param<std::string>("source", "");
+    if (source.empty()) {
+        logger_->error("No source directory or file pattern to ingest");
+        return false;
+    }
+    files_ = find_files(source, get_param<bool>("recursive", false));
+    if (files_.empty()) {
+        logger_->error("No CSV files found at {}", source);
+        return false;
+    }
+
+    std::string bar_type_str = get_param<std::string>("bar_type", "1 day");
+    auto [type, size] = provider::DataProvider::get_bar_type_from_string(bar_type_str);
+    if (type == BarType::NONE) {
+        logger_->error("Invalid bar type: {}", bar_type_str);
+        return false;
+    }
+    bar_type_ = type;
+    bar_size_ = size;
+
+    std::string mode = get_param<std::string>("mode", "replace");
+    if (mode != "replace" && mode != "append") {
+        logger_->error("Invalid ingest mode {}, use replace or append", mode);
+        return false;
+    }
+    append_ = mode == "append";
+    threads_ = static_cast<size_t>(std::max(get_param<int>("threads", 0), 0));
+    memory_bytes_ = static_cast<size_t>(std::max(get_param<int>("memory_mb", kDefaultMemoryMb), 1)) * 1024 * 1024;
+
+    // Same parsing options as CsvDataFeed
+    std::string delimiter = get_param<std::string>("delimiter", ",");
+    format_.delimiter = delimiter.empty() ? ',' : delimiter.front();
+    format_.has_header = get_param<bool>("has_header", true);
+    format_.date_time_column = get_param<int>("datetime_column", 0);
+    format_.open_column = get_param<int>("open_column", 1);
+    format_.high_column = get_param<int>("high_column", 2);
+    format_.low_column = get_param<int>("low_column", 3);
+    format_.close_column = get_param<int>("close_column", 4);
+    format_.volume_column = get_param<int>("volume_column", 5);
+    format_.date_format = get_param<std::string>("date_format", "%Y-%m-%d");
+
+    std::string storage_type = get_param<std::string>("storage_type", "file");
+    std::string storage_path = get_param<std::string>("storage_path", "./data");
+    storage_ = storage::StorageFactory::create(storage_type);
+    if (!storage_->configure(params_) || !storage_->initialize(storage_path)) {
+        logger_->error("Failed to initialize {} storage at path: {}", storage_type, storage_path);
+        return false;
+    }
+
+    logger_->info("Ingesting {} CSV files from {} into {} storage at {}", files_.size(), source, storage_type, storage_path);
+    prepared_ = true;
+    return true;
+}
+
+std::optional<IngestStats> CsvIngester::run() {
+    if (!prepared_) {
+        logger_->error("CsvIngester::run called before a successful prepare");
+        return std::nullopt;
+    }
+
+    // Many files are parsed one per thread, a few large files are split between the threads
+    size_t threads = ThreadPool::bounded_size(std::numeric_limits<size_t>::max(), threads_);
+    size_t workers = std::min(threads, files_.size());
+    size_t parser_threads = std::max<size_t>(threads / workers, 1);
+    MemoryBudget budget(memory_bytes_);
+    IngestStats stats;
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(workers);
+        std::vector<std::future<bool>> results;
+        results.reserve(files_.size());
+        for (const auto& path : files_) {
+            results.push_back(pool.submit([this, &path, parser_threads, &budget, &stats]() {
+                return ingest_file(path, parser_threads, budget, stats);
+            }));
+        }
+        for (auto& result : results) {
+            if (!result.get()) {
+                ++stats.failed_files;
+            }
+        }
+    }
+    stats.files = files_.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double seconds = std::max(stats.seconds, 1e-9);
+    logger_->info("Ingested {} rows of {} files ({} failed, {} MB) in {:.2f}s: {:.0f} rows/s, {:.1f} MB/s", stats.rows,
+                  stats.files, stats.failed_files, stats.bytes / (1024 * 1024), stats.seconds, stats.rows / seconds,
+                  stats.bytes / seconds / (1024 * 1024));
+    return stats;
+}
+
+bool CsvIngester::ingest_file(const std::string& path, size_t parser_threads, MemoryBudget& budget, IngestStats& stats) {
+    std::error_code ec;
+    size_t file_size = static_cast<size_t>(fs::file_size(path, ec));
+    if (ec) {
+        logger_->error("Failed to open CSV file: {}", path);
+        return false;
+    }
+    std::string symbol = fs::path(path).stem().string();
+    size_t reserved = file_size * kBarBytesPerCsvByte;
+    budget.acquire(reserved);
+
+    auto start = std::chrono::steady_clock::now();
+    auto parsed = feed::CsvParser(format_, logger_).parse_file(path, parser_threads);
+    bool stored = false;
+    size_t rows = 0;
+    if (parsed) {
+        util::sort_and_dedupe(parsed->bars);
+        rows = parsed->bars.size();
+        if (rows == 0) {
+            logger_->warn("No bars in {}", path);
+        } else {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            stored = append_ ? storage_->append_bars(symbol, bar_type_, bar_size_, parsed->bars)
+                             : storage_->store_bars(symbol, bar_type_, bar_size_, parsed->bars);
+        }
+        parsed.reset();
+    }
+    budget.release(reserved);
+
+    if (!stored) {
+        logger_->error("Failed to ingest {} as {}", path, symbol);
+        return false;
+    }
+    logger_->info("Ingested {} bars of {} from {} in {:.1f}ms", rows, symbol, path,
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats.rows += rows;
+    stats.bytes += file_size;
+    return true;
+}
+
+std::vector<std::string> CsvIngester::find_files(const std::string& source, bool recursive) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    fs::path source_path(source);
+    if (fs::is_directory(source_path, ec)) {
+        auto add = [&files](const fs::directory_entry& entry) {
+            if (entry.is_regular_file() && is_csv(entry.path())) {
+                files.push_back(entry.path().string());
+            }
+        };
+        if (recursive) {
+            for (const auto& entry : fs::recursive_directory_iterator(source_path, ec)) {
+                add(entry);
+            }
+        } else {
+            for (const auto& entry : fs::directory_iterator(source_path, ec)) {
+                add(entry);
+            }
+        }
+    } else if (source.find_first_of("*?") != std::string::npos) {
+        fs::path directory = source_path.parent_path().empty() ? fs::path(".") : source_path.parent_path();
+        std::string pattern = source_path.filename().string();
+        for (const auto& entry : fs::directory_iterator(directory, ec)) {
+            if (entry.is_regular_file() && wildcard_match(pattern.c_str(), entry.path().filename().string().c_str())) {
+                files.push_back(entry.path().string());
+            }
+        }
+    } else if (fs::is_regular_file(source_path, ec)) {
+        files.push_back(source);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+} // namespace ingest
+} // namespace data
+} // namespace quanttrader
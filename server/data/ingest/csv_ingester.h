@@ -0,0 +1,117 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include "data/feed/csv_parser.h"
+#include "data/storage/data_storage.h"
+#include "logger/quantlogger.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace ingest {
+
+struct IngestStats {
+    size_t files = 0;
+    size_t failed_files = 0;
+    size_t rows = 0;
+    size_t bytes = 0;  // CSV bytes read
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Offline conversion of CSV files into a data storage
+ *
+ * Every file holds the bars of one symbol, named after the file. Files are parsed in
+ * parallel, sorted and written to the storage one at a time. A memory budget bounds the
+ * bars in flight, a file waits until the files before it have been written when the
+ * budget is used up.
+ *
+ * Options, usually the ingest_config table of the main config:
+ * source (a directory or a file pattern with * and ?), recursive, bar_type, storage_type,
+ * storage_path, mode (replace or append), threads, memory_mb, the CsvDataFeed parsing
+ * options (delimiter, has_header, datetime_column, open_column, high_column, low_column,
+ * close_column, volume_column, date_format) and the options of the storage backend.
+ */
+class CsvIngester {
+public:
+    explicit CsvIngester(const storage::StorageParams& params);
+
+    /**
+     * @brief Read the options, find the files and open the storage
+     *
+     * @return true if there is something to ingest, false otherwise
+     */
+    bool prepare();
+
+    /**
+     * @brief Convert all files found by prepare
+     *
+     * @return The totals, nullopt if prepare was not successful
+     */
+    std::optional<IngestStats> run();
+
+    /**
+     * @brief Files of a directory or matching a pattern such as AAPL_*.csv
+     *
+     * @param source A directory, a file, or a pattern with * and ? in the file name
+     * @param recursive Also search the sub directories of a directory
+     * @return The sorted file paths
+     */
+    static std::vector<std::string> find_files(const std::string& source, bool recursive);
+
+    static constexpr size_t kDefaultMemoryMb = 2048;
+
+private:
+    // Bytes of bars in flight, a request above the budget is granted when nothing else is in flight
+    class MemoryBudget {
+    public:
+        explicit MemoryBudget(size_t bytes) : budget_(bytes) {}
+        void acquire(size_t bytes);
+        void release(size_t bytes);
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        size_t budget_;
+        size_t used_ = 0;
+    };
+
+    bool ingest_file(const std::string& path, size_t parser_threads, MemoryBudget& budget, IngestStats& stats);
+
+    template <typename T>
+    T get_param(const std::string& key, const T& default_value) const {
+        auto iter = params_.find(key);
+        if (iter == params_.end()) {
+            return default_value;
+        }
+        try {
+            return std::any_cast<T>(iter->second);
+        } catch (const std::bad_any_cast&) {
+            return default_value;
+        }
+    }
+
+    storage::StorageParams params_;
+    feed::CsvFormat format_;
+    std::vector<std::string> files_;
+    std::shared_ptr<storage::DataStorage> storage_;
+    BarType bar_type_ = BarType::NONE;
+    unsigned int bar_size_ = 0;
+    bool append_ = false;
+    size_t threads_ = 0;
+    size_t memory_bytes_ = 0;
+    bool prepared_ = false;
+
+    std::mutex write_mutex_;  // storages are written by one thread at a time
+    std::mutex stats_mutex_;
+    quanttrader::log::LoggerPtr logger_;
+};
+
+} // namespace ingest
+} // namespace data
+} // namespace quanttrader
@@ -1,6 +1,7 @@
 #include "data_replay_controller.h"
+#include <tuple>
 #include "basic/time/time_util.h"
-#include "basic/time/time_with_zone.h"
+#include "common/thread_pool.h"
 #include <algorithm>
 #include <limits>
 #include <ctime>
@@ -13,18 +14,41 @@ namespace quanttrader {
 namespace data {
 namespace replay {
 
+namespace {
+
+struct StartResult {
+    bool started = false;
+    double millis = 0.0;
+};
+
+double millis_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
 DataReplayController::DataReplayController()
-    : replay_mode_(provider::DataProvider::ReplayMode::NORMAL) {
+    : replay_mode_(provider::DataProvider::ReplayMode::NORMAL),
+      merge_engine_(quanttrader::log::get_common_rotation_logger("DataReplayController", "data")) {
     logger_ = quanttrader::log::get_common_rotation_logger("DataReplayController", "data");
 }
 
+DataReplayController::~DataReplayController() {
+    clear_ready_listeners();
+}
+
 bool DataReplayController::add_data_provider(const std::string& name, std::shared_ptr<provider::DataProvider> provider) {
     if (providers_.find(name) != providers_.end()) {
         return false;
     }
 
+    auto id = merge_engine_.add_feed(name, provider);
+    if (!id.has_value()) {
+        return false;
+    }
+
     providers_[name] = provider;
-    has_more_data_[name] = true;
+    on_feeds_changed();
     return true;
 }
 
@@ -34,12 +58,55 @@ bool DataReplayController::remove_data_provider(const std::string& name) {
         return false;
     }
 
+    it->second->set_ready_listener(nullptr);
     providers_.erase(it);
-    has_more_data_.erase(name);
-    latest_bars_.erase(name);
+
+    std::optional<FeedId> moved_from;
+    merge_engine_.remove_feed(name, moved_from);
+    on_feeds_changed();
     return true;
 }
 
+void DataReplayController::on_feeds_changed() {
+    size_t count = merge_engine_.feed_count();
+
+    // Feed ids may have moved, so the frame starts over
+    result_.bars.assign(count, std::nullopt);
+    result_.ticked.clear();
+    result_.ticked.reserve(count);
+    result_.has_result = false;
+
+    std::vector<FeedId> by_name(count);
+    for (FeedId id = 0; id < count; ++id) {
+        by_name[id] = id;
+    }
+    std::sort(by_name.begin(), by_name.end(), [this](FeedId lhs, FeedId rhs) {
+        return merge_engine_.feed_name(lhs) < merge_engine_.feed_name(rhs);
+    });
+    feed_rank_.resize(count);
+    for (uint32_t rank = 0; rank < count; ++rank) {
+        feed_rank_[by_name[rank]] = rank;
+    }
+
+    update_timezone();
+}
+
+void DataReplayController::update_timezone() {
+    std::string timezone = providers_.empty() ? "UTC" : providers_.begin()->second->get_timezone();
+    if (timezone != timezone_) {
+        timezone_ = timezone;
+        boundary_tracker_ = quanttrader::time::TimeBoundaryTracker(timezone_);
+    }
+}
+
+size_t DataReplayController::get_emitted_count(FeedId id) const {
+    size_t position = merge_engine_.feed_provider(id)->get_position();
+    if (merge_engine_.has_lookahead(id) && position > 0) {
+        --position;
+    }
+    return position;
+}
+
 std::shared_ptr<provider::DataProvider> DataReplayController::get_data_provider(const std::string& name) const {
     auto it = providers_.find(name);
     if (it == providers_.end()) {
@@ -49,18 +116,76 @@ std::shared_ptr<provider::DataProvider> DataReplayController::get_data_provider(
 }
 
 bool DataReplayController::start() {
-    bool success = true;
+    update_timezone();
+    auto started = std::chrono::steady_clock::now();
 
-    // Start and prepare all data providers
+    using NamedProvider = std::pair<std::string, std::shared_ptr<provider::DataProvider>>;
+    std::vector<NamedProvider> parallel;
+    std::vector<NamedProvider> serial;
     for (auto& [name, provider] : providers_) {
         provider->set_replay_mode(replay_mode_);
+        provider->set_ready_listener([this, name, started]() { on_provider_ready(name, started); });
+        (provider->supports_parallel_start() ? parallel : serial).emplace_back(name, provider);
+    }
 
-        if (!provider->start_request_data()) {
-            logger_->error("Failed to start data provider: {}", name);
-            success = false;
+    auto start_provider = [this](const NamedProvider& named) {
+        auto begin = std::chrono::steady_clock::now();
+        StartResult result;
+        try {
+            result.started = named.second->start_request_data();
+        } catch (const std::exception& e) {
+            logger_->error("Data provider {} failed with an exception: {}", named.first, e.what());
+        }
+        result.millis = millis_since(begin);
+        if (result.started) {
+            logger_->info("Started data provider {} in {:.1f} ms", named.first, result.millis);
+        } else {
+            logger_->error("Failed to start data provider: {}", named.first);
         }
+        return result;
+    };
+
+    // Start and prepare all data providers
+    std::vector<StartResult> results;
+    results.reserve(providers_.size());
+    size_t threads = 0;
+    if (!parallel.empty()) {
+        ThreadPool pool(ThreadPool::bounded_size(parallel.size(), start_threads_));
+        threads = pool.size();
+        std::vector<std::future<StartResult>> futures;
+        futures.reserve(parallel.size());
+        for (const auto& named : parallel) {
+            futures.push_back(pool.submit([&start_provider, &named]() { return start_provider(named); }));
+        }
+        for (auto& future : futures) {
+            results.push_back(future.get());
+        }
+    }
+
+    // Providers that read other providers, e.g. resamplers, start after their sources
+    for (const auto& named : serial) {
+        results.push_back(start_provider(named));
     }
 
+    bool success = true;
+    size_t slowest = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        success = success && results[i].started;
+        if (results[i].millis > results[slowest].millis) {
+            slowest = i;
+        }
+    }
+    if (!results.empty()) {
+        const auto& slowest_name = slowest < parallel.size() ? parallel[slowest].first : serial[slowest - parallel.size()].first;
+        logger_->info("Started {} data providers ({} on {} threads) in {:.1f} ms, slowest {} took {:.1f} ms", results.size(),
+                      parallel.size(), threads, millis_since(started), slowest_name, results[slowest].millis);
+    }
+
+    // Wake a waiter for the providers that got ready while starting
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+    }
+    ready_cv_.notify_all();
     return success;
 }
 
@@ -68,159 +193,101 @@ void DataReplayController::stop() {
     for (auto& [name, provider] : providers_) {
         provider->terminate_request_data();
     }
+    clear_ready_listeners();
 }
 
-void DataReplayController::set_replay_mode(provider::DataProvider::ReplayMode mode) {
-    replay_mode_ = mode;
-    for (auto& [name, provider] : providers_) {
-        provider->set_replay_mode(mode);
+void DataReplayController::on_provider_ready(const std::string& name, std::chrono::steady_clock::time_point started) {
+    auto provider = get_data_provider(name);
+    auto error = provider ? provider->get_data_error() : std::nullopt;
+    if (error) {
+        logger_->error("Data provider {} failed after {:.1f} ms: {}", name, millis_since(started), *error);
+    } else {
+        logger_->info("Data provider {} ready after {:.1f} ms", name, millis_since(started));
+    }
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
     }
+    ready_cv_.notify_all();
 }
 
-void compare_time_changes(uint64_t previous_time, uint64_t current_time, const std::string& timezone, SynchronizedDataResult& result, const std::shared_ptr<spdlog::logger>& logger, std::string_view data_name) {
-    if (previous_time > 0) {
-        quanttrader::time::TimeWithZone prev_twz(previous_time, timezone);
-        quanttrader::time::TimeWithZone curr_twz(current_time, timezone);
-
-        auto prev_local = prev_twz.get_local_time();
-        auto curr_local = curr_twz.get_local_time();
-
-        auto prev_days = std::chrono::floor<std::chrono::days>(prev_local);
-        auto curr_days = std::chrono::floor<std::chrono::days>(curr_local);
-        if (prev_days != curr_days) {
-            result.day_changed = true;
-            logger->debug("Day changed (epoch): {} -> {}", prev_days.time_since_epoch().count(), curr_days.time_since_epoch().count());
-        }
-
-        auto prev_hour = std::chrono::floor<std::chrono::hours>(prev_local);
-        auto curr_hour = std::chrono::floor<std::chrono::hours>(curr_local);
-        if (prev_hour != curr_hour || result.day_changed) {
-            result.hour_changed = true;
-            logger->debug("Hour changed (epoch): {} -> {}", prev_hour.time_since_epoch().count(), curr_hour.time_since_epoch().count());
-        }
-
-        auto prev_min = std::chrono::floor<std::chrono::minutes>(prev_local);
-        auto curr_min = std::chrono::floor<std::chrono::minutes>(curr_local);
-        if (prev_min != curr_min || result.hour_changed) {
-            result.minute_changed = true;
-            logger->debug("Minute changed (epoch): {} -> {}", prev_min.time_since_epoch().count(), curr_min.time_since_epoch().count());
-        }
-        logger->debug("Current aligned time: {} (ns: {}), data {}", curr_twz.to_string_with_name(), current_time, data_name);
-    } else {
-        quanttrader::time::TimeWithZone curr_twz(current_time, timezone);
-        logger->info("Initializing with time: {} (ns: {}), data {}", curr_twz.to_string_with_name(), current_time, data_name);
+void DataReplayController::clear_ready_listeners() {
+    for (auto& [name, provider] : providers_) {
+        provider->set_ready_listener(nullptr);
     }
 }
 
-// Helper: fetch next valid bar for a provider
-void fetch_next_valid_bar(const std::string& name, std::shared_ptr<provider::DataProvider> provider, std::map<std::string, std::optional<BarStruct>>& latest_bars_, std::map<std::string, bool>& has_more_data_, uint64_t previous_time_, const std::shared_ptr<spdlog::logger>& logger) {
-    bool need_new_data = false;
-    if (latest_bars_.find(name) == latest_bars_.end() || !latest_bars_[name].has_value()) {
-        need_new_data = true;
-    } else if (previous_time_ > 0 && latest_bars_[name]->time < previous_time_) {
-        need_new_data = true;
-        logger->debug("Advancing provider {} past old cached time {} (current time: {})", name, latest_bars_[name]->time, previous_time_);
-    }
-    if (need_new_data) {
-        std::optional<BarStruct> next_bar;
-        do {
-            next_bar = provider->next();
-            if (next_bar.has_value()) {
-                logger->debug("Fetched bar for provider {}: time={}", name, next_bar->time);
-                if (previous_time_ == 0 || next_bar->time >= previous_time_) {
-                    latest_bars_[name] = next_bar;
-                    break;
-                } else {
-                    logger->info("Skipping old bar for provider {} (time: {} < current: {})", name, next_bar->time, previous_time_);
-                }
-            } else {
-                has_more_data_[name] = false;
-                latest_bars_[name] = std::nullopt;
-                logger->debug("No more data for provider {}", name);
-                break;
-            }
-        } while (next_bar.has_value() && next_bar->time < previous_time_);
+void DataReplayController::set_replay_mode(provider::DataProvider::ReplayMode mode) {
+    replay_mode_ = mode;
+    for (auto& [name, provider] : providers_) {
+        provider->set_replay_mode(mode);
     }
 }
 
-// Helper: find earliest timestamp among all providers
-void find_earliest_time(const std::map<std::string, std::optional<BarStruct>>& latest_bars_, uint64_t previous_time_, uint64_t& earliest_time, std::string_view& data_name) {
-    earliest_time = std::numeric_limits<uint64_t>::max();
-    for (const auto& [name, bar_opt] : latest_bars_) {
-        if (!bar_opt.has_value()) {
-            continue;
-        }
-        
-        if((previous_time_ == 0 || bar_opt->time >= previous_time_)) {
-            if (bar_opt->time < earliest_time) {
-                earliest_time = bar_opt->time;
-                data_name = name;
-            }
-        }
+void compare_time_changes(uint64_t previous_time, uint64_t current_time, quanttrader::time::TimeBoundaryTracker& tracker, SynchronizedDataResult& result, const std::shared_ptr<spdlog::logger>& logger, std::string_view data_name) {
+    if (previous_time == 0) {
+        // A new or rewound timeline
+        tracker.reset();
+        tracker.advance(current_time);
+        logger->info("Initializing with time: {} (ns: {}), data {}", tracker.format(current_time), current_time, data_name);
+        return;
     }
-}
 
-// Helper: process each provider for result.data
-void process_providers_for_result(std::map<std::string, std::optional<BarStruct>>& latest_bars_, std::map<std::string, std::optional<BarStruct>>& result_data, uint64_t earliest_time, const std::shared_ptr<spdlog::logger>& logger) {
-    for (const auto& [name, bar_opt] : latest_bars_) {
-        if (bar_opt.has_value()) {
-            if (bar_opt->time <= earliest_time) {
-                result_data[name] = bar_opt;
-                logger->debug("Including data from provider {} at time {}", name, bar_opt->time);
-                // Clear this provider's cached bar so it fetches a new one next time
-                latest_bars_[name] = std::nullopt;
-            } else {
-                result_data[name] = std::nullopt;
-                logger->debug("Keeping future data from provider {} (future time: {} vs current: {})", name, bar_opt->time, earliest_time);
-            }
-        } else {
-            result_data[name] = std::nullopt;
-            logger->debug("No data available for provider {}", name);
+    auto changes = tracker.advance(current_time);
+    result.day_changed = changes.day;
+    result.hour_changed = changes.hour;
+    result.minute_changed = changes.minute;
+    if (logger->should_log(spdlog::level::debug)) {
+        // Only format the time string when it is going to be written
+        if (changes.minute) {
+            logger->debug("Time changed (day {}, hour {}, minute {}): {} -> {}", changes.day, changes.hour, changes.minute,
+                          previous_time, current_time);
         }
+        logger->debug("Current aligned time: {} (ns: {}), data {}", tracker.format(current_time), current_time, data_name);
     }
 }
 
-SynchronizedDataResult DataReplayController::next_synchronized() {
-    SynchronizedDataResult result;
-    if (providers_.empty()) {
-        logger_->debug("No providers available for synchronization");
-        return result;
+const SynchronizedDataResult& DataReplayController::next_synchronized() {
+    // Clear the slots filled by the previous step
+    for (auto id : result_.ticked) {
+        result_.bars[id].reset();
     }
+    result_.ticked.clear();
+    result_.has_result = false;
+    result_.current_time = 0;
+    result_.day_changed = false;
+    result_.hour_changed = false;
+    result_.minute_changed = false;
 
-    // Step 1: Fetch next valid bar for each provider
-    for (auto& [name, provider] : providers_) {
-        if (!has_more_data_[name]) continue;
-        fetch_next_valid_bar(name, provider, latest_bars_, has_more_data_, previous_time_, logger_);
+    if (providers_.empty()) {
+        logger_->debug("No providers available for synchronization");
+        return result_;
     }
 
-    // Step 2: Find the earliest timestamp among all providers
-    uint64_t earliest_time = std::numeric_limits<uint64_t>::max();
-    std::string_view data_name;
-    find_earliest_time(latest_bars_, previous_time_, earliest_time, data_name);
+    uint64_t previous_time = merge_engine_.current_time();
 
-    // Step 3: If no valid bar was found, return empty result
-    if (earliest_time == std::numeric_limits<uint64_t>::max()) {
+    // Pull new bars for the feeds consumed last step and pop every feed at the earliest timestamp
+    if (!merge_engine_.step()) {
         logger_->debug("No valid bars found, returning empty result");
-        return result;
+        return result_;
     }
 
-    result.current_time = earliest_time;
-    result.has_result = true;
-
-    // Step 4: Compare time changes (day/hour/minute)
-    std::string timezone = "UTC";
-    if (!providers_.empty()) {
-        timezone = providers_.begin()->second->get_timezone();
+    for (auto id : merge_engine_.ticked()) {
+        result_.bars[id] = merge_engine_.ticked_bar(id);
+        result_.ticked.push_back(id);
     }
-    compare_time_changes(previous_time_, earliest_time, timezone, result, logger_, data_name);
+    // Hand the ticked feeds out in feed name order
+    std::sort(result_.ticked.begin(), result_.ticked.end(), [this](FeedId lhs, FeedId rhs) {
+        return feed_rank_[lhs] < feed_rank_[rhs];
+    });
 
-    // Step 5: Process each provider for result.data and clear used bars
-    process_providers_for_result(latest_bars_, result.data, earliest_time, logger_);
+    uint64_t earliest_time = merge_engine_.current_time();
+    result_.current_time = earliest_time;
+    result_.has_result = true;
 
-    // Step 6: Update previous time for next iteration
-    previous_time_ = earliest_time;
+    // Compare time changes (day/hour/minute)
+    compare_time_changes(previous_time, earliest_time, boundary_tracker_, result_, logger_, merge_engine_.feed_name(result_.ticked.front()));
 
-    return result;
+    return result_;
 }
 
 void DataReplayController::next_step() {
@@ -237,16 +304,117 @@ bool DataReplayController::rewind() {
         if (!provider->rewind()) {
             success = false;
         }
-        has_more_data_[name] = true;
     }
     
-    // Clear cached bars and reset previous time
-    latest_bars_.clear();
-    previous_time_ = 0;
+    // Clear pending bars and reset the merged timeline
+    merge_engine_.reset();
     
     return success;
 }
 
+bool DataReplayController::seek(uint64_t time) {
+    bool success = true;
+    for (auto& [name, provider] : providers_) {
+        if (!provider->seek(time)) {
+            logger_->error("Failed to seek data provider {} to {}", name, time);
+            success = false;
+        }
+    }
+
+    // Bars pulled before the seek belong to the old position
+    merge_engine_.reset();
+    return success;
+}
+
+void DataReplayController::checkpoint(StateWriter& writer) const {
+    writer.write(merge_engine_.current_time());
+    writer.write<uint64_t>(merge_engine_.feed_count());
+    for (FeedId id = 0; id < merge_engine_.feed_count(); ++id) {
+        size_t emitted = get_emitted_count(id);
+        auto bars = merge_engine_.feed_provider(id)->get_bar_view(emitted);
+        writer.write(merge_engine_.feed_name(id));
+        writer.write<uint64_t>(emitted);
+        writer.write<uint64_t>(bars.empty() ? 0 : bars.start_time.back());
+    }
+}
+
+std::function<void()> DataReplayController::stage_restore(StateReader& reader) {
+    uint64_t current_time = 0;
+    uint64_t count = 0;
+    reader.read(current_time);
+    reader.read_count(count);
+    std::vector<std::tuple<std::string, uint64_t, uint64_t>> positions;
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        std::string name;
+        uint64_t emitted = 0;
+        uint64_t last_time = 0;
+        reader.read(name);
+        reader.read(emitted);
+        reader.read(last_time);
+        positions.emplace_back(std::move(name), emitted, last_time);
+    }
+    if (!reader.ok()) {
+        logger_->error("Malformed replay state in the checkpoint");
+        return {};
+    }
+    if (positions.size() != merge_engine_.feed_count()) {
+        logger_->error("The checkpoint has {} feeds, the replay has {}", positions.size(), merge_engine_.feed_count());
+        return {};
+    }
+
+    std::vector<std::pair<std::shared_ptr<provider::DataProvider>, size_t>> moves;
+    moves.reserve(positions.size());
+    for (const auto& [name, emitted, last_time] : positions) {
+        auto provider = get_data_provider(name);
+        if (!provider) {
+            logger_->error("Feed {} of the checkpoint is not in the replay", name);
+            return {};
+        }
+        // Move there to reach the bars a lazy provider has not stored yet, then back
+        size_t previous = provider->get_position();
+        if (!provider->set_position(emitted)) {
+            logger_->error("Cannot move feed {} to its {} bars of the checkpoint", name, emitted);
+            provider->set_position(previous);
+            return {};
+        }
+        auto bars = provider->get_bar_view(emitted);
+        uint64_t time = bars.empty() ? 0 : bars.start_time.back();
+        provider->set_position(previous);
+        if (bars.size() != emitted || time != last_time) {
+            logger_->error("Feed {} has other bars than the checkpoint, bar {} is at {} instead of {}", name, emitted, time, last_time);
+            return {};
+        }
+        moves.emplace_back(std::move(provider), emitted);
+    }
+
+    return [this, current_time, moves = std::move(moves)]() {
+        for (const auto& [provider, emitted] : moves) {
+            provider->set_position(emitted);  // reached while staging
+        }
+
+        // The feeds pull their next bar again, the time changes continue from the last step
+        merge_engine_.reset(current_time);
+        boundary_tracker_.reset();
+        if (current_time > 0) {
+            boundary_tracker_.advance(current_time);
+        }
+        logger_->info("Restored the replay of {} feeds at {}", moves.size(), current_time);
+    };
+}
+
+bool DataReplayController::restore(StateReader& reader) {
+    auto apply = stage_restore(reader);
+    if (!apply) {
+        return false;
+    }
+    apply();
+    return true;
+}
+
+void DataReplayController::resume_exhausted_providers() {
+    merge_engine_.resume_exhausted();
+}
+
 bool DataReplayController::all_data_ready() const {
     for (const auto& [name, provider] : providers_) {
         if (!provider->is_data_ready()) {
@@ -256,13 +424,31 @@ bool DataReplayController::all_data_ready() const {
     return !providers_.empty();
 }
 
-bool DataReplayController::has_more_data() const {
-    for (const auto& [name, has_more] : has_more_data_) {
-        if (has_more) {
-            return true;
+bool DataReplayController::wait_all_data_ready(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(ready_mutex_);
+    while (!all_data_ready()) {
+        // A provider that failed will not get ready, waiting for the timeout does not help
+        for (const auto& [name, provider] : providers_) {
+            if (auto error = provider->get_data_error()) {
+                logger_->error("Data provider {} cannot get ready: {}", name, *error);
+                return false;
+            }
         }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        // Providers that never mark their data ready are polled
+        auto wait = std::min<std::chrono::steady_clock::duration>(deadline - now, kReadyPollInterval);
+        ready_cv_.wait_for(lock, wait);
     }
-    return false;
+    return true;
+}
+
+bool DataReplayController::has_more_data() const {
+    return merge_engine_.has_more_data();
 }
 
 } // namespace replay
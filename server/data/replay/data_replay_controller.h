@@ -1,8 +1,15 @@
 #pragma once
 
 #include "data/common/data_provider.h"
+#include "data/replay/feed_merge_engine.h"
+#include "basic/time/time_boundary_tracker.h"
 #include "logger/quantlogger.h"
+#include "common/state_archive.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <map>
 #include <string>
@@ -14,9 +21,15 @@ namespace replay {
 
 /**
  * @brief Structure to hold synchronized data and time switch information
+ *
+ * The controller owns one instance and refills it on every step, so the
+ * replay loop does not allocate once the feeds are registered.
  */
 struct SynchronizedDataResult {
-    std::map<std::string, std::optional<BarStruct>> data;
+    // One slot per feed indexed by feed id, only the slots listed in ticked hold a bar
+    std::vector<std::optional<BarStruct>> bars;
+    // Feeds that delivered a bar at current_time, ordered by feed name
+    std::vector<FeedId> ticked;
     bool day_changed = false;
     bool hour_changed = false;
     bool minute_changed = false;
@@ -40,7 +53,7 @@ public:
     /**
      * @brief Destroy the Data Replay Controller
      */
-    ~DataReplayController() = default;
+    ~DataReplayController();
     
     /**
      * @brief Add a data provider to the controller
@@ -70,9 +83,19 @@ public:
     /**
      * @brief Start all data providers
      * 
+     * Providers that support it start concurrently on a bounded thread pool, the others
+     * one after another once the pool is done. The start time of every provider is logged.
+     * 
      * @return true if all providers started successfully
      */
     bool start();
+
+    /**
+     * @brief Set the number of threads that start providers
+     * 
+     * @param threads Upper bound of the pool size, 0 for the number of hardware threads
+     */
+    void set_start_threads(size_t threads) { start_threads_ = threads; }
     
     /**
      * @brief Stop all data providers
@@ -89,9 +112,11 @@ public:
     /**
      * @brief Get the next synchronized data point from all providers
      * 
+     * The returned frame is reused and stays valid until the next call.
+     *
      * @return SynchronizedDataResult containing data and time switch information
      */
-    SynchronizedDataResult next_synchronized();
+    const SynchronizedDataResult& next_synchronized();
     
     /**
      * @brief Signal to provide the next step in STEPPED replay mode for all providers
@@ -104,6 +129,57 @@ public:
      * @return true if all providers were rewound successfully
      */
     bool rewind();
+
+    /**
+     * @brief Move all data providers to their first bar at or after a time
+     * 
+     * Each provider finds the bar in its sorted bars, nothing before it is replayed.
+     * 
+     * @param time Time in nanoseconds
+     * @return true if all providers moved
+     */
+    bool seek(uint64_t time);
+    
+    /**
+     * @brief Write the replay position to a checkpoint
+     * 
+     * Saves the time of the last step and, per feed, the bars emitted so far and the time of
+     * the last one. Bars pulled ahead are not part of it, they are pulled again after a restore.
+     * Call it between steps.
+     */
+    void checkpoint(StateWriter& writer) const;
+
+    /**
+     * @brief Read a replay state written by checkpoint and check it against the feeds
+     * 
+     * The providers must hold the same bars as when the checkpoint was taken. Each moves its
+     * cursor to the saved count, has the time of its last emitted bar checked and moves back,
+     * a lazy resampler keeps the periods it built to get there.
+     * 
+     * @return A function moving the replay to the state, empty if the state is malformed, a feed
+     *         is missing or its bars differ
+     */
+    std::function<void()> stage_restore(StateReader& reader);
+
+    /**
+     * @brief Continue the replay from a checkpoint, see stage_restore
+     * 
+     * @return false if the state is malformed, a feed is missing or its bars differ
+     */
+    bool restore(StateReader& reader);
+
+    /**
+     * @brief Time of the last step, 0 before the first one
+     */
+    uint64_t get_current_time() const { return merge_engine_.current_time(); }
+
+    /**
+     * @brief Poll providers that ran out of data again
+     * 
+     * Live providers keep receiving bars after they returned nullopt, call this
+     * once they signalled new data.
+     */
+    void resume_exhausted_providers();
     
     /**
      * @brief Check if all data providers are ready
@@ -111,6 +187,17 @@ public:
      * @return true if all providers are ready
      */
     bool all_data_ready() const;
+
+    /**
+     * @brief Wait until all data providers are ready
+     * 
+     * Wakes as soon as the last provider marks its data ready. Providers that do not
+     * signal readiness are checked every kReadyPollInterval.
+     * 
+     * @param timeout Longest time to wait
+     * @return true if all providers are ready, false on the timeout or as soon as a provider failed
+     */
+    bool wait_all_data_ready(std::chrono::milliseconds timeout);
     
     /**
      * @brief Check if any data provider still has data
@@ -119,15 +206,51 @@ public:
      */
     bool has_more_data() const;
 
+    /**
+     * @brief Get the number of registered feeds; feed ids are 0 .. count - 1
+     */
+    size_t get_feed_count() const { return merge_engine_.feed_count(); }
+
+    /**
+     * @brief Get the name of a feed by id
+     */
+    const std::string& get_feed_name(FeedId id) const { return merge_engine_.feed_name(id); }
+
+    /**
+     * @brief Get the data provider of a feed by id
+     */
+    const std::shared_ptr<provider::DataProvider>& get_feed_provider(FeedId id) const { return merge_engine_.feed_provider(id); }
+
+    /**
+     * @brief Get the number of bars of a feed that have reached the timeline
+     * 
+     * Bars the controller already pulled but has not emitted yet are excluded,
+     * so a view of this length never looks ahead of the current time.
+     */
+    size_t get_emitted_count(FeedId id) const;
+
 public:
     // Expose providers for timezone check in CerebroBase
     const std::unordered_map<std::string, std::shared_ptr<provider::DataProvider>>& get_providers() const { return providers_; }
 private:
+    static constexpr std::chrono::milliseconds kReadyPollInterval {100};
+
+    void on_feeds_changed();
+    void on_provider_ready(const std::string& name, std::chrono::steady_clock::time_point started);
+    void clear_ready_listeners();
+    // Follow the first provider's timezone for the time change detection
+    void update_timezone();
+
     std::unordered_map<std::string, std::shared_ptr<provider::DataProvider>> providers_;
     provider::DataProvider::ReplayMode replay_mode_;
-    std::map<std::string, std::optional<BarStruct>> latest_bars_;
-    std::map<std::string, bool> has_more_data_;
-    uint64_t previous_time_ = 0;  // Previous timestamp for time change detection
+    FeedMergeEngine merge_engine_;
+    SynchronizedDataResult result_;
+    std::vector<uint32_t> feed_rank_;  // position of each feed id in name order
+    std::string timezone_ = "UTC";     // timezone of the first provider, used for time change detection
+    quanttrader::time::TimeBoundaryTracker boundary_tracker_ {"UTC"};
+    size_t start_threads_ = 0;
+    std::mutex ready_mutex_;
+    std::condition_variable ready_cv_;
     quanttrader::log::LoggerPtr logger_ = nullptr;  // Logger for this controller
 };
 
@@ -0,0 +1,161 @@
+#include "feed_merge_engine.h"
+#include <algorithm>
+#include <functional>
+
+namespace quanttrader {
+namespace data {
+namespace replay {
+
+FeedMergeEngine::FeedMergeEngine(quanttrader::log::LoggerPtr logger)
+    : logger_(std::move(logger)) {
+}
+
+std::optional<FeedId> FeedMergeEngine::add_feed(const std::string& name, std::shared_ptr<provider::DataProvider> provider) {
+    if (feed_ids_.find(name) != feed_ids_.end()) {
+        return std::nullopt;
+    }
+
+    FeedId id = static_cast<FeedId>(feeds_.size());
+    feeds_.push_back(FeedState{name, std::move(provider), std::nullopt, false, true});
+    feed_ids_[name] = id;
+    refill_.push_back(id);
+
+    // Reserve up front so that steps never grow these buffers
+    heap_.reserve(feeds_.size());
+    refill_.reserve(feeds_.size());
+    ticked_.reserve(feeds_.size());
+    return id;
+}
+
+std::optional<FeedId> FeedMergeEngine::remove_feed(const std::string& name, std::optional<FeedId>& moved_from) {
+    moved_from = std::nullopt;
+    auto it = feed_ids_.find(name);
+    if (it == feed_ids_.end()) {
+        return std::nullopt;
+    }
+
+    FeedId id = it->second;
+    FeedId last = static_cast<FeedId>(feeds_.size() - 1);
+    feed_ids_.erase(it);
+
+    auto remap = [id, last](std::vector<FeedId>& ids) {
+        std::erase(ids, id);
+        for (auto& value : ids) {
+            if (value == last) {
+                value = id;
+            }
+        }
+    };
+    remap(refill_);
+    remap(ticked_);
+
+    if (id != last) {
+        feeds_[id] = std::move(feeds_[last]);
+        feed_ids_[feeds_[id].name] = id;
+        moved_from = last;
+    }
+    feeds_.pop_back();
+
+    // Removal is rare, a full rebuild keeps the heap consistent with the new ids
+    rebuild_heap();
+    return id;
+}
+
+std::optional<FeedId> FeedMergeEngine::find_feed(const std::string& name) const {
+    auto it = feed_ids_.find(name);
+    if (it == feed_ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void FeedMergeEngine::refill(FeedId id) {
+    auto& feed = feeds_[id];
+    feed.pending.reset();
+    feed.emitted = false;
+    if (!feed.has_more) {
+        return;
+    }
+
+    while (true) {
+        auto next_bar = feed.provider->next();
+        if (!next_bar.has_value()) {
+            feed.has_more = false;
+            logger_->debug("No more data for provider {}", feed.name);
+            return;
+        }
+
+        if (current_time_ == 0 || next_bar->time >= current_time_) {
+            feed.pending = next_bar;
+            heap_.emplace_back(next_bar->time, id);
+            std::push_heap(heap_.begin(), heap_.end(), std::greater<>{});
+            return;
+        }
+        logger_->info("Skipping old bar for provider {} (time: {} < current: {})", feed.name, next_bar->time, current_time_);
+    }
+}
+
+void FeedMergeEngine::rebuild_heap() {
+    heap_.clear();
+    for (FeedId id = 0; id < feeds_.size(); ++id) {
+        if (feeds_[id].pending.has_value() && !feeds_[id].emitted) {
+            heap_.emplace_back(feeds_[id].pending->time, id);
+        }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), std::greater<>{});
+}
+
+bool FeedMergeEngine::step() {
+    for (FeedId id : refill_) {
+        refill(id);
+    }
+    refill_.clear();
+    ticked_.clear();
+
+    if (heap_.empty()) {
+        return false;
+    }
+
+    uint64_t earliest_time = heap_.front().first;
+    while (!heap_.empty() && heap_.front().first == earliest_time) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<>{});
+        feeds_[heap_.back().second].emitted = true;
+        ticked_.push_back(heap_.back().second);
+        heap_.pop_back();
+    }
+
+    current_time_ = earliest_time;
+    // The ticked feeds keep their bar until the next step, then pull a new one
+    refill_.assign(ticked_.begin(), ticked_.end());
+    return true;
+}
+
+void FeedMergeEngine::reset(uint64_t current_time) {
+    heap_.clear();
+    ticked_.clear();
+    refill_.clear();
+    for (FeedId id = 0; id < feeds_.size(); ++id) {
+        feeds_[id].pending.reset();
+        feeds_[id].emitted = false;
+        feeds_[id].has_more = true;
+        refill_.push_back(id);
+    }
+    current_time_ = current_time;
+}
+
+void FeedMergeEngine::resume_exhausted() {
+    for (FeedId id = 0; id < feeds_.size(); ++id) {
+        if (!feeds_[id].has_more) {
+            feeds_[id].has_more = true;
+            refill_.push_back(id);
+        }
+    }
+}
+
+bool FeedMergeEngine::has_more_data() const {
+    return std::any_of(feeds_.begin(), feeds_.end(), [](const FeedState& feed) { return feed.has_more; });
+}
+
+} // namespace replay
+} // namespace data
+} // namespace quanttrader
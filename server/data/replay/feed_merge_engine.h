@@ -0,0 +1,132 @@
+#pragma once
+
+#include "data/common/data_provider.h"
+#include "logger/quantlogger.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace replay {
+
+// Dense index of a feed inside the replay controller
+using FeedId = uint32_t;
+
+/**
+ * @brief K-way merge of many data providers into one timeline
+ *
+ * Every feed gets a dense integer id. Feeds that hold a pending bar sit in a
+ * min-heap keyed on that bar's timestamp, so one step only touches the feeds
+ * that tick at the earliest timestamp: O(k log n) for k ticking feeds out of n.
+ * Only the feeds consumed in the previous step are pulled from their provider
+ * again, all other pending bars stay in the heap.
+ */
+class FeedMergeEngine {
+public:
+    explicit FeedMergeEngine(quanttrader::log::LoggerPtr logger);
+    ~FeedMergeEngine() = default;
+
+    /**
+     * @brief Register a new feed
+     *
+     * @param name Unique feed name
+     * @param provider The data provider behind the feed
+     * @return The dense id of the feed, or std::nullopt if the name already exists
+     */
+    std::optional<FeedId> add_feed(const std::string& name, std::shared_ptr<provider::DataProvider> provider);
+
+    /**
+     * @brief Remove a feed
+     *
+     * The last feed is moved into the freed id so ids stay dense.
+     *
+     * @param name The feed name
+     * @param moved_from Set to the previous id of the feed that now owns the removed id, if any
+     * @return The id that was removed, or std::nullopt if the feed is unknown
+     */
+    std::optional<FeedId> remove_feed(const std::string& name, std::optional<FeedId>& moved_from);
+
+    /**
+     * @brief Look up the id of a feed by name
+     */
+    std::optional<FeedId> find_feed(const std::string& name) const;
+
+    size_t feed_count() const { return feeds_.size(); }
+    const std::string& feed_name(FeedId id) const { return feeds_[id].name; }
+    const std::shared_ptr<provider::DataProvider>& feed_provider(FeedId id) const { return feeds_[id].provider; }
+
+    /**
+     * @brief Advance the merged timeline by one timestamp
+     *
+     * @return true if at least one feed ticked, false if no pending bar is left
+     */
+    bool step();
+
+    /**
+     * @brief Feeds that ticked in the last successful step, in heap pop order
+     */
+    std::span<const FeedId> ticked() const { return ticked_; }
+
+    /**
+     * @brief The bar emitted by a feed in the last step; only valid for ids in ticked()
+     */
+    const BarStruct& ticked_bar(FeedId id) const { return *feeds_[id].pending; }
+
+    /**
+     * @brief Check if a feed already pulled a bar from its provider that has not been emitted yet
+     */
+    bool has_lookahead(FeedId id) const { return feeds_[id].pending.has_value() && !feeds_[id].emitted; }
+
+    /**
+     * @brief Timestamp of the last step, 0 before the first step
+     */
+    uint64_t current_time() const { return current_time_; }
+
+    /**
+     * @brief Forget every pending bar and mark all feeds as having data again
+     *
+     * @param current_time Time of the last step the timeline continues from, 0 for a new timeline
+     */
+    void reset(uint64_t current_time = 0);
+
+    /**
+     * @brief Poll exhausted feeds again on the next step, for live feeds that receive more bars
+     */
+    void resume_exhausted();
+
+    /**
+     * @brief Check if any feed may still deliver data
+     */
+    bool has_more_data() const;
+
+private:
+    struct FeedState {
+        std::string name;
+        std::shared_ptr<provider::DataProvider> provider;
+        std::optional<BarStruct> pending;
+        bool emitted = false;  // pending was handed out by the last step
+        bool has_more = true;
+    };
+
+    using HeapEntry = std::pair<uint64_t, FeedId>;
+
+    void refill(FeedId id);
+    void rebuild_heap();
+
+    std::vector<FeedState> feeds_;
+    std::unordered_map<std::string, FeedId> feed_ids_;
+    std::vector<HeapEntry> heap_;
+    std::vector<FeedId> refill_;   // feeds that need a new bar before the next step
+    std::vector<FeedId> ticked_;
+    uint64_t current_time_ = 0;
+    quanttrader::log::LoggerPtr logger_ = nullptr;
+};
+
+} // namespace replay
+} // namespace data
+} // namespace quanttrader
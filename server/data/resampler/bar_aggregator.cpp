@@ -0,0 +1,170 @@
+#include "bar_aggregator.h"
+#include "time/time_util.h"
+#include <algorithm>
+
+namespace quanttrader {
+namespace data {
+namespace resampler {
+
+std::optional<BarStruct> BarAggregator::add(const BarStruct& bar) {
+    if (aligner_ && aligner_->has_session() && !aligner_->in_session(bar.time)) {
+        return std::nullopt;
+    }
+
+    // Most bars fall into the period in progress, no alignment needed
+    if (started_ && period_end_ != 0 && bar.time >= current_.time && bar.time < period_end_) {
+        merge(bar);
+        return std::nullopt;
+    }
+
+    uint64_t period_start = align_to_period_start(bar.time);
+    if (!started_) {
+        start(bar, period_start);
+        return std::nullopt;
+    }
+
+    if (period_start == current_.time) {
+        merge(bar);
+        return std::nullopt;
+    }
+
+    if (period_start < current_.time) {
+        return std::nullopt;
+    }
+
+    auto finished = flush();
+    start(bar, period_start);
+    return finished;
+}
+
+void BarAggregator::merge(const BarStruct& bar) {
+    current_.high = std::max(current_.high, bar.high);
+    current_.low = std::min(current_.low, bar.low);
+    current_.close = bar.close;
+    current_.volume = DecimalFunctions::add(current_.volume, bar.volume);
+    current_.count += bar.count;
+    double volume = DecimalFunctions::decimalToDouble(bar.volume);
+    if (volume > 0.0) {
+        volume_ += volume;
+        wap_volume_ += DecimalFunctions::decimalToDouble(bar.swap) * volume;
+    }
+}
+
+std::optional<BarStruct> BarAggregator::partial() const {
+    if (!started_) {
+        return std::nullopt;
+    }
+    BarStruct bar = current_;
+    if (volume_ > 0.0) {
+        bar.swap = DecimalFunctions::doubleToDecimal(wap_volume_ / volume_);
+    }
+    return bar;
+}
+
+std::optional<BarStruct> BarAggregator::flush() {
+    auto bar = partial();
+    started_ = false;
+    return bar;
+}
+
+void BarAggregator::start(const BarStruct& bar, uint64_t period_start) {
+    current_ = bar;
+    current_.time = period_start;
+    uint64_t length = fixed_period_nanos(bar_type_, bar_size_);
+    if (length != 0) {
+        period_end_ = period_start + length;
+    } else if (aligner_) {
+        period_end_ = aligner_->align(period_start, aligned_period(), bar_size_).end;
+    } else {
+        period_end_ = find_period_end(period_start);
+    }
+    volume_ = DecimalFunctions::decimalToDouble(bar.volume);
+    wap_volume_ = volume_ > 0.0 ? DecimalFunctions::decimalToDouble(bar.swap) * volume_ : 0.0;
+    started_ = true;
+}
+
+uint64_t BarAggregator::find_period_end(uint64_t period_start) const {
+    uint64_t nominal_seconds = 0;
+    switch (bar_type_) {
+        case BarType::Day:
+            nominal_seconds = bar_size_ * 86400ULL;
+            break;
+        case BarType::Week:
+            nominal_seconds = 7 * 86400ULL;
+            break;
+        case BarType::Month:
+            nominal_seconds = 31 * 86400ULL;
+            break;
+        default:
+            return 0;
+    }
+
+    // Periods end on a whole second, search the first one aligned past this period
+    uint64_t low = period_start / kSecondsToNano;
+    uint64_t high = low + 2 * nominal_seconds;
+    if (align_to_period_start(high * kSecondsToNano) <= period_start) {
+        return 0;
+    }
+    while (high - low > 1) {
+        uint64_t middle = low + (high - low) / 2;
+        if (align_to_period_start(middle * kSecondsToNano) > period_start) {
+            high = middle;
+        } else {
+            low = middle;
+        }
+    }
+    return high * kSecondsToNano;
+}
+
+uint64_t BarAggregator::fixed_period_nanos(BarType bar_type, unsigned int bar_size) {
+    switch (bar_type) {
+        case BarType::Second:
+            return bar_size * kSecondsToNano;
+        case BarType::Minute:
+            return bar_size * 60ULL * kSecondsToNano;
+        case BarType::Hour:
+            return bar_size * 3600ULL * kSecondsToNano;
+        default:
+            return 0;
+    }
+}
+
+quanttrader::time::PeriodAligner::Period BarAggregator::aligned_period() const {
+    switch (bar_type_) {
+        case BarType::Week:
+            return quanttrader::time::PeriodAligner::Period::Week;
+        case BarType::Month:
+            return quanttrader::time::PeriodAligner::Period::Month;
+        default:
+            return quanttrader::time::PeriodAligner::Period::Day;
+    }
+}
+
+uint64_t BarAggregator::align_to_period_start(uint64_t time_ns) const {
+    using quanttrader::time::TimeUtil;
+
+    if (aligner_ && fixed_period_nanos(bar_type_, bar_size_) == 0) {
+        return aligner_->align(time_ns, aligned_period(), bar_size_).start;
+    }
+
+    switch (bar_type_) {
+        case BarType::Second:
+            return TimeUtil::align_to_second(time_ns, bar_size_);
+        case BarType::Minute:
+            return TimeUtil::align_to_minute(time_ns, bar_size_);
+        case BarType::Hour:
+            return TimeUtil::align_to_hour(time_ns, bar_size_);
+        case BarType::Day:
+            return TimeUtil::align_to_day(time_ns, bar_size_);
+        case BarType::Week:
+            return TimeUtil::align_to_week(time_ns);
+        case BarType::Month:
+            return TimeUtil::align_to_month(time_ns);
+        default:
+            return time_ns;
+    }
+}
+
+} // namespace resampler
+} // namespace data
+} // namespace quanttrader
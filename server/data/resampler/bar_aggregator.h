@@ -0,0 +1,105 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include "data/common/data_consts.h"
+#include "time/period_aligner.h"
+#include <memory>
+#include <optional>
+
+namespace quanttrader {
+namespace data {
+namespace resampler {
+
+/**
+ * @brief Folds source bars into bars of a larger period, one source bar at a time
+ *
+ * A period is finished when the first bar of a later period arrives. Bars older than the
+ * period in progress are dropped. Volumes add up as decimals, the wap is volume weighted.
+ * Days, weeks and months follow the aligner's trading days when one is given, bars outside
+ * its session are dropped, and UTC calendar days otherwise.
+ */
+class BarAggregator {
+public:
+    BarAggregator(BarType bar_type, unsigned int bar_size, std::shared_ptr<quanttrader::time::PeriodAligner> aligner = nullptr)
+        : bar_type_(bar_type), bar_size_(bar_size), aligner_(std::move(aligner)) {}
+
+    /**
+     * @brief Add a source bar
+     *
+     * @param bar The source bar
+     * @return The finished period when the bar starts a new one
+     */
+    std::optional<BarStruct> add(const BarStruct& bar);
+
+    /**
+     * @brief The period in progress, stamped with its start time
+     */
+    std::optional<BarStruct> partial() const;
+
+    /**
+     * @brief Finish the period in progress, e.g. at the end of a finite source
+     */
+    std::optional<BarStruct> flush();
+
+    void reset() { started_ = false; }
+    bool has_partial() const { return started_; }
+
+    /**
+     * @brief Whether a timestamp falls into the period in progress
+     */
+    bool in_period(uint64_t time_ns) const {
+        if (period_end_ != 0) {
+            return time_ns >= current_.time && time_ns < period_end_;
+        }
+        return align_to_period_start(time_ns) == current_.time;
+    }
+
+    /**
+     * @brief Whether a timestamp is past the period in progress, which is then finished
+     */
+    bool is_ended_by(uint64_t time_ns) const {
+        if (!started_) {
+            return false;
+        }
+        if (period_end_ != 0) {
+            return time_ns >= period_end_;
+        }
+        return align_to_period_start(time_ns) > current_.time;
+    }
+
+    /**
+     * @brief Length of a period in nanoseconds, 0 for days and longer whose length varies
+     */
+    static uint64_t fixed_period_nanos(BarType bar_type, unsigned int bar_size);
+
+    BarType get_bar_type() const { return bar_type_; }
+    unsigned int get_bar_size() const { return bar_size_; }
+
+    /**
+     * @brief Align a timestamp to the start of its period
+     *
+     * @param time_ns The timestamp to align
+     * @return The aligned timestamp
+     */
+    uint64_t align_to_period_start(uint64_t time_ns) const;
+
+private:
+    void start(const BarStruct& bar, uint64_t period_start);
+    void merge(const BarStruct& bar);
+    quanttrader::time::PeriodAligner::Period aligned_period() const;
+    // End of a calendar period, found once with about 20 alignments instead of one per bar
+    uint64_t find_period_end(uint64_t period_start) const;
+
+    BarType bar_type_;
+    unsigned int bar_size_;
+    std::shared_ptr<quanttrader::time::PeriodAligner> aligner_;  // trading days of the exchange, may be shared
+    bool started_ = false;
+    BarStruct current_ {};
+    uint64_t period_end_ = 0;  // end of the period in progress, 0 if unknown
+    double volume_ = 0.0;      // the wap weights, as doubles to avoid decimal divisions per bar
+    double wap_volume_ = 0.0;
+};
+
+} // namespace resampler
+} // namespace data
+} // namespace quanttrader
@@ -1,7 +1,6 @@
 #include "data_resampler.h"
-#include "time/time_util.h"
-#include <limits>
 #include <algorithm>
+#include <limits>
 
 // Avoid macro conflicts with std::max
 #undef min
@@ -36,15 +35,26 @@ bool can_resample(BarType source_type, BarType target_type) {
     return source_pos <= target_pos;
 }
 
+std::shared_ptr<quanttrader::time::PeriodAligner> make_period_aligner(const provider::DataProvider& source_provider,
+                                                                      BarType target_type) {
+    if (target_type != BarType::Day && target_type != BarType::Week && target_type != BarType::Month) {
+        return nullptr;
+    }
+    auto session = source_provider.get_session_hours();
+    return std::make_shared<quanttrader::time::PeriodAligner>(session.timezone, session.start, session.end);
+}
+
 DataResampler::DataResampler(std::shared_ptr<provider::DataProvider> source_provider, 
                            BarType target_type, unsigned int target_size)
     : DataProvider(source_provider->get_data_name() + "_resampled", 
                   std::make_shared<std::unordered_map<std::string, std::any>>()),
-      source_provider_(source_provider) {
+      source_provider_(source_provider),
+      aggregator_(target_type, target_size, make_period_aligner(*source_provider, target_type)) {
     
     symbol_ = source_provider->get_symbol();
     bar_type_ = target_type;
     bar_size_ = target_size;
+    timezone_ = source_provider->get_timezone();
     
     logger_->info("Creating resampler from {} to {} for symbol {}", 
         get_bar_type_string(source_provider->get_bar_type(), source_provider->get_bar_size()),
@@ -58,23 +68,10 @@ bool DataResampler::prepare_data() {
         return false;
     }
     
-    // Initialize the bar line with appropriate type and size
+    // The bar line keeps the served periods for the strategies' views and for rewind
     bar_line_ = std::make_shared<util::BarLine>(0, bar_type_, bar_size_);
-    
-    // Reset aggregate values
-    current_aggregation_started_ = false;
-    current_period_start_ = 0;
-    agg_open_ = 0.0;
-    agg_high_ = 0.0;
-    agg_low_ = 0.0;
-    agg_close_ = 0.0;
-    agg_volume_ = Decimal(0);
-    agg_wap_ = Decimal(0);
-    agg_count_ = 0;
-    bar_count_ = 0;
-    
-    // Clear any existing resampled bars
-    resampled_bars_.clear();
+    aggregator_.reset();
+    source_finished_ = false;
     
     return true;
 }
@@ -84,64 +81,40 @@ bool DataResampler::start_request_data() {
         logger_->error("Source provider is null");
         return false;
     }
-    
-    if (!source_provider_->is_data_ready()) {
-        logger_->error("Source provider is not ready");
-        return false;
-    }
-    
-    // Preload data from source provider
-    source_provider_->rewind();
-    
-    // Process all bars from source provider
-    std::optional<BarStruct> bar;
-    while ((bar = source_provider_->next()).has_value()) {
-        if (add_to_aggregation(bar.value()) && bar_line_) {
-            // A new resampled bar is ready, add it to our bar line
-            BarStruct resampled_bar = finalize_aggregation();
-            bar_line_->push_data(
-                resampled_bar.time,
-                resampled_bar.open,
-                resampled_bar.high,
-                resampled_bar.low,
-                resampled_bar.close,
-                resampled_bar.volume,
-                resampled_bar.swap,
-                resampled_bar.count
-            );
-        }
+
+    // Live sources tell the replay loop about new bars through the resampler
+    source_provider_->set_data_listener([this]() { notify_data_listener(); });
+    if (source_provider_->is_data_ready()) {
+        mark_data_ready();
+        return true;
     }
-    
-    // If there's an incomplete bar at the end, finalize it too
-    if (current_aggregation_started_ && bar_line_) {
-        BarStruct resampled_bar = finalize_aggregation();
-        bar_line_->push_data(
-            resampled_bar.time,
-            resampled_bar.open,
-            resampled_bar.high,
-            resampled_bar.low,
-            resampled_bar.close,
-            resampled_bar.volume,
-            resampled_bar.swap,
-            resampled_bar.count
-        );
+
+    // The resampler replaced its source in the replay controller, so it starts the source
+    source_provider_->set_ready_listener([this]() { mark_data_ready(); });
+    if (!source_provider_->start_request_data()) {
+        logger_->error("Failed to start the source provider {}", source_provider_->get_data_name());
+        return false;
     }
-    
-    // Reset bar line to beginning
-    if (bar_line_) {
-        bar_line_->reset();
+    if (source_provider_->is_data_ready()) {
+        mark_data_ready();
     }
-    
-    data_ready_ = true;
     return true;
 }
 
 bool DataResampler::terminate_request_data() {
-    // Nothing to do for resampler
-    return true;
+    if (!source_provider_) {
+        return true;
+    }
+    source_provider_->set_data_listener(nullptr);
+    source_provider_->set_ready_listener(nullptr);
+    return source_provider_->terminate_request_data();
 }
 
 bool DataResampler::is_data_ready() {
+    if (!data_ready_ && source_provider_ && source_provider_->is_data_ready()) {
+        // Sources that do not mark their data ready are polled
+        mark_data_ready();
+    }
     return data_ready_;
 }
 
@@ -150,24 +123,22 @@ std::optional<BarStruct> DataResampler::next() {
         return std::nullopt;
     }
     
+    // After a rewind the periods served so far come from the bar line
     auto bar_opt = bar_line_->next();
     if (!bar_opt.has_value()) {
-        return std::nullopt;
+        bar_opt = pull_next_period();
+        if (!bar_opt.has_value()) {
+            return std::nullopt;
+        }
+        bar_line_->push_data(bar_opt.value());
+        bar_line_->next();
     }
     
-    // Handle replay modes
-    if (bar_opt.has_value()) {
-        BarStruct current_bar = bar_opt.value();
-        
-        // For realtime mode, wait appropriately
-        wait_for_realtime(current_bar, last_bar_);
-        
-        // For stepped mode, wait for step signal
-        wait_for_step();
-        
-        // Update last bar for next time
-        last_bar_ = current_bar;
-    }
+    // For stepped mode, wait for step signal
+    wait_for_step();
+    
+    // Update last bar for next time
+    last_bar_ = bar_opt.value();
     
     return bar_opt;
 }
@@ -178,92 +149,56 @@ bool DataResampler::rewind() {
         return false;
     }
     
+    // The source stays where it is, the periods read from it are replayed from the bar line
     bar_line_->reset();
     return true;
 }
 
-bool DataResampler::add_to_aggregation(const BarStruct& bar) {
-    uint64_t bar_time = bar.time;
-    
-    // If this is the first bar, start a new aggregation
-    if (!current_aggregation_started_) {
-        current_period_start_ = align_to_period_start(bar_time);
-        agg_open_ = bar.open;
-        agg_high_ = bar.high;
-        agg_low_ = bar.low;
-        agg_close_ = bar.close;
-        agg_volume_ = bar.volume;
-        agg_wap_ = bar.swap;
-        agg_count_ = bar.count;
-        bar_count_ = 1;
-        current_aggregation_started_ = true;
+bool DataResampler::seek(uint64_t time) {
+    if (!bar_line_) {
+        logger_->error("Cannot seek resampler: bar line is not initialized");
         return false;
     }
-    
-    // Check if this bar belongs to the current period
-    if (is_same_period(bar_time)) {
-        // Update aggregation values
-        agg_high_ = std::max(agg_high_, bar.high);
-        agg_low_ = std::min(agg_low_, bar.low);
-        agg_close_ = bar.close;
-        agg_volume_ = agg_volume_ + bar.volume;
-        // Update weighted average price if volume is available
-        if (bar.volume > Decimal(0)) {
-            Decimal bar_volume_weight = bar.volume / (agg_volume_);
-            agg_wap_ = agg_wap_ + (bar.swap - agg_wap_) * bar_volume_weight;
+
+    // Build the periods up to the time from the source, they stay in the views as history
+    auto periods = bar_line_->view(std::numeric_limits<size_t>::max());
+    std::optional<uint64_t> last_time;
+    if (!periods.empty()) {
+        last_time = periods.start_time.back();
+    }
+    while (!last_time.has_value() || last_time.value() < time) {
+        auto period = pull_next_period();
+        if (!period.has_value()) {
+            break;  // the source has no more bars yet, the cursor waits at the end
         }
-        agg_count_ += bar.count;
-        bar_count_++;
-        return false;
-    } else {
-        // The bar belongs to a new period, so the current aggregation is complete
-        return true;
+        bar_line_->push_data(period.value());
+        last_time = period->time;
     }
+    bar_line_->seek(time);
+    return true;
 }
 
-BarStruct DataResampler::finalize_aggregation() {
-    BarStruct resampled_bar;
-    resampled_bar.time = current_period_start_;
-    resampled_bar.open = agg_open_;
-    resampled_bar.high = agg_high_;
-    resampled_bar.low = agg_low_;
-    resampled_bar.close = agg_close_;
-    resampled_bar.volume = agg_volume_;
-    resampled_bar.swap = agg_wap_;
-    resampled_bar.count = agg_count_;
-    
-    // Reset aggregation
-    current_aggregation_started_ = false;
-    
-    return resampled_bar;
-}
+std::optional<BarStruct> DataResampler::pull_next_period() {
+    if (source_finished_) {
+        return std::nullopt;
+    }
 
-bool DataResampler::is_same_period(uint64_t bar_time) const {
-    uint64_t period_start = align_to_period_start(bar_time);
-    return period_start == current_period_start_;
-}
+    std::optional<BarStruct> bar;
+    while ((bar = source_provider_->next()).has_value()) {
+        auto finished = aggregator_.add(bar.value());
+        if (finished.has_value()) {
+            return finished;
+        }
+    }
 
-uint64_t DataResampler::align_to_period_start(uint64_t time_ns) const {
-    using quanttrader::time::TimeUtil;
-    
-    switch (bar_type_) {
-        case BarType::Second:
-            return TimeUtil::align_to_second(time_ns, bar_size_);
-        case BarType::Minute:
-            return TimeUtil::align_to_minute(time_ns, bar_size_);
-        case BarType::Hour:
-            return TimeUtil::align_to_hour(time_ns, bar_size_);
-        case BarType::Day:
-            return TimeUtil::align_to_day(time_ns, bar_size_);
-        case BarType::Week:
-            return TimeUtil::align_to_week(time_ns);
-        case BarType::Month:
-            return TimeUtil::align_to_month(time_ns);
-        default:
-            return time_ns;
+    // A finite source has no more bars, its last period is complete
+    if (!source_provider_->is_live() && source_provider_->is_data_ready()) {
+        source_finished_ = true;
+        return aggregator_.flush();
     }
+    return std::nullopt;
 }
 
 } // namespace resampler
 } // namespace data
-} // namespace quanttrader
\ No newline at end of file
+} // namespace quanttrader
@@ -1,9 +1,9 @@
 #pragma once
 
 #include "data/common/data_provider.h"
+#include "bar_aggregator.h"
 #include <memory>
 #include <vector>
-#include <deque>
 
 namespace quanttrader {
 namespace data {
@@ -18,11 +18,25 @@ namespace resampler {
  */
 bool can_resample(BarType source_type, BarType target_type);
 
+/**
+ * @brief Create the aligner of a calendar timeframe from the source's timezone and session
+ * 
+ * @param source_provider The provider to resample
+ * @param target_type The target bar type
+ * @return The aligner for days, weeks and months, nullptr for intraday timeframes
+ */
+std::shared_ptr<quanttrader::time::PeriodAligner> make_period_aligner(const provider::DataProvider& source_provider,
+                                                                      BarType target_type);
+
 /**
  * @brief Data resampler class that converts data from one timeframe to another
  * 
  * This class wraps an existing data provider and resamples its data to a new timeframe.
  * It acts as a data provider itself, allowing transparent usage in the framework.
+ * Source bars are pulled in next(): a period is served once the first bar of the next
+ * period arrives, so it works on live sources that keep growing. Periods are stored while
+ * the replay merges the other feeds, so views over them are taken with pin_bar_view after
+ * the merge.
  */
 class DataResampler : public provider::DataProvider {
 public:
@@ -45,53 +59,33 @@ public:
     bool is_data_ready() override;
     std::optional<BarStruct> next() override;
     bool rewind() override;
-    
-private:
-    /**
-     * @brief Add a new bar to the current aggregation
-     * 
-     * @param bar The bar to add
-     * @return true if a new resampled bar is completed and ready
-     */
-    bool add_to_aggregation(const BarStruct& bar);
-    
+    bool seek(uint64_t time) override;  // reads the source up to the time
+    bool is_live() const override { return source_provider_ && source_provider_->is_live(); }
+    provider::SessionHours get_session_hours() const override { return source_provider_->get_session_hours(); }
+    // Starts and reads its source provider
+    bool supports_parallel_start() const override { return false; }
+
     /**
-     * @brief Finalize the current aggregation into a complete bar
+     * @brief The period in progress, built from the source bars read so far
      * 
-     * @return The completed resampled bar
-     */
-    BarStruct finalize_aggregation();
-    
-    /**
-     * @brief Check if the current bar belongs to the current aggregation period
+     * Call it from the thread that calls next(). A live strategy can act on it before the
+     * period is finished.
      * 
-     * @param bar_time The timestamp of the bar to check
-     * @return true if the bar belongs to the current period, false otherwise
+     * @return The partial bar, std::nullopt before the first source bar
      */
-    bool is_same_period(uint64_t bar_time) const;
+    std::optional<BarStruct> get_partial_bar() const { return aggregator_.partial(); }
     
+private:
     /**
-     * @brief Align a timestamp to the start of its period based on target timeframe
+     * @brief Read source bars until a period is finished
      * 
-     * @param time_ns The timestamp to align
-     * @return The aligned timestamp
+     * @return The finished period, std::nullopt when the source has no more bars yet
      */
-    uint64_t align_to_period_start(uint64_t time_ns) const;
+    std::optional<BarStruct> pull_next_period();
 
     std::shared_ptr<provider::DataProvider> source_provider_;
-    std::deque<BarStruct> resampled_bars_;
-    bool current_aggregation_started_ = false;
-    uint64_t current_period_start_ = 0;
-    
-    // Aggregation state
-    double agg_open_ = 0.0;
-    double agg_high_ = 0.0;
-    double agg_low_ = 0.0;
-    double agg_close_ = 0.0;
-    Decimal agg_volume_ = Decimal(0);
-    Decimal agg_wap_ = Decimal(0);
-    int agg_count_ = 0;
-    int bar_count_ = 0;
+    BarAggregator aggregator_;
+    bool source_finished_ = false;  // a finite source is exhausted and the last period served
 };
 
 } // namespace resampler
@@ -0,0 +1,341 @@
+#include "multi_resampler.h"
+#include "data_resampler.h"
+#include <algorithm>
+#include <limits>
+
+namespace quanttrader {
+namespace data {
+namespace resampler {
+
+namespace {
+
+// Rough period length used to order the timeframes
+uint64_t period_order(BarType bar_type, unsigned int bar_size) {
+    uint64_t fixed = BarAggregator::fixed_period_nanos(bar_type, bar_size);
+    if (fixed != 0) {
+        return fixed;
+    }
+    constexpr uint64_t kDay = 86400ULL * kSecondsToNano;
+    switch (bar_type) {
+        case BarType::Day:
+            return bar_size * kDay;
+        case BarType::Week:
+            return 7 * kDay;
+        case BarType::Month:
+            return 31 * kDay;
+        default:
+            return 0;
+    }
+}
+
+}
+
+MultiResampler::MultiResampler(std::shared_ptr<provider::DataProvider> source_provider)
+    : source_provider_(std::move(source_provider)) {
+    logger_ = quanttrader::log::get_common_rotation_logger("MultiResampler", "data");
+}
+
+MultiResampler::~MultiResampler() {
+    if (started_) {
+        source_provider_->set_data_listener(nullptr);
+        source_provider_->set_ready_listener(nullptr);
+    }
+}
+
+std::vector<std::shared_ptr<ResampledFeed>> MultiResampler::create(std::shared_ptr<provider::DataProvider> source_provider,
+                                                                   const std::vector<Target>& targets) {
+    std::vector<std::shared_ptr<ResampledFeed>> feeds;
+    if (!source_provider || targets.empty()) {
+        return feeds;
+    }
+
+    auto resampler = std::make_shared<MultiResampler>(source_provider);
+    auto source_type = source_provider->get_bar_type();
+    auto source_size = source_provider->get_bar_size();
+    std::vector<Target> ordered;
+    for (const auto& target : targets) {
+        if (!can_resample(source_type, target.first) || target.second == 0 || period_order(target.first, target.second) == 0 ||
+            (target.first == source_type && target.second <= source_size)) {
+            resampler->logger_->error("Cannot resample {} from {} to {}", source_provider->get_data_name(),
+                                      provider::DataProvider::get_bar_type_string(source_type, source_size),
+                                      provider::DataProvider::get_bar_type_string(target.first, target.second));
+            return {};
+        }
+        if (std::find(ordered.begin(), ordered.end(), target) == ordered.end()) {
+            ordered.push_back(target);
+        }
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const Target& a, const Target& b) {
+        return period_order(a.first, a.second) < period_order(b.first, b.second);
+    });
+
+    std::shared_ptr<quanttrader::time::PeriodAligner> aligner;
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        if (!aligner && BarAggregator::fixed_period_nanos(ordered[i].first, ordered[i].second) == 0) {
+            aligner = make_period_aligner(*source_provider, ordered[i].first);
+        }
+        Level level {BarAggregator(ordered[i].first, ordered[i].second,
+                                   BarAggregator::fixed_period_nanos(ordered[i].first, ordered[i].second) == 0 ? aligner : nullptr)};
+        // The largest smaller intraday timeframe that divides this one
+        uint64_t length = BarAggregator::fixed_period_nanos(ordered[i].first, ordered[i].second);
+        for (size_t j = i; length != 0 && j-- > 0;) {
+            uint64_t parent_length = BarAggregator::fixed_period_nanos(ordered[j].first, ordered[j].second);
+            if (parent_length != 0 && parent_length < length && length % parent_length == 0) {
+                level.parent = static_cast<int>(j);
+                break;
+            }
+        }
+        if (level.parent < 0) {
+            resampler->roots_.push_back(i);
+        } else {
+            resampler->levels_[level.parent].children.push_back(i);
+        }
+        resampler->levels_.push_back(std::move(level));
+    }
+
+    std::string chain;
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        const auto& level = resampler->levels_[i];
+        const auto& from = level.parent < 0 ? Target {source_type, source_size} : ordered[level.parent];
+        chain += (i ? ", " : "") + provider::DataProvider::get_bar_type_string(ordered[i].first, ordered[i].second) + " from " +
+                 provider::DataProvider::get_bar_type_string(from.first, from.second);
+    }
+    resampler->logger_->info("Resampling {} in one pass: {}", source_provider->get_data_name(), chain);
+
+    std::vector<Target> created;
+    for (const auto& target : targets) {
+        if (std::find(created.begin(), created.end(), target) != created.end()) {
+            continue;
+        }
+        created.push_back(target);
+        size_t level = std::find(ordered.begin(), ordered.end(), target) - ordered.begin();
+        std::string name = provider::DataProvider::get_bar_type_string(target.first, target.second);
+        std::replace(name.begin(), name.end(), ' ', '_');
+        auto feed = std::make_shared<ResampledFeed>(resampler, level, source_provider->get_data_name() + "_" + name,
+                                                    source_provider->get_symbol(), target.first, target.second,
+                                                    source_provider->get_timezone());
+        if (!feed->prepare_data()) {
+            return {};
+        }
+        resampler->levels_[level].feed = feed;
+        feeds.push_back(std::move(feed));
+    }
+    return feeds;
+}
+
+bool MultiResampler::start() {
+    if (started_) {
+        return true;
+    }
+    started_ = true;
+
+    source_provider_->set_data_listener([this]() { notify_feeds(false); });
+    if (source_provider_->is_data_ready()) {
+        notify_feeds(true);
+        return true;
+    }
+    source_provider_->set_ready_listener([this]() { notify_feeds(true); });
+    if (!source_provider_->start_request_data()) {
+        logger_->error("Failed to start the source provider {}", source_provider_->get_data_name());
+        return false;
+    }
+    if (source_provider_->is_data_ready()) {
+        notify_feeds(true);
+    }
+    return true;
+}
+
+bool MultiResampler::terminate() {
+    if (!started_ || terminated_) {
+        return true;
+    }
+    terminated_ = true;
+    source_provider_->set_data_listener(nullptr);
+    source_provider_->set_ready_listener(nullptr);
+    return source_provider_->terminate_request_data();
+}
+
+std::optional<BarStruct> MultiResampler::pull(size_t level) {
+    auto& finished = levels_[level].finished;
+    while (finished.empty()) {
+        if (source_finished_) {
+            return std::nullopt;
+        }
+        auto bar = source_provider_->next();
+        if (bar.has_value()) {
+            feed_source_bar(bar.value());
+            continue;
+        }
+        // A finite source has no more bars, the last periods are complete
+        if (!source_provider_->is_live() && source_provider_->is_data_ready()) {
+            flush_all();
+            source_finished_ = true;
+            continue;
+        }
+        return std::nullopt;
+    }
+    BarStruct bar = finished.front();
+    finished.pop_front();
+    return bar;
+}
+
+std::optional<BarStruct> MultiResampler::partial(size_t level) const {
+    const auto& current = levels_[level];
+    if (current.parent < 0) {
+        return current.aggregator.partial();
+    }
+    auto from_parent = partial(current.parent);
+    if (!from_parent.has_value()) {
+        return current.aggregator.partial();
+    }
+    BarAggregator combined = current.aggregator;
+    combined.add(from_parent.value());
+    return combined.partial();
+}
+
+void MultiResampler::feed_source_bar(const BarStruct& bar) {
+    // Finish the periods the bar is past, smaller ones first so they reach their children in time
+    for (size_t i = 0; i < levels_.size(); ++i) {
+        if (levels_[i].aggregator.is_ended_by(bar.time)) {
+            emit(i, levels_[i].aggregator.flush().value());
+        }
+    }
+    for (size_t root : roots_) {
+        auto finished = levels_[root].aggregator.add(bar);
+        if (finished.has_value()) {
+            emit(root, finished.value());
+        }
+    }
+}
+
+void MultiResampler::emit(size_t level, const BarStruct& bar) {
+    auto& current = levels_[level];
+    if (!current.feed.expired()) {
+        current.finished.push_back(bar);
+    }
+    for (size_t child : current.children) {
+        auto finished = levels_[child].aggregator.add(bar);
+        if (finished.has_value()) {
+            emit(child, finished.value());
+        }
+    }
+}
+
+void MultiResampler::flush_all() {
+    for (size_t i = 0; i < levels_.size(); ++i) {
+        auto bar = levels_[i].aggregator.flush();
+        if (bar.has_value()) {
+            emit(i, bar.value());
+        }
+    }
+}
+
+void MultiResampler::notify_feeds(bool ready) {
+    for (auto& level : levels_) {
+        if (auto feed = level.feed.lock()) {
+            if (ready) {
+                feed->on_source_ready();
+            } else {
+                feed->on_source_data();
+            }
+        }
+    }
+}
+
+ResampledFeed::ResampledFeed(std::shared_ptr<MultiResampler> resampler, size_t level, const std::string& data_name,
+                             const std::string& symbol, BarType bar_type, unsigned int bar_size, const std::string& timezone)
+    : DataProvider(data_name, std::make_shared<std::unordered_map<std::string, std::any>>()),
+      resampler_(std::move(resampler)),
+      level_(level) {
+    symbol_ = symbol;
+    bar_type_ = bar_type;
+    bar_size_ = bar_size;
+    timezone_ = timezone;
+}
+
+bool ResampledFeed::prepare_data() {
+    // The bar line keeps the served periods for the strategies' views and for rewind
+    bar_line_ = std::make_shared<util::BarLine>(0, bar_type_, bar_size_);
+    return true;
+}
+
+bool ResampledFeed::start_request_data() {
+    if (!resampler_->start()) {
+        return false;
+    }
+    if (resampler_->is_source_ready()) {
+        mark_data_ready();
+    }
+    return true;
+}
+
+bool ResampledFeed::terminate_request_data() {
+    return resampler_->terminate();
+}
+
+bool ResampledFeed::is_data_ready() {
+    if (!data_ready_ && resampler_->is_source_ready()) {
+        mark_data_ready();
+    }
+    return data_ready_;
+}
+
+std::optional<BarStruct> ResampledFeed::next() {
+    if (!data_ready_ || !bar_line_) {
+        return std::nullopt;
+    }
+
+    // After a rewind the periods served so far come from the bar line
+    auto bar_opt = bar_line_->next();
+    if (!bar_opt.has_value()) {
+        bar_opt = resampler_->pull(level_);
+        if (!bar_opt.has_value()) {
+            return std::nullopt;
+        }
+        bar_line_->push_data(bar_opt.value());
+        bar_line_->next();
+    }
+
+    // For stepped mode, wait for step signal
+    wait_for_step();
+
+    last_bar_ = bar_opt.value();
+    return bar_opt;
+}
+
+bool ResampledFeed::rewind() {
+    if (!bar_line_) {
+        logger_->error("Cannot rewind resampled feed: bar line is not initialized");
+        return false;
+    }
+    bar_line_->reset();
+    return true;
+}
+
+bool ResampledFeed::seek(uint64_t time) {
+    if (!bar_line_) {
+        logger_->error("Cannot seek resampled feed: bar line is not initialized");
+        return false;
+    }
+
+    // Build the periods up to the time from the source, they stay in the views as history
+    auto periods = bar_line_->view(std::numeric_limits<size_t>::max());
+    std::optional<uint64_t> last_time;
+    if (!periods.empty()) {
+        last_time = periods.start_time.back();
+    }
+    while (!last_time.has_value() || last_time.value() < time) {
+        auto period = resampler_->pull(level_);
+        if (!period.has_value()) {
+            break;  // the source has no more bars yet, the cursor waits at the end
+        }
+        bar_line_->push_data(period.value());
+        last_time = period->time;
+    }
+    bar_line_->seek(time);
+    return true;
+}
+
+} // namespace resampler
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "data/common/data_provider.h"
+#include "bar_aggregator.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace resampler {
+
+class ResampledFeed;
+
+/**
+ * @brief Resamples one source provider into several timeframes in a single pass
+ *
+ * Every source bar is read once. An intraday timeframe is built from the largest smaller
+ * one it nests in, e.g. 5 mins from 1 min and 1 hour from 15 mins, so each source bar is
+ * aggregated into the finest timeframes only. Days and longer are built from the source and
+ * share one aligner for the trading days of its session. Finished periods wait in a queue per
+ * timeframe until its ResampledFeed reads them.
+ *
+ * Not thread safe: the feeds are read from the replay thread.
+ */
+class MultiResampler {
+public:
+    using Target = std::pair<BarType, unsigned int>;
+
+    explicit MultiResampler(std::shared_ptr<provider::DataProvider> source_provider);
+    ~MultiResampler();
+
+    /**
+     * @brief Create the feeds of the timeframes
+     *
+     * @param source_provider The provider to resample
+     * @param targets The timeframes, each one larger than the source's
+     * @return One prepared feed per distinct target in the same order, empty if a target is invalid
+     */
+    static std::vector<std::shared_ptr<ResampledFeed>> create(std::shared_ptr<provider::DataProvider> source_provider,
+                                                              const std::vector<Target>& targets);
+
+    // Called by the feeds
+    bool start();
+    bool terminate();
+    bool is_source_ready() const { return source_provider_->is_data_ready(); }
+    bool is_source_live() const { return source_provider_->is_live(); }
+    provider::SessionHours get_source_session() const { return source_provider_->get_session_hours(); }
+    std::optional<BarStruct> pull(size_t level);
+    std::optional<BarStruct> partial(size_t level) const;
+
+    /**
+     * @brief Index of the timeframe a level is built from, -1 for the source
+     */
+    int get_parent(size_t level) const { return levels_[level].parent; }
+
+private:
+    struct Level {
+        BarAggregator aggregator;
+        int parent = -1;
+        std::vector<size_t> children {};
+        std::deque<BarStruct> finished {};  // periods not read by the feed yet
+        std::weak_ptr<ResampledFeed> feed {};
+    };
+
+    void feed_source_bar(const BarStruct& bar);
+    void emit(size_t level, const BarStruct& bar);
+    void flush_all();
+    void notify_feeds(bool ready);
+
+    std::shared_ptr<provider::DataProvider> source_provider_;
+    std::vector<Level> levels_;  // ordered from the shortest period
+    std::vector<size_t> roots_;  // levels built from the source bars
+    bool started_ = false;
+    bool terminated_ = false;
+    bool source_finished_ = false;
+    quanttrader::log::LoggerPtr logger_ {nullptr};
+};
+
+/**
+ * @brief One timeframe of a MultiResampler, served like any data provider
+ */
+class ResampledFeed : public provider::DataProvider {
+public:
+    ResampledFeed(std::shared_ptr<MultiResampler> resampler, size_t level, const std::string& data_name,
+                  const std::string& symbol, BarType bar_type, unsigned int bar_size, const std::string& timezone);
+
+    bool prepare_data() override;
+    bool start_request_data() override;
+    bool terminate_request_data() override;
+    bool is_data_ready() override;
+    std::optional<BarStruct> next() override;
+    bool rewind() override;
+    bool seek(uint64_t time) override;  // reads the source up to the time
+    bool is_live() const override { return resampler_->is_source_live(); }
+    provider::SessionHours get_session_hours() const override { return resampler_->get_source_session(); }
+    // Shares the source with the other timeframes
+    bool supports_parallel_start() const override { return false; }
+
+    /**
+     * @brief The period in progress, including the source bars not in a finished smaller period yet
+     */
+    std::optional<BarStruct> get_partial_bar() const { return resampler_->partial(level_); }
+
+private:
+    friend class MultiResampler;
+    void on_source_ready() { mark_data_ready(); }
+    void on_source_data() { notify_data_listener(); }
+
+    std::shared_ptr<MultiResampler> resampler_;
+    size_t level_;
+};
+
+} // namespace resampler
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,576 @@
+#include "chunked_file.h"
+#include "mapped_file.h"
+#include "time/time_util.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+namespace {
+
+constexpr uint64_t kNanosPerDay = 86400ULL * 1000000000ULL;
+
+constexpr std::array<size_t, 8> kColumnSizes = {
+    sizeof(uint64_t), sizeof(double), sizeof(double), sizeof(double),
+    sizeof(double), sizeof(Decimal), sizeof(Decimal), sizeof(int)};
+
+constexpr size_t kBarBytes = sizeof(uint64_t) + sizeof(double) * 4 + sizeof(Decimal) * 2 + sizeof(int);
+
+// start_time, open, high, low, close, wap, volume, count
+constexpr std::array<ColumnCodec, kChunkColumnCount> kDefaultColumnCodecs = {
+    ColumnCodec::DeltaOfDelta, ColumnCodec::ScaledDelta, ColumnCodec::ScaledDelta, ColumnCodec::ScaledDelta,
+    ColumnCodec::ScaledDelta, ColumnCodec::ZigzagDelta, ColumnCodec::ZigzagDelta, ColumnCodec::Zigzag};
+
+ChunkEncoding header_encoding(const ChunkedFileHeader& header) {
+    return header.column_count == kChunkColumnCount ? ChunkEncoding::ColumnCodecs : ChunkEncoding::Zlib;
+}
+
+// Everything needed to read or extend a mapped file, the chunks point into the mapping
+struct FileLayout {
+    ChunkedFileHeader header;
+    ChunkedFileTrailer trailer;
+    std::span<const ChunkInfo> chunks;
+};
+
+template <typename T>
+void pack_column(std::vector<char>& raw, size_t& offset, std::span<const T> column, size_t first, size_t count) {
+    std::memcpy(raw.data() + offset, column.data() + first, count * sizeof(T));
+    offset += count * sizeof(T);
+}
+
+template <typename T>
+void unpack_column(std::vector<T>& column, size_t to, const char* raw, size_t column_offset, size_t first, size_t count) {
+    std::memcpy(column.data() + to, raw + column_offset + first * sizeof(T), count * sizeof(T));
+}
+
+bool compress_chunk(const std::vector<char>& raw, std::vector<char>& compressed) {
+    uLongf size = compressBound(static_cast<uLong>(raw.size()));
+    compressed.resize(size);
+    int result = compress(reinterpret_cast<Bytef*>(compressed.data()), &size,
+                          reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()));
+    if (result != Z_OK) {
+        return false;
+    }
+    compressed.resize(size);
+    return true;
+}
+
+bool decompress_chunk(const char* source, const ChunkInfo& chunk, std::vector<char>& raw) {
+    uLongf size = static_cast<uLongf>(chunk.raw_size);
+    int result = uncompress(reinterpret_cast<Bytef*>(raw.data()), &size,
+                            reinterpret_cast<const Bytef*>(source + chunk.offset), static_cast<uLong>(chunk.stored_size));
+    return result == Z_OK && size == chunk.raw_size;
+}
+
+template <typename T>
+void encode_column(std::vector<char>& out, ColumnCodec codec, std::span<const T> column, size_t first, size_t count,
+                   std::vector<uint64_t>& words) {
+    words.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            words[i] = std::bit_cast<uint64_t>(column[first + i]);
+        } else {
+            words[i] = static_cast<uint64_t>(static_cast<int64_t>(column[first + i]));
+        }
+    }
+    ColumnCoder::encode(codec, words, out);
+}
+
+// Chunk payload: the encoded size of every column, then the columns
+void encode_chunk(const BarSeriesView& bars, size_t first, size_t count, const ChunkedFileHeader& header,
+                  std::vector<char>& encoded, std::vector<uint64_t>& words) {
+    std::array<uint64_t, kChunkColumnCount> sizes {};
+    encoded.assign(sizeof(sizes), 0);
+    auto codec = [&header](size_t c) { return static_cast<ColumnCodec>(header.column_codecs[c]); };
+    auto encode = [&](size_t c, const auto& column) {
+        size_t before = encoded.size();
+        encode_column(encoded, codec(c), column, first, count, words);
+        sizes[c] = encoded.size() - before;
+    };
+    encode(0, bars.start_time);
+    encode(1, bars.open);
+    encode(2, bars.high);
+    encode(3, bars.low);
+    encode(4, bars.close);
+    encode(5, bars.wap);
+    encode(6, bars.volume);
+    encode(7, bars.count);
+    std::memcpy(encoded.data(), sizes.data(), sizeof(sizes));
+}
+
+bool decode_chunk(const char* source, const ChunkInfo& chunk, const ChunkedFileHeader& header, std::vector<char>& raw,
+                  DecodePath path) {
+    std::array<uint64_t, kChunkColumnCount> sizes;
+    if (chunk.stored_size < sizeof(sizes)) {
+        return false;
+    }
+    const char* data = source + chunk.offset;
+    std::memcpy(sizes.data(), data, sizeof(sizes));
+
+    uint64_t position = sizeof(sizes);
+    size_t raw_offset = 0;
+    std::vector<uint64_t> counts;
+    for (size_t c = 0; c < kChunkColumnCount; ++c) {
+        if (sizes[c] > chunk.stored_size - position) {
+            return false;
+        }
+        auto codec = static_cast<ColumnCodec>(header.column_codecs[c]);
+        if (kColumnSizes[c] == sizeof(uint64_t)) {
+            std::span<uint64_t> words(reinterpret_cast<uint64_t*>(raw.data() + raw_offset), chunk.bar_count);
+            if (!ColumnCoder::decode(codec, data + position, sizes[c], words, path)) {
+                return false;
+            }
+        } else {
+            // Narrow columns are encoded as sign extended words
+            counts.resize(chunk.bar_count);
+            if (!ColumnCoder::decode(codec, data + position, sizes[c], counts, path)) {
+                return false;
+            }
+            auto* values = reinterpret_cast<int*>(raw.data() + raw_offset);
+            for (size_t i = 0; i < counts.size(); ++i) {
+                values[i] = static_cast<int>(static_cast<int64_t>(counts[i]));
+            }
+        }
+        position += sizes[c];
+        raw_offset += chunk.bar_count * kColumnSizes[c];
+    }
+    return true;
+}
+
+bool read_chunk(const char* source, const ChunkInfo& chunk, const ChunkedFileHeader& header, std::vector<char>& raw,
+                DecodePath path) {
+    raw.resize(chunk.raw_size);
+    if (chunk.codec == static_cast<uint32_t>(ChunkEncoding::ColumnCodecs)) {
+        return decode_chunk(source, chunk, header, raw, path);
+    }
+    return decompress_chunk(source, chunk, raw);
+}
+
+// Writes bars as chunks starting at offset, then the index (index plus the new chunks) and the trailer
+bool write_chunks(std::ostream& file, uint64_t offset, const BarSeriesView& bars, const ChunkedFileHeader& header,
+                  BarType bar_type, unsigned int bar_size, std::vector<ChunkInfo>& index) {
+    ChunkEncoding encoding = header_encoding(header);
+    std::vector<char> raw;
+    std::vector<char> stored;
+    std::vector<uint64_t> words;
+    size_t first = 0;
+    while (first < bars.size()) {
+        // One chunk per calendar month, capped so that second bars stay manageable
+        size_t limit = std::min(bars.size(), first + kChunkMaxBars);
+        uint64_t boundary = ChunkedFile::next_month_start(bars.start_time[first]);
+        size_t last = static_cast<size_t>(
+            std::lower_bound(bars.start_time.begin() + first, bars.start_time.begin() + limit, boundary) - bars.start_time.begin());
+        size_t count = last - first;
+
+        if (encoding == ChunkEncoding::ColumnCodecs) {
+            encode_chunk(bars, first, count, header, stored, words);
+        } else {
+            raw.resize(count * kBarBytes);
+            size_t raw_offset = 0;
+            pack_column(raw, raw_offset, bars.start_time, first, count);
+            pack_column(raw, raw_offset, bars.open, first, count);
+            pack_column(raw, raw_offset, bars.high, first, count);
+            pack_column(raw, raw_offset, bars.low, first, count);
+            pack_column(raw, raw_offset, bars.close, first, count);
+            pack_column(raw, raw_offset, bars.wap, first, count);
+            pack_column(raw, raw_offset, bars.volume, first, count);
+            pack_column(raw, raw_offset, bars.count, first, count);
+            if (!compress_chunk(raw, stored)) {
+                return false;
+            }
+        }
+        file.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+
+        ChunkInfo chunk {};
+        chunk.first_time = bars.start_time[first];
+        chunk.last_time = bars.start_time[last - 1];
+        chunk.offset = offset;
+        chunk.stored_size = stored.size();
+        chunk.raw_size = count * kBarBytes;
+        chunk.bar_count = static_cast<uint32_t>(count);
+        chunk.codec = static_cast<uint32_t>(encoding);
+        index.push_back(chunk);
+
+        offset += stored.size();
+        first = last;
+    }
+
+    // Align the index so it can be read in place from a mapping
+    std::array<char, alignof(ChunkInfo)> padding {};
+    size_t pad = (alignof(ChunkInfo) - offset % alignof(ChunkInfo)) % alignof(ChunkInfo);
+    file.write(padding.data(), static_cast<std::streamsize>(pad));
+    offset += pad;
+
+    ChunkedFileTrailer trailer {};
+    std::memcpy(trailer.magic, kChunkedMagic, sizeof(kChunkedMagic));
+    trailer.version = kChunkedVersion;
+    trailer.bar_type = static_cast<uint32_t>(bar_type);
+    trailer.bar_size = bar_size;
+    trailer.chunk_count = static_cast<uint32_t>(index.size());
+    trailer.index_offset = offset;
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(ChunkInfo)));
+    file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    return true;
+}
+
+// Appends start a new chunk even when the month of the previous chunk is not over
+bool mergeable(const ChunkInfo& previous, const ChunkInfo& chunk) {
+    return chunk.first_time < ChunkedFile::next_month_start(previous.first_time) &&
+           previous.bar_count + chunk.bar_count <= kChunkMaxBars;
+}
+
+// Validates the header, trailer and index of a mapped chunked file
+std::optional<FileLayout> map_layout(const MappedFile& file, const std::string& path, quanttrader::log::LoggerPtr logger) {
+    FileLayout layout;
+    if (file.size() < sizeof(ChunkedFileHeader) + sizeof(ChunkedFileTrailer)) {
+        logger->error("File {} is not a chunked bar file", path);
+        return std::nullopt;
+    }
+    std::memcpy(&layout.header, file.data(), sizeof(layout.header));
+    if (std::memcmp(layout.header.magic, kChunkedMagic, sizeof(kChunkedMagic)) != 0) {
+        logger->error("File {} is not a chunked bar file", path);
+        return std::nullopt;
+    }
+    if (layout.header.column_count == kChunkColumnCount) {
+        for (uint8_t codec : layout.header.column_codecs) {
+            if (!ColumnCoder::is_valid(codec)) {
+                logger->error("File {} uses unknown column codec {}", path, codec);
+                return std::nullopt;
+            }
+        }
+    }
+
+    auto& trailer = layout.trailer;
+    std::memcpy(&trailer, file.data() + file.size() - sizeof(trailer), sizeof(trailer));
+    if (std::memcmp(trailer.magic, kChunkedMagic, sizeof(kChunkedMagic)) != 0 ||
+        trailer.version < kChunkedMinVersion || trailer.version > kChunkedVersion) {
+        logger->error("File {} has no valid version {} trailer", path, kChunkedVersion);
+        return std::nullopt;
+    }
+
+    uint64_t index_end = trailer.index_offset + static_cast<uint64_t>(trailer.chunk_count) * sizeof(ChunkInfo);
+    if (trailer.index_offset < kChunkedHeaderSize || index_end > file.size() - sizeof(trailer) ||
+        trailer.index_offset % alignof(ChunkInfo) != 0) {
+        logger->error("Chunk index of file {} is out of bounds", path);
+        return std::nullopt;
+    }
+
+    layout.chunks = std::span<const ChunkInfo>(reinterpret_cast<const ChunkInfo*>(file.data() + trailer.index_offset), trailer.chunk_count);
+    for (const auto& chunk : layout.chunks) {
+        bool known_codec = chunk.codec == static_cast<uint32_t>(ChunkEncoding::Zlib) ||
+                           (chunk.codec == static_cast<uint32_t>(ChunkEncoding::ColumnCodecs) &&
+                            header_encoding(layout.header) == ChunkEncoding::ColumnCodecs);
+        if (chunk.offset + chunk.stored_size > trailer.index_offset || chunk.raw_size != chunk.bar_count * kBarBytes || !known_codec) {
+            logger->error("Chunk at offset {} of file {} is invalid", chunk.offset, path);
+            return std::nullopt;
+        }
+    }
+    return layout;
+}
+
+// Maps the file just long enough to copy its layout, so it can be written afterwards
+std::optional<FileLayout> copy_layout(const std::string& path, std::vector<ChunkInfo>& index, quanttrader::log::LoggerPtr logger) {
+    auto mapped = MappedFile::open(path);
+    if (!mapped) {
+        logger->error("Failed to map file: {}", path);
+        return std::nullopt;
+    }
+    auto layout = map_layout(*mapped, path, logger);
+    if (layout.has_value()) {
+        index.assign(layout->chunks.begin(), layout->chunks.end());
+        layout->chunks = {};
+    }
+    return layout;
+}
+
+}  // namespace
+
+uint64_t ChunkedFile::next_month_start(uint64_t time) {
+    int64_t year = 0;
+    unsigned int month = 0;
+    unsigned int day = 0;
+    time::TimeUtil::civil_from_days(static_cast<int64_t>(time / kNanosPerDay), year, month, day);
+    if (month == 12) {
+        ++year;
+        month = 1;
+    } else {
+        ++month;
+    }
+    return static_cast<uint64_t>(time::TimeUtil::days_from_civil(year, month, 1)) * kNanosPerDay;
+}
+
+bool ChunkedFile::write(const std::string& path, const BarSeriesView& bars, BarType bar_type, unsigned int bar_size,
+                        quanttrader::log::LoggerPtr logger, ChunkEncoding encoding) {
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            logger->error("Failed to open file for writing: {}", temp_path);
+            return false;
+        }
+
+        ChunkedFileHeader header {};
+        std::memcpy(header.magic, kChunkedMagic, sizeof(kChunkedMagic));
+        header.version = kChunkedVersion;
+        if (encoding == ChunkEncoding::ColumnCodecs) {
+            header.column_count = kChunkColumnCount;
+            for (size_t c = 0; c < kChunkColumnCount; ++c) {
+                header.column_codecs[c] = static_cast<uint8_t>(kDefaultColumnCodecs[c]);
+            }
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<ChunkInfo> index;
+        if (!write_chunks(file, sizeof(header), bars, header, bar_type, bar_size, index)) {
+            logger->error("Failed to compress chunks for {}", path);
+            return false;
+        }
+        if (!file) {
+            logger->error("Failed to write data to file: {}", temp_path);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(temp_path, path, error);
+    if (error) {
+        logger->error("Failed to replace {} with {}, error: {}", path, temp_path, error.message());
+        fs::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+bool ChunkedFile::append(const std::string& path, const BarSeriesView& bars, quanttrader::log::LoggerPtr logger) {
+    if (bars.empty()) {
+        return true;
+    }
+
+    std::vector<ChunkInfo> index;
+    auto layout = copy_layout(path, index, logger);
+    if (!layout.has_value()) {
+        return false;
+    }
+    const auto& trailer = layout->trailer;
+
+    if (!index.empty() && bars.start_time.front() <= index.back().last_time) {
+        logger->error("Cannot append bars starting at {} to {}, it already ends at {}",
+                      bars.start_time.front(), path, index.back().last_time);
+        return false;
+    }
+
+    // The new chunks overwrite the old index and trailer, the file only grows so nothing is left behind
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file) {
+        logger->error("Failed to open file for appending: {}", path);
+        return false;
+    }
+    file.seekp(static_cast<std::streamoff>(trailer.index_offset));
+    if (!write_chunks(file, trailer.index_offset, bars, layout->header, static_cast<BarType>(trailer.bar_type), trailer.bar_size, index)) {
+        logger->error("Failed to compress chunks for {}", path);
+        return false;
+    }
+    file.flush();
+    if (!file) {
+        logger->error("Failed to append data to file: {}", path);
+        return false;
+    }
+    return true;
+}
+
+bool ChunkedFile::compact(const std::string& path, quanttrader::log::LoggerPtr logger) {
+    std::vector<ChunkInfo> index;
+    auto layout = copy_layout(path, index, logger);
+    if (!layout.has_value()) {
+        return false;
+    }
+    const auto& trailer = layout->trailer;
+
+    // Appends only fragment the end of the file, rewrite from the first fragmented month on
+    size_t first_fragment = 1;
+    while (first_fragment < index.size() && !mergeable(index[first_fragment - 1], index[first_fragment])) {
+        ++first_fragment;
+    }
+    if (first_fragment >= index.size()) {
+        return true;
+    }
+    size_t rewrite_from = first_fragment - 1;
+
+    auto bars = read(path, index[rewrite_from].first_time, std::nullopt, logger);
+    if (!bars.has_value()) {
+        return false;
+    }
+
+    uint64_t offset = index[rewrite_from].offset;
+    index.resize(rewrite_from);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file) {
+            logger->error("Failed to open file for compaction: {}", path);
+            return false;
+        }
+        file.seekp(static_cast<std::streamoff>(offset));
+        if (!write_chunks(file, offset, BarSeriesView(bars.value()), layout->header,
+                          static_cast<BarType>(trailer.bar_type), trailer.bar_size, index)) {
+            logger->error("Failed to compress chunks for {}", path);
+            return false;
+        }
+        file.flush();
+        if (!file) {
+            logger->error("Failed to write compacted chunks to file: {}", path);
+            return false;
+        }
+        offset = static_cast<uint64_t>(file.tellp());
+    }
+
+    // Merged chunks compress better, drop what is left of the old tail so the trailer is at the end
+    std::error_code error;
+    fs::resize_file(path, offset, error);
+    if (error) {
+        logger->error("Failed to truncate {} after compaction, error: {}", path, error.message());
+        return false;
+    }
+    return true;
+}
+
+size_t ChunkedFile::fragment_count(const std::vector<ChunkInfo>& index) {
+    size_t fragments = 0;
+    for (size_t c = 1; c < index.size(); ++c) {
+        if (mergeable(index[c - 1], index[c])) {
+            ++fragments;
+        }
+    }
+    return fragments;
+}
+
+std::optional<std::vector<ChunkInfo>> ChunkedFile::read_index(const std::string& path, quanttrader::log::LoggerPtr logger) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        logger->error("Failed to map file: {}", path);
+        return std::nullopt;
+    }
+    auto layout = map_layout(*file, path, logger);
+    if (!layout.has_value()) {
+        return std::nullopt;
+    }
+    return std::vector<ChunkInfo>(layout->chunks.begin(), layout->chunks.end());
+}
+
+std::optional<BarSeries> ChunkedFile::read(const std::string& path,
+                                           std::optional<uint64_t> start_time,
+                                           std::optional<uint64_t> end_time,
+                                           quanttrader::log::LoggerPtr logger,
+                                           unsigned int max_threads,
+                                           DecodePath decode_path) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        logger->error("Failed to map file: {}", path);
+        return std::nullopt;
+    }
+    auto layout = map_layout(*file, path, logger);
+    if (!layout.has_value()) {
+        return std::nullopt;
+    }
+    auto index = layout->chunks;
+
+    // Chunks are in time order, keep the ones overlapping the range
+    auto first_chunk = start_time.has_value()
+        ? std::partition_point(index.begin(), index.end(), [&](const ChunkInfo& c) { return c.last_time < start_time.value(); })
+        : index.begin();
+    auto last_chunk = end_time.has_value()
+        ? std::partition_point(first_chunk, index.end(), [&](const ChunkInfo& c) { return c.first_time <= end_time.value(); })
+        : index.end();
+    std::span<const ChunkInfo> chunks(first_chunk, last_chunk);
+    if (chunks.empty()) {
+        return BarSeries();
+    }
+
+    std::vector<std::vector<char>> raw(chunks.size());
+    std::atomic<size_t> next_chunk {0};
+    std::atomic<bool> failed {false};
+    auto decompress_worker = [&]() {
+        size_t c;
+        while ((c = next_chunk.fetch_add(1)) < chunks.size()) {
+            if (!read_chunk(file->data(), chunks[c], layout->header, raw[c], decode_path)) {
+                failed.store(true);
+            }
+        }
+    };
+
+    unsigned int threads = max_threads ? max_threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned int>(std::min<size_t>(threads, chunks.size()));
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; ++i) {
+        workers.emplace_back(decompress_worker);
+    }
+    decompress_worker();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (failed.load()) {
+        logger->error("Failed to decompress chunks of file {}", path);
+        return std::nullopt;
+    }
+
+    // Only the edge chunks are cut to the range
+    std::vector<std::pair<size_t, size_t>> ranges(chunks.size());
+    size_t total = 0;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const auto* times = reinterpret_cast<const uint64_t*>(raw[c].data());
+        size_t count = chunks[c].bar_count;
+        size_t lo = start_time.has_value() ? static_cast<size_t>(std::lower_bound(times, times + count, start_time.value()) - times) : 0;
+        size_t hi = end_time.has_value() ? static_cast<size_t>(std::upper_bound(times, times + count, end_time.value()) - times) : count;
+        ranges[c] = {lo, std::max(lo, hi)};
+        total += ranges[c].second - ranges[c].first;
+    }
+
+    BarSeries result;
+    result.start_time.resize(total);
+    result.open.resize(total);
+    result.high.resize(total);
+    result.low.resize(total);
+    result.close.resize(total);
+    result.wap.resize(total);
+    result.volume.resize(total);
+    result.count.resize(total);
+
+    size_t to = 0;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        auto [lo, hi] = ranges[c];
+        size_t count = chunks[c].bar_count;
+        const char* data = raw[c].data();
+        size_t column_offset = 0;
+        unpack_column(result.start_time, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[0];
+        unpack_column(result.open, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[1];
+        unpack_column(result.high, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[2];
+        unpack_column(result.low, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[3];
+        unpack_column(result.close, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[4];
+        unpack_column(result.wap, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[5];
+        unpack_column(result.volume, to, data, column_offset, lo, hi - lo);
+        column_offset += count * kColumnSizes[6];
+        unpack_column(result.count, to, data, column_offset, lo, hi - lo);
+        to += hi - lo;
+    }
+    return result;
+}
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "column_codec.h"
+#include "data/common/data_struct.h"
+#include "logger/quantlogger.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+constexpr char kChunkedMagic[8] = {'Q', 'T', 'C', 'H', 'U', 'N', 'K', 'S'};
+constexpr uint32_t kChunkedVersion = 2;     // 2 added column codecs
+constexpr uint32_t kChunkedMinVersion = 1;
+constexpr size_t kChunkedHeaderSize = 64;
+constexpr uint32_t kChunkMaxBars = 1 << 20;  // second bars would make month chunks too large
+constexpr uint32_t kChunkColumnCount = 8;
+
+/**
+ * @brief How the columns of a chunk are stored
+ */
+enum class ChunkEncoding : uint32_t {
+    Zlib = 0,          // the raw columns compressed together with zlib
+    ColumnCodecs = 1,  // every column encoded with the codec the file header names for it
+};
+
+/**
+ * @brief Header at the start of a chunked file
+ *
+ * Version 1 files have no column codecs, column_count is 0 and all their chunks are zlib.
+ */
+struct ChunkedFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;                         // kChunkColumnCount if column_codecs is set
+    uint8_t column_codecs[kChunkColumnCount];      // ColumnCodec of start_time, open, high, low, close, wap, volume, count
+    uint8_t reserved[40];
+};
+static_assert(sizeof(ChunkedFileHeader) == kChunkedHeaderSize, "The chunked file header must stay 64 bytes");
+
+/**
+ * @brief Index entry of one chunk in a chunked file
+ */
+struct ChunkInfo {
+    uint64_t first_time;   // start time of the first bar
+    uint64_t last_time;    // start time of the last bar
+    uint64_t offset;       // file offset of the compressed chunk
+    uint64_t stored_size;  // compressed size in bytes
+    uint64_t raw_size;     // size of the columns after decompression
+    uint32_t bar_count;
+    uint32_t codec;        // ChunkEncoding
+    uint64_t reserved[2];
+};
+static_assert(sizeof(ChunkInfo) == 64, "The chunk index entry must stay 64 bytes");
+
+/**
+ * @brief Trailer at the very end of a chunked file, points to the chunk index
+ */
+struct ChunkedFileTrailer {
+    char magic[8];
+    uint32_t version;
+    uint32_t bar_type;
+    uint32_t bar_size;
+    uint32_t chunk_count;
+    uint64_t index_offset;
+};
+static_assert(sizeof(ChunkedFileTrailer) == 32, "The chunked file trailer must stay 32 bytes");
+
+/**
+ * @brief Compressed bar file split into time chunks (".qtz")
+ *
+ * Layout: [header][chunk 0]...[chunk n-1][chunk index][trailer]. Bars are cut into
+ * one chunk per UTC calendar month (at most kChunkMaxBars each), every chunk holds its
+ * own columns and is compressed on its own. A range load reads the index from the end
+ * of the file and decompresses only the chunks overlapping the range, in parallel.
+ *
+ * A ColumnCodecs chunk starts with the encoded size of each of its 8 columns, followed
+ * by the columns encoded with the codecs of the file header.
+ */
+class ChunkedFile {
+public:
+    /**
+     * @brief Write sorted bars to a chunked file, replacing the file atomically
+     *
+     * @param encoding Zlib or the default column codecs, later appends keep the encoding of the file
+     * @return true if the file was written
+     */
+    static bool write(const std::string& path, const BarSeriesView& bars, BarType bar_type, unsigned int bar_size,
+                      quanttrader::log::LoggerPtr logger, ChunkEncoding encoding = ChunkEncoding::ColumnCodecs);
+
+    /**
+     * @brief Append sorted bars that all start after the last bar of the file
+     *
+     * The new chunks are written in place of the old index, followed by the new index and
+     * trailer, so existing chunks are not touched. The file is not replaced atomically, a
+     * crash during the append leaves it without a valid trailer.
+     *
+     * @return true if the bars were appended
+     */
+    static bool append(const std::string& path, const BarSeriesView& bars, quanttrader::log::LoggerPtr logger);
+
+    /**
+     * @brief Merge appended chunks so that every month is one chunk again
+     *
+     * Only the chunks from the first fragmented month on are rewritten, in place like append().
+     *
+     * @return true if the file was compacted or had nothing to compact
+     */
+    static bool compact(const std::string& path, quanttrader::log::LoggerPtr logger);
+
+    /**
+     * @brief Number of chunks that could be merged into the chunk before them
+     *
+     * Appends cut a month into several small chunks, a rewrite with write() merges them again.
+     */
+    static size_t fragment_count(const std::vector<ChunkInfo>& index);
+
+    /**
+     * @brief Read the bars in [start_time, end_time], both optional
+     *
+     * @param max_threads Upper bound for the decompression threads, 0 for the hardware concurrency
+     * @param decode_path Unpacking code for column codec chunks
+     * @return The bars, or nullopt if the file cannot be read
+     */
+    static std::optional<BarSeries> read(const std::string& path,
+                                         std::optional<uint64_t> start_time,
+                                         std::optional<uint64_t> end_time,
+                                         quanttrader::log::LoggerPtr logger,
+                                         unsigned int max_threads = 0,
+                                         DecodePath decode_path = DecodePath::Auto);
+
+    /**
+     * @brief Read only the chunk index
+     *
+     * @return The chunks in time order, or nullopt if the file is not a valid chunked file
+     */
+    static std::optional<std::vector<ChunkInfo>> read_index(const std::string& path, quanttrader::log::LoggerPtr logger);
+
+    /**
+     * @brief Start of the UTC calendar month after the one containing time
+     *
+     * @param time Time in nanoseconds since the epoch
+     * @return Time in nanoseconds since the epoch
+     */
+    static uint64_t next_month_start(uint64_t time);
+};
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,398 @@
+#include "column_codec.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QUANTTRADER_CODEC_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define QUANTTRADER_TARGET_AVX2
+#else
+#define QUANTTRADER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+namespace {
+
+constexpr size_t kBlockHeaderSize = 2;  // bit width, shift
+constexpr size_t kStreamPadding = sizeof(uint64_t);  // lets the unpacking read one word past the last block
+constexpr uint8_t kMaxScale = 9;         // ScaledDelta handles up to 9 decimals
+constexpr uint8_t kUnscaled = 0xFF;      // ScaledDelta column stored with Xor
+constexpr std::array<double, kMaxScale + 1> kPowersOfTen = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+constexpr double kMaxScaled = 2251799813685248.0;  // 2^51, lets the AVX2 path convert integers with a magic number
+
+// Whether value / 10^scale gives back the double exactly, the integer is returned in scaled
+bool scales_exactly(uint64_t bits, uint8_t scale, int64_t& scaled) {
+    double value = std::bit_cast<double>(bits);
+    double integer = std::round(value * kPowersOfTen[scale]);
+    if (!(std::abs(integer) < kMaxScaled)) {
+        return false;
+    }
+    scaled = static_cast<int64_t>(integer);
+    return std::bit_cast<uint64_t>(static_cast<double>(scaled) / kPowersOfTen[scale]) == bits;
+}
+
+// Smallest number of decimals all values have, kUnscaled if some value has more or is not finite.
+// Each value is only checked up to its own scale, the caller has to check all values at the result.
+uint8_t find_scale(std::span<const uint64_t> words) {
+    uint8_t scale = 0;
+    int64_t scaled;
+    for (uint64_t word : words) {
+        while (!scales_exactly(word, scale, scaled)) {
+            if (++scale > kMaxScale) {
+                return kUnscaled;
+            }
+        }
+    }
+    return scale;
+}
+
+uint64_t zigzag_encode(uint64_t value) {
+    return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+}
+
+uint64_t zigzag_decode(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+size_t packed_words(size_t count, unsigned width) {
+    return (count * width + 63) / 64;
+}
+
+void append_bytes(std::vector<char>& out, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void pack_block(const uint64_t* values, size_t count, std::vector<char>& out) {
+    uint64_t all_bits = 0;
+    for (size_t j = 0; j < count; ++j) {
+        all_bits |= values[j];
+    }
+    unsigned shift = all_bits == 0 ? 0 : static_cast<unsigned>(std::countr_zero(all_bits));
+    unsigned width = static_cast<unsigned>(std::bit_width(all_bits >> shift));
+
+    std::array<uint64_t, kCodecBlockValues> packed {};
+    for (size_t j = 0; j < count && width > 0; ++j) {
+        uint64_t value = values[j] >> shift;
+        size_t position = j * width;
+        size_t word = position / 64;
+        unsigned bit = static_cast<unsigned>(position % 64);
+        packed[word] |= value << bit;
+        if (bit + width > 64) {
+            packed[word + 1] |= value >> (64 - bit);
+        }
+    }
+
+    out.push_back(static_cast<char>(width));
+    out.push_back(static_cast<char>(shift));
+    append_bytes(out, packed.data(), packed_words(count, width) * sizeof(uint64_t));
+}
+
+uint64_t load_word(const char* data, size_t word) {
+    uint64_t value;
+    std::memcpy(&value, data + word * sizeof(uint64_t), sizeof(value));
+    return value;
+}
+
+void unpack_scalar(const char* data, unsigned width, unsigned shift, size_t first, size_t count, uint64_t* out, bool zigzag) {
+    if (width == 0) {
+        std::fill(out + first, out + count, 0);
+        return;
+    }
+    const uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    for (size_t j = first; j < count; ++j) {
+        size_t position = j * width;
+        size_t word = position / 64;
+        unsigned bit = static_cast<unsigned>(position % 64);
+        uint64_t value = load_word(data, word) >> bit;
+        if (bit + width > 64) {
+            value |= load_word(data, word + 1) << (64 - bit);
+        }
+        value = (value & mask) << shift;
+        out[j] = zigzag ? zigzag_decode(value) : value;
+    }
+}
+
+#ifdef QUANTTRADER_CODEC_X86
+// Four values per step: gather the two words each value can span, shift them together and mask
+QUANTTRADER_TARGET_AVX2
+void unpack_avx2(const char* data, unsigned width, unsigned shift, size_t count, uint64_t* out, bool zigzag) {
+    if (width == 0) {
+        std::fill(out, out + count, 0);
+        return;
+    }
+    const __m256i mask = _mm256_set1_epi64x(width == 64 ? -1LL : static_cast<long long>((1ULL << width) - 1));
+    const __m256i widths = _mm256_set1_epi64x(width);
+    const __m256i shifts = _mm256_set1_epi64x(shift);
+    const __m256i low_bits = _mm256_set1_epi64x(63);
+    const __m256i word_bits = _mm256_set1_epi64x(64);
+    const __m256i ones = _mm256_set1_epi64x(1);
+    const __m256i step = _mm256_set1_epi64x(4);
+    const auto* base = reinterpret_cast<const long long*>(data);
+    const auto* next = reinterpret_cast<const long long*>(data + sizeof(uint64_t));
+
+    __m256i index = _mm256_setr_epi64x(0, 1, 2, 3);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m256i position = _mm256_mul_epu32(index, widths);
+        __m256i offset = _mm256_slli_epi64(_mm256_srli_epi64(position, 6), 3);
+        __m256i bit = _mm256_and_si256(position, low_bits);
+        __m256i low = _mm256_srlv_epi64(_mm256_i64gather_epi64(base, offset, 1), bit);
+        // a shift by 64 yields 0, values that do not span two words take nothing from the next one
+        __m256i high = _mm256_sllv_epi64(_mm256_i64gather_epi64(next, offset, 1), _mm256_sub_epi64(word_bits, bit));
+        __m256i value = _mm256_sllv_epi64(_mm256_and_si256(_mm256_or_si256(low, high), mask), shifts);
+        if (zigzag) {
+            __m256i sign = _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(value, ones));
+            value = _mm256_xor_si256(_mm256_srli_epi64(value, 1), sign);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), value);
+        index = _mm256_add_epi64(index, step);
+    }
+    unpack_scalar(data, width, shift, j, count, out, zigzag);
+}
+
+// Integers below 2^51 become doubles by adding them to the bits of 1.5 * 2^52 and subtracting it
+QUANTTRADER_TARGET_AVX2
+void unscale_avx2(uint64_t* words, size_t count, double divisor) {
+    const __m256i magic_bits = _mm256_set1_epi64x(0x4338000000000000LL);
+    const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+    const __m256d divisors = _mm256_set1_pd(divisor);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m256i integers = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + j));
+        __m256d values = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(integers, magic_bits)), magic);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(words + j), _mm256_castpd_si256(_mm256_div_pd(values, divisors)));
+    }
+    for (; j < count; ++j) {
+        words[j] = std::bit_cast<uint64_t>(static_cast<double>(static_cast<int64_t>(words[j])) / divisor);
+    }
+}
+
+bool detect_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (!os_saves_avx) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+}  // namespace
+
+bool ColumnCoder::simd_supported() {
+#ifdef QUANTTRADER_CODEC_X86
+    static const bool supported = detect_avx2();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+std::string ColumnCoder::to_string(ColumnCodec codec) {
+    switch (codec) {
+        case ColumnCodec::Raw:
+            return "raw";
+        case ColumnCodec::DeltaOfDelta:
+            return "delta_of_delta";
+        case ColumnCodec::Xor:
+            return "xor";
+        case ColumnCodec::ZigzagDelta:
+            return "zigzag_delta";
+        case ColumnCodec::Zigzag:
+            return "zigzag";
+        case ColumnCodec::ScaledDelta:
+            return "scaled_delta";
+        default:
+            return "unknown";
+    }
+}
+
+void ColumnCoder::encode(ColumnCodec codec, std::span<const uint64_t> words, std::vector<char>& out) {
+    if (codec == ColumnCodec::Raw) {
+        append_bytes(out, words.data(), words.size_bytes());
+        return;
+    }
+    if (codec == ColumnCodec::ScaledDelta) {
+        uint8_t scale = find_scale(words);
+        std::vector<uint64_t> scaled;
+        if (scale != kUnscaled) {
+            // The scale only grows while searching, a large value checked at a smaller scale may not fit it
+            scaled.resize(words.size());
+            int64_t integer = 0;
+            for (size_t i = 0; i < words.size(); ++i) {
+                if (!scales_exactly(words[i], scale, integer)) {
+                    scale = kUnscaled;
+                    break;
+                }
+                scaled[i] = static_cast<uint64_t>(integer);
+            }
+        }
+        out.push_back(static_cast<char>(scale));
+        if (scale == kUnscaled) {
+            encode(ColumnCodec::Xor, words, out);
+            return;
+        }
+        encode(ColumnCodec::ZigzagDelta, scaled, out);
+        return;
+    }
+
+    size_t first = 0;
+    uint64_t previous = 0;
+    uint64_t previous_delta = 0;
+    if (codec != ColumnCodec::Zigzag && !words.empty()) {
+        append_bytes(out, &words[0], sizeof(uint64_t));
+        previous = words[0];
+        first = 1;
+    }
+
+    std::array<uint64_t, kCodecBlockValues> block;
+    for (size_t i = first; i < words.size(); i += kCodecBlockValues) {
+        size_t count = std::min(kCodecBlockValues, words.size() - i);
+        for (size_t j = 0; j < count; ++j) {
+            uint64_t word = words[i + j];
+            switch (codec) {
+                case ColumnCodec::DeltaOfDelta: {
+                    uint64_t delta = word - previous;
+                    block[j] = zigzag_encode(delta - previous_delta);
+                    previous_delta = delta;
+                    break;
+                }
+                case ColumnCodec::Xor:
+                    block[j] = word ^ previous;
+                    break;
+                case ColumnCodec::ZigzagDelta:
+                    block[j] = zigzag_encode(word - previous);
+                    break;
+                default:
+                    block[j] = zigzag_encode(word);
+                    break;
+            }
+            previous = word;
+        }
+        pack_block(block.data(), count, out);
+    }
+    out.insert(out.end(), kStreamPadding, 0);
+}
+
+bool ColumnCoder::decode(ColumnCodec codec, const char* data, size_t size, std::span<uint64_t> words, DecodePath path) {
+    if (!is_valid(static_cast<uint8_t>(codec))) {
+        return false;
+    }
+    if (codec == ColumnCodec::Raw) {
+        if (size < words.size_bytes()) {
+            return false;
+        }
+        std::memcpy(words.data(), data, words.size_bytes());
+        return true;
+    }
+    if (codec == ColumnCodec::ScaledDelta) {
+        if (size < 1) {
+            return false;
+        }
+        uint8_t scale = static_cast<uint8_t>(data[0]);
+        if (scale == kUnscaled) {
+            return decode(ColumnCodec::Xor, data + 1, size - 1, words, path);
+        }
+        if (scale > kMaxScale || !decode(ColumnCodec::ZigzagDelta, data + 1, size - 1, words, path)) {
+            return false;
+        }
+#ifdef QUANTTRADER_CODEC_X86
+        if (path != DecodePath::Scalar && simd_supported()) {
+            unscale_avx2(words.data(), words.size(), kPowersOfTen[scale]);
+            return true;
+        }
+#endif
+        for (uint64_t& word : words) {
+            word = std::bit_cast<uint64_t>(static_cast<double>(static_cast<int64_t>(word)) / kPowersOfTen[scale]);
+        }
+        return true;
+    }
+
+    size_t position = 0;
+    size_t first = 0;
+    if (codec != ColumnCodec::Zigzag && !words.empty()) {
+        if (size < sizeof(uint64_t)) {
+            return false;
+        }
+        std::memcpy(&words[0], data, sizeof(uint64_t));
+        position = sizeof(uint64_t);
+        first = 1;
+    }
+
+    bool zigzag = codec != ColumnCodec::Xor;
+    bool simd = path != DecodePath::Scalar && simd_supported();
+    for (size_t i = first; i < words.size(); i += kCodecBlockValues) {
+        size_t count = std::min(kCodecBlockValues, words.size() - i);
+        if (position + kBlockHeaderSize > size) {
+            return false;
+        }
+        unsigned width = static_cast<unsigned char>(data[position]);
+        unsigned shift = static_cast<unsigned char>(data[position + 1]);
+        position += kBlockHeaderSize;
+        size_t block_size = packed_words(count, width) * sizeof(uint64_t);
+        if (width > 64 || width + shift > 64 || position + block_size + kStreamPadding > size) {
+            return false;
+        }
+
+#ifdef QUANTTRADER_CODEC_X86
+        if (simd) {
+            unpack_avx2(data + position, width, shift, count, words.data() + i, zigzag);
+        } else {
+            unpack_scalar(data + position, width, shift, 0, count, words.data() + i, zigzag);
+        }
+#else
+        (void)simd;
+        unpack_scalar(data + position, width, shift, 0, count, words.data() + i, zigzag);
+#endif
+        position += block_size;
+    }
+
+    // The unpacked values are steps, undo them in one sequential pass
+    switch (codec) {
+        case ColumnCodec::DeltaOfDelta: {
+            uint64_t delta = 0;
+            for (size_t i = 1; i < words.size(); ++i) {
+                delta += words[i];
+                words[i] = words[i - 1] + delta;
+            }
+            break;
+        }
+        case ColumnCodec::Xor:
+            for (size_t i = 1; i < words.size(); ++i) {
+                words[i] ^= words[i - 1];
+            }
+            break;
+        case ColumnCodec::ZigzagDelta:
+            for (size_t i = 1; i < words.size(); ++i) {
+                words[i] += words[i - 1];
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+/**
+ * @brief Encoding of one column of 64 bit words, stored per column in the chunked file header
+ *
+ * DeltaOfDelta, Xor and ZigzagDelta keep the first word as it is and turn the others into
+ * small integers, which are bit packed in blocks of kCodecBlockValues values. Every block
+ * has its own bit width and a shift for the trailing zero bits all its values share, like
+ * Gorilla drops the trailing zeros of an XOR. Blocks keep the decoding branch free, the
+ * unpacking runs 4 values per AVX2 instruction.
+ */
+enum class ColumnCodec : uint8_t {
+    Raw = 0,           // words as they are
+    DeltaOfDelta = 1,  // start times: zigzag of the change of the step, 0 for regular bars
+    Xor = 2,           // doubles: XOR with the previous bit pattern
+    ZigzagDelta = 3,   // decimals: zigzag of the difference of the BID64 words
+    Zigzag = 4,        // small signed integers such as trade counts
+    ScaledDelta = 5,   // doubles with few decimals such as prices: ZigzagDelta of the scaled integers, else Xor
+};
+
+constexpr size_t kCodecBlockValues = 64;
+
+/**
+ * @brief Which unpacking code decodes the blocks
+ */
+enum class DecodePath {
+    Auto,    // SIMD if the CPU supports it
+    Scalar,
+    Simd,    // falls back to scalar without AVX2
+};
+
+/**
+ * @brief Encoder and decoder of column codecs
+ */
+class ColumnCoder {
+public:
+    /**
+     * @brief Append the encoded words to out
+     *
+     * @param codec The codec to use
+     * @param words Column values; doubles as bit patterns, integers sign extended
+     * @param out Buffer the encoded column is appended to
+     */
+    static void encode(ColumnCodec codec, std::span<const uint64_t> words, std::vector<char>& out);
+
+    /**
+     * @brief Decode a column written by encode
+     *
+     * @param codec The codec the column was written with
+     * @param data Encoded column
+     * @param size Size of the encoded column in bytes
+     * @param words Receives the values, its size is the number of encoded values
+     * @param path Unpacking code to use
+     * @return false if the data is truncated or malformed
+     */
+    static bool decode(ColumnCodec codec, const char* data, size_t size, std::span<uint64_t> words,
+                       DecodePath path = DecodePath::Auto);
+
+    /**
+     * @brief Whether DecodePath::Simd runs SIMD code on this CPU
+     */
+    static bool simd_supported();
+
+    static bool is_valid(uint8_t codec) { return codec <= static_cast<uint8_t>(ColumnCodec::ScaledDelta); }
+
+    static std::string to_string(ColumnCodec codec);
+};
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,284 @@
+#include "columnar_file.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+namespace {
+
+constexpr std::array<size_t, kColumnarColumnCount> kColumnSizes = {
+    sizeof(uint64_t), sizeof(double), sizeof(double), sizeof(double),
+    sizeof(double), sizeof(Decimal), sizeof(Decimal), sizeof(int)};
+
+size_t align_up(size_t value) {
+    return (value + kColumnarAlignment - 1) / kColumnarAlignment * kColumnarAlignment;
+}
+
+size_t index_entries(uint64_t bar_count, uint32_t stride) {
+    return static_cast<size_t>((bar_count + stride - 1) / stride);
+}
+
+// Computes the section offsets for a capacity, returns the file size
+size_t layout(ColumnarFileHeader& header) {
+    size_t offset = align_up(sizeof(ColumnarFileHeader));
+    for (size_t c = 0; c < kColumnarColumnCount; ++c) {
+        header.column_offsets[c] = offset;
+        offset = align_up(offset + header.capacity * kColumnSizes[c]);
+    }
+    header.index_offset = offset;
+    return offset + index_entries(header.capacity, header.index_stride) * sizeof(uint64_t);
+}
+
+class PaddedWriter {
+public:
+    explicit PaddedWriter(std::ofstream& file) : file_(file) {}
+
+    void write(const void* data, size_t size) {
+        file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position_ += size;
+    }
+
+    void pad_to(size_t target) {
+        static const std::array<char, 4096> zeros {};
+        while (position_ < target) {
+            size_t chunk = std::min(zeros.size(), target - position_);
+            write(zeros.data(), chunk);
+        }
+    }
+
+private:
+    std::ofstream& file_;
+    size_t position_ = 0;
+};
+
+template <typename T>
+void write_column(PaddedWriter& writer, std::span<const T> column, uint64_t offset) {
+    writer.pad_to(offset);
+    writer.write(column.data(), column.size_bytes());
+}
+
+template <typename T>
+std::span<const T> column_at(const char* base, uint64_t offset, uint64_t count) {
+    return std::span<const T>(reinterpret_cast<const T*>(base + offset), count);
+}
+
+}  // namespace
+
+bool ColumnarFile::write(const std::string& path, const BarSeriesView& bars, BarType bar_type, unsigned int bar_size,
+                         size_t capacity, quanttrader::log::LoggerPtr logger) {
+    ColumnarFileHeader header {};
+    std::memcpy(header.magic, kColumnarMagic, sizeof(header.magic));
+    header.version = kColumnarVersion;
+    header.header_size = sizeof(ColumnarFileHeader);
+    header.bar_count = bars.size();
+    header.capacity = std::max(capacity, bars.size());
+    header.first_time = bars.empty() ? 0 : bars.start_time.front();
+    header.last_time = bars.empty() ? 0 : bars.start_time.back();
+    header.bar_type = static_cast<uint32_t>(bar_type);
+    header.bar_size = bar_size;
+    header.index_stride = kColumnarIndexStride;
+    size_t file_size = layout(header);
+
+    // Write next to the target and rename, readers that mapped the old file keep their pages
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            logger->error("Failed to open file for writing: {}", temp_path);
+            return false;
+        }
+
+        PaddedWriter writer(file);
+        writer.write(&header, sizeof(header));
+        write_column(writer, bars.start_time, header.column_offsets[0]);
+        write_column(writer, bars.open, header.column_offsets[1]);
+        write_column(writer, bars.high, header.column_offsets[2]);
+        write_column(writer, bars.low, header.column_offsets[3]);
+        write_column(writer, bars.close, header.column_offsets[4]);
+        write_column(writer, bars.wap, header.column_offsets[5]);
+        write_column(writer, bars.volume, header.column_offsets[6]);
+        write_column(writer, bars.count, header.column_offsets[7]);
+
+        writer.pad_to(header.index_offset);
+        for (size_t i = 0; i < bars.size(); i += header.index_stride) {
+            writer.write(&bars.start_time[i], sizeof(uint64_t));
+        }
+        writer.pad_to(file_size);
+
+        if (!file) {
+            logger->error("Failed to write data to file: {}", temp_path);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(temp_path, path, error);
+    if (error) {
+        logger->error("Failed to replace {} with {}, error: {}", path, temp_path, error.message());
+        fs::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+bool ColumnarFile::append(const std::string& path, const BarSeriesView& bars, quanttrader::log::LoggerPtr logger) {
+    if (bars.empty()) {
+        return true;
+    }
+
+    ColumnarFileHeader header;
+    {
+        auto existing = open(path, logger);
+        if (!existing) {
+            return false;
+        }
+        header = existing->header();
+    }
+
+    if (header.bar_count + bars.size() > header.capacity) {
+        logger->error("Column file {} has room for {} more bars, cannot append {}",
+                      path, header.capacity - header.bar_count, bars.size());
+        return false;
+    }
+    if (header.bar_count > 0 && bars.start_time.front() <= header.last_time) {
+        logger->error("Cannot append bars starting at {} to {}, it already ends at {}",
+                      bars.start_time.front(), path, header.last_time);
+        return false;
+    }
+
+    auto target = MappedFile::open(path, true);
+    if (!target) {
+        logger->error("Failed to map file for appending: {}", path);
+        return false;
+    }
+
+    char* base = target->writable_data();
+    auto append_column = [&](size_t column, const auto& values) {
+        std::memcpy(base + header.column_offsets[column] + header.bar_count * kColumnSizes[column], values.data(),
+                    values.size_bytes());
+    };
+    append_column(0, bars.start_time);
+    append_column(1, bars.open);
+    append_column(2, bars.high);
+    append_column(3, bars.low);
+    append_column(4, bars.close);
+    append_column(5, bars.wap);
+    append_column(6, bars.volume);
+    append_column(7, bars.count);
+
+    uint64_t new_count = header.bar_count + bars.size();
+    uint64_t first_entry = index_entries(header.bar_count, header.index_stride);
+    for (uint64_t entry = first_entry; entry * header.index_stride < new_count; ++entry) {
+        std::memcpy(base + header.index_offset + entry * sizeof(uint64_t),
+                    &bars.start_time[entry * header.index_stride - header.bar_count], sizeof(uint64_t));
+    }
+
+    // Readers take the times from the bars, these fields only describe the file
+    auto* mapped_header = reinterpret_cast<ColumnarFileHeader*>(base);
+    if (header.bar_count == 0) {
+        mapped_header->first_time = bars.start_time.front();
+    }
+    mapped_header->last_time = bars.start_time.back();
+
+    // The count goes last, readers only see the new bars once their slots are written
+    std::atomic_ref<uint64_t>(mapped_header->bar_count).store(new_count, std::memory_order_release);
+    return true;
+}
+
+std::shared_ptr<ColumnarFile> ColumnarFile::open(const std::string& path, quanttrader::log::LoggerPtr logger) {
+    auto mapped = MappedFile::open(path);
+    if (!mapped) {
+        logger->error("Failed to map file: {}", path);
+        return nullptr;
+    }
+
+    if (mapped->size() < sizeof(ColumnarFileHeader)) {
+        logger->error("File {} is too small to be a column file", path);
+        return nullptr;
+    }
+
+    // An append may publish a new count meanwhile, the bars below it are complete
+    auto* header = reinterpret_cast<const ColumnarFileHeader*>(mapped->data());
+    uint64_t count = std::atomic_ref<uint64_t>(const_cast<uint64_t&>(header->bar_count)).load(std::memory_order_acquire);
+    if (std::memcmp(header->magic, kColumnarMagic, sizeof(header->magic)) != 0 ||
+        header->version != kColumnarVersion || header->header_size != sizeof(ColumnarFileHeader)) {
+        logger->error("File {} is not a version {} column file", path, kColumnarVersion);
+        return nullptr;
+    }
+
+    if (count > header->capacity || header->index_stride == 0) {
+        logger->error("Column file {} has an invalid header", path);
+        return nullptr;
+    }
+
+    for (size_t c = 0; c < kColumnarColumnCount; ++c) {
+        uint64_t offset = header->column_offsets[c];
+        if (offset % kColumnarAlignment != 0 || offset + header->capacity * kColumnSizes[c] > mapped->size()) {
+            logger->error("Column {} of file {} is out of bounds", c, path);
+            return nullptr;
+        }
+    }
+    size_t entries = index_entries(count, header->index_stride);
+    if (header->index_offset + entries * sizeof(uint64_t) > mapped->size()) {
+        logger->error("Time index of file {} is out of bounds", path);
+        return nullptr;
+    }
+
+    std::shared_ptr<ColumnarFile> file(new ColumnarFile());
+    const char* base = mapped->data();
+    file->bars_.start_time = column_at<uint64_t>(base, header->column_offsets[0], count);
+    file->bars_.open = column_at<double>(base, header->column_offsets[1], count);
+    file->bars_.high = column_at<double>(base, header->column_offsets[2], count);
+    file->bars_.low = column_at<double>(base, header->column_offsets[3], count);
+    file->bars_.close = column_at<double>(base, header->column_offsets[4], count);
+    file->bars_.wap = column_at<Decimal>(base, header->column_offsets[5], count);
+    file->bars_.volume = column_at<Decimal>(base, header->column_offsets[6], count);
+    file->bars_.count = column_at<int>(base, header->column_offsets[7], count);
+    file->index_ = column_at<uint64_t>(base, header->index_offset, entries);
+    file->header_ = *header;
+    file->header_.bar_count = count;
+    file->header_.first_time = count == 0 ? 0 : file->bars_.start_time.front();
+    file->header_.last_time = count == 0 ? 0 : file->bars_.start_time.back();
+    file->file_ = std::move(mapped);
+    return file;
+}
+
+size_t ColumnarFile::lower_bound(uint64_t time) const {
+    if (index_.empty()) {
+        return 0;
+    }
+
+    // The last block whose first bar is not after time holds the answer, or it is the next block start
+    auto block = std::upper_bound(index_.begin(), index_.end(), time);
+    size_t block_index = block == index_.begin() ? 0 : static_cast<size_t>(block - index_.begin()) - 1;
+    size_t first = block_index * header_.index_stride;
+    size_t last = std::min(first + header_.index_stride, bars_.size());
+
+    auto begin = bars_.start_time.begin();
+    return static_cast<size_t>(std::lower_bound(begin + first, begin + last, time) - begin);
+}
+
+BarSeriesView ColumnarFile::range(std::optional<uint64_t> start_time, std::optional<uint64_t> end_time) const {
+    size_t first = start_time.has_value() ? lower_bound(start_time.value()) : 0;
+    size_t last = bars_.size();
+    if (end_time.has_value()) {
+        // upper bound of end_time is the lower bound of the next nanosecond
+        last = end_time.value() == UINT64_MAX ? bars_.size() : lower_bound(end_time.value() + 1);
+    }
+    if (first >= last) {
+        return BarSeriesView();
+    }
+    return bars_.subview(first, last - first);
+}
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "data/common/data_struct.h"
+#include "logger/quantlogger.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+constexpr char kColumnarMagic[8] = {'Q', 'T', 'C', 'O', 'L', 'U', 'M', 'N'};
+constexpr uint32_t kColumnarVersion = 2;
+constexpr size_t kColumnarAlignment = 64;       // every section starts on a cache line
+constexpr uint32_t kColumnarIndexStride = 4096; // one time index entry per 4096 bars
+constexpr size_t kColumnarColumnCount = 8;
+
+/**
+ * @brief Header of a FileStorage v2 column file (".qtc")
+ *
+ * Layout: [header][start_time][open][high][low][close][wap][volume][count][time index].
+ * Each column holds `capacity` slots, `bar_count` of them used, and starts on a 64 byte
+ * boundary so a mapped column can be handed to ta-lib or SIMD code as it is. The time
+ * index keeps every kColumnarIndexStride-th start time so range lookups touch few pages.
+ * Values are stored in host byte order. bar_count is the only field readers trust, an
+ * append publishes it with one aligned store after everything else is written.
+ */
+struct ColumnarFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t bar_count;
+    uint64_t capacity;
+    uint64_t first_time;
+    uint64_t last_time;
+    uint32_t bar_type;
+    uint32_t bar_size;
+    uint32_t index_stride;
+    uint32_t reserved0;
+    uint64_t index_offset;
+    uint64_t column_offsets[kColumnarColumnCount];  // same order as the layout above
+    uint8_t reserved[120];
+};
+static_assert(sizeof(ColumnarFileHeader) == 256, "The column file header must stay 256 bytes");
+
+/**
+ * @brief A memory mapped column file, its bars are served without copying
+ */
+class ColumnarFile {
+public:
+    /**
+     * @brief Write bars to a column file, replacing the file atomically
+     *
+     * @param path Destination path
+     * @param bars Sorted bars to write
+     * @param bar_type The type of bar
+     * @param bar_size The size of the bar
+     * @param capacity Slots per column, at least the number of bars, to leave room for appends
+     * @param logger Logger for errors
+     * @return true if the file was written
+     */
+    static bool write(const std::string& path, const BarSeriesView& bars, BarType bar_type, unsigned int bar_size,
+                      size_t capacity, quanttrader::log::LoggerPtr logger);
+
+    /**
+     * @brief Write sorted bars into the free slots of a column file
+     *
+     * The bars must start after the last stored bar and fit into the capacity. Slots and
+     * time index entries are written first, then the new bar count is published with a
+     * single release store. Existing mappings keep seeing the bars they mapped. Callers
+     * serialize appends to a file.
+     *
+     * @return true if the bars were appended
+     */
+    static bool append(const std::string& path, const BarSeriesView& bars, quanttrader::log::LoggerPtr logger);
+
+    /**
+     * @brief Map and validate a column file
+     *
+     * @return The file, or nullptr if it cannot be mapped or is not a valid column file
+     */
+    static std::shared_ptr<ColumnarFile> open(const std::string& path, quanttrader::log::LoggerPtr logger);
+
+    /**
+     * @brief The header as it was when the file was opened, first_time and last_time come from the bars
+     */
+    const ColumnarFileHeader& header() const { return header_; }
+    BarSeriesView bars() const { return bars_; }
+
+    /**
+     * @brief Get the bars in [start_time, end_time], both optional
+     */
+    BarSeriesView range(std::optional<uint64_t> start_time, std::optional<uint64_t> end_time) const;
+
+    /**
+     * @brief Index of the first bar with a start time not less than time, found through the time index
+     */
+    size_t lower_bound(uint64_t time) const;
+
+private:
+    ColumnarFile() = default;
+
+    std::shared_ptr<MappedFile> file_;
+    ColumnarFileHeader header_ {};
+    BarSeriesView bars_;
+    std::span<const uint64_t> index_;
+};
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
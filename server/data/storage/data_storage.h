@@ -1,15 +1,20 @@
 #pragma once
 
 #include "data/common/data_struct.h"
+#include <algorithm>
+#include <any>
 #include <string>
 #include <memory>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 namespace quanttrader {
 namespace data {
 namespace storage {
 
+using StorageParams = std::unordered_map<std::string, std::any>;
+
 /**
  * @brief Abstract base class for data storage
  * 
@@ -29,6 +34,14 @@ public:
      */
     virtual bool initialize(const std::string& storage_path) = 0;
 
+    /**
+     * @brief Apply backend specific options from a data provider config, before initialize
+     * 
+     * @param params The data provider config, unknown keys are ignored
+     * @return true if the options are valid, false otherwise
+     */
+    virtual bool configure(const StorageParams& params) { return true; }
+
     /**
      * @brief Store a series of bar data
      * 
@@ -43,6 +56,40 @@ public:
                            unsigned int bar_size,
                            const BarSeries& bars) = 0;
 
+    /**
+     * @brief Add bars after the stored ones without rewriting the history when the backend allows it
+     * 
+     * Bars at or before the last stored bar are skipped, the stored rows win. Use store_bars
+     * to correct history. Without stored data this behaves like store_bars. The default
+     * implementation loads, extends and stores the whole series.
+     * 
+     * @param symbol The symbol/ticker for the data
+     * @param bar_type The type of bar (second, minute, etc.)
+     * @param bar_size The size of the bar
+     * @param bars Bars sorted by time
+     * @return true if the new bars were stored (or there were none), false otherwise
+     */
+    virtual bool append_bars(const std::string& symbol,
+                             BarType bar_type,
+                             unsigned int bar_size,
+                             const BarSeries& bars) {
+        if (bars.start_time.empty()) {
+            return true;
+        }
+
+        auto existing = has_data(symbol, bar_type, bar_size) ? load_bars(symbol, bar_type, bar_size) : std::nullopt;
+        if (!existing.has_value() || existing->start_time.empty()) {
+            return store_bars(symbol, bar_type, bar_size, bars);
+        }
+
+        size_t first_new = new_bars_offset(bars, existing->start_time.back());
+        if (first_new == bars.size()) {
+            return true;
+        }
+        existing->append(bars, first_new);
+        return store_bars(symbol, bar_type, bar_size, existing.value());
+    }
+
     /**
      * @brief Load a series of bar data
      * 
@@ -59,6 +106,31 @@ public:
                                               std::optional<uint64_t> start_time = std::nullopt,
                                               std::optional<uint64_t> end_time = std::nullopt) = 0;
 
+    /**
+     * @brief Load a series of bar data that may be shared without copying
+     * 
+     * Backends that can serve bars in place (e.g. memory mapped files) override this,
+     * the default loads a private copy through load_bars.
+     * 
+     * @param symbol The symbol/ticker for the data
+     * @param bar_type The type of bar (second, minute, etc.)
+     * @param bar_size The size of the bar
+     * @param start_time Optional start time to filter data
+     * @param end_time Optional end time to filter data
+     * @return The shared bars or nullopt if loading failed
+     */
+    virtual std::optional<SharedBarSeries> map_bars(const std::string& symbol,
+                                                   BarType bar_type,
+                                                   unsigned int bar_size,
+                                                   std::optional<uint64_t> start_time = std::nullopt,
+                                                   std::optional<uint64_t> end_time = std::nullopt) {
+        auto bars = load_bars(symbol, bar_type, bar_size, start_time, end_time);
+        if (!bars.has_value()) {
+            return std::nullopt;
+        }
+        return SharedBarSeries::own(std::move(bars.value()));
+    }
+
     /**
      * @brief Check if data exists for a symbol
      * 
@@ -77,6 +149,13 @@ public:
      * @return Vector of available symbols
      */
     virtual std::vector<std::string> get_available_symbols() = 0;
+
+protected:
+    // Index of the first bar after last_time in sorted bars
+    static size_t new_bars_offset(const BarSeries& bars, uint64_t last_time) {
+        return static_cast<size_t>(std::upper_bound(bars.start_time.begin(), bars.start_time.end(), last_time) -
+                                   bars.start_time.begin());
+    }
 };
 
 } // namespace storage
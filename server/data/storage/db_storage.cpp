@@ -1,5 +1,7 @@
 #include "db_storage.h"
+#include <algorithm>
 #include <filesystem>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -14,12 +16,66 @@ DbStorage::DbStorage() {
 }
 
 DbStorage::~DbStorage() {
+    // Statements must be finalized before the connection closes
+    tables_.clear();
+    upsert_symbol_.reset();
+    select_symbol_.reset();
     if (db_handle_) {
         sqlite3_close(db_handle_);
         db_handle_ = nullptr;
     }
 }
 
+bool DbStorage::configure(const StorageParams& params) {
+    auto get_string = [&params, this](const std::string& key, std::string& value) {
+        auto iter = params.find(key);
+        if (iter == params.end()) {
+            return true;
+        }
+        try {
+            value = std::any_cast<std::string>(iter->second);
+        } catch (const std::bad_any_cast&) {
+            logger_->error("{} must be a string", key);
+            return false;
+        }
+        return true;
+    };
+
+    std::string decimal_format;
+    if (!get_string("db_journal_mode", journal_mode_) || !get_string("db_synchronous", synchronous_) ||
+        !get_string("db_decimal_format", decimal_format)) {
+        return false;
+    }
+
+    // Pragma values cannot be bound, only plain words are accepted
+    for (const auto& value : {journal_mode_, synchronous_}) {
+        if (value.empty() || !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isalpha(c); })) {
+            logger_->error("Invalid database pragma value: {}", value);
+            return false;
+        }
+    }
+
+    if (decimal_format == "binary") {
+        decimal_format_ = DecimalFormat::Binary;
+    } else if (decimal_format == "text") {
+        decimal_format_ = DecimalFormat::Text;
+    } else if (!decimal_format.empty()) {
+        logger_->error("Unknown db_decimal_format: {}, expected binary or text", decimal_format);
+        return false;
+    }
+
+    auto iter = params.find("db_cache_size_mb");
+    if (iter != params.end()) {
+        try {
+            cache_size_mb_ = std::any_cast<int>(iter->second);
+        } catch (const std::bad_any_cast&) {
+            logger_->error("db_cache_size_mb must be an integer");
+            return false;
+        }
+    }
+    return true;
+}
+
 bool DbStorage::initialize(const std::string& storage_path) {
     // Create directory if it doesn't exist
     fs::path dir_path(storage_path);
@@ -44,7 +100,7 @@ bool DbStorage::initialize(const std::string& storage_path) {
     }
     
     // Create necessary tables if they don't exist
-    if (!create_tables_if_needed()) {
+    if (!apply_pragmas() || !create_tables_if_needed()) {
         sqlite3_close(db_handle_);
         db_handle_ = nullptr;
         return false;
@@ -54,14 +110,30 @@ bool DbStorage::initialize(const std::string& storage_path) {
     return true;
 }
 
+bool DbStorage::apply_pragmas() {
+    // A negative cache size is in KiB
+    return execute_query("PRAGMA journal_mode = " + journal_mode_ + ";") &&
+           execute_query("PRAGMA synchronous = " + synchronous_ + ";") &&
+           execute_query("PRAGMA cache_size = " + std::to_string(-static_cast<int64_t>(cache_size_mb_) * 1024) + ";") &&
+           execute_query("PRAGMA temp_store = MEMORY;");
+}
+
 bool DbStorage::create_tables_if_needed() {
     // Create symbols table
     if (!execute_query(create_symbols_table_)) {
         logger_->error("Failed to create symbols table");
         return false;
     }
-    
-    return true;
+
+    upsert_symbol_ = prepare(
+        "INSERT INTO " + symbols_table_ + " (symbol, bar_type, bar_size, first_time, last_time, count) "
+        "VALUES (?1, ?2, ?3, ?4, ?5, ?6) ON CONFLICT(symbol, bar_type, bar_size) DO UPDATE SET "
+        "first_time = MIN(first_time, excluded.first_time), "
+        "last_time = MAX(last_time, excluded.last_time), "
+        "count = count + excluded.count;");
+    select_symbol_ = prepare("SELECT first_time, last_time, count FROM " + symbols_table_ +
+                             " WHERE symbol = ?1 AND bar_type = ?2 AND bar_size = ?3;");
+    return upsert_symbol_ && select_symbol_;
 }
 
 bool DbStorage::execute_query(const std::string& query) {
@@ -123,241 +195,343 @@ bool DbStorage::store_bars(const std::string& symbol,
         logger_->warn("Attempting to store empty bar series for symbol: {}", symbol);
         return false;
     }
-    
+    return write_bars(symbol, bar_type, bar_size, bars, false);
+}
+
+bool DbStorage::append_bars(const std::string& symbol,
+                           BarType bar_type,
+                           unsigned int bar_size,
+                           const BarSeries& bars) {
+    if (bars.start_time.empty()) {
+        return true;
+    }
+    return write_bars(symbol, bar_type, bar_size, bars, true);
+}
+
+DbStorage::Statement DbStorage::prepare(const std::string& query) {
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v3(db_handle_, query.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+    if (result != SQLITE_OK) {
+        logger_->error("Failed to prepare statement: {}, Query: {}", sqlite3_errmsg(db_handle_), query);
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    return Statement(stmt);
+}
+
+DbStorage::TableStatements* DbStorage::get_table(const std::string& table_name, bool create) {
+    auto iter = tables_.find(table_name);
+    if (iter != tables_.end()) {
+        return &iter->second;
+    }
+
+    if (create) {
+        const char* decimal_type = decimal_format_ == DecimalFormat::Binary ? "INTEGER" : "TEXT";
+        std::stringstream create_table_ss;
+        create_table_ss << "CREATE TABLE IF NOT EXISTS " << table_name << " ("
+                        << "time INTEGER PRIMARY KEY, "
+                        << "open REAL, "
+                        << "high REAL, "
+                        << "low REAL, "
+                        << "close REAL, "
+                        << "volume " << decimal_type << ", "
+                        << "wap " << decimal_type << ", "
+                        << "count INTEGER"
+                        << ");";
+        if (!execute_query(create_table_ss.str())) {
+            return nullptr;
+        }
+    }
+
+    // The declared type of volume tells how the decimals of a table are stored, no row means no table
+    Statement type_stmt = prepare("SELECT type FROM pragma_table_info(?1) WHERE name = 'volume';");
+    if (!type_stmt) {
+        return nullptr;
+    }
+    sqlite3_bind_text(type_stmt.get(), 1, table_name.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(type_stmt.get()) != SQLITE_ROW) {
+        return nullptr;
+    }
+    const char* declared_type = reinterpret_cast<const char*>(sqlite3_column_text(type_stmt.get(), 0));
+
+    TableStatements table;
+    table.decimal_format = declared_type && std::string(declared_type) == "INTEGER" ? DecimalFormat::Binary : DecimalFormat::Text;
+
+    auto insert_query = [&table_name](const char* verb, size_t rows) {
+        std::string query = std::string(verb) + " INTO " + table_name + " (time, open, high, low, close, volume, wap, count) VALUES ";
+        for (size_t row = 0; row < rows; ++row) {
+            query += row == 0 ? "(?, ?, ?, ?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        return query + ";";
+    };
+    table.replace_row = prepare(insert_query("INSERT OR REPLACE", 1));
+    table.replace_batch = prepare(insert_query("INSERT OR REPLACE", kInsertBatchRows));
+    table.ignore_row = prepare(insert_query("INSERT OR IGNORE", 1));
+    table.ignore_batch = prepare(insert_query("INSERT OR IGNORE", kInsertBatchRows));
+    table.load_range = prepare("SELECT time, open, high, low, close, volume, wap, count FROM " + table_name +
+                               " WHERE time >= ?1 AND time <= ?2 ORDER BY time;");
+    table.count_range = prepare("SELECT COUNT(*) FROM " + table_name + " WHERE time >= ?1 AND time <= ?2;");
+    table.last_time = prepare("SELECT MAX(time) FROM " + table_name + ";");
+    if (!table.replace_row || !table.replace_batch || !table.ignore_row || !table.ignore_batch || !table.load_range ||
+        !table.count_range || !table.last_time) {
+        return nullptr;
+    }
+    return &tables_.emplace(table_name, std::move(table)).first->second;
+}
+
+bool DbStorage::write_bars(const std::string& symbol,
+                          BarType bar_type,
+                          unsigned int bar_size,
+                          const BarSeries& bars,
+                          bool append_only) {
+    if (!bars.is_aligned()) {
+        logger_->error("Cannot store bars for symbol: {}, the columns have different sizes", symbol);
+        return false;
+    }
+
     std::string table_name = get_table_name(symbol, bar_type, bar_size);
     std::string bar_type_str = get_bar_type_string(bar_type, bar_size);
-    
+
     // Start a transaction for better performance
     if (!execute_query("BEGIN TRANSACTION;")) {
         return false;
     }
-    
-    // Create table for this data series if it doesn't exist
-    std::stringstream create_table_ss;
-    create_table_ss << "CREATE TABLE IF NOT EXISTS " << table_name << " ("
-                    << "time INTEGER PRIMARY KEY, "
-                    << "open REAL, "
-                    << "high REAL, "
-                    << "low REAL, "
-                    << "close REAL, "
-                    << "volume TEXT, "
-                    << "wap TEXT, "
-                    << "count INTEGER"
-                    << ");";
-    
-    if (!execute_query(create_table_ss.str())) {
+
+    // A rolled back CREATE TABLE must not leave its statements cached
+    bool cached = tables_.contains(table_name);
+    auto rollback = [this, &table_name, cached]() {
         execute_query("ROLLBACK;");
+        if (!cached) {
+            tables_.erase(table_name);
+        }
         return false;
+    };
+
+    // Create table for this data series if it doesn't exist
+    TableStatements* table = get_table(table_name, true);
+    if (!table) {
+        return rollback();
+    }
+
+    // Appends skip the bars that are already stored, the latest time is a lookup on the primary key
+    size_t first = 0;
+    if (append_only) {
+        sqlite3_stmt* stmt = table->last_time.get();
+        int result = sqlite3_step(stmt);
+        if (result == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+            first = new_bars_offset(bars, static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)));
+        }
+        sqlite3_reset(stmt);
+        if (result != SQLITE_ROW) {
+            logger_->error("Failed to read the last time of {}: {}", table_name, sqlite3_errmsg(db_handle_));
+            return rollback();
+        }
     }
-    
-    // Add or update entry in symbols table
-    uint64_t first_time = bars.start_time[0];
-    uint64_t last_time = bars.start_time.back();
     size_t count = bars.start_time.size();
-    
-    std::stringstream upsert_ss;
-    upsert_ss << "INSERT INTO " << symbols_table_ 
-              << " (symbol, bar_type, bar_size, first_time, last_time, count) VALUES ("
-              << "'" << symbol << "', "
-              << "'" << bar_type_str << "', "
-              << bar_size << ", "
-              << first_time << ", "
-              << last_time << ", "
-              << count
-              << ") ON CONFLICT(symbol, bar_type, bar_size) DO UPDATE SET "
-              << "first_time = MIN(first_time, excluded.first_time), "
-              << "last_time = MAX(last_time, excluded.last_time), "
-              << "count = count + excluded.count;";
-    
-    if (!execute_query(upsert_ss.str())) {
-        execute_query("ROLLBACK;");
-        return false;
+    if (first == count) {
+        execute_query("COMMIT;");
+        return true;
     }
-    
-    // Prepare statement for inserting data
-    sqlite3_stmt* stmt = nullptr;
-    std::stringstream insert_ss;
-    insert_ss << "INSERT OR REPLACE INTO " << table_name 
-              << " (time, open, high, low, close, volume, wap, count) "
-              << "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
-    
-    int result = sqlite3_prepare_v2(db_handle_, insert_ss.str().c_str(), -1, &stmt, nullptr);
-    if (result != SQLITE_OK) {
-        logger_->error("Failed to prepare statement: {}", sqlite3_errmsg(db_handle_));
-        execute_query("ROLLBACK;");
-        return false;
+
+    // Rows of the written range are counted before and after, so replaced rows are not counted twice
+    auto [min_time, max_time] = std::minmax_element(bars.start_time.begin() + first, bars.start_time.end());
+    auto rows_before = count_rows(*table, *min_time, *max_time);
+    if (!rows_before.has_value() || !insert_rows(*table, bars, first, append_only)) {
+        return rollback();
     }
-    
-    // Insert data rows
-    for (size_t i = 0; i < count; ++i) {
-        sqlite3_bind_int64(stmt, 1, bars.start_time[i]);
-        sqlite3_bind_double(stmt, 2, bars.open[i]);
-        sqlite3_bind_double(stmt, 3, bars.high[i]);
-        sqlite3_bind_double(stmt, 4, bars.low[i]);
-        sqlite3_bind_double(stmt, 5, bars.close[i]);
-        
-        // Convert Decimal to string using DecimalFunctions
-        std::string volume_str = DecimalFunctions::decimalToString(bars.volume[i]);
-        std::string wap_str = DecimalFunctions::decimalToString(bars.wap[i]);
-        
-        sqlite3_bind_text(stmt, 6, volume_str.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 7, wap_str.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int(stmt, 8, bars.count[i]);
-        
-        result = sqlite3_step(stmt);
-        if (result != SQLITE_DONE) {
-            logger_->error("Failed to insert row: {}", sqlite3_errmsg(db_handle_));
-            sqlite3_finalize(stmt);
-            execute_query("ROLLBACK;");
-            return false;
-        }
-        
-        sqlite3_reset(stmt);
+    auto rows_after = count_rows(*table, *min_time, *max_time);
+    if (!rows_after.has_value()) {
+        return rollback();
     }
-    
-    sqlite3_finalize(stmt);
-    
+
+    // Add or update entry in symbols table
+    sqlite3_stmt* upsert = upsert_symbol_.get();
+    sqlite3_bind_text(upsert, 1, symbol.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(upsert, 2, bar_type_str.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(upsert, 3, static_cast<int>(bar_size));
+    sqlite3_bind_int64(upsert, 4, static_cast<sqlite3_int64>(*min_time));
+    sqlite3_bind_int64(upsert, 5, static_cast<sqlite3_int64>(*max_time));
+    sqlite3_bind_int64(upsert, 6, static_cast<sqlite3_int64>(rows_after.value() - rows_before.value()));
+    int result = sqlite3_step(upsert);
+    sqlite3_reset(upsert);
+    if (result != SQLITE_DONE) {
+        logger_->error("Failed to update symbol {}: {}", symbol, sqlite3_errmsg(db_handle_));
+        return rollback();
+    }
+
     // Commit the transaction
     if (!execute_query("COMMIT;")) {
-        execute_query("ROLLBACK;");
-        return false;
+        return rollback();
+    }
+
+    logger_->info("Successfully {} {} bars for symbol: {} bar_type: {} bar_size: {}",
+                 append_only ? "appended" : "stored", count - first, symbol, bar_type_str, bar_size);
+    return true;
+}
+
+bool DbStorage::insert_rows(TableStatements& table, const BarSeries& bars, size_t first, bool append_only) {
+    // An append never overwrites a stored row
+    sqlite3_stmt* batch = append_only ? table.ignore_batch.get() : table.replace_batch.get();
+    sqlite3_stmt* single = append_only ? table.ignore_row.get() : table.replace_row.get();
+    size_t count = bars.start_time.size();
+
+    size_t row = first;
+    while (row < count) {
+        size_t rows = count - row >= kInsertBatchRows ? kInsertBatchRows : 1;
+        sqlite3_stmt* stmt = rows == kInsertBatchRows ? batch : single;
+        for (size_t i = 0; i < rows; ++i) {
+            bind_row(stmt, static_cast<int>(i * 8 + 1), bars, row + i, table.decimal_format);
+        }
+
+        int result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (result != SQLITE_DONE) {
+            logger_->error("Failed to insert data: {}", sqlite3_errmsg(db_handle_));
+            return false;
+        }
+        row += rows;
     }
-    
-    logger_->info("Successfully stored {} bars for symbol: {} bar_type: {} bar_size: {}", 
-                 count, symbol, bar_type_str, bar_size);
     return true;
 }
 
+void DbStorage::bind_row(sqlite3_stmt* stmt, int first_param, const BarSeries& bars, size_t row, DecimalFormat format) const {
+    sqlite3_bind_int64(stmt, first_param, static_cast<sqlite3_int64>(bars.start_time[row]));
+    sqlite3_bind_double(stmt, first_param + 1, bars.open[row]);
+    sqlite3_bind_double(stmt, first_param + 2, bars.high[row]);
+    sqlite3_bind_double(stmt, first_param + 3, bars.low[row]);
+    sqlite3_bind_double(stmt, first_param + 4, bars.close[row]);
+    if (format == DecimalFormat::Binary) {
+        // The BID64 word as it is, no string conversion either way
+        sqlite3_bind_int64(stmt, first_param + 5, static_cast<sqlite3_int64>(bars.volume[row]));
+        sqlite3_bind_int64(stmt, first_param + 6, static_cast<sqlite3_int64>(bars.wap[row]));
+    } else {
+        // Convert Decimal to string using DecimalFunctions
+        std::string volume_str = DecimalFunctions::decimalToString(bars.volume[row]);
+        std::string wap_str = DecimalFunctions::decimalToString(bars.wap[row]);
+        sqlite3_bind_text(stmt, first_param + 5, volume_str.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, first_param + 6, wap_str.c_str(), -1, SQLITE_TRANSIENT);
+    }
+    sqlite3_bind_int(stmt, first_param + 7, bars.count[row]);
+}
+
+std::optional<uint64_t> DbStorage::count_rows(TableStatements& table, uint64_t start_time, uint64_t end_time) {
+    sqlite3_stmt* stmt = table.count_range.get();
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(start_time));
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(end_time));
+    std::optional<uint64_t> rows;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        rows = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+    } else {
+        logger_->error("Failed to count rows: {}", sqlite3_errmsg(db_handle_));
+    }
+    sqlite3_reset(stmt);
+    return rows;
+}
+
+std::optional<DbStorage::SymbolStats> DbStorage::get_symbol_stats(const std::string& symbol,
+                                                                  const std::string& bar_type_str,
+                                                                  unsigned int bar_size) {
+    sqlite3_stmt* stmt = select_symbol_.get();
+    sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, bar_type_str.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, static_cast<int>(bar_size));
+
+    std::optional<SymbolStats> stats;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        stats = SymbolStats{static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)),
+                            static_cast<uint64_t>(sqlite3_column_int64(stmt, 1)),
+                            static_cast<uint64_t>(std::max<sqlite3_int64>(0, sqlite3_column_int64(stmt, 2)))};
+    }
+    sqlite3_reset(stmt);
+    return stats;
+}
+
 std::optional<BarSeries> DbStorage::load_bars(const std::string& symbol,
                                              BarType bar_type,
                                              unsigned int bar_size,
                                              std::optional<uint64_t> start_time,
                                              std::optional<uint64_t> end_time) {
     std::string table_name = get_table_name(symbol, bar_type, bar_size);
-    
-    // Check if table exists by querying for its metadata
-    std::stringstream check_ss;
-    check_ss << "SELECT name FROM sqlite_master WHERE type='table' AND name='" << table_name << "';";
-    
-    sqlite3_stmt* check_stmt = nullptr;
-    int result = sqlite3_prepare_v2(db_handle_, check_ss.str().c_str(), -1, &check_stmt, nullptr);
-    if (result != SQLITE_OK) {
-        logger_->error("Failed to prepare statement: {}", sqlite3_errmsg(db_handle_));
-        return std::nullopt;
-    }
-    
-    result = sqlite3_step(check_stmt);
-    sqlite3_finalize(check_stmt);
-    
-    if (result != SQLITE_ROW) {
-        logger_->warn("No data found for symbol: {} bar_type: {} bar_size: {}", 
-                     symbol, get_bar_type_string(bar_type, bar_size), bar_size);
+    std::string bar_type_str = get_bar_type_string(bar_type, bar_size);
+
+    TableStatements* table = get_table(table_name, false);
+    if (!table) {
+        logger_->warn("No data found for symbol: {} bar_type: {} bar_size: {}",
+                     symbol, bar_type_str, bar_size);
         return std::nullopt;
     }
-    
-    // Build query to fetch data with optional time filters
-    std::stringstream query_ss;
-    query_ss << "SELECT time, open, high, low, close, volume, wap, count FROM " << table_name;
-    
-    if (start_time.has_value() || end_time.has_value()) {
-        query_ss << " WHERE ";
-        
-        if (start_time.has_value()) {
-            query_ss << "time >= " << start_time.value();
-            if (end_time.has_value()) {
-                query_ss << " AND ";
-            }
-        }
-        
-        if (end_time.has_value()) {
-            query_ss << "time <= " << end_time.value();
+
+    uint64_t first = start_time.value_or(0);
+    uint64_t last = std::min<uint64_t>(end_time.value_or(UINT64_MAX), std::numeric_limits<sqlite3_int64>::max());
+
+    // Reserve the share of the stored rows the range covers, the columns are filled without reallocating
+    BarSeries bars;
+    auto stats = get_symbol_stats(symbol, bar_type_str, bar_size);
+    if (stats.has_value() && stats->count > 0 && stats->last_time >= stats->first_time) {
+        uint64_t covered_first = std::max(first, stats->first_time);
+        uint64_t covered_last = std::min(last, stats->last_time);
+        if (covered_first <= covered_last) {
+            double span = static_cast<double>(stats->last_time - stats->first_time) + 1.0;
+            double share = (static_cast<double>(covered_last - covered_first) + 1.0) / span;
+            bars.reserve(std::min<size_t>(stats->count, static_cast<size_t>(static_cast<double>(stats->count) * share * 1.05) + 16));
         }
     }
-    
-    query_ss << " ORDER BY time;";
-    
-    // Prepare and execute the query
-    sqlite3_stmt* stmt = nullptr;
-    result = sqlite3_prepare_v2(db_handle_, query_ss.str().c_str(), -1, &stmt, nullptr);
-    if (result != SQLITE_OK) {
-        logger_->error("Failed to prepare statement: {}", sqlite3_errmsg(db_handle_));
-        return std::nullopt;
-    }
-    
-    // Create bar series and load data
-    BarSeries bars;
-    
+
+    sqlite3_stmt* stmt = table->load_range.get();
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(first));
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(last));
+
+    bool binary = table->decimal_format == DecimalFormat::Binary;
+    int result;
     while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
-        // Extract basic types
-        uint64_t time = sqlite3_column_int64(stmt, 0);
-        double open = sqlite3_column_double(stmt, 1);
-        double high = sqlite3_column_double(stmt, 2);
-        double low = sqlite3_column_double(stmt, 3);
-        double close = sqlite3_column_double(stmt, 4);
-        int count = sqlite3_column_int(stmt, 7);
-        
-        // Extract text fields and convert to Decimal using DecimalFunctions
-        const char* volume_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        const char* wap_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-        
-        // Convert strings to Decimal values
         Decimal volume = 0;
         Decimal wap = 0;
-        
-        if (volume_str) {
-            volume = DecimalFunctions::stringToDecimal(volume_str);
-        }
-        
-        if (wap_str) {
-            wap = DecimalFunctions::stringToDecimal(wap_str);
+        if (binary) {
+            volume = static_cast<Decimal>(sqlite3_column_int64(stmt, 5));
+            wap = static_cast<Decimal>(sqlite3_column_int64(stmt, 6));
+        } else {
+            // Extract text fields and convert to Decimal using DecimalFunctions
+            const char* volume_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+            const char* wap_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
+            if (volume_str) {
+                volume = DecimalFunctions::stringToDecimal(volume_str);
+            }
+            if (wap_str) {
+                wap = DecimalFunctions::stringToDecimal(wap_str);
+            }
         }
-        
-        // Add data to the bar series
-        bars.start_time.push_back(time);
-        bars.open.push_back(open);
-        bars.high.push_back(high);
-        bars.low.push_back(low);
-        bars.close.push_back(close);
-        bars.volume.push_back(volume);
-        bars.wap.push_back(wap);
-        bars.count.push_back(count);
+
+        bars.push_back(static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)),
+                       sqlite3_column_double(stmt, 1),
+                       sqlite3_column_double(stmt, 2),
+                       sqlite3_column_double(stmt, 3),
+                       sqlite3_column_double(stmt, 4),
+                       volume,
+                       wap,
+                       sqlite3_column_int(stmt, 7));
     }
-    
-    sqlite3_finalize(stmt);
-    
+    sqlite3_reset(stmt);
+
+    if (result != SQLITE_DONE) {
+        logger_->error("Failed to load bars for symbol: {}, error: {}", symbol, sqlite3_errmsg(db_handle_));
+        return std::nullopt;
+    }
+
     if (bars.start_time.empty()) {
         logger_->warn("No data found in the specified time range for symbol: {}", symbol);
         return std::nullopt;
     }
-    
-    logger_->info("Successfully loaded {} bars for symbol: {} bar_type: {} bar_size: {}", 
-                 bars.start_time.size(), symbol, get_bar_type_string(bar_type, bar_size), bar_size);
+
+    logger_->info("Successfully loaded {} bars for symbol: {} bar_type: {} bar_size: {}",
+                 bars.start_time.size(), symbol, bar_type_str, bar_size);
     return bars;
 }
 
-bool DbStorage::has_data(const std::string& symbol, 
-                        BarType bar_type, 
+bool DbStorage::has_data(const std::string& symbol,
+                        BarType bar_type,
                         unsigned int bar_size) {
-    std::string bar_type_str = get_bar_type_string(bar_type, bar_size);
-    
-    std::stringstream query_ss;
-    query_ss << "SELECT count FROM " << symbols_table_
-             << " WHERE symbol = '" << symbol << "'"
-             << " AND bar_type = '" << bar_type_str << "'"
-             << " AND bar_size = " << bar_size << ";";
-    
-    sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db_handle_, query_ss.str().c_str(), -1, &stmt, nullptr);
-    if (result != SQLITE_OK) {
-        logger_->error("Failed to prepare statement: {}", sqlite3_errmsg(db_handle_));
-        return false;
-    }
-    
-    result = sqlite3_step(stmt);
-    bool has_data = (result == SQLITE_ROW && sqlite3_column_int(stmt, 0) > 0);
-    
-    sqlite3_finalize(stmt);
-    return has_data;
+    auto stats = get_symbol_stats(symbol, get_bar_type_string(bar_type, bar_size), bar_size);
+    return stats.has_value() && stats->count > 0;
 }
 
 std::vector<std::string> DbStorage::get_available_symbols() {
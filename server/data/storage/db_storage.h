@@ -5,6 +5,7 @@
 #include <string>
 #include <memory>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 #include <sqlite3.h>
 
@@ -14,9 +15,16 @@ namespace storage {
 
 /**
  * @brief SQLite database storage implementation
- * 
+ *
  * This class implements the DataStorage interface using SQLite database
  * to store and retrieve market data.
+ *
+ * New tables keep volume and wap as the 64 bit BID64 words in INTEGER columns
+ * ("db_decimal_format" = "binary", the default); tables written with "text" keep
+ * the decimal strings and stay readable. Statements are prepared once per table,
+ * rows are inserted kInsertBatchRows per statement. The connection is tuned by
+ * "db_journal_mode" (default WAL), "db_synchronous" (default NORMAL) and
+ * "db_cache_size_mb" (default 64).
  */
 class DbStorage : public DataStorage {
 public:
@@ -24,37 +32,87 @@ public:
     ~DbStorage() override;
 
     bool initialize(const std::string& storage_path) override;
-    
-    bool store_bars(const std::string& symbol, 
+    bool configure(const StorageParams& params) override;
+
+    bool store_bars(const std::string& symbol,
                    BarType bar_type,
                    unsigned int bar_size,
                    const BarSeries& bars) override;
-    
+
+    bool append_bars(const std::string& symbol,
+                     BarType bar_type,
+                     unsigned int bar_size,
+                     const BarSeries& bars) override;
+
     std::optional<BarSeries> load_bars(const std::string& symbol,
                                       BarType bar_type,
                                       unsigned int bar_size,
                                       std::optional<uint64_t> start_time = std::nullopt,
                                       std::optional<uint64_t> end_time = std::nullopt) override;
-    
-    bool has_data(const std::string& symbol, 
+
+    bool has_data(const std::string& symbol,
                  BarType bar_type,
                  unsigned int bar_size) override;
 
     std::vector<std::string> get_available_symbols() override;
 
+    static constexpr size_t kInsertBatchRows = 100;  // 800 parameters, below the 999 of older SQLite builds
+
 private:
+    enum class DecimalFormat { Text, Binary };
+
+    struct StatementDeleter {
+        void operator()(sqlite3_stmt* stmt) const { sqlite3_finalize(stmt); }
+    };
+    using Statement = std::unique_ptr<sqlite3_stmt, StatementDeleter>;
+
+    // Statements of one data table, prepared on first use
+    struct TableStatements {
+        DecimalFormat decimal_format = DecimalFormat::Binary;
+        Statement replace_row;
+        Statement replace_batch;
+        Statement ignore_row;
+        Statement ignore_batch;
+        Statement load_range;
+        Statement count_range;
+        Statement last_time;
+    };
+
+    struct SymbolStats {
+        uint64_t first_time = 0;
+        uint64_t last_time = 0;
+        uint64_t count = 0;
+    };
+
     std::string get_bar_type_string(BarType bar_type, unsigned int bar_size) const;
     std::string get_table_name(const std::string& symbol, BarType bar_type, unsigned int bar_size) const;
     bool create_tables_if_needed();
+    bool apply_pragmas();
     bool execute_query(const std::string& query);
-    
+    Statement prepare(const std::string& query);
+    TableStatements* get_table(const std::string& table_name, bool create);
+    bool write_bars(const std::string& symbol, BarType bar_type, unsigned int bar_size, const BarSeries& bars, bool append_only);
+    bool insert_rows(TableStatements& table, const BarSeries& bars, size_t first, bool append_only);
+    void bind_row(sqlite3_stmt* stmt, int first_param, const BarSeries& bars, size_t row, DecimalFormat format) const;
+    std::optional<uint64_t> count_rows(TableStatements& table, uint64_t start_time, uint64_t end_time);
+    std::optional<SymbolStats> get_symbol_stats(const std::string& symbol, const std::string& bar_type_str, unsigned int bar_size);
+
     std::string db_path_;
     sqlite3* db_handle_ = nullptr;
     quanttrader::log::LoggerPtr logger_;
 
+    std::string journal_mode_ = "WAL";
+    std::string synchronous_ = "NORMAL";
+    int cache_size_mb_ = 64;
+    DecimalFormat decimal_format_ = DecimalFormat::Binary;  // for new tables
+
+    std::unordered_map<std::string, TableStatements> tables_;
+    Statement upsert_symbol_;
+    Statement select_symbol_;
+
     // Table schema
     const std::string symbols_table_ = "symbols";
-    const std::string create_symbols_table_ = 
+    const std::string create_symbols_table_ =
         "CREATE TABLE IF NOT EXISTS symbols ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
         "symbol TEXT NOT NULL, "
@@ -68,4 +126,4 @@ private:
 
 } // namespace storage
 } // namespace data
-} // namespace quanttrader
\ No newline at end of file
+} // namespace quanttrader
@@ -1,4 +1,6 @@
 #include "file_storage.h"
+#include "columnar_file.h"
+#include "chunked_file.h"
 #include <fstream>
 #include <filesystem>
 #include <vector>
@@ -15,7 +17,15 @@ FileStorage::FileStorage() {
 }
 
 FileStorage::~FileStorage() {
-    // No specific cleanup needed
+    {
+        std::lock_guard<std::mutex> lock(compaction_mutex_);
+        stopping_ = true;
+    }
+    compaction_cv_.notify_all();
+    // Pending compactions are dropped, a fragmented file is still a valid file
+    if (compaction_thread_.joinable()) {
+        compaction_thread_.join();
+    }
 }
 
 bool FileStorage::initialize(const std::string& storage_path) {
@@ -35,18 +45,54 @@ bool FileStorage::initialize(const std::string& storage_path) {
     return true;
 }
 
-bool FileStorage::store_bars(const std::string& symbol, 
-                            BarType bar_type, 
-                            unsigned int bar_size,
-                            const BarSeries& bars) {
-    if (bars.start_time.empty()) {
-        logger_->warn("Attempting to store empty bar series for symbol: {}", symbol);
+bool FileStorage::configure(const StorageParams& params) {
+    auto get_string = [&params, this](const std::string& key, std::string& value) {
+        auto iter = params.find(key);
+        if (iter == params.end()) {
+            return true;
+        }
+        try {
+            value = std::any_cast<std::string>(iter->second);
+        } catch (const std::bad_any_cast&) {
+            logger_->error("{} must be a string", key);
+            return false;
+        }
+        return true;
+    };
+
+    std::string format;
+    std::string codec;
+    if (!get_string("storage_format", format) || !get_string("storage_codec", codec)) {
         return false;
     }
-    
-    std::string file_path = get_data_file_path(symbol, bar_type, bar_size);
-    
-    // Ensure the directory exists
+
+    if (format.empty()) {
+        // keep the current format
+    } else if (format == "columnar") {
+        format_ = FileFormat::Columnar;
+    } else if (format == "chunked") {
+        format_ = FileFormat::Chunked;
+    } else if (format == "legacy") {
+        format_ = FileFormat::Legacy;
+    } else {
+        logger_->error("Unknown storage format: {}, expected columnar, chunked or legacy", format);
+        return false;
+    }
+
+    if (codec.empty()) {
+        // keep the current codec
+    } else if (codec == "columns") {
+        chunk_encoding_ = ChunkEncoding::ColumnCodecs;
+    } else if (codec == "zlib") {
+        chunk_encoding_ = ChunkEncoding::Zlib;
+    } else {
+        logger_->error("Unknown storage codec: {}, expected columns or zlib", codec);
+        return false;
+    }
+    return true;
+}
+
+bool FileStorage::ensure_parent_directory(const std::string& file_path) {
     fs::path dir_path = fs::path(file_path).parent_path();
     if (!fs::exists(dir_path)) {
         try {
@@ -56,6 +102,222 @@ bool FileStorage::store_bars(const std::string& symbol,
             return false;
         }
     }
+    return true;
+}
+
+bool FileStorage::store_bars(const std::string& symbol, 
+                            BarType bar_type, 
+                            unsigned int bar_size,
+                            const BarSeries& bars) {
+    if (bars.start_time.empty()) {
+        logger_->warn("Attempting to store empty bar series for symbol: {}", symbol);
+        return false;
+    }
+
+    if (format_ == FileFormat::Legacy) {
+        // Newer formats are read first, drop them so the legacy file is used
+        std::error_code error;
+        fs::remove(get_columnar_file_path(symbol, bar_type, bar_size), error);
+        fs::remove(get_chunked_file_path(symbol, bar_type, bar_size), error);
+        return store_legacy_bars(symbol, bar_type, bar_size, bars);
+    }
+
+    if (!write_file(symbol, bar_type, bar_size, BarSeriesView(bars), format_)) {
+        logger_->error("Failed to store bars for symbol: {}", symbol);
+        return false;
+    }
+
+    logger_->info("Successfully stored {} bars for symbol: {} bar_type: {} bar_size: {}", 
+                 bars.size(), symbol, get_bar_type_string(bar_type, bar_size), bar_size);
+    return true;
+}
+
+bool FileStorage::append_bars(const std::string& symbol,
+                              BarType bar_type,
+                              unsigned int bar_size,
+                              const BarSeries& bars) {
+    if (bars.start_time.empty()) {
+        return true;
+    }
+    if (!bars.is_aligned()) {
+        logger_->error("Cannot append bars for symbol: {}, the columns have different sizes", symbol);
+        return false;
+    }
+    if (std::adjacent_find(bars.start_time.begin(), bars.start_time.end(), std::greater_equal<uint64_t>()) != bars.start_time.end()) {
+        logger_->error("Cannot append bars for symbol: {}, they are not sorted by time", symbol);
+        return false;
+    }
+
+    std::string columnar_path = get_columnar_file_path(symbol, bar_type, bar_size);
+    if (fs::exists(columnar_path)) {
+        return append_columnar_bars(columnar_path, bar_type, bar_size, bars);
+    }
+    std::string chunked_path = get_chunked_file_path(symbol, bar_type, bar_size);
+    if (fs::exists(chunked_path)) {
+        return append_chunked_bars(chunked_path, bars);
+    }
+    if (fs::exists(get_data_file_path(symbol, bar_type, bar_size))) {
+        // A legacy blob cannot grow, it is rewritten (in the configured format)
+        return DataStorage::append_bars(symbol, bar_type, bar_size, bars);
+    }
+    return store_bars(symbol, bar_type, bar_size, bars);
+}
+
+bool FileStorage::append_columnar_bars(const std::string& file_path, BarType bar_type, unsigned int bar_size,
+                                       const BarSeries& bars) {
+    std::unique_lock<std::shared_mutex> lock(write_mutex_);
+    auto file = ColumnarFile::open(file_path, logger_);
+    if (!file) {
+        return false;
+    }
+
+    ColumnarFileHeader header = file->header();
+    size_t first_new = header.bar_count == 0 ? 0 : new_bars_offset(bars, header.last_time);
+    if (first_new == bars.size()) {
+        return true;
+    }
+    BarSeriesView new_bars = BarSeriesView(bars).subview(first_new, bars.size() - first_new);
+
+    if (header.bar_count + new_bars.size() <= header.capacity) {
+        file.reset();
+        if (!ColumnarFile::append(file_path, new_bars, logger_)) {
+            return false;
+        }
+    } else {
+        // Full, rewrite once with room for the next appends
+        BarSeries combined = file->bars().to_bar_series();
+        combined.append(bars, first_new);
+        file.reset();
+        size_t capacity = combined.size() + std::max(kMinAppendSlack, combined.size() / 4);
+        if (!ColumnarFile::write(file_path, BarSeriesView(combined), bar_type, bar_size, capacity, logger_)) {
+            return false;
+        }
+    }
+
+    logger_->info("Appended {} bars to {}", new_bars.size(), file_path);
+    return true;
+}
+
+bool FileStorage::append_chunked_bars(const std::string& file_path, const BarSeries& bars) {
+    size_t fragments = 0;
+    size_t appended = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(write_mutex_);
+        auto index = ChunkedFile::read_index(file_path, logger_);
+        if (!index.has_value()) {
+            return false;
+        }
+
+        size_t first_new = index->empty() ? 0 : new_bars_offset(bars, index->back().last_time);
+        if (first_new == bars.size()) {
+            return true;
+        }
+        appended = bars.size() - first_new;
+        if (!ChunkedFile::append(file_path, BarSeriesView(bars).subview(first_new, appended), logger_)) {
+            return false;
+        }
+
+        index = ChunkedFile::read_index(file_path, logger_);
+        fragments = index.has_value() ? ChunkedFile::fragment_count(index.value()) : 0;
+    }
+
+    logger_->info("Appended {} bars to {}", appended, file_path);
+    if (fragments >= kCompactionFragments) {
+        schedule_compaction(file_path);
+    }
+    return true;
+}
+
+bool FileStorage::compact(const std::string& symbol, BarType bar_type, unsigned int bar_size) {
+    std::string file_path = get_chunked_file_path(symbol, bar_type, bar_size);
+    if (!fs::exists(file_path)) {
+        return true;
+    }
+    return compact_chunked_file(file_path);
+}
+
+bool FileStorage::compact_chunked_file(const std::string& file_path) {
+    std::unique_lock<std::shared_mutex> lock(write_mutex_);
+    auto index = ChunkedFile::read_index(file_path, logger_);
+    if (!index.has_value()) {
+        return false;
+    }
+    if (ChunkedFile::fragment_count(index.value()) == 0) {
+        return true;
+    }
+
+    if (!ChunkedFile::compact(file_path, logger_)) {
+        return false;
+    }
+    logger_->info("Compacted {} chunks of {}", index->size(), file_path);
+    return true;
+}
+
+void FileStorage::schedule_compaction(const std::string& file_path) {
+    {
+        std::lock_guard<std::mutex> lock(compaction_mutex_);
+        if (stopping_ || std::find(compaction_queue_.begin(), compaction_queue_.end(), file_path) != compaction_queue_.end()) {
+            return;
+        }
+        compaction_queue_.push_back(file_path);
+        if (!compaction_thread_.joinable()) {
+            compaction_thread_ = std::thread(&FileStorage::run_compactions, this);
+        }
+    }
+    compaction_cv_.notify_one();
+}
+
+void FileStorage::run_compactions() {
+    while (true) {
+        std::string file_path;
+        {
+            std::unique_lock<std::mutex> lock(compaction_mutex_);
+            compaction_cv_.wait(lock, [this]() { return stopping_ || !compaction_queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            file_path = compaction_queue_.front();
+        }
+
+        if (!compact_chunked_file(file_path)) {
+            logger_->error("Background compaction of {} failed", file_path);
+        }
+
+        // Dequeue only now so that appends in the meantime do not queue the file again
+        std::lock_guard<std::mutex> lock(compaction_mutex_);
+        compaction_queue_.pop_front();
+    }
+}
+
+bool FileStorage::write_file(const std::string& symbol, BarType bar_type, unsigned int bar_size,
+                             const BarSeriesView& bars, FileFormat format) {
+    std::string file_path = format == FileFormat::Chunked ? get_chunked_file_path(symbol, bar_type, bar_size)
+                                                          : get_columnar_file_path(symbol, bar_type, bar_size);
+    if (!ensure_parent_directory(file_path)) {
+        return false;
+    }
+
+    // A store must not interleave with an append to the same file, whatever the format
+    std::unique_lock<std::shared_mutex> lock(write_mutex_);
+    bool written = format == FileFormat::Chunked ? ChunkedFile::write(file_path, bars, bar_type, bar_size, logger_, chunk_encoding_)
+                                                 : ColumnarFile::write(file_path, bars, bar_type, bar_size, bars.size(), logger_);
+    if (written) {
+        // A column file is read before a chunked file, do not let an old one shadow the new data
+        std::error_code error;
+        fs::remove(format == FileFormat::Chunked ? get_columnar_file_path(symbol, bar_type, bar_size)
+                                                 : get_chunked_file_path(symbol, bar_type, bar_size), error);
+    }
+    return written;
+}
+
+bool FileStorage::store_legacy_bars(const std::string& symbol, 
+                                   BarType bar_type, 
+                                   unsigned int bar_size,
+                                   const BarSeries& bars) {
+    std::string file_path = get_data_file_path(symbol, bar_type, bar_size);
+    if (!ensure_parent_directory(file_path)) {
+        return false;
+    }
     
     // Prepare data for serialization
     // Format: size_t count, followed by the data arrays
@@ -143,6 +405,68 @@ std::optional<BarSeries> FileStorage::load_bars(const std::string& symbol,
                                                unsigned int bar_size,
                                                std::optional<uint64_t> start_time,
                                                std::optional<uint64_t> end_time) {
+    if (!fs::exists(get_columnar_file_path(symbol, bar_type, bar_size))) {
+        std::string chunked_path = get_chunked_file_path(symbol, bar_type, bar_size);
+        if (!fs::exists(chunked_path)) {
+            return load_legacy_bars(symbol, bar_type, bar_size, start_time, end_time);
+        }
+
+        std::optional<BarSeries> bars;
+        {
+            std::shared_lock<std::shared_mutex> lock(write_mutex_);
+            bars = ChunkedFile::read(chunked_path, start_time, end_time, logger_);
+        }
+        if (!bars.has_value()) {
+            return std::nullopt;
+        }
+        if (bars->start_time.empty()) {
+            logger_->warn("No data in the specified time range for symbol: {}", symbol);
+            return std::nullopt;
+        }
+        logger_->info("Successfully loaded {} bars for symbol: {} bar_type: {} bar_size: {}", 
+                     bars->size(), symbol, get_bar_type_string(bar_type, bar_size), bar_size);
+        return bars;
+    }
+
+    auto shared = map_bars(symbol, bar_type, bar_size, start_time, end_time);
+    if (!shared.has_value()) {
+        return std::nullopt;
+    }
+    return shared->view.to_bar_series();
+}
+
+std::optional<SharedBarSeries> FileStorage::map_bars(const std::string& symbol,
+                                                    BarType bar_type,
+                                                    unsigned int bar_size,
+                                                    std::optional<uint64_t> start_time,
+                                                    std::optional<uint64_t> end_time) {
+    std::string file_path = get_columnar_file_path(symbol, bar_type, bar_size);
+    if (!fs::exists(file_path)) {
+        // Compressed data, a private copy is the best we can do
+        return DataStorage::map_bars(symbol, bar_type, bar_size, start_time, end_time);
+    }
+
+    auto file = ColumnarFile::open(file_path, logger_);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    BarSeriesView bars = file->range(start_time, end_time);
+    if (bars.empty()) {
+        logger_->warn("No data in the specified time range for symbol: {}", symbol);
+        return std::nullopt;
+    }
+
+    logger_->info("Mapped {} bars for symbol: {} bar_type: {} bar_size: {}", 
+                 bars.size(), symbol, get_bar_type_string(bar_type, bar_size), bar_size);
+    return SharedBarSeries{bars, file};
+}
+
+std::optional<BarSeries> FileStorage::load_legacy_bars(const std::string& symbol, 
+                                                      BarType bar_type, 
+                                                      unsigned int bar_size,
+                                                      std::optional<uint64_t> start_time,
+                                                      std::optional<uint64_t> end_time) {
     std::string file_path = get_data_file_path(symbol, bar_type, bar_size);
     
     if (!fs::exists(file_path)) {
@@ -282,8 +606,35 @@ std::optional<BarSeries> FileStorage::load_bars(const std::string& symbol,
 bool FileStorage::has_data(const std::string& symbol, 
                           BarType bar_type, 
                           unsigned int bar_size) {
-    std::string file_path = get_data_file_path(symbol, bar_type, bar_size);
-    return fs::exists(file_path);
+    return fs::exists(get_columnar_file_path(symbol, bar_type, bar_size)) ||
+           fs::exists(get_chunked_file_path(symbol, bar_type, bar_size)) ||
+           fs::exists(get_data_file_path(symbol, bar_type, bar_size));
+}
+
+bool FileStorage::convert_legacy_file(const std::string& symbol, BarType bar_type, unsigned int bar_size, bool remove_legacy) {
+    std::string legacy_path = get_data_file_path(symbol, bar_type, bar_size);
+    auto bars = load_legacy_bars(symbol, bar_type, bar_size, std::nullopt, std::nullopt);
+    if (!bars.has_value() || bars->start_time.empty()) {
+        logger_->error("Cannot convert {}, no legacy data could be loaded", legacy_path);
+        return false;
+    }
+
+    FileFormat format = format_ == FileFormat::Legacy ? FileFormat::Columnar : format_;
+    if (!write_file(symbol, bar_type, bar_size, BarSeriesView(bars.value()), format)) {
+        logger_->error("Failed to convert {}", legacy_path);
+        return false;
+    }
+
+    if (remove_legacy) {
+        std::error_code error;
+        fs::remove(legacy_path, error);
+        if (error) {
+            logger_->warn("Converted {} but cannot remove it, error: {}", legacy_path, error.message());
+        }
+    }
+
+    logger_->info("Converted {} bars from {}", bars->size(), legacy_path);
+    return true;
 }
 
 std::vector<std::string> FileStorage::get_available_symbols() {
@@ -332,6 +683,20 @@ std::string FileStorage::get_data_file_path(const std::string& symbol,
     return base_path_ + "/" + symbol + "/" + bar_type_str + ".dat";
 }
 
+std::string FileStorage::get_columnar_file_path(const std::string& symbol, 
+                                               BarType bar_type, 
+                                               unsigned int bar_size) const {
+    std::string bar_type_str = get_bar_type_string(bar_type, bar_size);
+    return base_path_ + "/" + symbol + "/" + bar_type_str + ".qtc";
+}
+
+std::string FileStorage::get_chunked_file_path(const std::string& symbol, 
+                                              BarType bar_type, 
+                                              unsigned int bar_size) const {
+    std::string bar_type_str = get_bar_type_string(bar_type, bar_size);
+    return base_path_ + "/" + symbol + "/" + bar_type_str + ".qtz";
+}
+
 bool FileStorage::compress_data(const char* source, size_t source_size, std::vector<char>& dest) {
     // Estimate the buffer size needed for compression
     uLongf dest_size = static_cast<uLongf>(compressBound(static_cast<uLong>(source_size)));
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "chunked_file.h"
 #include "data_storage.h"
 #include "logger/quantlogger.h"
+#include <condition_variable>
+#include <deque>
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <zlib.h>
 
 namespace quanttrader {
@@ -15,7 +21,18 @@ namespace storage {
  * @brief File-based data storage implementation
  * 
  * This class implements the DataStorage interface using files to store market data.
- * It supports compression with zlib to reduce storage requirements.
+ * Two formats are supported, selected with the "storage_format" config key:
+ * - "columnar" (default): memory mapped column files (".qtc"), served to BarLine without copying
+ * - "chunked": one compressed chunk per month (".qtz"), range loads decompress only the
+ *   overlapping chunks, in parallel. "storage_codec" picks how new files compress their
+ *   chunks: "columns" (default) for per column time series codecs, or "zlib"
+ * - "legacy": one zlib compressed blob per series (".dat")
+ * Loads prefer a column file, then a chunked file, then a legacy file.
+ *
+ * append_bars writes only the new bars: into the free slots of a column file (which is
+ * rewritten with room to grow when full), or as new chunks at the end of a chunked file.
+ * Appended chunks split months into small pieces, once a file has kCompactionFragments of
+ * them a background thread merges them again. Legacy files are rewritten on every append.
  */
 class FileStorage : public DataStorage {
 public:
@@ -23,11 +40,17 @@ public:
     ~FileStorage() override;
 
     bool initialize(const std::string& storage_path) override;
+    bool configure(const StorageParams& params) override;
     
     bool store_bars(const std::string& symbol, 
                    BarType bar_type,
                    unsigned int bar_size,
                    const BarSeries& bars) override;
+
+    bool append_bars(const std::string& symbol,
+                     BarType bar_type,
+                     unsigned int bar_size,
+                     const BarSeries& bars) override;
     
     std::optional<BarSeries> load_bars(const std::string& symbol,
                                       BarType bar_type,
@@ -35,20 +58,74 @@ public:
                                       std::optional<uint64_t> start_time = std::nullopt,
                                       std::optional<uint64_t> end_time = std::nullopt) override;
     
+    std::optional<SharedBarSeries> map_bars(const std::string& symbol,
+                                           BarType bar_type,
+                                           unsigned int bar_size,
+                                           std::optional<uint64_t> start_time = std::nullopt,
+                                           std::optional<uint64_t> end_time = std::nullopt) override;
+
     bool has_data(const std::string& symbol, 
                  BarType bar_type,
                  unsigned int bar_size) override;
 
     std::vector<std::string> get_available_symbols() override;
 
+    /**
+     * @brief Convert a legacy ".dat" file to the configured format ("columnar" if "legacy" is configured)
+     * 
+     * @param symbol The symbol/ticker for the data
+     * @param bar_type The type of bar
+     * @param bar_size The size of the bar
+     * @param remove_legacy Delete the legacy file after a successful conversion
+     * @return true if the column file was written
+     */
+    bool convert_legacy_file(const std::string& symbol, BarType bar_type, unsigned int bar_size, bool remove_legacy = false);
+
+    /**
+     * @brief Merge the appended chunks of a chunked file so that every month is one chunk again
+     * 
+     * @param symbol The symbol/ticker for the data
+     * @param bar_type The type of bar
+     * @param bar_size The size of the bar
+     * @return true if the file was compacted, had nothing to compact or there is no chunked file
+     */
+    bool compact(const std::string& symbol, BarType bar_type, unsigned int bar_size);
+
+    static constexpr size_t kCompactionFragments = 16;  // appended chunks tolerated before a rewrite
+    static constexpr size_t kMinAppendSlack = 4096;     // free slots left when a column file grows
+
 private:
+    enum class FileFormat { Legacy, Columnar, Chunked };
+
+    bool append_columnar_bars(const std::string& file_path, BarType bar_type, unsigned int bar_size, const BarSeries& bars);
+    bool append_chunked_bars(const std::string& file_path, const BarSeries& bars);
+    bool compact_chunked_file(const std::string& file_path);
+    void schedule_compaction(const std::string& file_path);
+    void run_compactions();
+
+    bool store_legacy_bars(const std::string& symbol, BarType bar_type, unsigned int bar_size, const BarSeries& bars);
+    std::optional<BarSeries> load_legacy_bars(const std::string& symbol, BarType bar_type, unsigned int bar_size,
+                                              std::optional<uint64_t> start_time, std::optional<uint64_t> end_time);
     std::string get_bar_type_string(BarType bar_type, unsigned int bar_size) const;
     std::string get_data_file_path(const std::string& symbol, BarType bar_type, unsigned int bar_size) const;
+    std::string get_columnar_file_path(const std::string& symbol, BarType bar_type, unsigned int bar_size) const;
+    std::string get_chunked_file_path(const std::string& symbol, BarType bar_type, unsigned int bar_size) const;
+    bool write_file(const std::string& symbol, BarType bar_type, unsigned int bar_size, const BarSeriesView& bars, FileFormat format);
+    bool ensure_parent_directory(const std::string& file_path);
     bool compress_data(const char* source, size_t source_size, std::vector<char>& dest);
     bool decompress_data(const char* source, size_t source_size, std::vector<char>& dest, size_t expected_size);
 
     std::string base_path_;
+    FileFormat format_ = FileFormat::Columnar;
+    ChunkEncoding chunk_encoding_ = ChunkEncoding::ColumnCodecs;
     quanttrader::log::LoggerPtr logger_;
+
+    std::shared_mutex write_mutex_;  // serializes writers, chunked reads share it as appends rewrite the index in place
+    std::mutex compaction_mutex_;
+    std::condition_variable compaction_cv_;
+    std::deque<std::string> compaction_queue_;
+    std::thread compaction_thread_;
+    bool stopping_ = false;
 };
 
 } // namespace storage
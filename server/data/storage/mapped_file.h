@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace quanttrader {
+namespace data {
+namespace storage {
+
+/**
+ * @brief Memory mapping of a whole file, read-only unless opened for writing
+ *
+ * Pages are loaded by the OS on first access, so opening a large file costs
+ * only the page table setup. The mapping lives as long as the object. Writes
+ * go to the shared pages, so other mappings of the file see them.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map a file into memory
+     *
+     * @param path Path of the file, it must not be empty
+     * @param writable Map the file for writing in place, its size stays the same
+     * @return The mapping, or nullptr if the file cannot be opened or mapped
+     */
+    static std::shared_ptr<MappedFile> open(const std::string& path, bool writable = false);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    char* writable_data() const { return writable_ ? const_cast<char*>(data_) : nullptr; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile() = default;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace storage
+} // namespace data
+} // namespace quanttrader
@@ -3,11 +3,16 @@
 #include "boost/program_options.hpp"
 #include "service/service_factory.h"
 #include "service/service.h"
+#include "data/ingest/csv_ingester.h"
+#include "cerebro/optimize/parameter_sweep.h"
+#include "cerebro/optimize/walk_forward.h"
 
 #ifdef QUANTTRADER_BUILD_TEST
 #include "test/test_base.h"
 #endif
 
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -20,6 +25,9 @@ namespace qlog = quanttrader::log;
 // Configuration table names in the Lua config files
 constexpr char STRATEGY_CONFIG_TABLE_NAME[] = "strategy_config";
 constexpr char TEST_CONFIG_TABLE_NAME[] = "test_config";
+constexpr char INGEST_CONFIG_TABLE_NAME[] = "ingest_config";
+constexpr char OPTIMIZE_CONFIG_TABLE_NAME[] = "optimize_config";
+constexpr char WALKFORWARD_CONFIG_TABLE_NAME[] = "walkforward_config";
 
 /*
  * Configuration and Data Flow:
@@ -32,6 +40,15 @@ constexpr char TEST_CONFIG_TABLE_NAME[] = "test_config";
  *    - Gets required services from "strategy_config.start_services"
  *    - Initializes services using ServiceFactory
  *    - All strategy parameters come from the specified config files
+ * 4. For ingest mode:
+ *    - Reads the CSV files and the storage to convert them into from "ingest_config"
+ *    - Converts the files in parallel, backtests then load them from the storage
+ * 5. For optimize mode:
+ *    - Reads the trade config, the strategy and the parameter grid from "optimize_config"
+ *    - Loads the data once and backtests every point of the grid in parallel
+ * 6. For walkforward mode:
+ *    - Reads the optimize settings and the in-sample and out-of-sample windows from "walkforward_config"
+ *    - Optimizes every window in parallel and stitches the out-of-sample equity
  * 
  * All configuration sample files are under the "script" directory.
  */
@@ -45,7 +62,7 @@ int run_test_command(const std::string &config_path) {
     
     std::cout << "Running test using configuration: " << config_path << "\n";
     // The test function should read the configuration file to determine which test to run
-    auto &mgr = quanttrader::test::TestFunctionMgr::instance();
+    auto mgr = quanttrader::test::TestFunctionMgr::instance();
     // The actual test function should be specified in the config file
     auto config_loader = quanttrader::luascript::LuaConfigLoader(config_path);
     if (!config_loader.load_config()) {
@@ -55,7 +72,7 @@ int run_test_command(const std::string &config_path) {
         qlog::Info("Running test using configuration: {}", config_path);
     }
     auto func_name = config_loader.get_string_value(TEST_CONFIG_TABLE_NAME, "function_name");
-    return mgr.run_test(func_name);
+    return mgr->run_test(func_name) ? EXIT_SUCCESS : EXIT_FAILURE;
 #else
     std::cout << "Not build with test support. Please recompile with QUANTTRADER_BUILD_TEST defined." << std::endl;
     return EXIT_SUCCESS;
@@ -93,6 +110,160 @@ int run_strategy_command(const std::string &config_path) {
     }
 }
 
+int run_ingest_command(const std::string &config_path) {
+    auto config_loader = quanttrader::luascript::LuaConfigLoader(config_path);
+    if (!config_loader.load_config()) {
+        std::cerr << "Error: Failed to load configuration file: " << config_path << "\n";
+        return EXIT_FAILURE;
+    }
+    quanttrader::data::storage::StorageParams params;
+    if (!config_loader.get_all_values(INGEST_CONFIG_TABLE_NAME, params)) {
+        std::cerr << "Error: No '" << INGEST_CONFIG_TABLE_NAME << "' table in " << config_path << "\n";
+        return EXIT_FAILURE;
+    }
+    qlog::Info("Ingesting data using configuration: {}", config_path);
+
+    quanttrader::data::ingest::CsvIngester ingester(params);
+    if (!ingester.prepare()) {
+        std::cout << "Cannot prepare the ingestion. Check log/data.log for more information." << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto stats = ingester.run();
+    if (!stats) {
+        return EXIT_FAILURE;
+    }
+    double seconds = std::max(stats->seconds, 1e-9);
+    std::cout << "Ingested " << stats->rows << " rows from " << stats->files - stats->failed_files << " of " << stats->files
+              << " files in " << stats->seconds << "s (" << static_cast<size_t>(stats->rows / seconds) << " rows/s, "
+              << stats->bytes / seconds / (1024 * 1024) << " MB/s)" << std::endl;
+    return stats->failed_files == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int run_optimize_command(const std::string &config_path) {
+    auto config_loader = quanttrader::luascript::LuaConfigLoader(config_path);
+    if (!config_loader.load_config()) {
+        std::cerr << "Error: Failed to load configuration file: " << config_path << "\n";
+        return EXIT_FAILURE;
+    }
+    quanttrader::cerebro::optimize::SweepOptions options;
+    if (!config_loader.get_all_values(OPTIMIZE_CONFIG_TABLE_NAME, options)) {
+        std::cerr << "Error: No '" << OPTIMIZE_CONFIG_TABLE_NAME << "' table in " << config_path << "\n";
+        return EXIT_FAILURE;
+    }
+    qlog::Info("Optimizing using configuration: {}", config_path);
+
+    quanttrader::cerebro::optimize::ParameterSweep sweep(options);
+    if (!sweep.prepare()) {
+        std::cout << "Cannot prepare the optimization. Check log/cerebro.log for more information." << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto stats = sweep.run();
+    if (!stats) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Backtested " << stats->points << " parameter sets (" << stats->failed << " failed) on " << stats->threads
+              << " threads in " << stats->seconds << "s (" << stats->points / std::max(stats->seconds, 1e-9)
+              << " backtests/s), data loaded once in " << stats->load_seconds << "s" << std::endl;
+
+    // The best parameter sets, ranked by the configured metric
+    int top = config_loader.get_int_value(OPTIMIZE_CONFIG_TABLE_NAME, "top");
+    const auto& results = sweep.get_results();
+    size_t shown = std::min(results.size(), static_cast<size_t>(top > 0 ? top : 10));
+    std::cout << "Top " << shown << " by " << sweep.get_rank_by() << ":\n";
+    std::cout << std::left << std::setw(6) << "rank";
+    for (const auto& name : sweep.get_grid().get_names()) {
+        std::cout << std::setw(16) << name;
+    }
+    std::cout << std::setw(14) << "profit" << std::setw(10) << "return%" << std::setw(14) << "max_dd" << std::setw(8)
+              << "trades" << std::setw(8) << "win%" << "profit_factor\n";
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& result = results[i];
+        std::cout << std::setw(6) << i + 1;
+        for (const auto& value : result.values) {
+            std::cout << std::setw(16) << value;
+        }
+        if (!result.completed) {
+            std::cout << "failed\n";
+            continue;
+        }
+        const auto& summary = result.summary;
+        std::cout << std::fixed << std::setprecision(2) << std::setw(14) << summary.total_profit << std::setw(10)
+                  << summary.return_percent << std::setw(14) << summary.max_drawdown << std::setw(8) << summary.total_trades
+                  << std::setw(8) << summary.win_rate << summary.profit_factor << "\n" << std::defaultfloat;
+    }
+
+    auto output = config_loader.get_string_value(OPTIMIZE_CONFIG_TABLE_NAME, "output");
+    if (!output.empty()) {
+        if (!sweep.write_csv(output)) {
+            std::cerr << "Error: Cannot write the results to " << output << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Wrote all " << results.size() << " results to " << output << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
+
+int run_walkforward_command(const std::string &config_path) {
+    auto config_loader = quanttrader::luascript::LuaConfigLoader(config_path);
+    if (!config_loader.load_config()) {
+        std::cerr << "Error: Failed to load configuration file: " << config_path << "\n";
+        return EXIT_FAILURE;
+    }
+    quanttrader::cerebro::optimize::SweepOptions options;
+    if (!config_loader.get_all_values(WALKFORWARD_CONFIG_TABLE_NAME, options)) {
+        std::cerr << "Error: No '" << WALKFORWARD_CONFIG_TABLE_NAME << "' table in " << config_path << "\n";
+        return EXIT_FAILURE;
+    }
+    qlog::Info("Walking forward using configuration: {}", config_path);
+
+    quanttrader::cerebro::optimize::WalkForward walk_forward(options);
+    if (!walk_forward.prepare()) {
+        std::cout << "Cannot prepare the walk-forward analysis. Check log/cerebro.log for more information." << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto stats = walk_forward.run();
+    if (!stats) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Walked forward over " << stats->windows << " windows (" << stats->failed << " failed) of " << stats->points
+              << " parameter sets, " << stats->backtests << " backtests on " << stats->threads << " threads in "
+              << stats->seconds << "s, data loaded once in " << stats->load_seconds << "s" << std::endl;
+
+    // The parameters chosen in every window and how they did on the following bars
+    const auto& names = walk_forward.get_sweep().get_grid().get_names();
+    std::cout << std::left << std::setw(8) << "window" << std::setw(12) << "in_bars" << std::setw(12) << "out_bars";
+    for (const auto& name : names) {
+        std::cout << std::setw(16) << name;
+    }
+    std::cout << std::setw(14) << "in_profit" << std::setw(14) << "out_profit" << std::setw(14) << "out_max_dd" << "out_trades\n";
+    for (const auto& window : walk_forward.get_windows()) {
+        std::cout << std::setw(8) << window.index << std::setw(12) << window.in_sample_bars << std::setw(12) << window.out_of_sample_bars;
+        if (!window.completed) {
+            std::cout << "failed\n";
+            continue;
+        }
+        for (const auto& value : window.best_values) {
+            std::cout << std::setw(16) << value;
+        }
+        std::cout << std::fixed << std::setprecision(2) << std::setw(14) << window.in_sample.total_profit << std::setw(14)
+                  << window.out_of_sample.total_profit << std::setw(14) << window.out_of_sample.max_drawdown
+                  << window.out_of_sample.total_trades << "\n" << std::defaultfloat;
+    }
+    std::cout << std::fixed << std::setprecision(2) << "Out of sample: profit " << stats->total_profit << " ("
+              << stats->return_percent << "%), max drawdown " << stats->max_drawdown << ", " << stats->total_trades
+              << " trades\n" << std::defaultfloat;
+
+    auto output = config_loader.get_string_value(WALKFORWARD_CONFIG_TABLE_NAME, "output");
+    if (!output.empty()) {
+        if (!walk_forward.write_csv(output)) {
+            std::cerr << "Error: Cannot write the equity to " << output << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Wrote the stitched out-of-sample equity to " << output << std::endl;
+    }
+    return stats->failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, const char* argv[]) {
     try {
         // init logger first
@@ -102,7 +273,7 @@ int main(int argc, const char* argv[]) {
         po::options_description global_desc("QuantTrader options");
         global_desc.add_options()
             ("help,h", "Display help message")
-            ("command", po::value<std::string>()->default_value("strategy"), "Command to execute, choose from [test, strategy], default is strategy")
+            ("command", po::value<std::string>()->default_value("strategy"), "Command to execute, choose from [test, strategy, ingest, optimize, walkforward], default is strategy")
             ("config,c", po::value<std::string>()->default_value("main_config.lua"), "Path to the configuration file. Default value is : main_config.lua");
 
         // Parse options
@@ -147,9 +318,15 @@ int main(int argc, const char* argv[]) {
             return run_test_command(config_path);
         } else if (command == "strategy") {
             return run_strategy_command(config_path);
+        } else if (command == "ingest") {
+            return run_ingest_command(config_path);
+        } else if (command == "optimize") {
+            return run_optimize_command(config_path);
+        } else if (command == "walkforward") {
+            return run_walkforward_command(config_path);
         } else {
             std::cerr << "Error: Unknown command '" << command << "'.\n";
-            std::cout << "Valid commands are: test, strategy\n";
+            std::cout << "Valid commands are: test, strategy, ingest, optimize, walkforward\n";
             return EXIT_FAILURE;
         }
     } catch (const po::error &ex) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/state_archive.h"
+#include <functional>
 #include <map>
 #include <string>
 #include <cstdint>
@@ -22,6 +24,32 @@ public:
 
     virtual void report() const = 0;
 
+    /**
+     * @brief Write the state to a checkpoint, nothing for observers without state
+     */
+    virtual void checkpoint(StateWriter& writer) const {}
+
+    /**
+     * @brief Read a state written by checkpoint without changing the observer
+     *
+     * @return A function replacing the state with the one read, empty if the state is malformed
+     */
+    virtual std::function<void()> stage_restore(StateReader& reader) { return [] {}; }
+
+    /**
+     * @brief Replace the state with one written by checkpoint, see stage_restore
+     *
+     * @return false if the state is malformed, the observer is unchanged then
+     */
+    bool restore(StateReader& reader) {
+        auto apply = stage_restore(reader);
+        if (!apply) {
+            return false;
+        }
+        apply();
+        return true;
+    }
+
     // Timezone management
     virtual void set_timezone(const std::string& timezone) { timezone_ = timezone; }
     virtual std::string get_timezone() const { return timezone_; }
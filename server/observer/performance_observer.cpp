@@ -177,7 +177,216 @@ void PerformanceObserver::set_broker(std::shared_ptr<broker::AbstractBroker> bro
     broker_ = broker;
 }
 
+void PerformanceObserver::set_starting_cash(double starting_cash) {
+    starting_cash_ = starting_cash;
+    cash_ = starting_cash;
+    equity_ = starting_cash;
+    peak_equity_ = starting_cash;
+}
+
+PerformanceSummary PerformanceObserver::get_summary() const {
+    PerformanceSummary summary;
+    summary.starting_cash = starting_cash_;
+    summary.ending_equity = broker_ ? broker_->get_account_info().equity : equity_;
+    summary.total_profit = summary.ending_equity - starting_cash_;
+    summary.return_percent = starting_cash_ > 0 ? summary.total_profit / starting_cash_ * 100.0 : 0.0;
+    summary.max_drawdown = max_drawdown_;
+    summary.max_drawdown_percent = starting_cash_ > 0 ? max_drawdown_ / starting_cash_ * 100.0 : 0.0;
+
+    // Like the report, the broker's profit and loss come from the completed trades
+    double gross_profit = broker_ ? 0.0 : gross_profit_;
+    double gross_loss = broker_ ? 0.0 : gross_loss_;
+    for (const auto& trade : completed_trades_) {
+        if (trade.profit > 0) {
+            summary.winning_trades++;
+            gross_profit += broker_ ? trade.profit : 0.0;
+        } else if (trade.profit < 0) {
+            gross_loss += broker_ ? -trade.profit : 0.0;
+        }
+    }
+    summary.total_trades = completed_trades_.size();
+    summary.win_rate = summary.total_trades > 0 ? static_cast<double>(summary.winning_trades) / summary.total_trades * 100.0 : 0.0;
+    summary.profit_factor = gross_loss > 0 ? gross_profit / gross_loss
+                                           : (gross_profit > 0 ? std::numeric_limits<double>::infinity() : 0.0);
+    summary.return_dd_ratio = max_drawdown_ > 0 ? summary.total_profit / max_drawdown_ : std::numeric_limits<double>::infinity();
+    return summary;
+}
+
+void PerformanceObserver::checkpoint(StateWriter& writer) const {
+    writer.write(starting_cash_);
+    writer.write(cash_);
+    writer.write(equity_);
+    writer.write(peak_equity_);
+    writer.write(max_drawdown_);
+    writer.write(max_drawdown_time_);
+    writer.write(gross_profit_);
+    writer.write(gross_loss_);
+
+    writer.write<uint64_t>(positions_.size());
+    for (const auto& [symbol, quantity] : positions_) {
+        writer.write(symbol);
+        writer.write(quantity);
+    }
+    writer.write<uint64_t>(avg_price_.size());
+    for (const auto& [symbol, price] : avg_price_) {
+        writer.write(symbol);
+        writer.write(price);
+    }
+
+    writer.write<uint64_t>(trades_.size());
+    for (const auto& trade : trades_) {
+        writer.write(trade.time);
+        writer.write(trade.symbol);
+        writer.write(trade.quantity);
+        writer.write(trade.price);
+        writer.write(trade.is_buy);
+    }
+
+    writer.write<uint64_t>(open_trades_.size());
+    for (const auto& [symbol, trade] : open_trades_) {
+        writer.write(trade.entry_time);
+        writer.write(trade.symbol);
+        writer.write(trade.quantity);
+        writer.write(trade.is_long);
+        writer.write(trade.entry_price);
+        writer.write(trade.worst_price);
+        writer.write(trade.worst_price_time);
+    }
+
+    writer.write<uint64_t>(completed_trades_.size());
+    for (const auto& trade : completed_trades_) {
+        writer.write(trade.entry_time);
+        writer.write(trade.exit_time);
+        writer.write(trade.symbol);
+        writer.write(trade.quantity);
+        writer.write(trade.is_long);
+        writer.write(trade.entry_price);
+        writer.write(trade.exit_price);
+        writer.write(trade.max_drawdown);
+        writer.write(trade.max_drawdown_time);
+        writer.write(trade.profit);
+        writer.write(trade.duration);
+    }
+
+    writer.write<uint64_t>(equity_history_.size());
+    for (const auto& point : equity_history_) {
+        writer.write(point.time);
+        writer.write(point.equity);
+        writer.write(point.peak_equity);
+        writer.write(point.drawdown);
+    }
+}
+
+std::function<void()> PerformanceObserver::stage_restore(StateReader& reader) {
+    auto staged = std::make_shared<PerformanceObserver>(starting_cash_);
+    PerformanceObserver& restored = *staged;
+    reader.read(restored.starting_cash_);
+    reader.read(restored.cash_);
+    reader.read(restored.equity_);
+    reader.read(restored.peak_equity_);
+    reader.read(restored.max_drawdown_);
+    reader.read(restored.max_drawdown_time_);
+    reader.read(restored.gross_profit_);
+    reader.read(restored.gross_loss_);
+
+    uint64_t count = 0;
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        std::string symbol;
+        int quantity = 0;
+        reader.read(symbol);
+        reader.read(quantity);
+        restored.positions_[symbol] = quantity;
+    }
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        std::string symbol;
+        double price = 0.0;
+        reader.read(symbol);
+        reader.read(price);
+        restored.avg_price_[symbol] = price;
+    }
+
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        TradeRecord trade {};
+        reader.read(trade.time);
+        reader.read(trade.symbol);
+        reader.read(trade.quantity);
+        reader.read(trade.price);
+        reader.read(trade.is_buy);
+        restored.trades_.push_back(std::move(trade));
+    }
+
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        OpenTrade trade {};
+        reader.read(trade.entry_time);
+        reader.read(trade.symbol);
+        reader.read(trade.quantity);
+        reader.read(trade.is_long);
+        reader.read(trade.entry_price);
+        reader.read(trade.worst_price);
+        reader.read(trade.worst_price_time);
+        restored.open_trades_[trade.symbol] = trade;
+    }
+
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        CompletedTrade trade {};
+        reader.read(trade.entry_time);
+        reader.read(trade.exit_time);
+        reader.read(trade.symbol);
+        reader.read(trade.quantity);
+        reader.read(trade.is_long);
+        reader.read(trade.entry_price);
+        reader.read(trade.exit_price);
+        reader.read(trade.max_drawdown);
+        reader.read(trade.max_drawdown_time);
+        reader.read(trade.profit);
+        reader.read(trade.duration);
+        restored.completed_trades_.push_back(std::move(trade));
+    }
+
+    reader.read_count(count, sizeof(EquityPoint));
+    restored.equity_history_.reserve(reader.ok() ? count : 0);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        EquityPoint point {};
+        reader.read(point.time);
+        reader.read(point.equity);
+        reader.read(point.peak_equity);
+        reader.read(point.drawdown);
+        restored.equity_history_.push_back(point);
+    }
+
+    if (!reader.ok()) {
+        logger_->error("Malformed performance observer state in the checkpoint");
+        return {};
+    }
+    return [this, staged]() {
+        PerformanceObserver& restored = *staged;
+        starting_cash_ = restored.starting_cash_;
+        cash_ = restored.cash_;
+        equity_ = restored.equity_;
+        peak_equity_ = restored.peak_equity_;
+        max_drawdown_ = restored.max_drawdown_;
+        max_drawdown_time_ = restored.max_drawdown_time_;
+        gross_profit_ = restored.gross_profit_;
+        gross_loss_ = restored.gross_loss_;
+        positions_ = std::move(restored.positions_);
+        avg_price_ = std::move(restored.avg_price_);
+        trades_ = std::move(restored.trades_);
+        open_trades_ = std::move(restored.open_trades_);
+        completed_trades_ = std::move(restored.completed_trades_);
+        equity_history_ = std::move(restored.equity_history_);
+    };
+}
+
 void PerformanceObserver::report() const {
+    // Sweeps run thousands of backtests with the report level off, skip formatting the trades
+    if (!logger_->should_log(spdlog::level::info)) {
+        return;
+    }
     logger_->info("===== Performance Report =====");
     
     if (broker_) {
@@ -655,11 +864,14 @@ std::string PerformanceObserver::format_timestamp(uint64_t timestamp_ns) const {
     }
     
     try {
-        // Use the configured timezone instead of empty string
-        auto time_with_zone = quanttrader::time::TimeWithZone(timestamp_ns, timezone_);
-        return time_with_zone.to_string_with_name();  // Use to_string_with_name() to include timezone info
+        // Use the configured timezone instead of empty string, resolved once
+        if (!timestamp_tracker_.has_value() || timestamp_zone_ != timezone_) {
+            timestamp_tracker_.emplace(timezone_);
+            timestamp_zone_ = timezone_;
+        }
+        return timestamp_tracker_->format(timestamp_ns);  // Include the zone abbreviation
     } catch (const std::exception& e) {
-        // Fallback to simple formatting if TimeWithZone fails
+        // Fallback to simple formatting if the time zone lookup fails
         std::time_t timestamp_sec = timestamp_ns / 1000000000ULL; // Convert nanoseconds to seconds
         std::tm tm_local;
         
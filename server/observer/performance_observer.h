@@ -3,11 +3,12 @@
 #include "observer_base.h"
 #include "logger/quantlogger.h"
 #include "broker/abstract_broker.h"
-#include "basic/time/time_with_zone.h"
+#include "basic/time/time_boundary_tracker.h"
 #include <map>
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
 
 namespace quanttrader {
 namespace observer {
@@ -44,6 +45,30 @@ struct OpenTrade {
     uint64_t worst_price_time;  // Time when worst price occurred
 };
 
+struct EquityPoint {
+    uint64_t time;
+    double equity;
+    double peak_equity;
+    double drawdown;
+};
+
+/**
+ * @brief Headline metrics of a run, the numbers of the performance report
+ */
+struct PerformanceSummary {
+    double starting_cash = 0.0;
+    double ending_equity = 0.0;
+    double total_profit = 0.0;
+    double return_percent = 0.0;
+    double max_drawdown = 0.0;
+    double max_drawdown_percent = 0.0;
+    size_t total_trades = 0;       // completed round trips
+    size_t winning_trades = 0;
+    double win_rate = 0.0;         // percent of the completed trades
+    double profit_factor = 0.0;    // infinity without losing trades
+    double return_dd_ratio = 0.0;  // infinity without drawdown
+};
+
 class PerformanceObserver : public ObserverBase {
 public:
     explicit PerformanceObserver(double starting_cash = 100000.0);
@@ -62,9 +87,26 @@ public:
     uint64_t get_max_drawdown_time() const { return max_drawdown_time_; }
     double get_gross_profit() const { return gross_profit_; }
     double get_gross_loss() const { return gross_loss_; }
+    const std::vector<EquityPoint>& get_equity_history() const { return equity_history_; }
+
+    /**
+     * @brief Set the cash the returns are measured against, before the first update
+     */
+    void set_starting_cash(double starting_cash);
+
+    /**
+     * @brief Compute the headline metrics without logging them
+     *
+     * @return The metrics of the broker account when connected, of the recorded trades otherwise
+     */
+    PerformanceSummary get_summary() const;
 
     void report() const override;
 
+    // The account, trades and equity history
+    void checkpoint(StateWriter& writer) const override;
+    std::function<void()> stage_restore(StateReader& reader) override;
+
 private:
     double starting_cash_;
     double cash_;
@@ -82,16 +124,14 @@ private:
     quanttrader::log::LoggerPtr logger_;
     
     // Historical equity tracking for max drawdown time calculation
-    struct EquityPoint {
-        uint64_t time;
-        double equity;
-        double peak_equity;
-        double drawdown;
-    };
     std::vector<EquityPoint> equity_history_;
     
     // Broker integration
     std::shared_ptr<broker::AbstractBroker> broker_;
+
+    // Resolved zone for format_timestamp, rebuilt when the timezone changes
+    mutable std::optional<quanttrader::time::TimeBoundaryTracker> timestamp_tracker_;
+    mutable std::string timestamp_zone_;
     
     // Internal methods
     void update_from_broker(uint64_t time);
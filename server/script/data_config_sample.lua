@@ -40,7 +40,11 @@ min_data = {
 	bar_type = "15 mins",
 	up_to_date = false,
 	resample = false,  -- resample data or not
-	resample_bar_size = "15 mins",  -- resample bar type
+	resample_bar_size = "15 mins",  -- resample bar type, a list like "5 mins, 15 mins, 1 hour" is built in one pass
+	backfill_in_flight = 10,  -- without up_to_date the range is fetched in chunks, at most this many at once across tickers
+	backfill_requests_per_10min = 60,  -- pacing budget of the chunk requests, shared by all tickers
+	session_start = "09:30:00",  -- resampled days, weeks and months keep the bars in the session, stamped at its start
+	session_end = "16:00:00",
 }
 
 sec_data = {
@@ -61,4 +65,6 @@ sec_data = {
 	up_to_date = false,
 	resample = false,  -- resample data or not
 	resample_bar_size = "5 secs",  -- resample bar type
+	bar_line = "ring",  -- locked: shared_mutex protected, ring: lock-free single writer/single reader, for live feeds
+	bar_line_capacity = 4096,  -- ring capacity in bars, rounded up to a power of two
 }
\ No newline at end of file
@@ -7,4 +7,70 @@ strategy_config = {
 
 test_config = {
 	function_name = "xxx"
-}
\ No newline at end of file
+}
+
+-- used by the ingest command, converts CSV files into a storage once so backtests load binary data
+ingest_config = {
+	source = "csv/*.csv",  -- a directory or a file pattern with * and ?, one symbol per file named after it
+	recursive = false,  -- search the sub directories of a directory source
+	bar_type = "1 day",
+	storage_type = "file",  -- file or db
+	storage_path = "./data",
+	mode = "replace",  -- replace: the files replace stored bars, append: only bars after the stored ones are added
+	threads = 0,  -- 0 for all cores
+	memory_mb = 2048,  -- bars in flight, parsed bars take about twice the CSV size
+	-- CSV layout, the same options as the CSV data feed. Yahoo downloads have Adj Close before the volume: volume_column = 6
+	delimiter = ",",
+	has_header = true,
+	datetime_column = 0,
+	open_column = 1,
+	high_column = 2,
+	low_column = 3,
+	close_column = 4,
+	volume_column = 5,
+	date_format = "%Y-%m-%d",
+}
+
+-- used by the optimize command, backtests one strategy of a trade config over a grid of parameters
+optimize_config = {
+	config_path = "trade_config.lua",  -- data series and strategy table like the strategy command, live feeds cannot be swept
+	service = "StockTradeService",  -- the service table of the trade config
+	strategy = "apple_slope",  -- the strategy table to sweep, the first of strategy_names when empty
+	grid = {
+		-- "start:stop:step", "start:stop" or a list like "20,50,100", one backtest per combination
+		fast_ma_period = "5:50:5",
+		slow_ma_period = "20,50,100,200",
+	},
+	threads = 0,  -- 0 for all cores, each thread runs one backtest at a time
+	rank_by = "total_profit",  -- total_profit, return_percent, return_dd_ratio, profit_factor, win_rate, total_trades, max_drawdown, max_drawdown_percent
+	top = 10,  -- parameter sets printed
+	output = "optimize_results.csv",  -- all ranked results, empty for none
+	starting_cash = 100000,
+	commission = 0.0,
+	slippage = 0.0,
+	wait_data_timeout = 120000,  -- loading the data in milliseconds
+	log_level = "warn",  -- level of the backtests' loggers, empty keeps the configured levels
+}
+
+walkforward_config = {
+	config_path = "trade_config.lua",  -- data series and strategy table like the strategy command
+	service = "StockTradeService",
+	strategy = "apple_slope",
+	grid = {
+		-- optimized again on every in-sample window
+		fast_ma_period = "5:50:5",
+		slow_ma_period = "20,50,100,200",
+	},
+	in_sample_bars = 504,  -- bars of the first data series to optimize on
+	out_of_sample_bars = 126,  -- following bars traded with the best parameters
+	step_bars = 126,  -- bars between window starts, out_of_sample_bars by default
+	anchored = false,  -- true keeps every in-sample window starting at the first bar
+	threads = 0,  -- 0 for all cores, the windows are optimized at the same time
+	rank_by = "return_dd_ratio",  -- the metric that picks the parameters of a window, see optimize_config
+	output = "walkforward_equity.csv",  -- the stitched out-of-sample equity, empty for none
+	starting_cash = 100000,
+	commission = 0.0,
+	slippage = 0.0,
+	wait_data_timeout = 120000,
+	log_level = "warn",
+}
@@ -6,6 +6,7 @@ StockTradeService = {
 
 	-- settings for data series
 	data_series = "daily_data,min_data,sec_data",
+	bar_cache_mb = 1024,  -- memory budget of the bars shared by data providers and cerebros, use_bar_cache = false in a data config opts out
 	daily_data = {
 		provider_type = "tws",
 		provider_config = "data_config.lua",  -- configuration for daily data provider
@@ -30,12 +31,14 @@ StockTradeService = {
 	cerebro_names = "backtest_cerebro,live_cerebro",
 	backtest_cerebro = {
 		cerebro_type = "backtest",
-		replay_mode = "normal",
+		replay_mode = "normal",  -- normal/stepped: as fast as possible, realtime: paced by bar time, event: wait for new bars (live)
+		replay_speed = 1,  -- only for realtime, e.g. 60 replays one hour of bars in one minute, 0.5 half speed
 		wait_data_timeout = 120000, -- wait data from data provider timeout in milliseconds, not updated unless restart quanttrader
+		start_threads = 8,  -- threads starting the data providers, 0 or unset for the number of hardware threads
 	},
 	live_cerebro = {
 		cerebro_type = "live",
-		replay_mode = "normal",
+		replay_mode = "event",
 		wait_data_timeout = 120000, -- wait data from data provider timeout in milliseconds, not updated unless restart quanttrader
 	},
 	risk_manager = {
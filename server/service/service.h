@@ -36,6 +36,7 @@ public:
     
     // Configuration access methods
     virtual int get_int_value(const std::string &key) = 0;
+    virtual double get_double_value(const std::string &key) = 0;
     virtual std::string get_string_value(const std::string &key) = 0;
     virtual int get_int_value_in_table(const std::string &table_name, const std::string &key) = 0;
     virtual std::string get_string_value_in_table(const std::string &table_name, const std::string &key) = 0;
@@ -87,6 +88,14 @@ public:
         return lua_config_->get_int_value(service_name_, key);
     }
 
+    double get_double_value(const std::string &key) override {
+        if (!config_loaded_) {
+            throw std::runtime_error("Service is not prepared. Please prepare the service first.");
+        }
+
+        return lua_config_->get_double_value(service_name_, key);
+    }
+
     std::string get_string_value(const std::string &key) override {
         if (!config_loaded_) {
             throw std::runtime_error("Service is not prepared. Please prepare the service first.");
@@ -2,6 +2,7 @@
 #include "service/service_consts.h"
 #include "broker/broker_provider_factory.h"
 #include "data/common/data_provider_factory.h"
+#include "data/common/bar_cache.h"
 #include "strategy/strategy_factory.h"
 #include "strategy/strategy_loader.h"
 #include "cerebro/cerebro_factory.h"
@@ -53,6 +54,13 @@ bool StockTradeService::prepare_broker_service() {
 }
 
 bool StockTradeService::prepare_data_series() {
+    // Bars loaded by several providers or cerebros are shared through the bar cache
+    int bar_cache_mb = get_int_value("bar_cache_mb");
+    if (bar_cache_mb > 0) {
+        data::util::BarCache::instance()->set_memory_budget(static_cast<size_t>(bar_cache_mb) * 1024 * 1024);
+        logger_->info("Set the bar cache budget to {} MB", bar_cache_mb);
+    }
+
     // Parse data provider configurations
     auto data_series = get_string_value("data_series");
     std::vector<std::string> data_names;
@@ -146,6 +154,12 @@ bool StockTradeService::prepare_cerebro() {
         if (wait_data_timeout > 0) {
             cerebro->set_wait_data_ready_timeout(wait_data_timeout);
         }
+
+        // Data providers start concurrently, loading from files or storage is mostly I/O
+        int start_threads = get_int_value(cerebro_name + ".start_threads");
+        if (start_threads > 0) {
+            cerebro->set_start_threads(static_cast<size_t>(start_threads));
+        }
         
         // Add data providers to cerebro
         for (auto iter = data_providers_.begin(); iter != data_providers_.end(); iter++) {
@@ -165,14 +179,30 @@ bool StockTradeService::prepare_cerebro() {
                     logger_->error("Resample size is empty for data provider: {}", data_name);
                     return false;
                 }
-                auto [target_type, target_size] = data::provider::DataProvider::get_bar_type_from_string(resample_size);
-                if (target_type != data::BarType::NONE) {
-                    if (!cerebro->resample_data(data_name, target_type, target_size)) {
+                // A comma separated list, e.g. "1 min, 5 mins, 1 hour", is resampled in one pass
+                std::vector<std::pair<data::BarType, unsigned int>> targets;
+                std::stringstream sizes(resample_size);
+                std::string size;
+                while (std::getline(sizes, size, ',')) {
+                    size.erase(0, size.find_first_not_of(" \t"));
+                    size.erase(size.find_last_not_of(" \t") + 1);
+                    auto target = data::provider::DataProvider::get_bar_type_from_string(size);
+                    if (target.first == data::BarType::NONE) {
+                        logger_->error("Cannot parse the resample size {} of data provider: {}", size, data_name);
+                        return false;
+                    }
+                    targets.push_back(target);
+                }
+                if (targets.size() == 1) {
+                    if (!cerebro->resample_data(data_name, targets[0].first, targets[0].second)) {
                         logger_->error("Failed to resample data {} to {}", data_name, resample_size);
                         return false;
                     }
-                    logger_->info("Resampled data {} to {}", data_name, resample_size);
+                } else if (!targets.empty() && !cerebro->resample_data(data_name, targets)) {
+                    logger_->error("Failed to resample data {} to {}", data_name, resample_size);
+                    return false;
                 }
+                logger_->info("Resampled data {} to {}", data_name, resample_size);
             }
         }
         
@@ -184,12 +214,20 @@ bool StockTradeService::prepare_cerebro() {
                 mode = data::provider::DataProvider::ReplayMode::REALTIME;
             } else if (replay_mode_str == "stepped") {
                 mode = data::provider::DataProvider::ReplayMode::STEPPED;
-            } else if (replay_mode_str != "normal") {
+            } else if (replay_mode_str != "normal" && replay_mode_str != "event") {
                 logger_->error("Invalid replay mode: {} for cerebro: {}", replay_mode_str, cerebro_name);
                 return false;
             }
             cerebro->set_replay_mode(mode);
-            logger_->info("Set replay mode to {} for cerebro: {}", replay_mode_str, cerebro_name);
+
+            // The replay mode also decides how fast the cerebro event loop runs
+            double replay_speed = get_double_value(cerebro_name + ".replay_speed");
+            if (replay_speed <= 0.0) {
+                replay_speed = 1.0;
+            }
+            auto pacing_policy = cerebro::create_pacing_policy(replay_mode_str, replay_speed);
+            cerebro->set_pacing_policy(pacing_policy);
+            logger_->info("Set replay mode to {} (speed {}x) for cerebro: {}", replay_mode_str, replay_speed, cerebro_name);
         }
         
         // Add strategies to cerebro
@@ -331,6 +369,9 @@ void StockTradeService::stop() {
             logger_->error("Cerebro {} is not initialized.", pair.first);
         }
     }
+    auto cache_stats = data::util::BarCache::instance()->get_stats();
+    logger_->info("Bar cache: {} hits, {} misses, {} evictions, {} series in {} bytes", cache_stats.hits, cache_stats.misses,
+                  cache_stats.evictions, cache_stats.entries, cache_stats.bytes);
     logger_->info("Stop broker and back test service.");
     strategy::StrategyLoader::unload_plugins();
 }
@@ -62,8 +62,52 @@ bool StrategyBase::on_stop() {
     return true;
 }
 
-    
-void StrategyBase::on_data_series(const std::map<std::string, data::BarSeries>& bar_series_map, bool day_change, bool hour_change, bool minute_change) {
+void StrategyBase::checkpoint(StateWriter& writer) const {
+    writer.write(current_time_);
+    std::map<std::string, double> last_prices(last_prices_.begin(), last_prices_.end());
+    writer.write<uint64_t>(last_prices.size());
+    for (const auto& [data_name, price] : last_prices) {
+        writer.write(data_name);
+        writer.write(price);
+    }
+    writer.write(save_state());
+}
+
+std::function<bool()> StrategyBase::stage_restore(StateReader& reader) {
+    uint64_t current_time = 0;
+    uint64_t count = 0;
+    std::unordered_map<std::string, double> last_prices;
+    reader.read(current_time);
+    reader.read_count(count);
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        std::string data_name;
+        double price = 0.0;
+        reader.read(data_name);
+        reader.read(price);
+        last_prices[data_name] = price;
+    }
+    std::string state;
+    if (!reader.read(state)) {
+        logger_->error("Malformed state of strategy {} in the checkpoint", strategy_name_);
+        return {};
+    }
+    return [this, current_time, last_prices = std::move(last_prices), state = std::move(state)]() {
+        if (!load_state(state)) {
+            logger_->error("Strategy {} cannot load its state of {} bytes", strategy_name_, state.size());
+            return false;
+        }
+        current_time_ = current_time;
+        last_prices_ = last_prices;
+        return true;
+    };
+}
+
+bool StrategyBase::restore(StateReader& reader) {
+    auto apply = stage_restore(reader);
+    return apply && apply();
+}
+
+void StrategyBase::on_data_series(const std::map<std::string, data::BarSeriesView>& bar_series_map, bool day_change, bool hour_change, bool minute_change) {
     // Call on_bar with TA-Lib compatible data for each feed
     if (log_data_) {
         logger_->info("Processing data series for strategy: {}", strategy_name_);
@@ -12,11 +12,13 @@
 #include "data/common/data_struct.h"
 #include "observer/observer_base.h"
 #include "broker/abstract_broker.h"
+#include "common/state_archive.h"
 
 namespace quanttrader {
 namespace data {
 struct BarStruct;
 struct BarSeries;
+struct BarSeriesView;
 }
 namespace strategy {
 
@@ -38,7 +40,7 @@ public:
 
     // Core event handlers
     virtual void on_tick(const std::string& data_name, const std::any& tick_data) {}
-    virtual void on_bar(const std::string& data_name, const data::BarSeries& bar_series, bool day_change, bool hour_change, bool minute_change) {}
+    virtual void on_bar(const std::string& data_name, const data::BarSeriesView& bar_series, bool day_change, bool hour_change, bool minute_change) {}
     virtual void on_trade(const std::string& symbol, double price, int quantity, bool is_buy) {}
     virtual void on_order(const std::string& order_id, const std::string& status) {}
     
@@ -51,18 +53,54 @@ public:
     /**
      * @brief Called when new data is available (optimized version)
      * 
-     * This method receives cached TA-Lib compatible BarSeries directly from CerebroBase,
-     * avoiding the need to recreate BarSeries objects on each call.
+     * This method receives TA-Lib compatible views over the data providers' bars
+     * from CerebroBase, so no bars are copied on each call.
      * 
-     * @param bar_series_map Map of data provider names to cached BarSeries (readonly)
+     * @param bar_series_map Map of data provider names to the bars replayed so far (readonly)
      */
-    virtual void on_data_series(const std::map<std::string, data::BarSeries>& bar_series_map, bool day_change, bool hour_change, bool minute_change);
+    virtual void on_data_series(const std::map<std::string, data::BarSeriesView>& bar_series_map, bool day_change, bool hour_change, bool minute_change);
     
     // Lifecycle methods
     virtual bool initialize();
     virtual bool on_start();
     virtual bool on_stop();
 
+    /**
+     * @brief State of a derived strategy for a checkpoint, such as signals or counters
+     * 
+     * Indicators computed from the bar views need no state, the views come back with the replay.
+     * 
+     * @return The blob, empty for a strategy without state of its own
+     */
+    virtual std::string save_state() const { return ""; }
+
+    /**
+     * @brief Take back the blob of save_state, called after on_start when a checkpoint is restored
+     * 
+     * @return false if the blob cannot be used
+     */
+    virtual bool load_state(const std::string& state) { return true; }
+
+    /**
+     * @brief Write the replay time, the last prices and the blob of save_state to a checkpoint
+     */
+    void checkpoint(StateWriter& writer) const;
+
+    /**
+     * @brief Read a state written by checkpoint without changing the strategy
+     * 
+     * @return A function handing the blob to load_state and taking the rest of the state if
+     *         load_state accepts it, it returns false otherwise. Empty if the state is malformed.
+     */
+    std::function<bool()> stage_restore(StateReader& reader);
+
+    /**
+     * @brief Restore a state written by checkpoint, see stage_restore
+     * 
+     * @return false if the state is malformed or load_state refused the blob
+     */
+    bool restore(StateReader& reader);
+
     void add_observer(std::shared_ptr<observer::ObserverBase> obs) { if (obs) observers_.push_back(obs); }
     
     // Broker integration
@@ -0,0 +1,114 @@
+#include "test/test_base.h"
+#include "data/common/bar_cache.h"
+#include "data/feed/csv_data_feed.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+class TestBarCache : public TestBase {
+public:
+    TestBarCache(): TestBase("TestBarCache") {
+        register_test<TestBarCache>();
+    }
+
+    // Two providers of the same CSV file, as two cerebros or data series over one ticker
+    // would load it, then LRU eviction under a small budget. The default bar count keeps the
+    // test quick, set QUANTTRADER_BENCH_ROWS (e.g. 250000) to benchmark.
+    virtual void run() override {
+        size_t bar_count = kDefaultBars;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            bar_count = std::strtoull(env_rows, nullptr, 10);
+        }
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_bar_cache";
+        std::filesystem::create_directories(root);
+        std::string csv_path = (root / "BENCH.csv").string();
+        {
+            std::ofstream csv(csv_path);
+            csv << "date,open,high,low,close,volume\n";
+            for (int i = 0; i < static_cast<int>(bar_count); ++i) {
+                int day = i / 1440;
+                int minute = i % 1440;
+                double price = 100.0 + (i % 1000) * 0.01;
+                csv << "2000-" << two_digits(day / 28 + 1) << '-' << two_digits(day % 28 + 1) << ' ' << two_digits(minute / 60) << ':'
+                    << two_digits(minute % 60) << ',' << price << ',' << price + 0.5 << ',' << price - 0.5 << ',' << price << ",1000\n";
+            }
+        }
+
+        auto cache = data::util::BarCache::instance();
+        cache->clear();
+        auto params = std::make_shared<std::unordered_map<std::string, std::any>>();
+        (*params)["csv_file_path"] = csv_path;
+        (*params)["symbol"] = std::string("BENCH");
+        (*params)["bar_type"] = std::string("1 min");
+        (*params)["date_format"] = std::string("%Y-%m-%d %H:%M");
+
+        data::BarSeriesView views[2];
+        std::shared_ptr<data::feed::CsvDataFeed> feeds[2];
+        for (int i = 0; i < 2; ++i) {
+            feeds[i] = std::make_shared<data::feed::CsvDataFeed>("bench_" + std::to_string(i), params);
+            feeds[i]->prepare_data();
+            auto start = std::chrono::steady_clock::now();
+            feeds[i]->start_request_data();
+            views[i] = feeds[i]->get_bar_view(SIZE_MAX);
+            std::cout << "Provider " << i << ": " << views[i].size() << " bars in " << seconds_since(start) * 1000.0 << "ms"
+                      << std::endl;
+            expect(views[i].size() == bar_count, "provider " + std::to_string(i) + " loads every bar");
+        }
+        auto stats = cache->get_stats();
+        bool shared = views[0].close.data() == views[1].close.data();
+        std::cout << "Shared columns: " << (shared ? "yes" : "no") << ", hits " << stats.hits << ", misses " << stats.misses
+                  << ", cached bytes " << stats.bytes << std::endl;
+        expect(shared, "the second provider maps the columns of the first");
+        expect(stats.hits == 1 && stats.misses == 1, "the file is parsed once and served from the cache once");
+
+        // Three series of 1000 bars under a budget for two, the least recently used goes first
+        auto make_series = [](size_t count) {
+            data::BarSeries bars;
+            for (size_t i = 0; i < count; ++i) {
+                bars.push_back(i, 1.0, 1.0, 1.0, 1.0, 0, 0, 0);
+            }
+            return data::SharedBarSeries::own(std::move(bars));
+        };
+        size_t series_bytes = data::util::BarCache::byte_size(make_series(1000).view);
+        cache->clear();
+        cache->set_memory_budget(series_bytes * 2);
+        int loads = 0;
+        auto loader = [&]() { ++loads; return std::optional<data::SharedBarSeries>(make_series(1000)); };
+        for (const char* symbol : {"A", "B", "A", "C", "A", "B"}) {
+            cache->get_or_load(data::util::BarCacheKey{"test", symbol, data::BarType::Minute, 1}, loader);
+        }
+        stats = cache->get_stats();
+        std::cout << "LRU: " << loads << " loads (expected 4), " << stats.evictions << " evictions (expected 2), "
+                  << stats.entries << " series cached" << std::endl;
+        expect(loads == 4, "LRU: the evicted series are loaded again");
+        expect(stats.evictions == 2 && stats.entries == 2, "LRU: the least recently used series are evicted");
+
+        cache->set_memory_budget(data::util::BarCache::kDefaultBudget);
+        cache->clear();
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static constexpr size_t kDefaultBars = 20000;  // minutes of 14 days
+
+    static std::string two_digits(int value) {
+        return (value < 10 ? "0" : "") + std::to_string(value);
+    }
+
+    static double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestBarCache test_bar_cache;
+
+}
+}
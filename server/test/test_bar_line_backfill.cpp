@@ -0,0 +1,115 @@
+#include "test/test_base.h"
+#include "data/common/bar_line.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace quanttrader {
+namespace test {
+
+class TestBarLineBackfill : public TestBase {
+public:
+    TestBarLineBackfill(): TestBase("TestBarLineBackfill") {
+        register_test<TestBarLineBackfill>();
+    }
+
+    // Backfill 1% of a bar series at random positions, as TWS corrections do, a quarter of the
+    // late bars twice. The reader is halfway through and one late bar lands right at it. The default bar count keeps the test
+    // quick, set QUANTTRADER_BENCH_ROWS (e.g. 5000000) to benchmark.
+    virtual void run() override {
+        constexpr uint64_t kStartTime = 1704067200ULL * 1000000000ULL;
+        constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+        size_t bar_count = kDefaultBars;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            bar_count = std::strtoull(env_rows, nullptr, 10);
+        }
+        size_t late_count = std::max<size_t>(bar_count / 100, 1);
+
+        data::util::BarLine bar_line(static_cast<unsigned int>(bar_count), data::BarType::Minute, 1);
+        data::BarSeries history;
+        history.reserve(bar_count);
+        for (size_t i = 0; i < bar_count; ++i) {
+            // leave every other minute free for the backfill
+            history.push_back(kStartTime + 2 * i * kMinute, 100.0, 100.5, 99.5, 100.0, 100, 0, 1);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bar_line.append_batch(std::move(history));
+        auto load_seconds = elapsed_since(start);
+        size_t cursor = std::max<size_t>(bar_count / 2, 1);
+        bar_line.set_position(static_cast<unsigned int>(cursor));
+
+        std::mt19937_64 random(42);
+        std::vector<uint64_t> late_times;
+        late_times.reserve(late_count);
+        for (size_t i = 0; i < late_count; ++i) {
+            late_times.push_back(kStartTime + (2 * (random() % bar_count) + 1) * kMinute);
+        }
+        std::map<uint64_t, double> late_closes;  // the close of the last bar pushed at each time
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < late_times.size(); ++i) {
+            double close = 101.0 + static_cast<double>(i % 7);
+            bar_line.push_data(late_times[i], close, close + 0.5, close - 0.5, close, 10, 0, 1);
+            late_closes[late_times[i]] = close;
+        }
+        for (size_t i = 0; i < late_times.size() / 4; ++i) {
+            double close = 200.0 + static_cast<double>(i % 7);
+            bar_line.push_data(late_times[i], close, close + 0.5, close - 0.5, close, 10, 0, 1);
+            late_closes[late_times[i]] = close;
+        }
+        // a late bar right at the cursor, the reader has to merge before it goes on
+        uint64_t expected_time = kStartTime + (2 * cursor - 1) * kMinute;
+        bar_line.push_data(expected_time, 102.0, 102.5, 101.5, 102.0, 10, 0, 1);
+        late_closes[expected_time] = 102.0;
+        auto push_seconds = elapsed_since(start);
+
+        // The staged bars before the cursor move it, so the reader goes on with the late bar
+        size_t late_before = static_cast<size_t>(std::distance(late_closes.begin(), late_closes.find(expected_time)));
+        start = std::chrono::steady_clock::now();
+        auto bar = bar_line.next();
+        auto merge_seconds = elapsed_since(start);
+        bool cursor_kept = bar.has_value() && bar->time == expected_time && bar_line.get_position() == cursor + late_before + 1;
+
+        bar_line.reset();  // merges the late bars staged behind the cursor
+        size_t expected = bar_count + late_closes.size();
+        auto view = bar_line.view(bar_line.size());
+        bool sorted = std::adjacent_find(view.start_time.begin(), view.start_time.end(), std::greater_equal<>{}) ==
+                      view.start_time.end();
+        bool later_wins = view.size() == expected;
+        for (size_t i = 0; later_wins && i < view.size(); ++i) {
+            auto late = late_closes.find(view.start_time[i]);
+            later_wins = view.close[i] == (late == late_closes.end() ? 100.0 : late->second);
+        }
+
+        std::cout << "Loaded " << bar_count << " bars in " << load_seconds << "s" << std::endl;
+        std::cout << "Backfilled " << late_times.size() + late_times.size() / 4 + 1 << " bars in " << push_seconds << "s, final merge "
+                  << merge_seconds << "s" << std::endl;
+        std::cout << "Stored " << view.size() << " bars (expected " << expected << "), sorted and unique: " << (sorted ? "yes" : "no")
+                  << ", later bars win: " << (later_wins ? "yes" : "no") << ", cursor kept: " << (cursor_kept ? "yes" : "no")
+                  << std::endl;
+        expect(view.size() == expected, "every late bar is stored once");
+        expect(sorted, "the merged bars are sorted without duplicates");
+        expect(later_wins, "the later of two bars with the same time wins");
+        expect(cursor_kept, "late bars before the cursor do not move the reader back");
+    }
+
+private:
+    static constexpr size_t kDefaultBars = 50000;
+
+    static double elapsed_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestBarLineBackfill test_bar_line_backfill;
+
+}
+}
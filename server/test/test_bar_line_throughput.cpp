@@ -0,0 +1,85 @@
+#include "test/test_base.h"
+#include "data/common/bar_line.h"
+#include "data/common/ring_bar_line.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace quanttrader {
+namespace test {
+
+class TestBarLineThroughput : public TestBase {
+public:
+    TestBarLineThroughput(): TestBase("TestBarLineThroughput") {
+        register_test<TestBarLineThroughput>();
+    }
+
+    virtual void run() override {
+        constexpr unsigned int kCapacity = 4096;
+
+        auto locked = std::make_shared<data::util::BarLine>(kCapacity, data::BarType::Second, 5);
+        auto ring = std::make_shared<data::util::RingBarLine>(kCapacity, data::BarType::Second, 5);
+
+        run_one("locked", locked);
+        run_one("ring", ring);
+        std::cout << "ring overflowed " << ring->overflow_count() << " bars" << std::endl;
+    }
+
+private:
+    // A broker thread pushes bars, each bar updated in place kUpdatesPerBar times, while the cerebro thread polls next()
+    void run_one(const char *name, std::shared_ptr<data::util::BarLine> bar_line) {
+        constexpr uint64_t kBars = 200000;
+        constexpr int kUpdatesPerBar = 4;
+        constexpr uint64_t kStartTime = 1704067200ULL * 1000000000ULL;
+        constexpr uint64_t kStep = 5ULL * 1000000000ULL;
+
+        std::atomic<bool> done {false};
+        auto start = std::chrono::steady_clock::now();
+
+        std::thread writer([&]() {
+            for (uint64_t i = 0; i < kBars; ++i) {
+                for (int update = 0; update < kUpdatesPerBar; ++update) {
+                    double price = 100.0 + static_cast<double>(i % 100) * 0.01 + update * 0.001;
+                    bar_line->push_data(kStartTime + i * kStep, price, price + 0.5, price - 0.5, price, 100, 0, update + 1);
+                }
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        uint64_t read = 0;
+        uint64_t polls = 0;
+        while (true) {
+            bool finished = done.load(std::memory_order_acquire);
+            ++polls;
+            while (bar_line->next().has_value()) {
+                ++read;
+            }
+            if (finished) {
+                // one more pass after the writer is done picks up everything it published
+                while (bar_line->next().has_value()) {
+                    ++read;
+                }
+                break;
+            }
+        }
+        writer.join();
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double updates = static_cast<double>(kBars * kUpdatesPerBar);
+        std::cout << name << ": " << kBars * kUpdatesPerBar << " pushes, " << read << " bars read, "
+                  << polls << " polls in " << elapsed << "s, "
+                  << (elapsed > 0 ? updates / elapsed : 0.0) << " pushes/s" << std::endl;
+        if (bar_line->size() != kBars) {
+            std::cout << name << ": expected " << kBars << " bars, stored " << bar_line->size() << std::endl;
+        }
+    }
+};
+
+// dummy object to register test
+static TestBarLineThroughput test_bar_line_throughput;
+
+}
+}
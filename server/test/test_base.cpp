@@ -1,5 +1,6 @@
 #include "test_base.h"
 #include <format>
+#include <iostream>
 
 
 namespace quanttrader {
@@ -26,8 +27,20 @@ bool TestFunctionMgr::run_test(const std::string &name) {
 
     std::shared_ptr<TestBase> test = it->second(name);
     test->run();
+    if (test->has_failed()) {
+        logger_->error("Test {} failed", name);
+        return false;
+    }
     return true;
 }
 
+bool TestBase::expect(bool condition, std::string_view what) {
+    if (!condition) {
+        std::cout << "FAILED: " << what << std::endl;
+        failed_ = true;
+    }
+    return condition;
+}
+
 }
 }
\ No newline at end of file
@@ -31,6 +31,10 @@ public:
 
     virtual void run() = 0;
 
+    bool has_failed() const {
+        return failed_;
+    }
+
     template<typename T>
     static std::shared_ptr<TestBase> create(const std::string &name) {
         return std::shared_ptr<TestBase>(new T);
@@ -39,12 +43,22 @@ public:
 protected:
     template<typename T>
     bool register_test() {
-        TestFunctionMgr &mgr = TestFunctionMgr::instance();
-        return mgr.register_test(name_, create<T>);
+        auto mgr = TestFunctionMgr::instance();
+        return mgr->register_test(name_, create<T>);
     }
 
+    /**
+     * @brief Check a result, a failed check makes the test command exit with a failure
+     *
+     * @param condition The result to check
+     * @param what What was checked, printed when the check fails
+     * @return The condition
+     */
+    bool expect(bool condition, std::string_view what);
+
 private:
     std::string name_;
+    bool failed_ = false;
 };
 
 }
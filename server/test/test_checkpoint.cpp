@@ -0,0 +1,225 @@
+#include "test/test_base.h"
+#include "cerebro/backtest/backtest_cerebro.h"
+#include "common/state_archive.h"
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kStartTime = 1104537600ULL * 1000000000ULL;  // 2005-01-03 00:00:00 UTC
+constexpr uint64_t kDay = 86400ULL * 1000000000ULL;
+constexpr size_t kDays = 2520;
+constexpr size_t kPauseDay = 1500;
+
+// Daily bars of a trending, cycling price
+class CyclingBars : public data::provider::DataProvider {
+public:
+    explicit CyclingBars(size_t days)
+        : DataProvider("daily_TEST", std::make_shared<std::unordered_map<std::string, std::any>>()), days_(days) {
+        symbol_ = "TEST";
+        bar_type_ = data::BarType::Day;
+        bar_size_ = 1;
+        timezone_ = "UTC";
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(0, bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        data::BarSeries bars;
+        for (size_t day = 0; day < days_; ++day) {
+            double price = 100.0 + day * 0.02 + 10.0 * std::sin(day / 15.0) + 4.0 * std::sin(day / 4.0);
+            bars.push_back(kStartTime + day * kDay, price, price + 1.0, price - 1.0, price, 1000, 0, 1);
+        }
+        bar_line_->append_batch(std::move(bars));
+        mark_data_ready();
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+private:
+    size_t days_ = 0;
+};
+
+// Long while the fast moving average is above the slow one, the position flag is its state
+class CrossStrategy : public strategy::StrategyBase {
+public:
+    explicit CrossStrategy(strategy::StrategyCreateFuncParemType& params)
+        : StrategyBase(params), fast_(get_param<int>("fast_period", 5)), slow_(get_param<int>("slow_period", 20)) {}
+
+    void on_bar(const std::string& data_name, const data::BarSeriesView& bar_series, bool, bool, bool) override {
+        size_t count = bar_series.close.size();
+        if (count < static_cast<size_t>(std::max(fast_, slow_))) {
+            return;
+        }
+        bool above = average(bar_series, fast_) > average(bar_series, slow_);
+        if (above && !long_) {
+            buy(symbol_, 100);
+            long_ = true;
+        } else if (!above && long_) {
+            sell(symbol_, 100);
+            long_ = false;
+        }
+    }
+
+    std::string save_state() const override {
+        StateWriter writer;
+        writer.write<uint8_t>(long_ ? 1 : 0);
+        return writer.take();
+    }
+
+    bool load_state(const std::string& state) override {
+        StateReader reader(state);
+        uint8_t is_long = 0;
+        if (!reader.read(is_long) || !reader.at_end()) {
+            return false;
+        }
+        long_ = is_long != 0;
+        return true;
+    }
+
+protected:
+    void next() override {}
+
+private:
+    static double average(const data::BarSeriesView& bar_series, int period) {
+        double sum = 0.0;
+        for (size_t i = bar_series.close.size() - period; i < bar_series.close.size(); ++i) {
+            sum += bar_series.close[i];
+        }
+        return sum / period;
+    }
+
+    int fast_ = 5;
+    int slow_ = 20;
+    bool long_ = false;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+class TestCheckpoint : public TestBase {
+public:
+    TestCheckpoint(): TestBase("TestCheckpoint") {
+        register_test<TestCheckpoint>();
+    }
+
+    virtual void run() override {
+        // A run straight through is the reference
+        auto full = make_cerebro("checkpoint_full", kDays, 20);
+        full->run();
+        auto expected = summary(*full);
+
+        // Pause in the middle and save the state through a file
+        auto paused = make_cerebro("checkpoint_paused", kDays, 20);
+        auto replay_start = std::chrono::steady_clock::now();
+        paused->run_until(kStartTime + kPauseDay * kDay);
+        double replay_seconds = seconds_since(replay_start);
+        auto state = paused->checkpoint();
+        auto path = std::filesystem::temp_directory_path() / "quanttrader_test_checkpoint.bin";
+        bool file_ok = state && write_state_file(path, *state) && read_state_file(path) == state;
+        std::filesystem::remove(path);
+        if (!state || !file_ok) {
+            std::cout << "Checkpoint failed, file round trip: " << (file_ok ? "ok" : "WRONG") << std::endl;
+            expect(false, "checkpoint and write the state to a file");
+            return;
+        }
+
+        // The paused run and a fresh cerebro restored from the state finish like the full run
+        paused->run();
+        auto resumed = make_cerebro("checkpoint_resumed", kDays, 20);
+        auto restore_start = std::chrono::steady_clock::now();
+        bool restored = resumed->restore(*state);
+        double restore_seconds = seconds_since(restore_start);
+        resumed->run();
+        bool paused_ok = same(summary(*paused), expected);
+        bool resumed_ok = restored && same(summary(*resumed), expected);
+
+        // What-if branches continue the same state with other parameters
+        auto branch = make_cerebro("checkpoint_branch", kDays, 40);
+        bool branch_restored = branch->restore(*state);
+        branch->run();
+        auto branched = summary(*branch);
+
+        // A state does not restore over other bars, a truncated state is refused
+        auto shorter = make_cerebro("checkpoint_shorter", kPauseDay / 2, 20);
+        auto truncated = make_cerebro("checkpoint_truncated", kDays, 20);
+        bool refused = !shorter->restore(*state) && !truncated->restore(state->substr(0, state->size() / 2));
+
+        std::cout << "Checkpoint of " << state->size() << " bytes at day " << kPauseDay << ", file round trip: ok" << std::endl;
+        std::cout << "Full run: profit " << expected.profit << ", " << expected.trades << " trades, "
+                  << expected.equity_points << " equity points" << std::endl;
+        std::cout << "Paused and continued: " << (paused_ok ? "ok" : "WRONG") << ", restored and continued: "
+                  << (resumed_ok ? "ok" : "WRONG") << std::endl;
+        std::cout << "Branch with slow_period 40: " << (branch_restored ? "restored" : "FAILED") << ", profit "
+                  << branched.profit << ", " << branched.equity_points << " equity points" << std::endl;
+        std::cout << "Restore over other bars or from a truncated state refused: " << (refused ? "ok" : "WRONG") << std::endl;
+        std::cout << "Replay to the pause: " << replay_seconds << "s, restore: " << restore_seconds << "s" << std::endl;
+        expect(expected.equity_points > 0, "the full run records equity");
+        expect(paused_ok, "a paused run continues like the full run");
+        expect(resumed_ok, "a restored run continues like the full run");
+        expect(branch_restored && branched.equity_points == expected.equity_points, "a branch restores and runs to the end");
+        expect(refused, "refuse a state over other bars or a truncated state");
+    }
+
+private:
+    struct Outcome {
+        double profit = 0.0;
+        double max_drawdown = 0.0;
+        size_t trades = 0;
+        size_t equity_points = 0;
+    };
+
+    static bool same(const Outcome& left, const Outcome& right) {
+        return left.profit == right.profit && left.max_drawdown == right.max_drawdown && left.trades == right.trades &&
+               left.equity_points == right.equity_points;
+    }
+
+    std::unique_ptr<cerebro::BacktestCerebro> make_cerebro(const std::string& name, size_t days, int slow_period) {
+        auto cerebro = std::make_unique<cerebro::BacktestCerebro>(name);
+        auto source = std::make_shared<CyclingBars>(days);
+        source->prepare_data();
+        cerebro->add_data(source->get_data_name(), source);
+        strategy::StrategyCreateFuncParemType params {{"strategy_name", std::string("checkpoint_cross")},
+                                                      {"symbol", std::string("TEST")},
+                                                      {"fast_period", 5},
+                                                      {"slow_period", slow_period}};
+        cerebro->add_strategy(std::make_shared<CrossStrategy>(params));
+        cerebro->set_start_threads(1);
+        return cerebro;
+    }
+
+    static Outcome summary(const cerebro::CerebroBase& cerebro) {
+        Outcome outcome;
+        for (const auto& obs : cerebro.get_observers()) {
+            if (auto performance = std::dynamic_pointer_cast<observer::PerformanceObserver>(obs)) {
+                auto stats = performance->get_summary();
+                outcome.profit = stats.total_profit;
+                outcome.max_drawdown = stats.max_drawdown;
+                outcome.trades = stats.total_trades;
+                outcome.equity_points = performance->get_equity_history().size();
+            }
+        }
+        return outcome;
+    }
+};
+
+// dummy object to register test
+static TestCheckpoint test_checkpoint;
+
+}
+}
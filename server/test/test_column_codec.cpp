@@ -0,0 +1,217 @@
+#include "test/test_base.h"
+#include "data/storage/chunked_file.h"
+#include "data/storage/column_codec.h"
+#include "data/storage/file_storage.h"
+
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <zlib.h>
+
+namespace quanttrader {
+namespace test {
+
+class TestColumnCodec : public TestBase {
+public:
+    TestColumnCodec(): TestBase("TestColumnCodec") {
+        register_test<TestColumnCodec>();
+    }
+
+    // Ratio and decode speed of the column codecs against zlib. Minute bars of a symbol in a
+    // FileStorage directory are used when QUANTTRADER_BENCH_STORAGE and QUANTTRADER_BENCH_SYMBOL
+    // are set, otherwise a 5 year random walk on a one cent grid.
+    virtual void run() override {
+        data::BarSeries bars = load_bars();
+        std::cout << "Bars: " << bars.size() << ", SIMD decode " << (data::storage::ColumnCoder::simd_supported() ? "on" : "off")
+                  << std::endl;
+
+        using data::storage::ColumnCodec;
+        bench_column("start_time", ColumnCodec::DeltaOfDelta, to_words(bars.start_time));
+        bench_column("open", ColumnCodec::Xor, to_words(bars.open));
+        bench_column("open", ColumnCodec::ScaledDelta, to_words(bars.open));
+        bench_column("close", ColumnCodec::ScaledDelta, to_words(bars.close));
+        bench_column("wap", ColumnCodec::ZigzagDelta, to_words(bars.wap));
+        bench_column("volume", ColumnCodec::ZigzagDelta, to_words(bars.volume));
+        bench_column("count", ColumnCodec::Zigzag, to_words(bars.count));
+
+        check_scaled_round_trips();
+
+        // Whole files, all chunks decoded as a cold load would
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_codec_bench";
+        std::filesystem::create_directories(root);
+        auto logger = quanttrader::log::get_common_rotation_logger("TestColumnCodec", "test");
+        data::BarSeriesView view(bars);
+        size_t raw_bytes = bars.size() * (sizeof(uint64_t) + sizeof(double) * 4 + sizeof(Decimal) * 2 + sizeof(int));
+        for (auto encoding : {data::storage::ChunkEncoding::Zlib, data::storage::ChunkEncoding::ColumnCodecs}) {
+            bool zlib = encoding == data::storage::ChunkEncoding::Zlib;
+            std::string path = (root / (zlib ? "zlib.qtz" : "columns.qtz")).string();
+            auto start = std::chrono::steady_clock::now();
+            data::storage::ChunkedFile::write(path, view, data::BarType::Minute, 1, logger, encoding);
+            double write_s = seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            auto loaded = data::storage::ChunkedFile::read(path, std::nullopt, std::nullopt, logger, 1);
+            double read_s = seconds_since(start);
+
+            bool same = loaded.has_value() && loaded->start_time == bars.start_time && loaded->close == bars.close &&
+                        loaded->volume == bars.volume && loaded->count == bars.count;
+            double ratio = static_cast<double>(raw_bytes) / static_cast<double>(std::filesystem::file_size(path));
+            std::cout << (zlib ? "zlib file" : "codec file") << ": ratio " << ratio << ", write " << write_s * 1000.0
+                      << "ms, read (1 thread) " << gigabytes(raw_bytes) / read_s << " GB/s" << (same ? "" : " (content differs)")
+                      << std::endl;
+        }
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static constexpr int kRepeats = 5;
+
+    static double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static double gigabytes(size_t bytes) {
+        return static_cast<double>(bytes) / 1e9;
+    }
+
+    // coefficient * 10^exponent as a BID64 decimal, the exponent is stored with a bias of 398
+    static Decimal make_decimal(uint64_t coefficient, int exponent = 0) {
+        return (static_cast<uint64_t>(398 + exponent) << 53) | coefficient;
+    }
+
+    template <typename T>
+    static std::vector<uint64_t> to_words(const std::vector<T>& column) {
+        std::vector<uint64_t> words(column.size());
+        for (size_t i = 0; i < column.size(); ++i) {
+            if constexpr (std::is_floating_point_v<T>) {
+                words[i] = std::bit_cast<uint64_t>(column[i]);
+            } else {
+                words[i] = static_cast<uint64_t>(static_cast<int64_t>(column[i]));
+            }
+        }
+        return words;
+    }
+
+    static data::BarSeries load_bars() {
+        const char* storage_path = std::getenv("QUANTTRADER_BENCH_STORAGE");
+        const char* symbol = std::getenv("QUANTTRADER_BENCH_SYMBOL");
+        if (storage_path && symbol) {
+            data::storage::FileStorage storage;
+            if (storage.initialize(storage_path)) {
+                auto bars = storage.load_bars(symbol, data::BarType::Minute, 1);
+                if (bars.has_value() && !bars->start_time.empty()) {
+                    return std::move(bars.value());
+                }
+            }
+            std::cout << "No minute bars of " << symbol << " in " << storage_path << ", using generated bars" << std::endl;
+        }
+
+        constexpr uint64_t kNanosPerDay = 86400ULL * 1000000000ULL;
+        constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+        constexpr uint64_t kFirstDay = 16071;  // 2014-01-02
+        std::mt19937_64 random(42);
+        std::normal_distribution<double> step(0.0, 3.0);
+        std::lognormal_distribution<double> volume(7.0, 1.0);
+
+        data::BarSeries bars;
+        int64_t cents = 10000;
+        for (uint64_t day = kFirstDay; day < kFirstDay + 5 * 365; ++day) {
+            uint64_t weekday = (day + 4) % 7;  // 1970-01-01 was a Thursday
+            if (weekday == 0 || weekday == 6) {
+                continue;
+            }
+            uint64_t session_start = day * kNanosPerDay + (14 * 60 + 30) * kMinute;
+            for (uint64_t minute = 0; minute < 390; ++minute) {
+                int64_t open = cents;
+                int64_t close = std::max<int64_t>(100, open + static_cast<int64_t>(step(random)));
+                int64_t high = std::max(open, close) + static_cast<int64_t>(std::abs(step(random)));
+                int64_t low = std::min(open, close) - static_cast<int64_t>(std::abs(step(random)));
+                uint64_t shares = static_cast<uint64_t>(volume(random));
+                bars.push_back(session_start + minute * kMinute, open / 100.0, high / 100.0, low / 100.0, close / 100.0,
+                               make_decimal(shares), make_decimal(static_cast<uint64_t>((open + close) / 2), -2),
+                               static_cast<int>(shares / 50 + 1));
+                cents = close;
+            }
+        }
+        return bars;
+    }
+
+    // Large prices next to prices with many decimals must not overflow the scale found for the column
+    void check_scaled_round_trips() {
+        std::mt19937_64 random(7);
+        std::uniform_int_distribution<int64_t> digits(0, 999999999);
+        std::vector<double> mixed;
+        for (int i = 0; i < 1000; ++i) {
+            mixed.push_back(i % 2 == 0 ? 3e12 + static_cast<double>(i) : static_cast<double>(digits(random)) / 1e9);
+        }
+        const std::vector<std::vector<double>> columns = {
+            {3e12, 0.12345},
+            {0.12345, 3e12},
+            {1.5, 2251799.0, 0.000000001},
+            {9.87654321e10, 12.34, 0.5},
+            mixed,
+        };
+
+        size_t failed = 0;
+        for (const auto& column : columns) {
+            auto words = to_words(column);
+            std::vector<char> encoded;
+            data::storage::ColumnCoder::encode(data::storage::ColumnCodec::ScaledDelta, words, encoded);
+            for (auto path : {data::storage::DecodePath::Scalar, data::storage::DecodePath::Simd}) {
+                std::vector<uint64_t> decoded(words.size());
+                bool ok = data::storage::ColumnCoder::decode(data::storage::ColumnCodec::ScaledDelta, encoded.data(), encoded.size(),
+                                                             decoded, path);
+                failed += ok && decoded == words ? 0 : 1;
+            }
+        }
+        std::cout << "scaled_delta round trips of mixed magnitudes: " << (failed == 0 ? "ok" : "WRONG") << std::endl;
+        expect(failed == 0, "scaled_delta round trips of mixed magnitudes");
+    }
+
+    static void bench_column(const std::string& name, data::storage::ColumnCodec codec, const std::vector<uint64_t>& words) {
+        size_t raw_bytes = words.size() * sizeof(uint64_t);
+
+        // zlib over the raw column, as the v1 chunks do
+        uLongf zlib_size = compressBound(static_cast<uLong>(raw_bytes));
+        std::vector<char> zlib_data(zlib_size);
+        compress(reinterpret_cast<Bytef*>(zlib_data.data()), &zlib_size, reinterpret_cast<const Bytef*>(words.data()),
+                 static_cast<uLong>(raw_bytes));
+        std::vector<uint64_t> decoded(words.size());
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRepeats; ++i) {
+            uLongf size = static_cast<uLongf>(raw_bytes);
+            uncompress(reinterpret_cast<Bytef*>(decoded.data()), &size, reinterpret_cast<const Bytef*>(zlib_data.data()), zlib_size);
+        }
+        double zlib_speed = gigabytes(raw_bytes) * kRepeats / seconds_since(start);
+
+        std::vector<char> encoded;
+        data::storage::ColumnCoder::encode(codec, words, encoded);
+        double speeds[2];
+        bool same = true;
+        for (auto path : {data::storage::DecodePath::Scalar, data::storage::DecodePath::Simd}) {
+            std::fill(decoded.begin(), decoded.end(), 0);
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kRepeats; ++i) {
+                data::storage::ColumnCoder::decode(codec, encoded.data(), encoded.size(), decoded, path);
+            }
+            speeds[path == data::storage::DecodePath::Simd] = gigabytes(raw_bytes) * kRepeats / seconds_since(start);
+            same = same && decoded == words;
+        }
+
+        std::cout << name << " (" << data::storage::ColumnCoder::to_string(codec) << "): ratio "
+                  << static_cast<double>(raw_bytes) / static_cast<double>(encoded.size()) << " vs zlib "
+                  << static_cast<double>(raw_bytes) / static_cast<double>(zlib_size) << ", decode scalar " << speeds[0]
+                  << " GB/s, simd " << speeds[1] << " GB/s, zlib " << zlib_speed << " GB/s" << (same ? "" : " (round trip differs)")
+                  << std::endl;
+    }
+};
+
+// dummy object to register test
+static TestColumnCodec test_column_codec;
+
+}
+}
@@ -0,0 +1,143 @@
+#include "test/test_base.h"
+#include "data/storage/columnar_file.h"
+#include "data/storage/file_storage.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+class TestColumnarFile : public TestBase {
+public:
+    TestColumnarFile(): TestBase("TestColumnarFile") {
+        register_test<TestColumnarFile>();
+    }
+
+    // Round trips through ".qtc" files: direct writes and appends, FileStorage appends that
+    // outgrow the capacity, and the conversion of a legacy file
+    virtual void run() override {
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_test_columnar";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root);
+
+        check_file((root / "direct.qtc").string());
+        check_storage((root / "storage").string());
+        check_conversion((root / "convert").string());
+
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static constexpr uint64_t kStartTime = 1704067200ULL * 1000000000ULL;  // 2024-01-01 00:00:00 UTC
+    static constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+    const std::string kSymbol = "TEST";
+
+    static data::BarSeries make_bars(size_t first, size_t count) {
+        data::BarSeries bars;
+        bars.reserve(count);
+        for (size_t i = first; i < first + count; ++i) {
+            double price = 100.0 + static_cast<double>(i % 1000) * 0.01;
+            bars.push_back(kStartTime + i * kMinute, price, price + 0.5, price - 0.5, price + 0.25, 100 + i, i, static_cast<int>(i));
+        }
+        return bars;
+    }
+
+    static bool same(const data::BarSeriesView& left, const data::BarSeries& right) {
+        data::BarSeries copy = left.to_bar_series();
+        return copy.start_time == right.start_time && copy.open == right.open && copy.high == right.high &&
+               copy.low == right.low && copy.close == right.close && copy.wap == right.wap && copy.volume == right.volume &&
+               copy.count == right.count;
+    }
+
+    // The appended bars cross a time index stride, a mapping opened before keeps its bars
+    void check_file(const std::string& path) {
+        auto logger = quanttrader::log::get_common_rotation_logger("TestColumnarFile", "test");
+        constexpr size_t kFirst = data::storage::kColumnarIndexStride - 10;
+        constexpr size_t kAppended = 100;
+        data::BarSeries all = make_bars(0, kFirst + kAppended);
+        data::BarSeriesView view(all);
+
+        bool written = data::storage::ColumnarFile::write(path, view.subview(0, kFirst), data::BarType::Minute, 1,
+                                                          kFirst + kAppended, logger);
+        auto before = data::storage::ColumnarFile::open(path, logger);
+        bool appended = data::storage::ColumnarFile::append(path, view.subview(kFirst, kAppended), logger);
+        bool overflow_refused = !data::storage::ColumnarFile::append(path, data::BarSeriesView(make_bars(kFirst + kAppended, 1)), logger);
+        auto after = data::storage::ColumnarFile::open(path, logger);
+
+        bool before_ok = before && before->header().bar_count == kFirst && same(before->bars(), make_bars(0, kFirst));
+        bool after_ok = after && same(after->bars(), all) && after->header().first_time == all.start_time.front() &&
+                        after->header().last_time == all.start_time.back();
+        uint64_t range_start = all.start_time[kFirst - 5];
+        uint64_t range_end = all.start_time[kFirst + 5];
+        bool range_ok = after && same(after->range(range_start, range_end), make_bars(kFirst - 5, 11)) &&
+                        after->lower_bound(range_start + 1) == kFirst - 4;
+
+        std::cout << "Column file: write " << (written ? "ok" : "WRONG") << ", append " << (appended && after_ok ? "ok" : "WRONG")
+                  << ", earlier mapping " << (before_ok ? "unchanged" : "WRONG") << ", range " << (range_ok ? "ok" : "WRONG")
+                  << std::endl;
+        expect(written, "write a column file");
+        expect(appended && after_ok, "append to a column file");
+        expect(overflow_refused, "refuse appends past the capacity");
+        expect(before_ok, "a mapping keeps the bars it mapped");
+        expect(range_ok, "range lookups through the time index");
+    }
+
+    // The first append outgrows the file and rewrites it with slack, the second fills the slack
+    void check_storage(const std::string& path) {
+        data::storage::FileStorage storage;
+        storage.configure({{"storage_format", std::string("columnar")}});
+        storage.initialize(path);
+
+        data::BarSeries history = make_bars(0, 1000);
+        bool stored = storage.store_bars(kSymbol, data::BarType::Minute, 1, history);
+        auto mapped = storage.map_bars(kSymbol, data::BarType::Minute, 1);
+        bool loaded_ok = mapped.has_value() && same(mapped->view, history);
+
+        // Each refresh repeats the last bar it already sent
+        bool appended = storage.append_bars(kSymbol, data::BarType::Minute, 1, make_bars(999, 101)) &&
+                        storage.append_bars(kSymbol, data::BarType::Minute, 1, make_bars(1099, 101));
+        auto loaded = storage.load_bars(kSymbol, data::BarType::Minute, 1);
+        bool appended_ok = appended && loaded.has_value() && same(data::BarSeriesView(*loaded), make_bars(0, 1200));
+        bool mapping_kept = mapped.has_value() && same(mapped->view, history);
+
+        std::cout << "FileStorage columnar: store " << (stored && loaded_ok ? "ok" : "WRONG") << ", appends "
+                  << (appended_ok ? "ok" : "WRONG") << ", earlier mapping " << (mapping_kept ? "unchanged" : "WRONG") << std::endl;
+        expect(stored && loaded_ok, "store and map a column file");
+        expect(appended_ok, "append through FileStorage");
+        expect(mapping_kept, "a FileStorage mapping keeps the bars it mapped");
+    }
+
+    void check_conversion(const std::string& path) {
+        data::BarSeries bars = make_bars(0, 5000);
+        {
+            data::storage::FileStorage legacy;
+            legacy.configure({{"storage_format", std::string("legacy")}});
+            legacy.initialize(path);
+            legacy.store_bars(kSymbol, data::BarType::Minute, 1, bars);
+        }
+
+        data::storage::FileStorage storage;
+        storage.configure({{"storage_format", std::string("columnar")}});
+        storage.initialize(path);
+        bool converted = storage.convert_legacy_file(kSymbol, data::BarType::Minute, 1, true);
+        bool legacy_removed = true;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+            legacy_removed = legacy_removed && entry.path().extension() != ".dat";
+        }
+        auto mapped = storage.map_bars(kSymbol, data::BarType::Minute, 1);
+        bool content_ok = mapped.has_value() && same(mapped->view, bars);
+
+        std::cout << "Legacy conversion: " << (converted && content_ok ? "ok" : "WRONG") << ", legacy file "
+                  << (legacy_removed ? "removed" : "kept") << std::endl;
+        expect(converted && content_ok, "convert a legacy file to a column file");
+        expect(legacy_removed, "remove the converted legacy file");
+    }
+};
+
+// dummy object to register test
+static TestColumnarFile test_columnar_file;
+
+}
+}
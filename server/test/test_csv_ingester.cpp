@@ -0,0 +1,93 @@
+#include "test/test_base.h"
+#include "data/ingest/csv_ingester.h"
+#include "data/storage/file_storage.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+class TestCsvIngester : public TestBase {
+public:
+    TestCsvIngester(): TestBase("TestCsvIngester") {
+        register_test<TestCsvIngester>();
+    }
+
+    // 16 files of minute bars converted into a FileStorage, then read back. The default bar
+    // count keeps the test quick, set QUANTTRADER_BENCH_ROWS (e.g. 100000) to benchmark.
+    virtual void run() override {
+        constexpr int kFiles = 16;
+        size_t bar_count = kDefaultBars;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            bar_count = std::strtoull(env_rows, nullptr, 10);
+        }
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_csv_ingester";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "csv");
+        for (int f = 0; f < kFiles; ++f) {
+            std::ofstream csv(root / "csv" / ("SYM" + std::to_string(f) + ".csv"));
+            csv << "date,open,high,low,close,volume\n";
+            for (int i = 0; i < static_cast<int>(bar_count); ++i) {
+                int day = i / 390;
+                int minute = 570 + i % 390;
+                double price = 50.0 + f + (i % 500) * 0.01;
+                csv << "2021-" << two_digits(day / 28 % 12 + 1) << '-' << two_digits(day % 28 + 1) << ' ' << two_digits(minute / 60) << ':'
+                    << two_digits(minute % 60) << ',' << price << ',' << price + 0.2 << ',' << price - 0.2 << ',' << price << ','
+                    << 100 + i % 7 << '\n';
+            }
+        }
+        std::ofstream(root / "csv" / "notes.txt") << "not a csv file\n";
+
+        data::storage::StorageParams params;
+        params["source"] = (root / "csv").string();
+        params["storage_path"] = (root / "store").string();
+        params["bar_type"] = std::string("1 min");
+        params["date_format"] = std::string("%Y-%m-%d %H:%M");
+        params["memory_mb"] = 32;
+
+        data::ingest::CsvIngester ingester(params);
+        if (!expect(ingester.prepare(), "the ingester finds the CSV files")) {
+            std::filesystem::remove_all(root);
+            return;
+        }
+        auto stats = ingester.run();
+        if (!expect(stats.has_value(), "the ingest runs")) {
+            std::filesystem::remove_all(root);
+            return;
+        }
+        std::cout << "Ingested " << stats->rows << " rows of " << stats->files << " files (" << stats->failed_files << " failed) in "
+                  << stats->seconds << "s: " << stats->rows / stats->seconds << " rows/s, "
+                  << stats->bytes / stats->seconds / (1024 * 1024) << " MB/s" << std::endl;
+        expect(stats->files == kFiles && stats->failed_files == 0, "every CSV file is ingested, other files are left out");
+        expect(stats->rows == kFiles * bar_count, "every row is ingested");
+
+        data::storage::FileStorage storage;
+        storage.initialize((root / "store").string());
+        auto bars = storage.load_bars("SYM3", data::BarType::Minute, 1);
+        size_t symbols = storage.get_available_symbols().size();
+        std::cout << "SYM3: " << (bars ? bars->size() : 0) << " bars stored (expected " << bar_count << "), " << symbols
+                  << " symbols" << std::endl;
+        expect(bars && bars->size() == bar_count, "the bars of a file are read back");
+        expect(bars && bars->size() > 0 && bars->close.front() == 53.0, "the first bar is stored as written");
+        expect(symbols == kFiles, "one symbol per file");
+
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static constexpr size_t kDefaultBars = 5000;
+
+    static std::string two_digits(int value) {
+        return (value < 10 ? "0" : "") + std::to_string(value);
+    }
+};
+
+// dummy object to register test
+static TestCsvIngester test_csv_ingester;
+
+}
+}
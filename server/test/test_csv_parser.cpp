@@ -0,0 +1,145 @@
+#include "test/test_base.h"
+#include "data/feed/csv_parser.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace quanttrader {
+namespace test {
+
+class TestCsvParser : public TestBase {
+public:
+    TestCsvParser(): TestBase("TestCsvParser") {
+        register_test<TestCsvParser>();
+    }
+
+    // Second bars of a generated file read line by line as CsvDataFeed used to, then with
+    // the parser on 1 and 8 threads. The default row count keeps the test quick, set
+    // QUANTTRADER_BENCH_ROWS (e.g. 2000000) to benchmark.
+    virtual void run() override {
+        size_t rows = kDefaultRows;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            rows = std::strtoull(env_rows, nullptr, 10);
+        }
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_csv_parser";
+        std::filesystem::create_directories(root);
+        std::string csv_path = (root / "TICKS.csv").string();
+        {
+            std::ofstream csv(csv_path);
+            csv << "date,open,high,low,close,volume\n";
+            for (size_t i = 0; i < rows; ++i) {
+                size_t day = i / 23400;
+                size_t second = 34200 + i % 23400;
+                double price = 100.0 + (i % 1000) * 0.01;
+                csv << "2020-" << two_digits(day / 28 % 12 + 1) << '-' << two_digits(day % 28 + 1) << ' ' << two_digits(second / 3600)
+                    << ':' << two_digits(second / 60 % 60) << ':' << two_digits(second % 60) << ',' << price << ','
+                    << price + 0.5 << ',' << price - 0.5 << ',' << price << ',' << (i % 50) * 100 << "\r\n";
+            }
+        }
+        std::cout << "File: " << rows << " rows, " << std::filesystem::file_size(csv_path) / (1024 * 1024) << "MB" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        data::BarSeries baseline = parse_line_by_line(csv_path, "%Y-%m-%d %H:%M:%S");
+        std::cout << "Line by line: " << baseline.start_time.size() << " bars in " << millis_since(start) << "ms" << std::endl;
+        expect(baseline.start_time.size() == rows, "the line by line baseline reads every row");
+
+        data::feed::CsvFormat format;
+        format.date_format = "%Y-%m-%d %H:%M:%S";
+        data::feed::CsvParser parser(format, quanttrader::log::get_common_rotation_logger("TestCsvParser", "test"));
+        for (size_t threads : {1, 8}) {
+            start = std::chrono::steady_clock::now();
+            auto result = parser.parse_file(csv_path, threads);
+            double elapsed = millis_since(start);
+            bool same = result && same_bars(result->bars, baseline);
+            std::cout << "Parser on " << threads << " threads: " << (result ? result->bars.start_time.size() : 0) << " bars in "
+                      << elapsed << "ms, same bars: " << (same ? "yes" : "no") << std::endl;
+            expect(same, "the parser on " + std::to_string(threads) + " threads reads the bars of the baseline");
+        }
+
+        // The default file is too small to be split, with a smaller minimum it is cut into 32
+        // chunks at byte offsets that mostly fall inside a row
+        data::feed::CsvParser small_chunks(format, quanttrader::log::get_common_rotation_logger("TestCsvParser", "test"), 200);
+        auto split = small_chunks.parse_file(csv_path, 8);
+        bool split_same = split && same_bars(split->bars, baseline) && split->skipped == 0 && split->lines == rows + 1;
+        std::cout << "Parser on 8 threads in 32 chunks: same bars: " << (split_same ? "yes" : "no") << std::endl;
+        expect(split_same, "rows straddling the split points are read once, in file order");
+
+        // Fractions of a second, volumes and lines that cannot be parsed
+        std::string text = "date,open,high,low,close,volume\n"
+                           "2020-01-02 09:30:00.250,1,2,0.5,1.5,1200\n"
+                           "2020-01-02 09:30:00.5,1,2,0.5,1.5,0.25\n"
+                           "bad,1,2,0.5,1.5,1\n"
+                           "2020-01-02 09:30:01,1,2\n";
+        auto result = parser.parse(text.data(), text.size(), 1);
+        bool times_ok = result.bars.start_time.size() == 2 && result.bars.start_time[1] - result.bars.start_time[0] == 250000000ULL;
+        bool volumes_ok = result.bars.volume.size() == 2 && result.bars.volume[0] == 0x31C00000000004B0ULL &&
+                          result.bars.volume[1] == ((396ULL << 53) | 25);
+        std::cout << "Fractions: " << (times_ok ? "ok" : "wrong") << ", volumes: " << (volumes_ok ? "ok" : "wrong") << ", skipped "
+                  << result.skipped << " of " << result.lines << " lines (expected 2 of 5)" << std::endl;
+        expect(times_ok, "fractions of a second are parsed");
+        expect(volumes_ok, "volumes are parsed as decimals");
+        expect(result.skipped == 2 && result.lines == 5, "the lines that cannot be parsed are skipped");
+
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static constexpr size_t kDefaultRows = 20000;
+
+    // The baseline has no volumes
+    static bool same_bars(const data::BarSeries& bars, const data::BarSeries& baseline) {
+        return bars.start_time == baseline.start_time && bars.open == baseline.open && bars.high == baseline.high &&
+               bars.low == baseline.low && bars.close == baseline.close;
+    }
+
+    // The former CsvDataFeed parsing
+    static data::BarSeries parse_line_by_line(const std::string& path, const std::string& date_format) {
+        data::BarSeries bars;
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        while (std::getline(file, line)) {
+            std::vector<std::string> tokens;
+            std::stringstream ss(line);
+            std::string token;
+            while (std::getline(ss, token, ',')) {
+                tokens.push_back(token);
+            }
+            if (tokens.size() < 6) {
+                continue;
+            }
+            std::tm tm = {};
+            std::istringstream time_stream(tokens[0]);
+            time_stream >> std::get_time(&tm, date_format.c_str());
+            if (time_stream.fail()) {
+                continue;
+            }
+            uint64_t time_ns = static_cast<uint64_t>(std::mktime(&tm)) * 1000000000ULL;
+            bars.push_back(time_ns, std::stod(tokens[1]), std::stod(tokens[2]), std::stod(tokens[3]), std::stod(tokens[4]), 0,
+                           0, 0);
+        }
+        return bars;
+    }
+
+    static std::string two_digits(size_t value) {
+        return (value < 10 ? "0" : "") + std::to_string(value);
+    }
+
+    static double millis_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestCsvParser test_csv_parser;
+
+}
+}
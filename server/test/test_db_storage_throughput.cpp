@@ -0,0 +1,76 @@
+#include "test/test_base.h"
+#include "data/storage/db_storage.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+class TestDbStorageThroughput : public TestBase {
+public:
+    TestDbStorageThroughput(): TestBase("TestDbStorageThroughput") {
+        register_test<TestDbStorageThroughput>();
+    }
+
+    // Store and load round trips of DbStorage with binary and text decimals. The default row
+    // count keeps the test quick, set QUANTTRADER_BENCH_ROWS (e.g. 10000000) to benchmark.
+    virtual void run() override {
+        constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+        constexpr uint64_t kFirstTime = 1262563200ULL * 1000000000ULL;  // 2010-01-04
+        const std::string kSymbol = "BENCH";
+
+        size_t rows = kDefaultRows;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            rows = std::strtoull(env_rows, nullptr, 10);
+        }
+
+        data::BarSeries bars;
+        bars.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            double price = 100.0 + static_cast<double>(i % 1000) * 0.01;
+            bars.push_back(kFirstTime + i * kMinute, price, price + 0.05, price - 0.05, price, 1000 + i % 7, 0, 10);
+        }
+
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_db_bench";
+        for (const char* format : {"binary", "text"}) {
+            std::filesystem::remove_all(root / format);
+            data::storage::DbStorage storage;
+            storage.configure({{"db_decimal_format", std::string(format)}});
+            storage.initialize((root / format).string());
+
+            auto start = std::chrono::steady_clock::now();
+            bool stored = storage.store_bars(kSymbol, data::BarType::Minute, 1, bars);
+            double store_s = seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            auto loaded = storage.load_bars(kSymbol, data::BarType::Minute, 1);
+            double load_s = seconds_since(start);
+
+            bool same = loaded.has_value() && loaded->start_time == bars.start_time && loaded->open == bars.open &&
+                        loaded->high == bars.high && loaded->low == bars.low && loaded->close == bars.close &&
+                        loaded->wap == bars.wap && loaded->volume == bars.volume && loaded->count == bars.count;
+            std::cout << format << ": stored " << rows << " bars in " << store_s << "s (" << rows / store_s << " rows/s), loaded in "
+                      << load_s << "s (" << rows / load_s << " rows/s), content " << (same ? "ok" : "WRONG") << std::endl;
+            expect(stored, std::string("store bars with ") + format + " decimals");
+            expect(same, std::string("load the stored bars with ") + format + " decimals");
+        }
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static constexpr size_t kDefaultRows = 10000;
+
+    static double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestDbStorageThroughput test_db_storage_throughput;
+
+}
+}
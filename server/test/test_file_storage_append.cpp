@@ -0,0 +1,89 @@
+#include "test/test_base.h"
+#include "data/storage/file_storage.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+class TestFileStorageAppend : public TestBase {
+public:
+    TestFileStorageAppend(): TestBase("TestFileStorageAppend") {
+        register_test<TestFileStorageAppend>();
+    }
+
+    // Nightly refresh: append one session of minute bars to 10 years of history, for every format
+    virtual void run() override {
+        constexpr uint64_t kNanosPerDay = 86400ULL * 1000000000ULL;
+        constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+        constexpr uint64_t kFirstDay = 14613;  // 2010-01-04
+        constexpr uint64_t kHistoryDays = 10 * 365;
+        constexpr uint64_t kRefreshDays = 40;
+        const std::string kSymbol = "BENCH";
+
+        auto make_days = [&](uint64_t first_day, uint64_t days) {
+            data::BarSeries bars;
+            bars.reserve(days * 390);
+            for (uint64_t day = first_day; day < first_day + days; ++day) {
+                uint64_t session_start = day * kNanosPerDay + (14 * 60 + 30) * kMinute;
+                for (uint64_t minute = 0; minute < 390; ++minute) {
+                    double price = 100.0 + static_cast<double>((day * 390 + minute) % 1000) * 0.01;
+                    bars.push_back(session_start + minute * kMinute, price, price + 0.05, price - 0.05, price, 1000, 0, 10);
+                }
+            }
+            return bars;
+        };
+
+        data::BarSeries history = make_days(kFirstDay, kHistoryDays);
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_append_bench";
+        std::filesystem::remove_all(root);
+
+        for (const char* format : {"columnar", "chunked", "legacy"}) {
+            data::storage::FileStorage storage;
+            storage.configure({{"storage_format", std::string(format)}});
+            storage.initialize((root / format).string());
+            storage.store_bars(kSymbol, data::BarType::Minute, 1, history);
+
+            size_t expected = history.size();
+            double total_ms = 0.0;
+            double worst_ms = 0.0;
+            for (uint64_t day = 0; day < kRefreshDays; ++day) {
+                // Every refresh downloads the last two sessions again, only one is new
+                data::BarSeries refresh = make_days(kFirstDay + kHistoryDays + day - 1, 2);
+                auto start = std::chrono::steady_clock::now();
+                if (!storage.append_bars(kSymbol, data::BarType::Minute, 1, refresh)) {
+                    std::cout << format << ": append failed on day " << day << std::endl;
+                    return;
+                }
+                double ms = seconds_since(start) * 1000.0;
+                total_ms += ms;
+                worst_ms = std::max(worst_ms, ms);
+                expected += 390;
+            }
+            storage.compact(kSymbol, data::BarType::Minute, 1);
+
+            auto loaded = storage.load_bars(kSymbol, data::BarType::Minute, 1);
+            size_t loaded_count = loaded ? loaded->size() : 0;
+            bool sorted = loaded && std::is_sorted(loaded->start_time.begin(), loaded->start_time.end());
+            std::cout << format << ": " << kRefreshDays << " appends, average " << total_ms / kRefreshDays << "ms, worst "
+                      << worst_ms << "ms, " << loaded_count << " bars loaded"
+                      << (loaded_count == expected && sorted ? "" : " (unexpected content)") << std::endl;
+        }
+
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestFileStorageAppend test_file_storage_append;
+
+}
+}
@@ -0,0 +1,90 @@
+#include "test/test_base.h"
+#include "data/storage/file_storage.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+class TestFileStorageRange : public TestBase {
+public:
+    TestFileStorageRange(): TestBase("TestFileStorageRange") {
+        register_test<TestFileStorageRange>();
+    }
+
+    // Load latency against range width on 15 years of regular session minute bars
+    virtual void run() override {
+        constexpr uint64_t kNanosPerDay = 86400ULL * 1000000000ULL;
+        constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+        constexpr uint64_t kFirstDay = 14613;  // 2010-01-04
+        constexpr uint64_t kDays = 15 * 365;
+        const std::string kSymbol = "BENCH";
+
+        data::BarSeries bars;
+        bars.reserve(kDays * 390);
+        for (uint64_t day = kFirstDay; day < kFirstDay + kDays; ++day) {
+            uint64_t weekday = (day + 4) % 7;  // 1970-01-01 was a Thursday
+            if (weekday == 0 || weekday == 6) {
+                continue;
+            }
+            uint64_t session_start = day * kNanosPerDay + (14 * 60 + 30) * kMinute;
+            for (uint64_t minute = 0; minute < 390; ++minute) {
+                double price = 100.0 + static_cast<double>((day * 390 + minute) % 1000) * 0.01;
+                bars.push_back(session_start + minute * kMinute, price, price + 0.05, price - 0.05, price, 1000, 0, 10);
+            }
+        }
+
+        auto root = std::filesystem::temp_directory_path() / "quanttrader_range_bench";
+        std::filesystem::remove_all(root);
+
+        data::storage::FileStorage chunked;
+        chunked.configure({{"storage_format", std::string("chunked")}});
+        chunked.initialize((root / "chunked").string());
+        data::storage::FileStorage legacy;
+        legacy.configure({{"storage_format", std::string("legacy")}});
+        legacy.initialize((root / "legacy").string());
+
+        auto start = std::chrono::steady_clock::now();
+        chunked.store_bars(kSymbol, data::BarType::Minute, 1, bars);
+        std::cout << "Stored " << bars.size() << " bars chunked in " << seconds_since(start) << "s" << std::endl;
+        start = std::chrono::steady_clock::now();
+        legacy.store_bars(kSymbol, data::BarType::Minute, 1, bars);
+        std::cout << "Stored " << bars.size() << " bars legacy in " << seconds_since(start) << "s" << std::endl;
+
+        uint64_t last_time = bars.start_time.back();
+        const std::pair<const char*, uint64_t> widths[] = {
+            {"1 day", 1}, {"2 weeks", 14}, {"3 months", 91}, {"1 year", 365}, {"5 years", 5 * 365}, {"15 years", kDays}};
+        for (const auto& [name, days] : widths) {
+            uint64_t range_start = last_time - days * kNanosPerDay;
+
+            start = std::chrono::steady_clock::now();
+            auto from_chunks = chunked.load_bars(kSymbol, data::BarType::Minute, 1, range_start, last_time);
+            double chunked_ms = seconds_since(start) * 1000.0;
+
+            start = std::chrono::steady_clock::now();
+            auto from_legacy = legacy.load_bars(kSymbol, data::BarType::Minute, 1, range_start, last_time);
+            double legacy_ms = seconds_since(start) * 1000.0;
+
+            size_t chunked_count = from_chunks ? from_chunks->size() : 0;
+            size_t legacy_count = from_legacy ? from_legacy->size() : 0;
+            std::cout << name << ": " << chunked_count << " bars, chunked " << chunked_ms << "ms, legacy " << legacy_ms << "ms"
+                      << (chunked_count == legacy_count ? "" : " (bar counts differ)") << std::endl;
+        }
+
+        std::filesystem::remove_all(root);
+    }
+
+private:
+    static double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestFileStorageRange test_file_storage_range;
+
+}
+}
@@ -0,0 +1,157 @@
+#include "test/test_base.h"
+#include "data/resampler/data_resampler.h"
+#include "data/resampler/multi_resampler.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kStartTime = 1704067200ULL * 1000000000ULL;  // 2024-01-01 00:00:00 UTC
+constexpr uint64_t kSecond = 1000000000ULL;
+
+class SecondBars : public data::provider::DataProvider {
+public:
+    SecondBars(size_t bar_count, bool live) : DataProvider("seconds", nullptr), bar_count_(bar_count), live_(live) {
+        symbol_ = "TEST";
+        bar_type_ = data::BarType::Second;
+        bar_size_ = 1;
+        timezone_ = "UTC";
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(0, bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        data::BarSeries bars;
+        bars.reserve(bar_count_);
+        for (size_t i = 0; i < bar_count_; ++i) {
+            double price = 100.0 + static_cast<double>((i * 7919) % 1000) * 0.01;
+            bars.push_back(kStartTime + i * kSecond, price, price + 0.5, price - 0.5, price + 0.25, 10, 0, 1);
+        }
+        bar_line_->append_batch(std::move(bars));
+        mark_data_ready();
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    bool is_live() const override { return live_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+private:
+    size_t bar_count_ = 0;
+    bool live_ = false;
+};
+
+bool same_bar(const data::BarStruct& a, const data::BarStruct& b) {
+    return a.time == b.time && a.open == b.open && a.high == b.high && a.low == b.low && a.close == b.close &&
+           a.volume == b.volume && a.count == b.count;
+}
+
+}
+
+class TestMultiResampler : public TestBase {
+public:
+    TestMultiResampler(): TestBase("TestMultiResampler") {
+        register_test<TestMultiResampler>();
+    }
+
+    // Second bars to 1 min, 5 mins, 15 mins, 1 hour and 1 day: one DataResampler per
+    // timeframe reads the source five times, the MultiResampler once with 5 mins built from
+    // 1 min and so on. The feeds are read round robin as the replay loop does. The default
+    // bar count keeps the test quick, set QUANTTRADER_BENCH_ROWS (e.g. 2000000) to benchmark.
+    virtual void run() override {
+        size_t bar_count = kDefaultBars;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            bar_count = std::strtoull(env_rows, nullptr, 10);
+        }
+        const std::vector<std::pair<data::BarType, unsigned int>> targets = {
+            {data::BarType::Minute, 1}, {data::BarType::Minute, 5}, {data::BarType::Minute, 15},
+            {data::BarType::Hour, 1}, {data::BarType::Day, 1}};
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<data::provider::DataProvider>> separate;
+        for (const auto& target : targets) {
+            auto source = std::make_shared<SecondBars>(bar_count, false);
+            source->prepare_data();
+            auto resampler = std::make_shared<data::resampler::DataResampler>(source, target.first, target.second);
+            resampler->prepare_data();
+            separate.push_back(resampler);
+        }
+        auto separate_bars = drain(separate);
+        double separate_ms = millis_since(start);
+
+        start = std::chrono::steady_clock::now();
+        auto source = std::make_shared<SecondBars>(bar_count, false);
+        source->prepare_data();
+        auto feeds = data::resampler::MultiResampler::create(source, targets);
+        auto multi_bars = drain({feeds.begin(), feeds.end()});
+        double multi_ms = millis_since(start);
+
+        bool identical = separate_bars.size() == multi_bars.size();
+        for (size_t i = 0; identical && i < separate_bars.size(); ++i) {
+            identical = separate_bars[i].size() == multi_bars[i].size();
+            for (size_t j = 0; identical && j < separate_bars[i].size(); ++j) {
+                identical = same_bar(separate_bars[i][j], multi_bars[i][j]);
+            }
+        }
+        std::cout << "Separate resamplers: " << separate_ms << "ms, one pass: " << multi_ms << "ms, bars per timeframe:";
+        for (const auto& bars : multi_bars) {
+            std::cout << " " << bars.size();
+        }
+        std::cout << ", " << (identical ? "identical" : "DIFFERENT") << std::endl;
+        expect(identical && !multi_bars.front().empty(), "one pass gives the bars of the separate resamplers");
+
+        // A live source: the 5 mins bar in progress includes the 1 min bar in progress
+        auto live = std::make_shared<SecondBars>(150, true);
+        live->prepare_data();
+        auto live_feeds = data::resampler::MultiResampler::create(live, {{data::BarType::Minute, 1}, {data::BarType::Minute, 5}});
+        live_feeds[0]->start_request_data();
+        live_feeds[1]->start_request_data();
+        bool five_held = !live_feeds[1]->next().has_value();
+        auto partial = live_feeds[1]->get_partial_bar();
+        std::cout << "Live: 5 mins " << (five_held ? "held" : "served") << ", partial of " << (partial ? partial->count : 0)
+                  << " seconds (expected 150)" << std::endl;
+        expect(five_held, "a live 5 mins bar in progress is held");
+        expect(partial.has_value() && partial->count == 150, "the partial 5 mins bar includes the 1 min bar in progress");
+    }
+
+private:
+    static constexpr size_t kDefaultBars = 200000;
+
+    static std::vector<std::vector<data::BarStruct>> drain(const std::vector<std::shared_ptr<data::provider::DataProvider>>& feeds) {
+        std::vector<std::vector<data::BarStruct>> bars(feeds.size());
+        for (const auto& feed : feeds) {
+            feed->start_request_data();
+        }
+        bool more = true;
+        while (more) {
+            more = false;
+            for (size_t i = 0; i < feeds.size(); ++i) {
+                auto bar = feeds[i]->next();
+                if (bar.has_value()) {
+                    bars[i].push_back(bar.value());
+                    more = true;
+                }
+            }
+        }
+        return bars;
+    }
+
+    static double millis_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestMultiResampler test_multi_resampler;
+
+}
+}
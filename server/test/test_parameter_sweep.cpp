@@ -0,0 +1,187 @@
+#include "test/test_base.h"
+#include "cerebro/optimize/parameter_sweep.h"
+#include "strategy/strategy_factory.h"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kStartTime = 1104537600ULL * 1000000000ULL;  // 2005-01-03 00:00:00 UTC
+constexpr uint64_t kDay = 86400ULL * 1000000000ULL;
+
+// Daily bars of a trending, cycling price, counts how often it is loaded
+class CyclingBars : public data::provider::DataProvider {
+public:
+    CyclingBars(size_t days, std::atomic<size_t>& loads)
+        : DataProvider("daily_TEST", std::make_shared<std::unordered_map<std::string, std::any>>()), days_(days), loads_(loads) {
+        symbol_ = "TEST";
+        bar_type_ = data::BarType::Day;
+        bar_size_ = 1;
+        timezone_ = "UTC";
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(0, bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        ++loads_;
+        data::BarSeries bars;
+        for (size_t day = 0; day < days_; ++day) {
+            double price = 100.0 + day * 0.02 + 10.0 * std::sin(day / 15.0) + 4.0 * std::sin(day / 4.0);
+            bars.push_back(kStartTime + day * kDay, price, price + 1.0, price - 1.0, price, 1000, 0, 1);
+        }
+        bar_line_->append_batch(std::move(bars));
+        mark_data_ready();
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+private:
+    size_t days_ = 0;
+    std::atomic<size_t>& loads_;
+};
+
+// Long while the fast moving average is above the slow one
+class CrossStrategy : public strategy::StrategyBase {
+public:
+    explicit CrossStrategy(strategy::StrategyCreateFuncParemType& params)
+        : StrategyBase(params), fast_(get_param<int>("fast_period", 5)), slow_(get_param<int>("slow_period", 20)) {}
+
+    void on_bar(const std::string& data_name, const data::BarSeriesView& bar_series, bool, bool, bool) override {
+        size_t count = bar_series.close.size();
+        if (fast_ <= 0 || slow_ <= 0 || count < static_cast<size_t>(std::max(fast_, slow_))) {
+            return;
+        }
+        bool above = average(bar_series, fast_) > average(bar_series, slow_);
+        if (above && !long_) {
+            buy(symbol_, 100);
+            long_ = true;
+        } else if (!above && long_) {
+            sell(symbol_, 100);
+            long_ = false;
+        }
+    }
+
+protected:
+    void next() override {}
+
+private:
+    static double average(const data::BarSeriesView& bar_series, int period) {
+        double sum = 0.0;
+        for (size_t i = bar_series.close.size() - period; i < bar_series.close.size(); ++i) {
+            sum += bar_series.close[i];
+        }
+        return sum / period;
+    }
+
+    int fast_ = 5;
+    int slow_ = 20;
+    bool long_ = false;
+};
+
+}
+
+class TestParameterSweep : public TestBase {
+public:
+    TestParameterSweep(): TestBase("TestParameterSweep") {
+        register_test<TestParameterSweep>();
+    }
+
+    virtual void run() override {
+        strategy::StrategyFactory::register_strategy("sweep_cross", [](strategy::StrategyCreateFuncParemType& params) {
+            return std::make_shared<CrossStrategy>(params);
+        });
+
+        // Ten years of days over a grid of 10 x 5 points, on one thread and on all of them
+        size_t hardware = std::max<unsigned int>(std::thread::hardware_concurrency(), 1);
+        auto serial = sweep(1);
+        auto parallel = sweep(static_cast<int>(hardware));
+        if (!expect(serial.stats && parallel.stats && !parallel.results.empty(), "the sweep runs")) {
+            return;
+        }
+
+        // Every point has the same metrics whichever thread ran it
+        size_t mismatches = 0;
+        std::vector<const cerebro::optimize::SweepResult*> by_point(serial.results.size(), nullptr);
+        for (const auto& result : serial.results) {
+            by_point[result.point] = &result;
+        }
+        for (const auto& result : parallel.results) {
+            const auto* expected = by_point[result.point];
+            if (!expected || !result.completed || result.values != expected->values ||
+                result.summary.total_profit != expected->summary.total_profit ||
+                result.summary.max_drawdown != expected->summary.max_drawdown ||
+                result.summary.total_trades != expected->summary.total_trades) {
+                ++mismatches;
+            }
+        }
+        bool ranked = std::is_sorted(parallel.results.begin(), parallel.results.end(), [](const auto& a, const auto& b) {
+            return a.summary.total_profit > b.summary.total_profit;
+        });
+
+        const auto& best = parallel.results.front();
+        std::cout << "Points: " << parallel.stats->points << " (expected 50), failed: " << parallel.stats->failed
+                  << ", mismatches between 1 and " << parallel.stats->threads << " threads: " << mismatches
+                  << ", ranked by profit: " << (ranked ? "ok" : "WRONG") << std::endl;
+        std::cout << "Data loaded " << serial.loads << " and " << parallel.loads << " times (expected once per sweep), "
+                  << parallel.stats->bars << " shared bars" << std::endl;
+        std::cout << "Best fast_period " << best.values[0] << ", slow_period " << best.values[1] << ": profit "
+                  << best.summary.total_profit << " in " << best.summary.total_trades << " trades" << std::endl;
+        std::cout << "1 thread: " << serial.stats->seconds << "s, " << parallel.stats->threads << " threads: "
+                  << parallel.stats->seconds << "s, speedup " << serial.stats->seconds / std::max(parallel.stats->seconds, 1e-9)
+                  << std::endl;
+        expect(parallel.stats->points == 50 && parallel.stats->failed == 0 && parallel.results.size() == 50,
+               "every point of the grid runs");
+        expect(mismatches == 0, "every point has the same metrics on 1 and on all threads");
+        expect(ranked, "the results are ranked by profit");
+        expect(serial.loads == 1 && parallel.loads == 1, "the data is loaded once per sweep");
+        expect(parallel.stats->bars == kDays, "the points share the bars of the source");
+        expect(best.summary.total_trades > 0, "the best point trades");
+    }
+
+private:
+    static constexpr size_t kDays = 2520;
+
+    struct Outcome {
+        std::optional<cerebro::optimize::SweepStats> stats;
+        std::vector<cerebro::optimize::SweepResult> results;
+        size_t loads = 0;
+    };
+
+    Outcome sweep(int threads) {
+        std::atomic<size_t> loads {0};
+        cerebro::optimize::SweepOptions options {{"threads", threads},
+                                                 {"grid.fast_period", std::string("2:20:2")},
+                                                 {"grid.slow_period", std::string("20:60:10")}};
+        cerebro::optimize::ParameterSweep sweep(options);
+        auto source = std::make_shared<CyclingBars>(kDays, loads);
+        source->prepare_data();
+        sweep.add_data(source);
+        sweep.set_strategy("sweep_cross", {{"strategy_name", std::string("sweep_cross")}, {"symbol", std::string("TEST")}});
+
+        Outcome outcome;
+        if (sweep.prepare()) {
+            outcome.stats = sweep.run();
+            outcome.results = sweep.get_results();
+        }
+        outcome.loads = loads;
+        return outcome;
+    }
+};
+
+// dummy object to register test
+static TestParameterSweep test_parameter_sweep;
+
+}
+}
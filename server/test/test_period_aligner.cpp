@@ -0,0 +1,152 @@
+#include "test/test_base.h"
+#include "time/period_aligner.h"
+#include "data/resampler/data_resampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kSecond = 1000000000ULL;
+constexpr uint64_t kMinute = 60 * kSecond;
+constexpr uint64_t kDay = 86400 * kSecond;
+constexpr uint64_t kStartDay = 1709769600ULL * kSecond;  // 2024-03-07 00:00:00 UTC, Thursday
+
+// 1 min bars of New York trading days from 04:00 to 20:00, the pre and post market included
+class ExtendedHoursBars : public data::provider::DataProvider {
+public:
+    ExtendedHoursBars(size_t days)
+        : DataProvider("extended", std::make_shared<std::unordered_map<std::string, std::any>>()), days_(days) {
+        symbol_ = "TEST";
+        bar_type_ = data::BarType::Minute;
+        bar_size_ = 1;
+        timezone_ = "America/New_York";
+        (*params_)[data::DATA_SESSION_START_NAME] = std::string("09:30:00");
+        (*params_)[data::DATA_SESSION_END_NAME] = std::string("16:00:00");
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(0, bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        data::BarSeries bars;
+        for (size_t day = 0; day < days_; ++day) {
+            uint64_t midnight = kStartDay + day * kDay;
+            // 04:00 in New York is 09:00 UTC before 2024-03-10 and 08:00 UTC after
+            uint64_t open = midnight + (midnight < 1710028800ULL * kSecond ? 9 : 8) * 60 * kMinute;
+            for (uint64_t minute = 0; minute < 16 * 60; ++minute) {
+                bars.push_back(open + minute * kMinute, 100.0, 101.0, 99.0, 100.5, 10, 0, 1);
+            }
+        }
+        bar_line_->append_batch(std::move(bars));
+        mark_data_ready();
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+private:
+    size_t days_ = 0;
+};
+
+// The previous alignment: gmtime_r then mktime in the host time zone
+uint64_t mktime_align_to_day(uint64_t time_ns) {
+    time_t seconds = static_cast<time_t>(time_ns / kSecond);
+    std::tm cal_time = {};
+#ifdef _WIN32
+    gmtime_s(&cal_time, &seconds);
+#else
+    gmtime_r(&seconds, &cal_time);
+#endif
+    cal_time.tm_hour = 0;
+    cal_time.tm_min = 0;
+    cal_time.tm_sec = 0;
+    return static_cast<uint64_t>(std::mktime(&cal_time)) * kSecond;
+}
+
+double nanos_per_call(std::chrono::steady_clock::time_point start, size_t calls) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+}
+
+class TestPeriodAligner : public TestBase {
+public:
+    TestPeriodAligner(): TestBase("TestPeriodAligner") {
+        register_test<TestPeriodAligner>();
+    }
+
+    virtual void run() override {
+        // Six days around the DST switch of 2024-03-10 with pre and post market bars
+        auto source = std::make_shared<ExtendedHoursBars>(6);
+        source->prepare_data();
+        data::resampler::DataResampler resampler(source, data::BarType::Day, 1);
+        resampler.prepare_data();
+        resampler.start_request_data();
+        bool stamps_ok = true;
+        size_t days = 0;
+        for (auto bar = resampler.next(); bar.has_value(); bar = resampler.next()) {
+            // 09:30 in New York, 14:30 UTC before the switch and 13:30 UTC after
+            uint64_t midnight = kStartDay + days * kDay;
+            uint64_t expected = midnight + (midnight < 1710028800ULL * kSecond ? 14 : 13) * 60 * kMinute + 30 * kMinute;
+            stamps_ok = stamps_ok && bar->time == expected && bar->count == 390;
+            ++days;
+        }
+        std::cout << "Daily bars: " << days << " (expected 6), stamped at 09:30 New York with 390 session minutes: "
+                  << (stamps_ok ? "ok" : "WRONG") << std::endl;
+        expect(days == 6, "one daily bar per trading day");
+        expect(stamps_ok, "daily bars start at the session open and hold the session minutes only");
+
+        // A session over midnight, the bars from Sunday 18:00 belong to Monday
+        time::PeriodAligner futures("America/New_York", "18:00:00", "17:00:00");
+        uint64_t sunday_evening = 1710108000ULL * kSecond;  // 2024-03-10 18:00 EDT
+        auto range = futures.align(sunday_evening, time::PeriodAligner::Period::Day);
+        bool in_session = futures.in_session(sunday_evening);
+        std::cout << "Overnight session: Sunday 18:00 in trading day from " << range.start / kSecond << " to " << range.end / kSecond
+                  << " (expected 1710108000 to 1710194400), in session " << in_session << std::endl;
+        expect(range.start == 1710108000ULL * kSecond && range.end == 1710194400ULL * kSecond,
+               "the bars from Sunday 18:00 belong to the Monday session");
+        expect(in_session, "Sunday 18:00 is in the overnight session");
+
+        // Alignment cost per bar over a month of minutes, set QUANTTRADER_BENCH_ROWS (e.g. 525600
+        // for a year) to benchmark
+        size_t calls = kDefaultCalls;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            calls = std::max<size_t>(std::strtoull(env_rows, nullptr, 10), 1);
+        }
+        uint64_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < calls; ++i) {
+            sink += mktime_align_to_day(kStartDay + i * kMinute);
+        }
+        double mktime_ns = nanos_per_call(start, calls);
+
+        time::PeriodAligner aligner("America/New_York", "09:30:00", "16:00:00");
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < calls; ++i) {
+            sink += aligner.align(kStartDay + i * kMinute, time::PeriodAligner::Period::Day).start;
+        }
+        double aligner_ns = nanos_per_call(start, calls);
+        std::cout << "Day alignment: gmtime/mktime " << mktime_ns << "ns, aligner " << aligner_ns << "ns per bar (" << sink % 10
+                  << ")" << std::endl;
+    }
+
+private:
+    static constexpr size_t kDefaultCalls = 43200;
+};
+
+// dummy object to register test
+static TestPeriodAligner test_period_aligner;
+
+}
+}
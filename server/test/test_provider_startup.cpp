@@ -0,0 +1,108 @@
+#include "test/test_base.h"
+#include "data/common/data_provider.h"
+#include "data/replay/data_replay_controller.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace quanttrader {
+namespace test {
+
+// Spends its start in blocking I/O, like a CSV or storage feed, and is ready when the start returns
+class BlockingStartFeed : public data::provider::DataProvider {
+public:
+    BlockingStartFeed(const std::string& name, std::chrono::milliseconds io_time, std::chrono::milliseconds ready_delay)
+        : DataProvider(name, nullptr), io_time_(io_time), ready_delay_(ready_delay) {
+        symbol_ = name;
+        timezone_ = "UTC";
+    }
+
+    ~BlockingStartFeed() override {
+        if (ready_thread_.joinable()) {
+            ready_thread_.join();
+        }
+    }
+
+    bool prepare_data() override { return true; }
+
+    bool start_request_data() override {
+        std::this_thread::sleep_for(io_time_);
+        if (ready_delay_.count() == 0) {
+            mark_data_ready();
+        } else {
+            // Data that arrives later on another thread, like a broker response
+            ready_thread_ = std::thread([this]() {
+                std::this_thread::sleep_for(ready_delay_);
+                mark_data_ready();
+            });
+        }
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<data::BarStruct> next() override { return std::nullopt; }
+
+private:
+    std::chrono::milliseconds io_time_;
+    std::chrono::milliseconds ready_delay_;
+    std::thread ready_thread_;
+};
+
+class TestProviderStartup : public TestBase {
+public:
+    TestProviderStartup(): TestBase("TestProviderStartup") {
+        register_test<TestProviderStartup>();
+    }
+
+    // Startup of 40 feeds with 10ms of I/O each, one after another and on a pool, then the wait
+    // for a feed whose data arrives 150ms after its start
+    virtual void run() override {
+        constexpr size_t kFeeds = 40;
+        double serial_ms = 0.0;
+        for (size_t threads : {1, 8, 32}) {
+            data::replay::DataReplayController controller;
+            controller.set_start_threads(threads);
+            for (size_t i = 0; i < kFeeds; ++i) {
+                std::string name = "feed_" + std::to_string(i);
+                controller.add_data_provider(name, std::make_shared<BlockingStartFeed>(name, std::chrono::milliseconds(10),
+                                                                                       std::chrono::milliseconds(0)));
+            }
+            auto start = std::chrono::steady_clock::now();
+            bool started = controller.start();
+            bool ready = controller.wait_all_data_ready(std::chrono::milliseconds(60000));
+            double elapsed = millis_since(start);
+            std::cout << kFeeds << " feeds on " << threads << " threads: ready in " << elapsed << "ms"
+                      << (started && ready ? "" : " (failed)") << std::endl;
+            expect(started && ready, std::to_string(kFeeds) + " feeds on " + std::to_string(threads) + " threads get ready");
+            if (threads == 1) {
+                serial_ms = elapsed;
+            } else {
+                expect(elapsed < serial_ms / 2, "the feeds start in parallel on " + std::to_string(threads) + " threads");
+            }
+        }
+
+        data::replay::DataReplayController controller;
+        controller.add_data_provider("late", std::make_shared<BlockingStartFeed>("late", std::chrono::milliseconds(0),
+                                                                                 std::chrono::milliseconds(150)));
+        auto start = std::chrono::steady_clock::now();
+        controller.start();
+        bool ready = controller.wait_all_data_ready(std::chrono::milliseconds(10000));
+        double waited = millis_since(start);
+        std::cout << "Feed ready after 150ms, wait returned after " << waited << "ms" << (ready ? "" : " (timed out)") << std::endl;
+        expect(ready && waited >= 150.0 && waited < 5000.0, "the wait returns when the late feed gets ready");
+    }
+
+private:
+    static double millis_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestProviderStartup test_provider_startup;
+
+}
+}
@@ -0,0 +1,150 @@
+#include "test/test_base.h"
+#include "cerebro/cerebro_base.h"
+#include "data/common/data_provider.h"
+#include "strategy/strategy_base.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+// Counter of the current thread's allocations, only set while an AllocationCountScope is alive.
+// Other threads and code outside the scope only pay for reading it.
+thread_local uint64_t* t_allocation_counter = nullptr;
+
+class AllocationCountScope {
+public:
+    explicit AllocationCountScope(uint64_t& counter) : previous_(t_allocation_counter) {
+        t_allocation_counter = &counter;
+    }
+    ~AllocationCountScope() {
+        t_allocation_counter = previous_;
+    }
+
+private:
+    uint64_t* previous_;
+};
+}
+
+void* operator new(std::size_t size) {
+    if (t_allocation_counter) {
+        ++*t_allocation_counter;
+    }
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace quanttrader {
+namespace test {
+
+// In-memory minute bars, no file or network access
+class SyntheticFeed : public data::provider::DataProvider {
+public:
+    SyntheticFeed(const std::string& symbol, size_t bar_count)
+        : DataProvider(symbol, nullptr), bar_count_(bar_count) {
+        symbol_ = symbol;
+        bar_type_ = data::BarType::Minute;
+        bar_size_ = 1;
+        timezone_ = "UTC";
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(static_cast<unsigned int>(bar_count_), bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        constexpr uint64_t kStartTime = 1704067200ULL * 1000000000ULL;  // 2024-01-01 00:00:00 UTC
+        constexpr uint64_t kMinute = 60ULL * 1000000000ULL;
+        for (size_t i = 0; i < bar_count_; ++i) {
+            double price = 100.0 + static_cast<double>(i % 100) * 0.01;
+            bar_line_->push_data(kStartTime + i * kMinute, price, price + 0.5, price - 0.5, price, 100, 0, 1);
+        }
+        data_ready_ = true;
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+private:
+    size_t bar_count_ = 0;
+};
+
+class IdleStrategy : public strategy::StrategyBase {
+public:
+    IdleStrategy() : StrategyBase(strategy::StrategyCreateFuncParemType{{"strategy_name", std::string("idle")}}) {}
+    void next() override {}
+};
+
+class ThroughputCerebro : public cerebro::CerebroBase {
+public:
+    ThroughputCerebro() : CerebroBase("replay_throughput") {}
+    bool step() { return process_next(); }
+};
+
+class TestReplayThroughput : public TestBase {
+public:
+    TestReplayThroughput(): TestBase("TestReplayThroughput") {
+        register_test<TestReplayThroughput>();
+    }
+
+    virtual void run() override {
+        constexpr size_t kSymbols = 500;
+        constexpr size_t kBarsPerSymbol = 2000;
+        constexpr size_t kWarmupSteps = 10;
+
+        ThroughputCerebro cerebro;
+        for (size_t i = 0; i < kSymbols; ++i) {
+            auto feed = std::make_shared<SyntheticFeed>("SYM" + std::to_string(i), kBarsPerSymbol);
+            feed->prepare_data();
+            cerebro.add_data(feed->get_symbol(), feed);
+        }
+        cerebro.add_strategy(std::make_shared<IdleStrategy>());
+
+        if (!expect(cerebro.prepare(), "cerebro prepares the synthetic feeds")) {
+            return;
+        }
+
+        // The first steps create the per-feed series, measure the steady state afterwards
+        for (size_t i = 0; i < kWarmupSteps; ++i) {
+            cerebro.step();
+        }
+
+        uint64_t steps = 0;
+        uint64_t allocations = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            AllocationCountScope scope(allocations);
+            while (cerebro.step()) {
+                ++steps;
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double bars = static_cast<double>(steps * kSymbols);
+        std::cout << "Replayed " << steps << " steps of " << kSymbols << " symbols in " << elapsed << "s" << std::endl;
+        std::cout << "Bars per second: " << (elapsed > 0 ? bars / elapsed : 0.0) << std::endl;
+        std::cout << "Heap allocations per step: " << (steps ? static_cast<double>(allocations) / steps : 0.0) << std::endl;
+        expect(steps > 0, "replay steps after the warmup");
+        expect(allocations == 0, "no heap allocations in the steady state replay loop");
+    }
+};
+
+// dummy object to register test
+static TestReplayThroughput test_replay_throughput;
+
+}
+}
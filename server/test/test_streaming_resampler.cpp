@@ -0,0 +1,172 @@
+#include "test/test_base.h"
+#include "data/resampler/data_resampler.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kStartTime = 1704067200ULL * 1000000000ULL;  // 2024-01-01 00:00:00 UTC
+constexpr uint64_t kSecond = 1000000000ULL;
+
+// Second bars in memory; a live feed gets its bars pushed while it is read
+class SecondFeed : public data::provider::DataProvider {
+public:
+    SecondFeed(size_t bar_count, bool live) : DataProvider("seconds", nullptr), bar_count_(bar_count), live_(live) {
+        symbol_ = "TEST";
+        bar_type_ = data::BarType::Second;
+        bar_size_ = 1;
+        timezone_ = "UTC";
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(0, bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        data::BarSeries bars;
+        bars.reserve(bar_count_);
+        for (size_t i = 0; i < bar_count_; ++i) {
+            bars.push_back(kStartTime + i * kSecond, price(i), price(i) + 0.5, price(i) - 0.5, price(i) + 0.25, 10, 0, 1);
+        }
+        bar_line_->append_batch(std::move(bars));
+        mark_data_ready();
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    bool is_live() const override { return live_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+    void push(size_t i) {
+        bar_line_->push_data(kStartTime + i * kSecond, price(i), price(i) + 0.5, price(i) - 0.5, price(i) + 0.25, 10, 0, 1);
+        notify_data_listener();
+    }
+
+    static double price(size_t i) { return 100.0 + static_cast<double>((i * 7919) % 1000) * 0.01; }
+
+private:
+    size_t bar_count_ = 0;
+    bool live_ = false;
+};
+
+}
+
+class TestStreamingResampler : public TestBase {
+public:
+    TestStreamingResampler(): TestBase("TestStreamingResampler") {
+        register_test<TestStreamingResampler>();
+    }
+
+    virtual void run() override {
+        run_historical();
+        run_live();
+        run_seek();
+    }
+
+private:
+    // 2M second bars to 1 min: the first bar is served right away and every minute is
+    // checked against the source bars it covers
+    static void run_historical() {
+        constexpr size_t kBars = 2000000;
+        auto source = std::make_shared<SecondFeed>(kBars, false);
+        source->prepare_data();
+        data::resampler::DataResampler resampler(source, data::BarType::Minute, 1);
+        resampler.prepare_data();
+
+        auto start = std::chrono::steady_clock::now();
+        resampler.start_request_data();
+        auto first = resampler.next();
+        double first_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        size_t served = first.has_value() ? 1 : 0;
+        bool values_ok = first.has_value() && check_minute(first.value(), 0, kBars);
+        std::optional<data::BarStruct> bar;
+        while ((bar = resampler.next()).has_value()) {
+            values_ok = values_ok && check_minute(bar.value(), served, kBars);
+            ++served;
+        }
+        double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Historical: " << served << " minutes (expected " << (kBars + 59) / 60 << "), first after " << first_ms
+                  << "ms, all in " << total_ms << "ms, " << total_ms * 1e6 / kBars << "ns per source bar, values "
+                  << (values_ok ? "ok" : "wrong") << std::endl;
+
+        resampler.rewind();
+        size_t replayed = 0;
+        while (resampler.next().has_value()) {
+            ++replayed;
+        }
+        std::cout << "Replayed after rewind: " << replayed << std::endl;
+    }
+
+    // Bars pushed one by one: a minute is served when the next one starts, the partial
+    // bar follows the pushed bars in between
+    static void run_live() {
+        auto source = std::make_shared<SecondFeed>(0, true);
+        source->prepare_data();
+        data::resampler::DataResampler resampler(source, data::BarType::Minute, 1);
+        resampler.prepare_data();
+        resampler.start_request_data();
+
+        size_t early = 0;
+        for (size_t i = 0; i < 90; ++i) {
+            source->push(i);
+            if (resampler.next().has_value()) {
+                ++early;
+            }
+        }
+        auto partial = resampler.get_partial_bar();
+        bool partial_ok = partial.has_value() && partial->time == kStartTime + 60 * kSecond &&
+                          partial->close == SecondFeed::price(89) + 0.25 && partial->count == 30;
+        std::cout << "Live: " << early << " minute served in 90 seconds, partial "
+                  << (partial_ok ? "ok" : "wrong") << ", pending " << (resampler.next().has_value() ? "served" : "held")
+                  << std::endl;
+    }
+
+    // Seeking ahead of the periods read so far builds them from the source, the earlier
+    // periods stay in the view as history
+    void run_seek() {
+        constexpr size_t kBars = 6000;
+        constexpr size_t kMinute = 40;
+        auto source = std::make_shared<SecondFeed>(kBars, false);
+        source->prepare_data();
+        data::resampler::DataResampler resampler(source, data::BarType::Minute, 1);
+        resampler.prepare_data();
+        resampler.start_request_data();
+
+        bool sought = resampler.seek(kStartTime + kMinute * 60 * kSecond);
+        auto bar = resampler.next();
+        bool bar_ok = bar.has_value() && check_minute(bar.value(), kMinute, kBars);
+        bool history_ok = resampler.get_bar_view(kMinute + 1).size() == kMinute + 1;
+        bool end_ok = resampler.seek(kStartTime + 2 * kBars * kSecond) && !resampler.next().has_value();
+        std::cout << "Seek ahead: " << (sought && bar_ok ? "ok" : "WRONG") << ", history " << (history_ok ? "kept" : "lost")
+                  << ", past the end " << (end_ok ? "ok" : "WRONG") << std::endl;
+        expect(sought && bar_ok, "seek ahead serves the period at the time");
+        expect(history_ok, "seek ahead keeps the earlier periods");
+        expect(end_ok, "seek past the end leaves no period");
+    }
+
+    static bool check_minute(const data::BarStruct& bar, size_t minute, size_t source_bars) {
+        size_t first = minute * 60;
+        size_t last = std::min(first + 60, source_bars);
+        double high = 0.0;
+        double low = 1e9;
+        for (size_t i = first; i < last; ++i) {
+            high = std::max(high, SecondFeed::price(i) + 0.5);
+            low = std::min(low, SecondFeed::price(i) - 0.5);
+        }
+        return bar.time == kStartTime + first * kSecond && bar.open == SecondFeed::price(first) && bar.high == high &&
+               bar.low == low && bar.close == SecondFeed::price(last - 1) + 0.25 && bar.count == static_cast<int>(last - first);
+    }
+};
+
+// dummy object to register test
+static TestStreamingResampler test_streaming_resampler;
+
+}
+}
@@ -0,0 +1,117 @@
+#include "test/test_base.h"
+#include "time/time_boundary_tracker.h"
+#include "time/time_with_zone.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kSecond = 1000000000ULL;
+constexpr uint64_t kStartTime = 1709856000ULL * kSecond;  // 2024-03-08 00:00:00 UTC
+constexpr uint64_t kEndTime = 1730851200ULL * kSecond;    // 2024-11-06 00:00:00 UTC
+
+struct Reference {
+    bool day = false;
+    bool hour = false;
+    bool minute = false;
+};
+
+// The detection the replay controller did before, two zoned times per step
+Reference reference_changes(uint64_t previous_time, uint64_t current_time, const std::string& zone) {
+    auto previous = time::TimeWithZone(previous_time, zone).get_local_time();
+    auto current = time::TimeWithZone(current_time, zone).get_local_time();
+    Reference changes;
+    changes.day = std::chrono::floor<std::chrono::days>(previous) != std::chrono::floor<std::chrono::days>(current);
+    changes.hour = std::chrono::floor<std::chrono::hours>(previous) != std::chrono::floor<std::chrono::hours>(current) ||
+                   changes.day;
+    changes.minute = std::chrono::floor<std::chrono::minutes>(previous) != std::chrono::floor<std::chrono::minutes>(current) ||
+                     changes.hour;
+    return changes;
+}
+
+double millis_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+class TestTimeBoundaryTracker : public TestBase {
+public:
+    TestTimeBoundaryTracker(): TestBase("TestTimeBoundaryTracker") {
+        register_test<TestTimeBoundaryTracker>();
+    }
+
+    // Steps of 20 seconds over both New York DST switches of 2024, checked against the
+    // zoned time detection, then timed over the same steps
+    virtual void run() override {
+        const std::string zone = "US/Eastern";
+        constexpr uint64_t kStep = 20 * kSecond;
+        const std::vector<std::pair<uint64_t, uint64_t>> windows = {
+            {kStartTime, kStartTime + 4 * 86400 * kSecond}, {kEndTime - 4 * 86400 * kSecond, kEndTime}};
+
+        size_t steps = 0;
+        size_t mismatches = 0;
+        size_t days = 0;
+        size_t hours = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& [from, to] : windows) {
+            for (uint64_t t = from + kStep; t < to; t += kStep) {
+                reference_changes(t - kStep, t, zone);
+                ++steps;
+            }
+        }
+        double reference_ms = millis_since(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const auto& [from, to] : windows) {
+            time::TimeBoundaryTracker tracker(zone);
+            tracker.advance(from);
+            for (uint64_t t = from + kStep; t < to; t += kStep) {
+                auto changes = tracker.advance(t);
+                days += changes.day;
+                hours += changes.hour;
+            }
+        }
+        double tracker_ms = millis_since(start);
+
+        for (const auto& [from, to] : windows) {
+            time::TimeBoundaryTracker tracker(zone);
+            tracker.advance(from);
+            for (uint64_t t = from + kStep; t < to; t += kStep) {
+                auto changes = tracker.advance(t);
+                auto expected = reference_changes(t - kStep, t, zone);
+                if (changes.day != expected.day || changes.hour != expected.hour || changes.minute != expected.minute) {
+                    if (mismatches++ < 5) {
+                        std::cout << "Mismatch at " << tracker.format(t) << std::endl;
+                    }
+                }
+            }
+        }
+
+        std::cout << "Steps: " << steps << ", day changes: " << days << " (expected 8), hour changes: " << hours
+                  << " (expected 189, the hour repeated when DST ends is no new hour), mismatches: " << mismatches << std::endl;
+        std::cout << "Zoned times: " << reference_ms << "ms, tracker: " << tracker_ms << "ms" << std::endl;
+        expect(mismatches == 0, "the tracker reports the changes of the zoned time detection");
+        expect(days == 8, "a day change at each local midnight");
+        expect(hours == 189, "an hour change at each new local hour");
+
+        time::TimeBoundaryTracker tracker(zone);
+        std::string after = tracker.format(1710054000ULL * kSecond);
+        std::string before = tracker.format(1710054000ULL * kSecond - 1);
+        std::cout << "Formatted: " << after << " / " << before
+                  << " (expected 2024-03-10 03:00:00.000000000 EDT / 2024-03-10 01:59:59.999999999 EST)" << std::endl;
+        expect(after == "2024-03-10 03:00:00.000000000 EDT", "the first instant of DST is formatted in EDT");
+        expect(before == "2024-03-10 01:59:59.999999999 EST", "the last instant before DST is formatted in EST");
+    }
+};
+
+// dummy object to register test
+static TestTimeBoundaryTracker test_time_boundary_tracker;
+
+}
+}
@@ -0,0 +1,320 @@
+#include "test/test_base.h"
+#include "data/feed/tws_backfill_scheduler.h"
+#include "broker/broker_provider.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+// Answers historical data requests like TWS does: after a delay, bar by bar on its own thread,
+// with pacing violations when too many requests arrive within a second
+class MockTwsBroker : public broker::BrokerProvider {
+public:
+    MockTwsBroker(std::chrono::milliseconds latency, size_t requests_per_second)
+        : latency_(latency), requests_per_second_(requests_per_second), worker_([this]() { run(); }) {}
+
+    ~MockTwsBroker() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    bool connect() override { return true; }
+    bool disconnect() override { return true; }
+    bool isConnected() const override { return true; }
+
+    long requestHistoricalData(const std::string&, const std::string&, const std::string&, const std::string&,
+                               const std::string& endTime, const std::string& duration, const std::string&,
+                               const std::string&, bool, bool, const std::string& = "", const std::string& = "",
+                               const std::string& = "") override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        long request_id = next_id_++;
+        auto now = std::chrono::steady_clock::now();
+        while (!sent_.empty() && now - sent_.front() > std::chrono::seconds(1)) {
+            sent_.pop_front();
+        }
+        sent_.push_back(now);
+        ++requests;
+
+        Response response {request_id, now + latency_, 0, 0, 0, ""};
+        uint64_t seconds = duration_seconds(duration);
+        if (sent_.size() > requests_per_second_) {
+            response.code = 162;
+            response.message = "Historical Market Data Service error message:Historical data request pacing violation";
+        } else if (seconds == 0 || seconds > 86400) {
+            // 1 min bars allow at most one day per request
+            response.code = 321;
+            response.message = "Error validating request: invalid duration " + duration;
+            ++invalid_durations;
+        } else {
+            response.end = parse_end_time(endTime);
+            response.start = response.end - seconds;
+        }
+        queue_.push_back(response);
+        cv_.notify_all();
+        return request_id;
+    }
+
+    long requestRealTimeData(const std::string&, const std::string&, const std::string&, const std::string&) override { return -1; }
+
+    void cancelHistoricalData(long requestId) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_.insert(requestId);
+    }
+
+    void cancelRealTimeData(long) override {}
+    long placeOrder(const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, double,
+                    double, const std::string&) override { return -1; }
+    void cancelOrder(long) override {}
+
+    void registerBarDataCallback(long requestId, broker::BarDataCallback callback) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bar_callbacks_[requestId] = std::move(callback);
+    }
+
+    void registerTradeCallback(broker::TradeCallback) override {}
+    void registerOrderStatusCallback(broker::OrderStatusCallback) override {}
+    void registerErrorCallback(broker::ErrorCallback) override {}
+
+    void registerRequestErrorCallback(long requestId, broker::ErrorCallback callback) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (callback) {
+            error_callbacks_[requestId] = std::move(callback);
+        } else {
+            error_callbacks_.erase(requestId);
+        }
+    }
+
+    long requestContractDetails(const std::string&, const std::string&, const std::string&, const std::string&) override { return -1; }
+    std::optional<std::string> getTradingHours(const std::string&, const std::string&, const std::string&,
+                                               const std::string&) const override { return std::nullopt; }
+    std::optional<std::string> getLiquidHours(const std::string&, const std::string&, const std::string&,
+                                              const std::string&) const override { return std::nullopt; }
+    std::optional<std::string> getTimeZone(const std::string&, const std::string&, const std::string&,
+                                           const std::string&) const override { return std::nullopt; }
+    void requestCurrentTime() override {}
+    long getNextRequestId() override { return next_id_; }
+
+    std::atomic<size_t> requests {0};
+    std::atomic<size_t> invalid_durations {0};
+
+private:
+    struct Response {
+        long request_id;
+        std::chrono::steady_clock::time_point due;
+        uint64_t start;
+        uint64_t end;
+        int code;
+        std::string message;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (queue_.empty()) {
+                cv_.wait(lock);
+                continue;
+            }
+            // Requests are served concurrently, each one after the latency
+            auto next = queue_.begin();
+            for (auto iter = queue_.begin(); iter != queue_.end(); ++iter) {
+                if (iter->due < next->due) {
+                    next = iter;
+                }
+            }
+            if (next->due > std::chrono::steady_clock::now()) {
+                cv_.wait_until(lock, next->due);
+                continue;
+            }
+            Response response = *next;
+            queue_.erase(next);
+            if (cancelled_.count(response.request_id)) {
+                continue;
+            }
+            if (response.code != 0) {
+                auto callback = error_callbacks_[response.request_id];
+                lock.unlock();
+                if (callback) {
+                    callback(response.code, response.message);
+                }
+                lock.lock();
+                continue;
+            }
+            auto callback = bar_callbacks_[response.request_id];
+            lock.unlock();
+            broker::BarData bar {};
+            for (uint64_t time = (response.start + 59) / 60 * 60; time < response.end; time += 60) {
+                bar.time = time * 1000000000ULL;
+                bar.end_time = bar.time + 60 * 1000000000ULL;
+                bar.open = bar.high = bar.low = bar.close = 100.0;
+                bar.is_last = false;
+                callback(bar);
+            }
+            bar.is_last = true;
+            callback(bar);
+            lock.lock();
+        }
+    }
+
+    static uint64_t duration_seconds(const std::string& duration) {
+        unsigned long long value = 0;
+        char unit = 0;
+        if (std::sscanf(duration.c_str(), "%llu %c", &value, &unit) != 2) {
+            return 0;
+        }
+        switch (unit) {
+        case 'S': return value;
+        case 'D': return value * 86400;
+        case 'W': return value * 7 * 86400;
+        default: return 0;
+        }
+    }
+
+    static uint64_t parse_end_time(const std::string& text) {
+        int year = 0;
+        unsigned month = 0, day = 0, hour = 0, minute = 0, second = 0;
+        std::sscanf(text.c_str(), "%4d%2u%2u-%u:%u:%u", &year, &month, &day, &hour, &minute, &second);
+        std::chrono::sys_days date {std::chrono::year {year} / std::chrono::month {month} / std::chrono::day {day}};
+        return date.time_since_epoch().count() * 86400ULL + hour * 3600 + minute * 60 + second;
+    }
+
+    std::chrono::milliseconds latency_;
+    size_t requests_per_second_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Response> queue_;
+    std::deque<std::chrono::steady_clock::time_point> sent_;
+    std::set<long> cancelled_;
+    std::unordered_map<long, broker::BarDataCallback> bar_callbacks_;
+    std::unordered_map<long, broker::ErrorCallback> error_callbacks_;
+    long next_id_ = 1;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+} // namespace
+
+class TestTwsBackfill : public TestBase {
+public:
+    TestTwsBackfill(): TestBase("TestTwsBackfill") {
+        register_test<TestTwsBackfill>();
+    }
+
+    // 4 tickers of 1 min bars over 15 days, 60 one day requests, against a mock broker with 50ms
+    // latency: one request at a time, 10 in flight, and 10 in flight without pacing so the
+    // mock answers with pacing violations that have to be retried
+    virtual void run() override {
+        using data::feed::TwsBackfillScheduler;
+        auto chunks = TwsBackfillScheduler::split_range(data::BarType::Minute, 1, 1700000000, 1700000000 + 3 * 86400 + 100);
+        std::cout << "Split: " << chunks.size() << " chunks, " << chunks.front().duration << " ending "
+                  << TwsBackfillScheduler::format_end_time(chunks.front().end_seconds) << ", last " << chunks.back().duration
+                  << std::endl;
+        auto seconds_chunks = TwsBackfillScheduler::split_range(data::BarType::Second, 5, 1700000000, 1700000000 + 86400);
+        std::cout << "Split 5 secs over a day: " << seconds_chunks.size() << " chunks of " << seconds_chunks.front().duration
+                  << std::endl;
+        // Chunks run backwards from the end, the last one takes the remainder
+        expect(chunks.size() == 4 && chunks.front().duration == "1 D" && chunks.back().duration == "100 S" &&
+                   TwsBackfillScheduler::format_end_time(chunks.front().end_seconds) == "20231117-22:15:00",
+               "split 3 days and 100 seconds of 1 min bars into days");
+        expect(seconds_chunks.size() == 24 && seconds_chunks.front().duration == "3600 S" &&
+                   seconds_chunks.back().duration == "3600 S",
+               "split a day of 5 secs bars into hours");
+        expect(TwsBackfillScheduler::split_range(data::BarType::Minute, 1, 1700000000, 1700000000).empty(),
+               "an empty range has no chunks");
+
+        auto broker = std::make_shared<MockTwsBroker>(std::chrono::milliseconds(50), 100);
+        data::feed::BackfillOptions options;
+        options.retry_delay = std::chrono::milliseconds(100);
+        options.request_timeout = std::chrono::milliseconds(5000);
+        // At most 20 + 75 requests in any second, below the 100 the mock allows
+        options.pacing_burst = 20;
+        options.pacing_rate = 75;
+
+        options.max_in_flight = 1;
+        double serial = run_jobs(broker, options, "Serial");
+        options.max_in_flight = 10;
+        double parallel = run_jobs(broker, options, "Parallel");
+        std::cout << "Speedup: " << serial / parallel << "x" << std::endl;
+
+        options.pacing_burst = 1000;
+        options.pacing_rate = 1000;
+        run_jobs(broker, options, "Unpaced");
+        std::cout << "Invalid durations sent: " << broker->invalid_durations.load() << std::endl;
+        expect(broker->invalid_durations.load() == 0, "no request the broker rejects as an invalid duration");
+    }
+
+private:
+    double run_jobs(std::shared_ptr<MockTwsBroker> broker, const data::feed::BackfillOptions& options, const char* name) {
+        using data::feed::TwsBackfillScheduler;
+        constexpr uint64_t kStart = 1704103200;  // 2024-01-01 10:00:00 UTC, not on a day boundary
+        constexpr uint64_t kEnd = kStart + 15 * 86400;
+        auto scheduler = TwsBackfillScheduler::instance();
+        scheduler->set_options(options);
+        auto before = scheduler->get_stats();
+
+        std::mutex mutex;
+        std::map<std::string, size_t> counts;
+        std::map<std::string, bool> ordered;
+        auto start = std::chrono::steady_clock::now();
+        for (const char* symbol : {"AAPL", "MSFT", "SPY", "QQQ"}) {
+            data::feed::BackfillRequest request;
+            request.symbol = symbol;
+            request.bar_size = "1 min";
+            request.bar_type = data::BarType::Minute;
+            request.bar_type_size = 1;
+            request.start_seconds = kStart;
+            request.end_seconds = kEnd;
+            std::string key = symbol;
+            scheduler->submit(
+                broker, request,
+                [&mutex, &counts, &ordered, key](data::BarSeries&& bars) {
+                    bool sorted = true;
+                    for (size_t i = 1; i < bars.size(); ++i) {
+                        sorted = sorted && bars.start_time[i] == bars.start_time[i - 1] + 60 * 1000000000ULL;
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    counts[key] = bars.size();
+                    ordered[key] = sorted && bars.size() > 0 && bars.start_time[0] == kStart * 1000000000ULL;
+                },
+                [key](const std::string& reason) { std::cout << key << " failed: " << reason << std::endl; });
+        }
+        bool idle = scheduler->wait_idle(std::chrono::seconds(60));
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto after = scheduler->get_stats();
+
+        bool complete = idle && counts.size() == 4;
+        for (const auto& [symbol, count] : counts) {
+            complete = complete && count == (kEnd - kStart) / 60 && ordered[symbol];
+        }
+        std::cout << name << ": " << seconds << "s, " << after.requests - before.requests << " requests, "
+                  << after.retries - before.retries << " retries, " << after.pacing_violations - before.pacing_violations
+                  << " pacing violations, bars " << (complete ? "complete" : "MISSING") << std::endl;
+        // Every symbol gets one bar per minute of the range, stitched in order without duplicates
+        expect(complete, std::string(name) + " backfill stitches the chunks of every symbol");
+        expect(after.failed_jobs == before.failed_jobs, std::string(name) + " backfill has no failed job");
+        return seconds;
+    }
+};
+
+// dummy object to register test
+static TestTwsBackfill test_tws_backfill;
+
+}
+}
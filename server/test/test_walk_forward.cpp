@@ -0,0 +1,224 @@
+#include "test/test_base.h"
+#include "cerebro/optimize/walk_forward.h"
+#include "data/common/bar_line.h"
+#include "strategy/strategy_factory.h"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace quanttrader {
+namespace test {
+
+namespace {
+
+constexpr uint64_t kStartTime = 1104537600ULL * 1000000000ULL;  // 2005-01-03 00:00:00 UTC
+constexpr uint64_t kDay = 86400ULL * 1000000000ULL;
+constexpr size_t kDays = 2520;
+constexpr int kInSample = 504;
+constexpr int kOutOfSample = 252;
+
+// Daily bars of a trending, cycling price, counts how often it is loaded
+class CyclingBars : public data::provider::DataProvider {
+public:
+    CyclingBars(size_t days, std::atomic<size_t>& loads)
+        : DataProvider("daily_TEST", std::make_shared<std::unordered_map<std::string, std::any>>()), days_(days), loads_(loads) {
+        symbol_ = "TEST";
+        bar_type_ = data::BarType::Day;
+        bar_size_ = 1;
+        timezone_ = "UTC";
+    }
+
+    bool prepare_data() override {
+        bar_line_ = std::make_shared<data::util::BarLine>(0, bar_type_, bar_size_);
+        return true;
+    }
+
+    bool start_request_data() override {
+        ++loads_;
+        data::BarSeries bars;
+        for (size_t day = 0; day < days_; ++day) {
+            double price = 100.0 + day * 0.02 + 10.0 * std::sin(day / 15.0) + 4.0 * std::sin(day / 4.0);
+            bars.push_back(kStartTime + day * kDay, price, price + 1.0, price - 1.0, price, 1000, 0, 1);
+        }
+        bar_line_->append_batch(std::move(bars));
+        mark_data_ready();
+        return true;
+    }
+
+    bool terminate_request_data() override { return true; }
+    bool is_data_ready() override { return data_ready_; }
+    std::optional<data::BarStruct> next() override { return bar_line_->next(); }
+
+private:
+    size_t days_ = 0;
+    std::atomic<size_t>& loads_;
+};
+
+// Long while the fast moving average is above the slow one
+class CrossStrategy : public strategy::StrategyBase {
+public:
+    explicit CrossStrategy(strategy::StrategyCreateFuncParemType& params)
+        : StrategyBase(params), fast_(get_param<int>("fast_period", 5)), slow_(get_param<int>("slow_period", 20)) {}
+
+    void on_bar(const std::string& data_name, const data::BarSeriesView& bar_series, bool, bool, bool) override {
+        size_t count = bar_series.close.size();
+        if (fast_ <= 0 || slow_ <= 0 || count < static_cast<size_t>(std::max(fast_, slow_))) {
+            return;
+        }
+        bool above = average(bar_series, fast_) > average(bar_series, slow_);
+        if (above && !long_) {
+            buy(symbol_, 100);
+            long_ = true;
+        } else if (!above && long_) {
+            sell(symbol_, 100);
+            long_ = false;
+        }
+    }
+
+protected:
+    void next() override {}
+
+private:
+    static double average(const data::BarSeriesView& bar_series, int period) {
+        double sum = 0.0;
+        for (size_t i = bar_series.close.size() - period; i < bar_series.close.size(); ++i) {
+            sum += bar_series.close[i];
+        }
+        return sum / period;
+    }
+
+    int fast_ = 5;
+    int slow_ = 20;
+    bool long_ = false;
+};
+
+}
+
+class TestWalkForward : public TestBase {
+public:
+    TestWalkForward(): TestBase("TestWalkForward") {
+        register_test<TestWalkForward>();
+    }
+
+    virtual void run() override {
+        strategy::StrategyFactory::register_strategy("walk_cross", [](strategy::StrategyCreateFuncParemType& params) {
+            return std::make_shared<CrossStrategy>(params);
+        });
+        test_seek();
+
+        // Ten years of days, two years in sample and one out of sample, on one thread and on all of them
+        size_t hardware = std::max<unsigned int>(std::thread::hardware_concurrency(), 1);
+        auto serial = walk(1, false);
+        auto parallel = walk(static_cast<int>(hardware), false);
+        auto anchored = walk(static_cast<int>(hardware), true);
+        if (!expect(serial.stats && parallel.stats && anchored.stats, "the walk-forward runs")) {
+            return;
+        }
+
+        // Every out-of-sample run replays its own bars only, the seek skips the bars before it
+        size_t mismatches = 0;
+        size_t replayed_wrong = 0;
+        for (size_t i = 0; i < parallel.windows.size(); ++i) {
+            const auto& window = parallel.windows[i];
+            const auto& expected = serial.windows[i];
+            if (!window.completed || window.best_point != expected.best_point ||
+                window.out_of_sample.total_profit != expected.out_of_sample.total_profit) {
+                ++mismatches;
+            }
+            if (parallel.points_per_window[i] != window.out_of_sample_bars) {
+                ++replayed_wrong;
+            }
+        }
+        bool anchored_ok = true;
+        for (size_t i = 0; i < anchored.windows.size(); ++i) {
+            anchored_ok = anchored_ok && anchored.windows[i].in_sample_begin == kStartTime &&
+                          anchored.windows[i].in_sample_bars == static_cast<size_t>(kInSample + i * kOutOfSample);
+        }
+
+        std::cout << "Windows: " << parallel.stats->windows << " (expected 8), failed: " << parallel.stats->failed
+                  << ", mismatches between 1 and " << parallel.stats->threads << " threads: " << mismatches
+                  << ", windows replaying other bars: " << replayed_wrong << std::endl;
+        std::cout << "Anchored windows: " << anchored.stats->windows << " (expected 8), growing in-sample: "
+                  << (anchored_ok ? "ok" : "WRONG") << std::endl;
+        std::cout << "Data loaded " << serial.loads << ", " << parallel.loads << " and " << anchored.loads
+                  << " times (expected once per walk)" << std::endl;
+        expect(parallel.stats->windows == 8 && parallel.stats->failed == 0, "eight windows, none failed");
+        expect(mismatches == 0, "every thread count picks the same points with the same profits");
+        expect(replayed_wrong == 0, "every out-of-sample run replays its own bars only");
+        expect(anchored.stats->windows == 8 && anchored_ok, "the anchored in-sample windows grow from the first bar");
+        expect(serial.loads == 1 && parallel.loads == 1 && anchored.loads == 1, "the data is loaded once per walk");
+        for (const auto& window : parallel.windows) {
+            std::cout << "  window " << window.index << ": fast_period " << window.best_values[0] << ", slow_period "
+                      << window.best_values[1] << ", in-sample profit " << window.in_sample.total_profit
+                      << ", out-of-sample profit " << window.out_of_sample.total_profit << std::endl;
+        }
+        std::cout << "Stitched out-of-sample profit " << parallel.stats->total_profit << " (" << parallel.stats->return_percent
+                  << "%), max drawdown " << parallel.stats->max_drawdown << ", " << parallel.stats->total_trades << " trades in "
+                  << parallel.equity_points << " equity points" << std::endl;
+        std::cout << parallel.stats->backtests << " backtests, 1 thread: " << serial.stats->seconds << "s, "
+                  << parallel.stats->threads << " threads: " << parallel.stats->seconds << "s, speedup "
+                  << serial.stats->seconds / std::max(parallel.stats->seconds, 1e-9) << std::endl;
+    }
+
+private:
+    struct Outcome {
+        std::optional<cerebro::optimize::WalkForwardStats> stats;
+        std::vector<cerebro::optimize::WalkForwardWindow> windows;
+        std::vector<size_t> points_per_window;  // stitched equity points of every window
+        size_t equity_points = 0;
+        size_t loads = 0;
+    };
+
+    void test_seek() {
+        data::util::BarLine line(0, data::BarType::Day, 1);
+        for (uint64_t day = 0; day < 10; ++day) {
+            line.push_data(kStartTime + day * kDay, 1.0, 1.0, 1.0, 1.0, 1, 0, 1);
+        }
+        bool ok = line.seek(kStartTime + 4 * kDay) == 4 && line.next()->time == kStartTime + 4 * kDay;
+        ok = ok && line.seek(kStartTime + 4 * kDay + 1) == 5 && line.get_position() == 5;
+        ok = ok && line.seek(0) == 0 && line.seek(kStartTime + 20 * kDay) == 10 && !line.next().has_value();
+        // The bars before the cursor stay in the view
+        ok = ok && line.seek(kStartTime + 7 * kDay) == 7 && line.view(line.get_position() + 1).size() == 8;
+        std::cout << "BarLine seek: " << (ok ? "ok" : "WRONG") << std::endl;
+        expect(ok, "BarLine::seek moves the cursor to the first bar at or after the time");
+    }
+
+    Outcome walk(int threads, bool anchored) {
+        std::atomic<size_t> loads {0};
+        cerebro::optimize::SweepOptions options {{"threads", threads},
+                                                 {"grid.fast_period", std::string("2:20:2")},
+                                                 {"grid.slow_period", std::string("20:60:10")},
+                                                 {"in_sample_bars", kInSample},
+                                                 {"out_of_sample_bars", kOutOfSample},
+                                                 {"anchored", anchored}};
+        cerebro::optimize::WalkForward walk_forward(options);
+        auto source = std::make_shared<CyclingBars>(kDays, loads);
+        source->prepare_data();
+        walk_forward.get_sweep().add_data(source);
+        walk_forward.get_sweep().set_strategy("walk_cross", {{"strategy_name", std::string("walk_cross")}, {"symbol", std::string("TEST")}});
+
+        Outcome outcome;
+        if (walk_forward.prepare()) {
+            outcome.stats = walk_forward.run();
+            outcome.windows = walk_forward.get_windows();
+            outcome.points_per_window.assign(outcome.windows.size(), 0);
+            const auto& equity = walk_forward.get_equity();
+            outcome.equity_points = equity.size();
+            for (const auto& window : outcome.windows) {
+                outcome.points_per_window[window.index] = static_cast<size_t>(std::count_if(equity.begin(), equity.end(), [&window](const auto& point) {
+                    return point.time >= window.out_of_sample_begin && point.time < window.out_of_sample_end;
+                }));
+            }
+        }
+        outcome.loads = loads;
+        return outcome;
+    }
+};
+
+// dummy object to register test
+static TestWalkForward test_walk_forward;
+
+}
+}
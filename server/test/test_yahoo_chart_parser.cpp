@@ -0,0 +1,125 @@
+#include "test/test_base.h"
+#include "data/feed/yahoo_chart_parser.h"
+#include <rapidjson/filereadstream.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace quanttrader {
+namespace test {
+
+class TestYahooChartParser : public TestBase {
+public:
+    TestYahooChartParser(): TestBase("TestYahooChartParser") {
+        register_test<TestYahooChartParser>();
+    }
+
+    // A generated chart response streamed in 16KB chunks as curl hands them over, then read
+    // from a saved file as the offline stand-in and the response cache do. The default row
+    // count keeps the test quick, set QUANTTRADER_BENCH_ROWS (e.g. 500000) to benchmark.
+    virtual void run() override {
+        size_t rows = kDefaultRows;
+        if (const char* env_rows = std::getenv("QUANTTRADER_BENCH_ROWS")) {
+            rows = std::strtoull(env_rows, nullptr, 10);
+        }
+        std::string response = make_response(rows);
+        std::cout << "Response: " << rows << " rows, " << response.size() / (1024 * 1024) << "MB" << std::endl;
+
+        data::feed::YahooChartHandler chart;
+        data::feed::ChunkedInputStream stream;
+        auto start = std::chrono::steady_clock::now();
+        std::thread download([&response, &stream]() {
+            constexpr size_t kChunk = 16 * 1024;
+            for (size_t offset = 0; offset < response.size(); offset += kChunk) {
+                if (!stream.push(response.data() + offset, std::min(kChunk, response.size() - offset))) {
+                    break;
+                }
+            }
+            stream.finish();
+        });
+        std::string error = data::feed::parse_chart(stream, chart);
+        stream.stop_reading();
+        download.join();
+        size_t skipped = 0;
+        auto bars = chart.to_bar_series(skipped);
+        size_t nulls = (rows + 49) / 100;  // rows 50, 150, ...
+        std::cout << "Streamed: " << bars.size() << " bars, " << skipped << " with nulls (expected " << nulls << ") in "
+                  << millis_since(start) << "ms" << (error.empty() ? "" : ", error: " + error) << std::endl;
+        expect(error.empty(), "the streamed response parses");
+        expect(skipped == nulls && bars.size() == rows - nulls, "the rows with a null close are skipped");
+        bool values_ok = bars.size() > 1 && bars.start_time[1] == 1600000060ULL * 1000000000ULL && bars.close[1] == 100.25 &&
+                         bars.volume[1] == ((398ULL << 53) | 1001);
+        std::cout << "Values: " << (values_ok ? "ok" : "wrong") << std::endl;
+        expect(values_ok, "times, prices and volumes are converted");
+
+        auto path = std::filesystem::temp_directory_path() / "quanttrader_chart.json";
+        std::ofstream(path, std::ios::binary) << response;
+        start = std::chrono::steady_clock::now();
+        data::feed::YahooChartHandler cached;
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        char buffer[65536];
+        rapidjson::FileReadStream file_stream(file, buffer, sizeof(buffer));
+        error = data::feed::parse_chart(file_stream, cached);
+        std::fclose(file);
+        std::cout << "From file: " << cached.rows() << " rows in " << millis_since(start) << "ms"
+                  << (error.empty() ? "" : ", error: " + error) << std::endl;
+        expect(error.empty() && cached.rows() == rows, "the saved response parses from a file");
+        std::filesystem::remove(path);
+
+        std::string failure = R"({"chart":{"result":null,"error":{"code":"Not Found","description":"No data found, symbol may be delisted"}}})";
+        data::feed::ChunkedInputStream failure_stream;
+        failure_stream.push(failure.data(), failure.size());
+        failure_stream.finish();
+        data::feed::YahooChartHandler failed;
+        data::feed::parse_chart(failure_stream, failed);
+        std::cout << "Error response: " << (failed.error().empty() ? "(none)" : failed.error()) << std::endl;
+        expect(failed.error() == "No data found, symbol may be delisted", "the error description of the response is kept");
+    }
+
+private:
+    static constexpr size_t kDefaultRows = 20000;
+
+    // Same layout as query1.finance.yahoo.com/v8/finance/chart, every 100th row has a null close
+    static std::string make_response(size_t rows) {
+        std::ostringstream json;
+        json << R"({"chart":{"result":[{"meta":{"symbol":"TEST","validRanges":["1d","5d"]},"timestamp":[)";
+        for (size_t i = 0; i < rows; ++i) {
+            json << (i ? "," : "") << 1600000000 + i * 60;
+        }
+        json << R"(],"indicators":{"quote":[{)";
+        const char* names[] = {"open", "high", "low", "close", "volume"};
+        for (int c = 0; c < 5; ++c) {
+            json << (c ? "," : "") << '"' << names[c] << "\":[";
+            for (size_t i = 0; i < rows; ++i) {
+                json << (i ? "," : "");
+                if (c == 3 && i % 100 == 50) {
+                    json << "null";
+                } else if (c == 4) {
+                    json << 1000 + i;
+                } else {
+                    json << 100.0 + (i % 400) * 0.25;
+                }
+            }
+            json << ']';
+        }
+        json << R"(}],"adjclose":[{"adjclose":[1.0,2.0]}]}}],"error":null}})";
+        return json.str();
+    }
+
+    static double millis_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// dummy object to register test
+static TestYahooChartParser test_yahoo_chart_parser;
+
+}
+}
@@ -36,7 +36,7 @@ bool SlopeStrategy::initialize() {
     return result;
 }
 
-void SlopeStrategy::calculate_moving_averages_incremental(const data::BarSeries& bar_series) {
+void SlopeStrategy::calculate_moving_averages_incremental(const data::BarSeriesView& bar_series) {
     // Get the current size of data
     size_t current_size = bar_series.close.size();
     
@@ -200,7 +200,7 @@ void SlopeStrategy::calculate_moving_averages_incremental(const data::BarSeries&
     }
 }
 
-void SlopeStrategy::on_bar(const std::string& data_name, const data::BarSeries& bar_series, 
+void SlopeStrategy::on_bar(const std::string& data_name, const data::BarSeriesView& bar_series, 
                            bool day_change, bool hour_change, bool minute_change) {
     // Extract the symbol from data_name by finding the part after the last underscore
     std::string bar_symbol = data_name;
@@ -13,7 +13,7 @@ namespace strategy {
 /**
  * @brief Example strategy using TA-Lib for technical indicators
  * 
- * This strategy demonstrates how to use the BarSeries data structure with TA-Lib.
+ * This strategy demonstrates how to use the BarSeriesView data structure with TA-Lib.
  * It calculates a simple moving average using TA-Lib and generates buy/sell signals.
  * Uses incremental calculation for improved performance.
  */
@@ -26,7 +26,7 @@ public:
     bool initialize() override;
     
     // Event handlers 
-    void on_bar(const std::string& data_name, const data::BarSeries& bar_series, bool day_change, bool hour_change, bool minute_change) override;
+    void on_bar(const std::string& data_name, const data::BarSeriesView& bar_series, bool day_change, bool hour_change, bool minute_change) override;
     
 protected:
     // Implementation of the next method required by StrategyBase
@@ -69,7 +69,7 @@ private:
      * 
      * @param bar_series The input bar series data
      */
-    void calculate_moving_averages_incremental(const data::BarSeries& bar_series);
+    void calculate_moving_averages_incremental(const data::BarSeriesView& bar_series);
 };
 
 }